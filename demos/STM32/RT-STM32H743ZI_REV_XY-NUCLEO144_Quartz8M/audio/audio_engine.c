@@ -0,0 +1,206 @@
+/**
+ * @file audio_engine.c
+ * @brief SAI2 bloc A maître TX, 2 × 32 bits à 48 kHz, DMA circulaire HT/TC.
+ *
+ * Profil SAI repris du bring-up (DS 32 bits, FTH ½, slots 32 bits, DMA mot)
+ * avec MCLK généré : FRL + 1 = 64 (puissance de 2, cf. « SAI LLD —
+ * Bring-up Safe Profile »).
+ *
+ * Gains : l’UI écrit une copie « suivante » sous verrou et lève un drapeau ;
+ * l’IRQ la recopie en tête de bloc. Le tampon DMA est en section `.nocache`
+ * (SRAM3, non cacheable via la MPU) : le D-Cache est actif, le DMA lit donc
+ * les échantillons mixés sans maintenance de cache.
+ *
+ * @ingroup audio
+ */
+
+#include <string.h>
+#include "ch.h"
+#include "hal.h"
+#include "audio_engine.h"
+
+#if HAL_USE_SAI != TRUE
+#error "audio_engine.c requiert HAL_USE_SAI = TRUE"
+#endif
+
+/* ====================================================================== */
+/*                                 ÉTAT                                   */
+/* ====================================================================== */
+
+/**
+ * @brief Tampon DMA circulaire (deux moitiés HT/TC).
+ * @details Section `.nocache` comme les anneaux MIDI : sans cela, les
+ *          écritures du mixeur resteraient dans le D-Cache et le DMA
+ *          émettrait des données périmées.
+ */
+static int32_t audio_tx[AUDIO_DMA_ITEMS]
+    __attribute__((section(".nocache"), aligned(32)));
+
+static audio_cart_gains_t gains_live[BRICK_MAX_CARTRIDGES];
+static int16_t            master_live;
+
+/* Réglages UI en attente (sous verrou système). */
+static audio_cart_gains_t gains_next[BRICK_MAX_CARTRIDGES];
+static int16_t            master_next;
+static bool               params_pending;
+
+static audio_input_t audio_input;
+static audio_block_hook_t audio_block_hook;
+static audio_stats_t audio_stats;
+
+/* ====================================================================== */
+/*                               IRQ AUDIO                                */
+/* ====================================================================== */
+
+static void audio_sai_cb(SAIDriver *saip, bool half) {
+  (void)saip;
+  const rtcnt_t t0 = chSysGetRealtimeCounterX();
+  const audio_input_t input = audio_input;
+  const audio_block_hook_t hook = audio_block_hook;
+  const int16_t *in[BRICK_MAX_CARTRIDGES];
+
+  chSysLockFromISR();
+  if (params_pending) {
+    memcpy(gains_live, gains_next, sizeof(gains_live));
+    master_live = master_next;
+    params_pending = false;
+  }
+  chSysUnlockFromISR();
+
+  if (hook != NULL) {
+    hook();
+  }
+
+  for (uint8_t c = 0U; c < BRICK_MAX_CARTRIDGES; c++) {
+    in[c] = (input != NULL) ? input(c) : NULL;
+  }
+
+  /* HT : la première moitié vient d’être émise, TC : la seconde. */
+  int32_t *dst = &audio_tx[half ? 0U : (AUDIO_DMA_ITEMS / 2U)];
+  audio_mix_block(in, gains_live, master_live, dst, AUDIO_SAI_SLOTS,
+                  BRICK_AUDIO_FRAME_SAMPLES);
+
+  const uint32_t dt = (uint32_t)(chSysGetRealtimeCounterX() - t0);
+  audio_stats.blocks++;
+  audio_stats.cycles_last = dt;
+  if (dt > audio_stats.cycles_max) {
+    audio_stats.cycles_max = dt;
+  }
+}
+
+void sai_dma_error_hook(SAIDriver *saip) {
+  (void)saip;
+  audio_stats.dma_errors++;
+}
+
+static const SAIConfig audio_sai_cfg = {
+  .tx_buffer = audio_tx,
+  .rx_buffer = NULL,
+  .size      = AUDIO_DMA_ITEMS,
+  .end_cb    = audio_sai_cb,
+  .gcr       = 0U,
+  .cr1       = (AUDIO_SAI_MCKDIV << SAI_xCR1_MCKDIV_Pos) |
+               (SAI_xCR1_DS_0 | SAI_xCR1_DS_1 | SAI_xCR1_DS_2),
+  .cr2       = SAI_xCR2_FTH_1,
+  .frcr      = ((32U * AUDIO_SAI_SLOTS - 1U) << SAI_xFRCR_FRL_Pos) |
+               ((16U * AUDIO_SAI_SLOTS - 1U) << SAI_xFRCR_FSALL_Pos),
+  .slotr     = (0U << SAI_xSLOTR_FBOFF_Pos) |
+               (SAI_xSLOTR_SLOTSZ_1) |
+               ((AUDIO_SAI_SLOTS - 1U) << SAI_xSLOTR_NBSLOT_Pos) |
+               (((1U << AUDIO_SAI_SLOTS) - 1U) << SAI_xSLOTR_SLOTEN_Pos),
+  .dma_mode  = STM32_DMA_CR_PSIZE_WORD | STM32_DMA_CR_MSIZE_WORD
+};
+
+/* ====================================================================== */
+/*                                  API                                   */
+/* ====================================================================== */
+
+void audio_engine_init(void) {
+  int16_t gl, gr;
+
+  audio_pan_gains(AUDIO_Q15_ONE, 0, &gl, &gr);
+  for (uint8_t t = 0U; t < AUDIO_NUM_TRACKS; t++) {
+    audio_cart_gains_set(&gains_next[t / BRICK_CART_AUDIO_CHANNELS],
+                         (uint8_t)(t % BRICK_CART_AUDIO_CHANNELS), gl, gr);
+  }
+  memcpy(gains_live, gains_next, sizeof(gains_live));
+  master_live = master_next = AUDIO_Q15_ONE;
+  params_pending = false;
+  audio_input = NULL;
+  audio_block_hook = NULL;
+
+  memset(audio_tx, 0, sizeof(audio_tx));
+  audio_stats = (audio_stats_t){0};
+  audio_stats.cycles_budget = (uint32_t)(((uint64_t)STM32_SYS_CK * BRICK_AUDIO_FRAME_SAMPLES) /
+                                         BRICK_AUDIO_SAMPLE_RATE);
+}
+
+bool audio_engine_start(void) {
+  palSetLineMode(LINE_SAI2_MCLK_A, PAL_MODE_ALTERNATE(10) | PAL_STM32_OSPEED_HIGHEST);
+  palSetLineMode(LINE_SAI2_SCK_A,  PAL_MODE_ALTERNATE(10) | PAL_STM32_OSPEED_HIGHEST);
+  palSetLineMode(LINE_SAI2_FS_A,   PAL_MODE_ALTERNATE(10) | PAL_STM32_OSPEED_HIGHEST);
+  palSetLineMode(LINE_SAI2_SD_A,   PAL_MODE_ALTERNATE(10) | PAL_STM32_OSPEED_HIGHEST);
+
+  if (saiStart(&SAID2A, &audio_sai_cfg) != HAL_RET_SUCCESS) {
+    audio_stats.sai_errors = SAID2A.error_flags;
+    return false;
+  }
+  saiStartExchange(&SAID2A);
+  audio_stats.sai_errors = SAID2A.error_flags;
+  return SAID2A.state == SAI_ACTIVE;
+}
+
+void audio_engine_stop(void) {
+  saiStopExchange(&SAID2A);
+  saiStop(&SAID2A);
+}
+
+void audio_engine_set_input(audio_input_t input) {
+  osalSysLock();
+  audio_input = input;
+  osalSysUnlock();
+}
+
+void audio_engine_set_block_hook(audio_block_hook_t hook) {
+  osalSysLock();
+  audio_block_hook = hook;
+  osalSysUnlock();
+}
+
+void audio_engine_set_track(uint8_t track, int16_t gain_q15, int8_t pan) {
+  int16_t gl, gr;
+
+  if (track >= AUDIO_NUM_TRACKS) {
+    return;
+  }
+  audio_pan_gains(gain_q15, pan, &gl, &gr);
+
+  osalSysLock();
+  audio_cart_gains_set(&gains_next[track / BRICK_CART_AUDIO_CHANNELS],
+                       (uint8_t)(track % BRICK_CART_AUDIO_CHANNELS), gl, gr);
+  params_pending = true;
+  osalSysUnlock();
+}
+
+void audio_engine_set_master(int16_t gain_q15) {
+  osalSysLock();
+  master_next = gain_q15;
+  params_pending = true;
+  osalSysUnlock();
+}
+
+void audio_engine_get_stats(audio_stats_t *stats) {
+  osalSysLock();
+  *stats = audio_stats;
+  stats->sai_errors = SAID2A.error_flags;
+  osalSysUnlock();
+}
+
+void audio_engine_stats_reset(void) {
+  osalSysLock();
+  audio_stats.blocks = 0U;
+  audio_stats.cycles_last = 0U;
+  audio_stats.cycles_max = 0U;
+  audio_stats.dma_errors = 0U;
+  osalSysUnlock();
+}
@@ -0,0 +1,109 @@
+/**
+ * @file audio_engine.h
+ * @brief Moteur audio par blocs : DMA SAI double tampon, graphe statique.
+ *
+ * Le DMA SAI (circulaire) lit un tampon de deux blocs de
+ * @ref BRICK_AUDIO_FRAME_SAMPLES trames ; chaque IRQ half / full remplit le
+ * bloc qui vient d’être émis pendant que le DMA lit l’autre. C’est le
+ * métronome audio (agent.md) : le calcul est fait dans le callback, court,
+ * sans appel RTOS bloquant.
+ *
+ * Graphe (figé) :
+ *   cartouches (4 × 4 canaux Q15) → gain/pan par piste → bus master
+ *   stéréo → gain master → sortie Q31 (slots 0/1 de la trame SAI).
+ *
+ * Piste t = canal (t % 4) de la cartouche (t / 4). Les gains modifiés par
+ * l’UI sont appliqués au début du bloc suivant (jamais au milieu d’un bloc).
+ *
+ * @ingroup audio
+ */
+
+#ifndef AUDIO_ENGINE_H
+#define AUDIO_ENGINE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "audio_mix.h"
+
+/* ====================================================================== */
+/*                             CONFIGURATION                              */
+/* ====================================================================== */
+
+/** @brief Slots de 32 bits par trame SAI (L, R). */
+#ifndef AUDIO_SAI_SLOTS
+#define AUDIO_SAI_SLOTS         2U
+#endif
+
+/**
+ * @brief Diviseur MCLK : 49,152 MHz (PLL2_P) / 4 = 12,288 MHz = 256 × Fs.
+ * @details RM0433, NOMCK = 0 : F_MCLK = F_sai_ker / MCKDIV,
+ *          F_SCK = F_MCLK × (FRL + 1) / 256 = 3,072 MHz pour 64 bits/trame.
+ */
+#ifndef AUDIO_SAI_MCKDIV
+#define AUDIO_SAI_MCKDIV        4U
+#endif
+
+#define AUDIO_NUM_TRACKS        (BRICK_MAX_CARTRIDGES * BRICK_CART_AUDIO_CHANNELS)
+#define AUDIO_DMA_ITEMS         (2U * BRICK_AUDIO_FRAME_SAMPLES * AUDIO_SAI_SLOTS)
+
+/* ====================================================================== */
+/*                                 TYPES                                  */
+/* ====================================================================== */
+
+/**
+ * @brief Source d’une cartouche, appelée depuis l’IRQ audio à chaque bloc.
+ * @return Bloc `int16_t [BRICK_AUDIO_FRAME_SAMPLES][4]` ou NULL (silence).
+ */
+typedef const int16_t *(*audio_input_t)(uint8_t cart);
+
+/**
+ * @brief Début de bloc, appelé depuis l’IRQ audio avant les sources
+ *        (cadence des échanges avec les cartouches).
+ */
+typedef void (*audio_block_hook_t)(void);
+
+/**
+ * @struct audio_stats_t
+ * @brief Charge et erreurs du chemin audio.
+ */
+typedef struct {
+  uint32_t blocks;          /**< Blocs calculés */
+  uint32_t cycles_last;     /**< Cycles CPU du dernier bloc */
+  uint32_t cycles_max;      /**< Cycles CPU maximum d’un bloc */
+  uint32_t cycles_budget;   /**< Cycles disponibles par bloc (temps réel) */
+  uint32_t dma_errors;      /**< Erreurs DMA (hook du LLD SAI) */
+  uint32_t sai_errors;      /**< Drapeaux d’erreur SAI latchés (OVRUDR, WCKCFG…) */
+} audio_stats_t;
+
+/* ====================================================================== */
+/*                                  API                                   */
+/* ====================================================================== */
+
+/** @brief Gains à l’unité, pan au centre, master à l’unité, aucune source. */
+void audio_engine_init(void);
+
+/**
+ * @brief Configure les broches SAI2 bloc A et démarre le flux.
+ * @return false si le SAI n’a pas démarré (voir `audio_stats_t::sai_errors`).
+ */
+bool audio_engine_start(void);
+
+void audio_engine_stop(void);
+
+/** @brief Source des blocs cartouche (NULL : silence). */
+void audio_engine_set_input(audio_input_t input);
+
+/** @brief Début de bloc (NULL : aucun). */
+void audio_engine_set_block_hook(audio_block_hook_t hook);
+
+/** @brief Gain (Q15) et panoramique d’une piste. */
+void audio_engine_set_track(uint8_t track, int16_t gain_q15, int8_t pan);
+
+/** @brief Gain master (Q15). */
+void audio_engine_set_master(int16_t gain_q15);
+
+void audio_engine_get_stats(audio_stats_t *stats);
+void audio_engine_stats_reset(void);
+
+#endif /* AUDIO_ENGINE_H */
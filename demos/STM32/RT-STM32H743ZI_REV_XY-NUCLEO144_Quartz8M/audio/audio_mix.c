@@ -0,0 +1,118 @@
+/**
+ * @file audio_mix.c
+ * @brief Mixage Q15 → Q31 : version SMLALD (Cortex-M7) et version C.
+ *
+ * Échelle : produit Q15 × Q15 = Q30 accumulé sur 64 bits ; le master
+ * (Q15) donne du Q45 ramené en Q31 : out = sat32((acc × master) >> 14).
+ * 16 canaux pleine échelle : |acc| < 2^34, |acc × master| < 2^49.
+ *
+ * @ingroup audio
+ */
+
+#include <string.h>
+#include "audio_mix.h"
+
+#if AUDIO_MIX_USE_DSP
+#include "cmsis_compiler.h"
+#endif
+
+BRICK_STATIC_ASSERT(BRICK_CART_AUDIO_CHANNELS == 4, audio_mix_four_channels);
+
+/* cos(i / 128 × π/2) en Q15 : gauche = cos(θ), droite = sin(θ) = cos(128 − i). */
+static const int16_t pan_cos[129] = {
+  32767, 32765, 32757, 32745, 32728, 32705, 32678, 32646, 32609, 32567, 32521, 32469,
+  32412, 32351, 32285, 32213, 32137, 32057, 31971, 31880, 31785, 31685, 31580, 31470,
+  31356, 31237, 31113, 30985, 30852, 30714, 30571, 30424, 30273, 30117, 29956, 29791,
+  29621, 29447, 29268, 29085, 28898, 28706, 28510, 28310, 28105, 27896, 27683, 27466,
+  27245, 27019, 26790, 26556, 26319, 26077, 25832, 25582, 25329, 25072, 24811, 24547,
+  24279, 24007, 23731, 23452, 23170, 22884, 22594, 22301, 22005, 21705, 21403, 21096,
+  20787, 20475, 20159, 19841, 19519, 19195, 18868, 18537, 18204, 17869, 17530, 17189,
+  16846, 16499, 16151, 15800, 15446, 15090, 14732, 14372, 14010, 13645, 13279, 12910,
+  12539, 12167, 11793, 11417, 11039, 10659, 10278,  9896,  9512,  9126,  8739,  8351,
+   7962,  7571,  7179,  6786,  6393,  5998,  5602,  5205,  4808,  4410,  4011,  3612,
+   3212,  2811,  2410,  2009,  1608,  1206,   804,   402,     0
+};
+
+void audio_pan_gains(int16_t gain_q15, int8_t pan, int16_t *gl, int16_t *gr) {
+  int32_t p = (int32_t)pan - AUDIO_PAN_LEFT;
+
+  if (p < 0) {
+    p = 0;
+  } else if (p > 128) {
+    p = 128;
+  }
+  *gl = (int16_t)(((int32_t)gain_q15 * pan_cos[p]) >> 15);
+  *gr = (int16_t)(((int32_t)gain_q15 * pan_cos[128 - p]) >> 15);
+}
+
+void audio_cart_gains_set(audio_cart_gains_t *g, uint8_t ch, int16_t gl, int16_t gr) {
+  const uint32_t shift = (ch & 1U) * 16U;
+  const uint32_t mask = 0xFFFFU << shift;
+  const uint8_t w = (uint8_t)(ch / 2U);
+
+  g->l[w] = (g->l[w] & ~mask) | (((uint32_t)(uint16_t)gl) << shift);
+  g->r[w] = (g->r[w] & ~mask) | (((uint32_t)(uint16_t)gr) << shift);
+}
+
+static inline int32_t to_q31(int64_t acc, int16_t master) {
+  const int64_t v = (acc * master) >> 14;
+
+  if (v > INT32_MAX) {
+    return INT32_MAX;
+  }
+  if (v < INT32_MIN) {
+    return INT32_MIN;
+  }
+  return (int32_t)v;
+}
+
+void audio_mix_block(const int16_t *const in[BRICK_MAX_CARTRIDGES],
+                     const audio_cart_gains_t gains[BRICK_MAX_CARTRIDGES],
+                     int16_t master, int32_t *out, size_t stride, size_t frames) {
+  const int16_t *src[BRICK_MAX_CARTRIDGES];
+  const audio_cart_gains_t *g[BRICK_MAX_CARTRIDGES];
+  size_t n = 0U;
+
+  /* Cartouches actives uniquement : la boucle interne n’a pas de test. */
+  for (size_t c = 0U; c < BRICK_MAX_CARTRIDGES; c++) {
+    if (in[c] != NULL) {
+      src[n] = in[c];
+      g[n] = &gains[c];
+      n++;
+    }
+  }
+
+  for (size_t f = 0U; f < frames; f++) {
+#if AUDIO_MIX_USE_DSP
+    uint64_t al = 0U;
+    uint64_t ar = 0U;
+
+    for (size_t c = 0U; c < n; c++) {
+      uint32_t w01, w23;
+      memcpy(&w01, &src[c][f * BRICK_CART_AUDIO_CHANNELS], sizeof(w01));
+      memcpy(&w23, &src[c][f * BRICK_CART_AUDIO_CHANNELS + 2U], sizeof(w23));
+      al = __SMLALD(w01, g[c]->l[0], al);
+      al = __SMLALD(w23, g[c]->l[1], al);
+      ar = __SMLALD(w01, g[c]->r[0], ar);
+      ar = __SMLALD(w23, g[c]->r[1], ar);
+    }
+    out[f * stride]      = to_q31((int64_t)al, master);
+    out[f * stride + 1U] = to_q31((int64_t)ar, master);
+#else
+    int64_t al = 0;
+    int64_t ar = 0;
+
+    for (size_t c = 0U; c < n; c++) {
+      const int16_t *s = &src[c][f * BRICK_CART_AUDIO_CHANNELS];
+      for (uint32_t k = 0U; k < BRICK_CART_AUDIO_CHANNELS; k++) {
+        const uint32_t w = k / 2U;
+        const uint32_t shift = (k & 1U) * 16U;
+        al += (int32_t)s[k] * (int16_t)(g[c]->l[w] >> shift);
+        ar += (int32_t)s[k] * (int16_t)(g[c]->r[w] >> shift);
+      }
+    }
+    out[f * stride]      = to_q31(al, master);
+    out[f * stride + 1U] = to_q31(ar, master);
+#endif
+  }
+}
@@ -0,0 +1,78 @@
+/**
+ * @file audio_mix.h
+ * @brief Noyaux de mixage en virgule fixe (cartouches → bus master stéréo).
+ *
+ * Formats :
+ * - **entrée** : un bloc par cartouche, `int16_t [trames][4]` Q15 entrelacé
+ *   (ordre du flux cartouche : canal 0, 1, 2, 3 pour chaque trame) ;
+ * - **gains** : par cartouche, gauche/droite de chaque canal en Q15, rangés
+ *   par paires dans des mots de 32 bits (canal pair en poids faible) ;
+ * - **sortie** : L/R en Q31 saturé, avec un pas de @p stride mots par trame
+ *   (slots SAI).
+ *
+ * Sur Cortex-M7 (`__ARM_FEATURE_DSP`), un mot chargé contient deux canaux et
+ * chaque `SMLALD` fait deux produits Q15 × Q15 accumulés sur 64 bits : aucun
+ * débordement possible quels que soient les gains. Sinon, même calcul en C.
+ *
+ * Aucun état, aucune dépendance RTOS : appelable depuis l’IRQ audio et
+ * compilable sur l’hôte.
+ *
+ * @ingroup audio
+ */
+
+#ifndef AUDIO_MIX_H
+#define AUDIO_MIX_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "brick_config.h"
+
+/** @brief Noyaux SIMD (SMLALD) ; 0 force la version C portable. */
+#ifndef AUDIO_MIX_USE_DSP
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+#define AUDIO_MIX_USE_DSP       1
+#else
+#define AUDIO_MIX_USE_DSP       0
+#endif
+#endif
+
+#define AUDIO_Q15_ONE           32767
+
+/** @brief Position de panoramique : -64 (gauche) … 0 (centre) … +64 (droite). */
+#define AUDIO_PAN_LEFT          (-64)
+#define AUDIO_PAN_RIGHT         64
+
+/**
+ * @struct audio_cart_gains_t
+ * @brief Gains d’une cartouche, paires Q15 prêtes pour `SMLALD`.
+ */
+typedef struct {
+  uint32_t l[BRICK_CART_AUDIO_CHANNELS / 2U];   /**< (g0 | g1 << 16), (g2 | g3 << 16) */
+  uint32_t r[BRICK_CART_AUDIO_CHANNELS / 2U];
+} audio_cart_gains_t;
+
+/**
+ * @brief Gains gauche/droite d’une piste, panoramique à puissance constante.
+ * @param gain_q15 Gain de la piste (Q15, 0 … @ref AUDIO_Q15_ONE).
+ * @param pan      @ref AUDIO_PAN_LEFT … @ref AUDIO_PAN_RIGHT (borné).
+ */
+void audio_pan_gains(int16_t gain_q15, int8_t pan, int16_t *gl, int16_t *gr);
+
+/** @brief Range le gain d’un canal dans les paires de la cartouche. */
+void audio_cart_gains_set(audio_cart_gains_t *g, uint8_t ch, int16_t gl, int16_t gr);
+
+/**
+ * @brief Mixe les cartouches sur le bus stéréo et écrit le bloc de sortie.
+ * @param in       Bloc de chaque cartouche (NULL : silencieuse).
+ * @param gains    Gains de chaque cartouche.
+ * @param master   Gain master (Q15).
+ * @param out      Sortie : out[f × stride] = L, out[f × stride + 1] = R.
+ * @param stride   Mots par trame de sortie (≥ 2).
+ * @param frames   Nombre de trames.
+ */
+void audio_mix_block(const int16_t *const in[BRICK_MAX_CARTRIDGES],
+                     const audio_cart_gains_t gains[BRICK_MAX_CARTRIDGES],
+                     int16_t master, int32_t *out, size_t stride, size_t frames);
+
+#endif /* AUDIO_MIX_H */
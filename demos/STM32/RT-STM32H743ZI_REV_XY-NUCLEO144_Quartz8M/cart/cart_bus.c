@@ -0,0 +1,306 @@
+/**
+ * @file cart_bus.c
+ * @brief SPI1 / SPI3 / SPI5 / SPI6 maîtres, un échange DMA par trame audio.
+ *
+ * Cartouche → SPI : 0 → SPI1, 1 → SPI3, 2 → SPI5, 3 → SPI6 (broches et NSS
+ * logiciel configurés par le board). SPI6 est servi par le BDMA, qui ne voit
+ * que la SRAM4 : tous les tampons d’échange sont en `.ram4`. La SRAM4 est
+ * cacheable (D-Cache actif) : la trame TX est nettoyée avant chaque échange
+ * et le tampon RX invalidé avant et après, chaque tampon occupant des lignes
+ * de cache entières.
+ *
+ * Horloges noyau : SPI123 = PLL1_Q 80 MHz, SPI5 = PCLK2 et SPI6 = PCLK4
+ * 100 MHz ; MBR /8 → 10 à 12,5 MHz, soit ~110 µs pour une trame de
+ * @ref CART_BUS_XFER_BYTES octets, sur 333 µs de bloc audio.
+ *
+ * Les tampons RX sont doublés : le DMA remplit l’un pendant que le mixeur lit
+ * le dernier reçu. Début de trame (IRQ audio) et fins d’échange (IRQ SPI)
+ * sont sérialisés par le verrou système.
+ *
+ * @ingroup cart
+ */
+
+#include <string.h>
+#include "ch.h"
+#include "hal.h"
+#include "cart_bus.h"
+
+#if HAL_USE_SPI != TRUE || SPI_SELECT_MODE != SPI_SELECT_MODE_PAD
+#error "cart_bus.c requiert HAL_USE_SPI = TRUE et SPI_SELECT_MODE_PAD"
+#endif
+
+BRICK_STATIC_ASSERT(BRICK_SPI_PER_CARTRIDGE == 1, one_spi_per_cartridge);
+BRICK_STATIC_ASSERT(BRICK_MAX_CARTRIDGES == 4, cart_bus_maps_four_spi);
+
+/* ====================================================================== */
+/*                                 ÉTAT                                   */
+/* ====================================================================== */
+
+/* Pas des tampons DMA : arrondi à la ligne de cache (32 octets), pour que la
+   maintenance d’un tampon ne touche jamais son voisin. */
+#define CART_BUS_BUF_BYTES  ((CART_BUS_XFER_BYTES + 31U) & ~31U)
+
+static uint8_t cart_tx[BRICK_MAX_CARTRIDGES][CART_BUS_BUF_BYTES]
+    __attribute__((section(".ram4"), aligned(32)));
+static uint8_t cart_rx[BRICK_MAX_CARTRIDGES][2][CART_BUS_BUF_BYTES]
+    __attribute__((section(".ram4"), aligned(32)));
+
+static cart_ring_t cart_rings[BRICK_MAX_CARTRIDGES];
+
+static uint8_t  rx_fill[BRICK_MAX_CARTRIDGES];   /* Tampon RX en cours de DMA */
+static uint8_t  rx_ready[BRICK_MAX_CARTRIDGES];  /* Dernier tampon RX complet */
+static uint8_t  frame_seq;
+static uint8_t  busy_mask;
+static uint8_t  present_mask;
+static bool     bus_running;
+static rtcnt_t  frame_t0;
+
+static event_source_t cart_bus_es;
+static cart_bus_stats_t cart_stats;
+
+/* ====================================================================== */
+/*                        CONFIGURATION MATÉRIELLE                        */
+/* ====================================================================== */
+
+static void cart_spi_done_cb(SPIDriver *spip);
+static void cart_spi_error_cb(SPIDriver *spip);
+
+#define CART_SPI_CFG(port, pad) {                                   \
+  .circular = false,                                                \
+  .slave    = false,                                                \
+  .data_cb  = cart_spi_done_cb,                                     \
+  .error_cb = cart_spi_error_cb,                                    \
+  .ssport   = (port),                                               \
+  .sspad    = (pad),                                                \
+  .cfg1     = SPI_CFG1_MBR_1 | SPI_CFG1_DSIZE_VALUE(7),             \
+  .cfg2     = SPI_CFG2_MASTER | SPI_CFG2_SSM                        \
+}
+
+static const SPIConfig cart_spi_cfg[BRICK_MAX_CARTRIDGES] = {
+  CART_SPI_CFG(GPIOG, GPIOG_SPI1_CS),
+  CART_SPI_CFG(GPIOB, GPIOB_SPI3_CS),
+  CART_SPI_CFG(GPIOE, GPIOE_SPI5_CS),
+  CART_SPI_CFG(GPIOD, GPIOD_SPI6_CS)
+};
+
+static SPIDriver *const cart_spi[BRICK_MAX_CARTRIDGES] = {
+  &SPID1, &SPID3, &SPID5, &SPID6
+};
+
+/* ====================================================================== */
+/*                                  IRQ                                   */
+/* ====================================================================== */
+
+static uint8_t cart_of(SPIDriver *spip) {
+  uint8_t c = 0U;
+  while (c < BRICK_MAX_CARTRIDGES - 1U && cart_spi[c] != spip) {
+    c++;
+  }
+  return c;
+}
+
+/* Fin d’échange d’une cartouche ; la dernière diffuse l’événement. */
+static void cart_xfer_end(uint8_t c, bool ok) {
+  const uint8_t bit = (uint8_t)(1U << c);
+
+  chSysLockFromISR();
+  spiUnselectI(cart_spi[c]);
+  /* Lignes éventuellement chargées par spéculation pendant le DMA. */
+  cacheBufferInvalidate(cart_rx[c][rx_fill[c]], CART_BUS_BUF_BYTES);
+  if (ok && cart_rx[c][rx_fill[c]][0] == CART_BUS_SYNC_RX) {
+    rx_ready[c] = rx_fill[c];
+    present_mask |= bit;
+  }
+  else if ((present_mask & bit) != 0U) {
+    present_mask &= (uint8_t)~bit;
+    cart_ring_clear(&cart_rings[c]);  /* rien ne sera rejoué à l’insertion */
+  }
+  busy_mask &= (uint8_t)~bit;
+  if (busy_mask == 0U) {
+    const uint32_t dt = (uint32_t)(chSysGetRealtimeCounterX() - frame_t0);
+    if (dt > cart_stats.xfer_cycles_max) {
+      cart_stats.xfer_cycles_max = dt;
+    }
+    chEvtBroadcastFlagsI(&cart_bus_es, CART_BUS_EVT_FRAME_DONE);
+  }
+  chSysUnlockFromISR();
+}
+
+static void cart_spi_done_cb(SPIDriver *spip) {
+  cart_xfer_end(cart_of(spip), true);
+}
+
+static void cart_spi_error_cb(SPIDriver *spip) {
+  const uint8_t c = cart_of(spip);
+
+  chSysLockFromISR();
+  cart_stats.spi_errors++;
+  (void)spiStopTransferI(spip, NULL);
+  chSysUnlockFromISR();
+  cart_xfer_end(c, false);
+}
+
+/* Prépare la trame TX de la cartouche c (verrou système tenu). */
+static void cart_fill_tx(uint8_t c) {
+  uint8_t *tx = cart_tx[c];
+  size_t n = 0U;
+
+  if ((present_mask & (1U << c)) != 0U) {
+    n = cart_ring_pop(&cart_rings[c], (cart_cmd_t *)&tx[CART_BUS_HDR_BYTES],
+                      CART_BUS_FRAME_CMDS);
+  }
+  tx[0] = CART_BUS_SYNC_TX;
+  tx[1] = frame_seq;
+  tx[2] = (uint8_t)n;
+  tx[3] = 0U;
+  /* NOP = 0 : le reste de la trame est remis à zéro. */
+  memset(&tx[CART_BUS_HDR_BYTES + n * sizeof(cart_cmd_t)], 0,
+         CART_BUS_XFER_BYTES - CART_BUS_HDR_BYTES - n * sizeof(cart_cmd_t));
+  cart_stats.cmds += (uint32_t)n;
+}
+
+void cart_bus_frame_start(void) {
+  chSysLockFromISR();
+  if (bus_running) {
+    frame_t0 = chSysGetRealtimeCounterX();
+    frame_seq++;
+    cart_stats.frames++;
+    for (uint8_t c = 0U; c < BRICK_MAX_CARTRIDGES; c++) {
+      const uint8_t bit = (uint8_t)(1U << c);
+      if ((busy_mask & bit) != 0U) {
+        cart_stats.overruns++;
+        continue;
+      }
+      cart_fill_tx(c);
+      rx_fill[c] = (uint8_t)(rx_ready[c] ^ 1U);
+      busy_mask |= bit;
+      cacheBufferFlush(cart_tx[c], CART_BUS_BUF_BYTES);
+      cacheBufferInvalidate(cart_rx[c][rx_fill[c]], CART_BUS_BUF_BYTES);
+      spiSelectI(cart_spi[c]);
+      (void)spiStartExchangeI(cart_spi[c], CART_BUS_XFER_BYTES,
+                              cart_tx[c], cart_rx[c][rx_fill[c]]);
+    }
+  }
+  chSysUnlockFromISR();
+}
+
+const int16_t *cart_bus_audio_input(uint8_t cart) {
+  if (cart >= BRICK_MAX_CARTRIDGES || (present_mask & (1U << cart)) == 0U) {
+    return NULL;
+  }
+  return (const int16_t *)(const void *)&cart_rx[cart][rx_ready[cart]][CART_BUS_HDR_BYTES];
+}
+
+/* ====================================================================== */
+/*                                  API                                   */
+/* ====================================================================== */
+
+void cart_bus_init(void) {
+  for (uint8_t c = 0U; c < BRICK_MAX_CARTRIDGES; c++) {
+    cart_ring_init(&cart_rings[c]);
+    rx_fill[c] = 0U;
+    rx_ready[c] = 1U;
+  }
+  memset(cart_rx, 0, sizeof(cart_rx));
+  frame_seq = 0U;
+  busy_mask = 0U;
+  present_mask = 0U;
+  bus_running = false;
+  chEvtObjectInit(&cart_bus_es);
+  cart_stats = (cart_bus_stats_t){0};
+}
+
+void cart_bus_start(void) {
+  for (uint8_t c = 0U; c < BRICK_MAX_CARTRIDGES; c++) {
+    spiStart(cart_spi[c], &cart_spi_cfg[c]);
+    spiUnselect(cart_spi[c]);
+  }
+  osalSysLock();
+  bus_running = true;
+  osalSysUnlock();
+}
+
+void cart_bus_stop(void) {
+  osalSysLock();
+  bus_running = false;
+  osalSysUnlock();
+
+  /* Laisse finir la trame en cours (une trame < 1 ms). */
+  while (__atomic_load_n(&busy_mask, __ATOMIC_RELAXED) != 0U) {
+    chThdSleepMilliseconds(1);
+  }
+  for (uint8_t c = 0U; c < BRICK_MAX_CARTRIDGES; c++) {
+    spiStop(cart_spi[c]);
+  }
+}
+
+bool cart_bus_param(uint8_t cart, uint8_t voice, uint8_t param, uint16_t value) {
+  bool ok = false;
+
+  if (cart >= BRICK_MAX_CARTRIDGES) {
+    return false;
+  }
+  osalSysLock();
+  if ((present_mask & (1U << cart)) != 0U) {
+    ok = cart_ring_param(&cart_rings[cart], voice, param, value);
+  }
+  osalSysUnlock();
+  return ok;
+}
+
+bool cart_bus_note(uint8_t cart, uint8_t voice, uint8_t note, uint8_t velocity, bool on) {
+  bool ok = false;
+
+  if (cart >= BRICK_MAX_CARTRIDGES) {
+    return false;
+  }
+  osalSysLock();
+  if ((present_mask & (1U << cart)) != 0U) {
+    ok = cart_ring_note(&cart_rings[cart], voice, note, velocity, on);
+  }
+  osalSysUnlock();
+  return ok;
+}
+
+void cart_bus_seq_sink(uint8_t cart, const seq_event_t *ev) {
+  const uint8_t voice = (uint8_t)(ev->track % BRICK_MAX_VOICES_PER_CART);
+
+  switch (ev->type) {
+  case SEQ_EV_NOTE_ON:
+  case SEQ_EV_NOTE_OFF:
+    (void)cart_bus_note(cart, voice, ev->a, ev->b, ev->type == SEQ_EV_NOTE_ON);
+    break;
+  case SEQ_EV_PLOCK:
+    (void)cart_bus_param(cart, voice, ev->a, ev->value);
+    break;
+  default:
+    break;
+  }
+}
+
+event_source_t *cart_bus_event_source(void) {
+  return &cart_bus_es;
+}
+
+void cart_bus_get_stats(cart_bus_stats_t *stats) {
+  osalSysLock();
+  *stats = cart_stats;
+  stats->coalesced = 0U;
+  stats->drops = 0U;
+  for (uint8_t c = 0U; c < BRICK_MAX_CARTRIDGES; c++) {
+    stats->coalesced += cart_rings[c].coalesced;
+    stats->drops += cart_rings[c].drops;
+  }
+  stats->present = present_mask;
+  osalSysUnlock();
+}
+
+void cart_bus_stats_reset(void) {
+  osalSysLock();
+  cart_stats = (cart_bus_stats_t){0};
+  for (uint8_t c = 0U; c < BRICK_MAX_CARTRIDGES; c++) {
+    cart_rings[c].coalesced = 0U;
+    cart_rings[c].drops = 0U;
+  }
+  osalSysUnlock();
+}
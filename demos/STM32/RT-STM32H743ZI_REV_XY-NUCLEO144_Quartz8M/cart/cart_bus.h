@@ -0,0 +1,125 @@
+/**
+ * @file cart_bus.h
+ * @brief Bus cartouches : 4 liens SPI en DMA, une trame par bloc audio.
+ *
+ * Chaque cartouche a son SPI (@ref BRICK_SPI_PER_CARTRIDGE) et sa file de
+ * commandes (`cart_ring.h`). Au début de chaque bloc audio, depuis l’IRQ
+ * audio, les quatre échanges full-duplex sont lancés ensemble et tournent en
+ * parallèle :
+ * - **TX** : en-tête + au plus @ref CART_BUS_FRAME_CMDS commandes, complété
+ *   par des NOP (longueur fixe, durée d’échange fixe) ;
+ * - **RX** : en-tête d’état + bloc audio de la cartouche
+ *   (`int16_t [BRICK_AUDIO_FRAME_SAMPLES][4]`), servi au mixeur au bloc
+ *   suivant via @ref cart_bus_audio_input.
+ *
+ * La latence de contrôle est donc bornée à une trame quel que soit le nombre
+ * de p-locks d’un pas : les écritures répétées d’un même paramètre sont
+ * fusionnées dans la file, le reste attend la trame suivante.
+ *
+ * Fin d’échange : un seul événement, @ref CART_BUS_EVT_FRAME_DONE diffusé sur
+ * @ref cart_bus_event_source quand les quatre transferts sont terminés.
+ *
+ * Une cartouche est « présente » tant que son en-tête RX est valide ; ses
+ * commandes ne sont retirées de la file que si elle l’était à la trame
+ * précédente, et la file est vidée quand elle disparaît.
+ *
+ * @ingroup cart
+ */
+
+#ifndef CART_BUS_H
+#define CART_BUS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "ch.h"
+#include "cart_ring.h"
+#include "seq_engine.h"
+
+/* ====================================================================== */
+/*                             CONFIGURATION                              */
+/* ====================================================================== */
+
+/** @brief Commandes par trame TX. */
+#ifndef CART_BUS_FRAME_CMDS
+#define CART_BUS_FRAME_CMDS     32U
+#endif
+
+#define CART_BUS_HDR_BYTES      4U
+#define CART_BUS_SYNC_TX        0xA5U
+#define CART_BUS_SYNC_RX        0x5AU
+
+#define CART_BUS_AUDIO_BYTES    (BRICK_AUDIO_FRAME_SAMPLES * BRICK_CART_AUDIO_CHANNELS * 2U)
+#define CART_BUS_TX_BYTES       (CART_BUS_HDR_BYTES + CART_BUS_FRAME_CMDS * 4U)
+#define CART_BUS_RX_BYTES       (CART_BUS_HDR_BYTES + CART_BUS_AUDIO_BYTES)
+
+/** @brief Longueur d’un échange (TX et RX complétés à la même taille). */
+#define CART_BUS_XFER_BYTES     (CART_BUS_TX_BYTES > CART_BUS_RX_BYTES ? \
+                                 CART_BUS_TX_BYTES : CART_BUS_RX_BYTES)
+
+/** @brief Drapeau diffusé quand les échanges de la trame sont terminés. */
+#define CART_BUS_EVT_FRAME_DONE ((eventflags_t)1U)
+
+/* ====================================================================== */
+/*                                 TYPES                                  */
+/* ====================================================================== */
+
+/**
+ * @struct cart_bus_stats_t
+ * @brief Statistiques du bus.
+ */
+typedef struct {
+  uint32_t frames;          /**< Trames lancées */
+  uint32_t cmds;            /**< Commandes envoyées */
+  uint32_t coalesced;       /**< Écritures fusionnées (toutes cartouches) */
+  uint32_t drops;           /**< Commandes perdues (file pleine) */
+  uint32_t overruns;        /**< Échanges encore en cours au début de trame */
+  uint32_t spi_errors;      /**< Erreurs SPI / DMA */
+  uint32_t xfer_cycles_max; /**< Début de trame → fin du dernier échange (cycles) */
+  uint8_t  present;         /**< Bit c : cartouche c présente */
+} cart_bus_stats_t;
+
+/* ====================================================================== */
+/*                                  API                                   */
+/* ====================================================================== */
+
+/** @brief Files vides, aucune cartouche présente. */
+void cart_bus_init(void);
+
+/** @brief Démarre les quatre SPI (les échanges suivent les blocs audio). */
+void cart_bus_start(void);
+
+void cart_bus_stop(void);
+
+/**
+ * @brief Début de trame : lance les échanges terminés.
+ * @details Signature @ref audio_block_hook_t, à passer à
+ *          `audio_engine_set_block_hook()`. Contexte : IRQ.
+ */
+void cart_bus_frame_start(void);
+
+/**
+ * @brief Dernier bloc audio reçu d’une cartouche (NULL si absente).
+ * @details Signature @ref audio_input_t. Contexte : IRQ audio.
+ */
+const int16_t *cart_bus_audio_input(uint8_t cart);
+
+/** @brief Écrit un paramètre de voix. @return false si refusé. */
+bool cart_bus_param(uint8_t cart, uint8_t voice, uint8_t param, uint16_t value);
+
+/** @brief Note on/off sur une voix. @return false si refusée. */
+bool cart_bus_note(uint8_t cart, uint8_t voice, uint8_t note, uint8_t velocity, bool on);
+
+/**
+ * @brief Sortie du séquenceur (@ref seq_cart_sink_t) : voix = piste % 4,
+ *        NOTE_* → note, PLOCK → paramètre.
+ */
+void cart_bus_seq_sink(uint8_t cart, const seq_event_t *ev);
+
+/** @brief Source de @ref CART_BUS_EVT_FRAME_DONE. */
+event_source_t *cart_bus_event_source(void);
+
+void cart_bus_get_stats(cart_bus_stats_t *stats);
+void cart_bus_stats_reset(void);
+
+#endif /* CART_BUS_H */
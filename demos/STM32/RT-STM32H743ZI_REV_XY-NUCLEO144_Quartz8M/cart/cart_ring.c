@@ -0,0 +1,88 @@
+/**
+ * @file cart_ring.c
+ * @brief File de commandes cartouche : fusion en O(1) par (voix, paramètre).
+ *
+ * `last[v][p]` mémorise la position de la dernière écriture de (v, p). Elle
+ * est réutilisable si elle est encore dans la file ([tail, head)), après la
+ * barrière de la voix, et contient bien (PARAM, v, p) : une position périmée
+ * qui ne remplit pas ces trois conditions est simplement ignorée, il n’y a
+ * rien à invalider au retrait.
+ *
+ * @ingroup cart
+ */
+
+#include <string.h>
+#include "cart_ring.h"
+
+#define RING_MASK   (CART_RING_LEN - 1U)
+
+void cart_ring_init(cart_ring_t *r) {
+  memset(r, 0, sizeof(*r));
+}
+
+static bool ring_push(cart_ring_t *r, uint8_t op_voice, uint8_t param,
+                      uint16_t value) {
+  if (cart_ring_count(r) >= CART_RING_LEN) {
+    r->drops++;
+    return false;
+  }
+  cart_cmd_t *c = &r->cmds[r->head & RING_MASK];
+  c->op_voice = op_voice;
+  c->param = param;
+  c->value = value;
+  r->head++;
+  return true;
+}
+
+bool cart_ring_param(cart_ring_t *r, uint8_t voice, uint8_t param, uint16_t value) {
+  if (voice >= BRICK_MAX_VOICES_PER_CART || param >= CART_RING_PARAMS) {
+    return false;
+  }
+
+  const uint8_t  op_voice = CART_CMD_OP_VOICE(CART_OP_PARAM, voice);
+  const uint16_t count = cart_ring_count(r);
+  const uint16_t pos = r->last[voice][param];
+  const uint16_t rel = (uint16_t)(pos - r->tail);
+  uint16_t bar = (uint16_t)(r->barrier[voice] - r->tail);
+
+  if (bar > count) {
+    bar = 0U;                     /* barrière déjà envoyée */
+  }
+  if (rel < count && rel >= bar) {
+    cart_cmd_t *c = &r->cmds[pos & RING_MASK];
+    if (c->op_voice == op_voice && c->param == param) {
+      c->value = value;
+      r->coalesced++;
+      return true;
+    }
+  }
+
+  r->last[voice][param] = r->head;
+  return ring_push(r, op_voice, param, value);
+}
+
+bool cart_ring_note(cart_ring_t *r, uint8_t voice, uint8_t note,
+                    uint8_t velocity, bool on) {
+  if (voice >= BRICK_MAX_VOICES_PER_CART) {
+    return false;
+  }
+  if (!ring_push(r, CART_CMD_OP_VOICE(on ? CART_OP_NOTE_ON : CART_OP_NOTE_OFF, voice),
+                 note, velocity)) {
+    return false;
+  }
+  r->barrier[voice] = r->head;
+  return true;
+}
+
+size_t cart_ring_pop(cart_ring_t *r, cart_cmd_t *out, size_t max) {
+  size_t n = cart_ring_count(r);
+
+  if (n > max) {
+    n = max;
+  }
+  for (size_t i = 0U; i < n; i++) {
+    out[i] = r->cmds[r->tail & RING_MASK];
+    r->tail++;
+  }
+  return n;
+}
@@ -0,0 +1,117 @@
+/**
+ * @file cart_ring.h
+ * @brief File de commandes d’une cartouche, avec fusion des écritures de
+ *        paramètre.
+ *
+ * Une commande fait 4 octets, identique à son format sur le lien SPI :
+ * opération et voix, paramètre (ou note), valeur 16 bits little-endian.
+ *
+ * Fusion : tant qu’une écriture (voix, paramètre) n’a pas quitté la file, une
+ * nouvelle écriture du même paramètre remplace sa valeur au lieu d’ajouter une
+ * commande. Le nombre de commandes d’une trame est ainsi borné par le nombre
+ * de paramètres touchés, pas par le nombre de p-locks émis.
+ *
+ * Une note (on/off) est une barrière pour sa voix : une écriture postérieure
+ * ne fusionne jamais avec une écriture antérieure à la note, l’ordre
+ * paramètre → note → paramètre vu par la cartouche est préservé.
+ *
+ * Contexte d’appel : non réentrant ; le verrou est à la charge de l’appelant
+ * (`cart_bus.c` : verrou système, producteur thread, consommateur IRQ).
+ *
+ * @ingroup cart
+ */
+
+#ifndef CART_RING_H
+#define CART_RING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "brick_config.h"
+
+/* ====================================================================== */
+/*                             CONFIGURATION                              */
+/* ====================================================================== */
+
+/** @brief Capacité de la file (puissance de 2, ≤ 32768). */
+#ifndef CART_RING_LEN
+#define CART_RING_LEN           256U
+#endif
+
+/** @brief Paramètres adressables par voix (p-locks de son). */
+#define CART_RING_PARAMS        BRICK_MAX_PLOCKS_PER_STEP
+
+BRICK_STATIC_ASSERT((CART_RING_LEN & (CART_RING_LEN - 1U)) == 0U &&
+                    CART_RING_LEN <= 32768U, cart_ring_len_pow2);
+
+/* ====================================================================== */
+/*                                 TYPES                                  */
+/* ====================================================================== */
+
+/** @brief Opération (4 bits de poids fort de l’octet 0). */
+typedef enum {
+  CART_OP_NOP = 0,
+  CART_OP_PARAM,        /**< param = paramètre, value = valeur */
+  CART_OP_NOTE_ON,      /**< param = note, value = vélocité */
+  CART_OP_NOTE_OFF      /**< param = note, value = vélocité */
+} cart_op_t;
+
+/** @brief Commande, format fil. */
+typedef struct {
+  uint8_t  op_voice;    /**< op << 4 | voix */
+  uint8_t  param;       /**< Paramètre ou note */
+  uint16_t value;       /**< Valeur (little-endian sur le fil) */
+} cart_cmd_t;
+
+#define CART_CMD_OP_VOICE(op, voice) ((uint8_t)(((uint8_t)(op) << 4) | ((uint8_t)(voice) & 0x0FU)))
+
+/**
+ * @struct cart_ring_t
+ * @brief File d’une cartouche. Compteurs 16 bits libres (modulo 2^16).
+ */
+typedef struct {
+  cart_cmd_t cmds[CART_RING_LEN];
+  uint16_t   head;                  /**< Prochaine écriture */
+  uint16_t   tail;                  /**< Prochaine lecture */
+  /** Position de la dernière note de chaque voix (barrière de fusion). */
+  uint16_t   barrier[BRICK_MAX_VOICES_PER_CART];
+  /** Position de la dernière écriture de chaque (voix, paramètre). */
+  uint16_t   last[BRICK_MAX_VOICES_PER_CART][CART_RING_PARAMS];
+  uint32_t   coalesced;             /**< Écritures fusionnées */
+  uint32_t   drops;                 /**< Commandes perdues (file pleine) */
+} cart_ring_t;
+
+/* ====================================================================== */
+/*                                  API                                   */
+/* ====================================================================== */
+
+/** @brief File vide, compteurs à zéro. */
+void cart_ring_init(cart_ring_t *r);
+
+/** @brief Vide la file (compteurs conservés). */
+static inline void cart_ring_clear(cart_ring_t *r) {
+  r->tail = r->head;
+}
+
+/**
+ * @brief Écrit un paramètre de voix (fusionné si possible).
+ * @return false si les arguments sont hors bornes ou la file pleine.
+ */
+bool cart_ring_param(cart_ring_t *r, uint8_t voice, uint8_t param, uint16_t value);
+
+/**
+ * @brief Ajoute une note (jamais fusionnée).
+ * @return false si les arguments sont hors bornes ou la file pleine.
+ */
+bool cart_ring_note(cart_ring_t *r, uint8_t voice, uint8_t note,
+                    uint8_t velocity, bool on);
+
+/** @brief Retire jusqu’à @p max commandes, dans l’ordre ; retourne leur nombre. */
+size_t cart_ring_pop(cart_ring_t *r, cart_cmd_t *out, size_t max);
+
+static inline uint16_t cart_ring_count(const cart_ring_t *r) {
+  return (uint16_t)(r->head - r->tail);
+}
+
+#endif /* CART_RING_H */
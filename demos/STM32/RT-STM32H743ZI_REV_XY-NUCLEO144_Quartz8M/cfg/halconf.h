@@ -78,6 +78,7 @@
 
 #define HAL_USE_SDRAM           TRUE
 #define HAL_USE_FSMC            TRUE
+#define HAL_USE_QEI             TRUE
 /**
  * @brief   Enables the EFlash subsystem.
  */
@@ -180,7 +181,7 @@
  * @brief   Enables the SAI subsystem.
  */
 #if !defined(HAL_USE_SAI) || defined(__DOXYGEN__)
-#define HAL_USE_SAI                         FALSE
+#define HAL_USE_SAI                         TRUE
 #endif
 
 /**
@@ -573,6 +574,18 @@
 #define WSPI_USE_MUTUAL_EXCLUSION           TRUE
 #endif
 
+/*===========================================================================*/
+/* MFS (os/hal/lib/complex/mfs) related settings.                            */
+/*===========================================================================*/
+
+/**
+ * @brief   Record alignment, equal to the drv_flash write unit.
+ * @note    Each MFS program operation must start on a blank unit.
+ */
+#if !defined(MFS_CFG_MEMORY_ALIGNMENT) || defined(__DOXYGEN__)
+#define MFS_CFG_MEMORY_ALIGNMENT            8
+#endif
+
 #endif /* HALCONF_H */
 
 /** @} */
@@ -191,3 +191,142 @@ int brick_cal_pot_next(struct brick_cal_pot* cal, uint8_t channel, uint16_t in,
   *out = in;
   return 0;
 }
+
+int brick_cal_key_offset_get(struct brick_cal_key* cal, uint8_t channel, int16_t* offset) {
+  if (cal == NULL || offset == NULL || channel >= BRICK_NUM_HALL_SENSORS) {
+    return 1;
+  }
+
+  *offset = cal->offset[channel];
+  return 0;
+}
+
+int brick_cal_key_offset_set(struct brick_cal_key* cal, uint8_t channel, int16_t offset) {
+  if (cal == NULL || channel >= BRICK_NUM_HALL_SENSORS) {
+    return 1;
+  }
+
+  cal->offset[channel] = offset;
+  return 0;
+}
+
+int brick_cal_key_curve_set(struct brick_cal_key* cal, uint8_t channel, const uint8_t* curve) {
+  if (cal == NULL || channel >= BRICK_NUM_HALL_SENSORS) {
+    return 1;
+  }
+
+  if (curve == NULL) {
+    cal->curve_set[channel] = 0;
+    memset(cal->curve[channel], 0, BRICK_CAL_CURVE_LEN);
+    return 0;
+  }
+
+  memcpy(cal->curve[channel], curve, BRICK_CAL_CURVE_LEN);
+  cal->curve_set[channel] = 1;
+  return 0;
+}
+
+const uint8_t* brick_cal_key_curve_get(struct brick_cal_key* cal, uint8_t channel) {
+  if (cal == NULL || channel >= BRICK_NUM_HALL_SENSORS || !cal->curve_set[channel]) {
+    return NULL;
+  }
+
+  return cal->curve[channel];
+}
+
+static void rest_thresholds(struct brick_cal_rest* rest, uint8_t channel) {
+  uint16_t baseline = rest->baseline[channel];
+  uint32_t travel = (rest->pressed[channel] > baseline)
+                        ? (uint32_t)(rest->pressed[channel] - baseline)
+                        : 1U;
+  uint32_t on = baseline + ((travel * rest->on_q8) >> 8);
+  uint32_t hyst = (travel * rest->hyst_q8) >> 8;
+
+  if (on <= baseline) {
+    on = (uint32_t)baseline + 1U;
+  }
+  if (on > UINT16_MAX) {
+    on = UINT16_MAX;
+  }
+  rest->on[channel] = (uint16_t)on;
+  rest->off[channel] = (on - hyst > baseline) ? (uint16_t)(on - hyst) : baseline;
+}
+
+int brick_cal_rest_init(struct brick_cal_rest* rest, uint16_t baseline, uint16_t pressed,
+                        uint8_t shift, uint8_t on_q8, uint8_t hyst_q8) {
+  if (rest == NULL || hyst_q8 >= on_q8) {
+    return 1;
+  }
+
+  rest->shift = (shift > 15U) ? 15U : shift;
+  rest->on_q8 = on_q8;
+  rest->hyst_q8 = hyst_q8;
+
+  for (uint8_t i = 0; i < BRICK_NUM_HALL_SENSORS; ++i) {
+    rest->acc[i] = (int32_t)baseline << 15;
+    rest->baseline[i] = baseline;
+    rest->pressed[i] = pressed;
+    rest->primed[i] = 0;
+    rest_thresholds(rest, i);
+  }
+
+  return 0;
+}
+
+void brick_cal_rest_next(struct brick_cal_rest* rest, uint8_t channel, uint16_t value, bool gate) {
+  if (channel >= BRICK_NUM_HALL_SENSORS) {
+    return;
+  }
+
+  uint16_t baseline = rest->baseline[channel];
+
+  if (gate) {
+    if (value > rest->pressed[channel]) {
+      rest->pressed[channel] = value;
+      rest_thresholds(rest, channel);
+    }
+    return;
+  }
+
+  /* First reading below the on threshold seeds the baseline (a key held
+     at power-up is not mistaken for its rest level). */
+  if (!rest->primed[channel]) {
+    if (value < rest->on[channel]) {
+      rest->acc[channel] = (int32_t)value << 15;
+      rest->baseline[channel] = value;
+      rest->primed[channel] = 1;
+      rest_thresholds(rest, channel);
+    }
+    return;
+  }
+
+  /* Key on its way down: not a rest sample. */
+  if (value > baseline + ((rest->on[channel] - baseline) >> 1)) {
+    return;
+  }
+
+  rest->acc[channel] += (((int32_t)value << 15) - rest->acc[channel]) >> rest->shift;
+  uint16_t tracked = (uint16_t)((rest->acc[channel] + (1 << 14)) >> 15);
+  if (tracked != baseline) {
+    rest->baseline[channel] = tracked;
+    rest_thresholds(rest, channel);
+  }
+}
+
+int brick_cal_rest_get(struct brick_cal_rest* rest, uint8_t channel, uint16_t* baseline,
+                       uint16_t* on, uint16_t* off) {
+  if (rest == NULL || channel >= BRICK_NUM_HALL_SENSORS) {
+    return 1;
+  }
+
+  if (baseline != NULL) {
+    *baseline = rest->baseline[channel];
+  }
+  if (on != NULL) {
+    *on = rest->on[channel];
+  }
+  if (off != NULL) {
+    *off = rest->off[channel];
+  }
+  return 0;
+}
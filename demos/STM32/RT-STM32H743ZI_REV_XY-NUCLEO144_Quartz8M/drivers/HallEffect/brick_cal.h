@@ -32,8 +32,59 @@ int brick_cal_pot_min_get(struct brick_cal_pot* cal, uint8_t channel, uint16_t*
 int brick_cal_pot_max_get(struct brick_cal_pot* cal, uint8_t channel, uint16_t* max_value);
 int brick_cal_pot_next(struct brick_cal_pot* cal, uint8_t channel, uint16_t in, uint16_t* out);
 
+/*
+ * Per-key Hall sensor calibration: offset added to the raw reading and an
+ * optional velocity curve (raw velocity 0..127 -> output 0..127, see
+ * hall_velocity_set_curve()). A key without curve uses the linear mapping.
+ */
+#define BRICK_CAL_CURVE_LEN 128U
+
+struct brick_cal_key {
+  int16_t offset[BRICK_NUM_HALL_SENSORS];
+  uint8_t curve_set[BRICK_NUM_HALL_SENSORS];
+  uint8_t curve[BRICK_NUM_HALL_SENSORS][BRICK_CAL_CURVE_LEN];
+};
+
+int brick_cal_key_offset_get(struct brick_cal_key* cal, uint8_t channel, int16_t* offset);
+int brick_cal_key_offset_set(struct brick_cal_key* cal, uint8_t channel, int16_t offset);
+/* curve == NULL restores the linear mapping. */
+int brick_cal_key_curve_set(struct brick_cal_key* cal, uint8_t channel, const uint8_t* curve);
+/* Returns NULL for a linear key (or an invalid channel). */
+const uint8_t* brick_cal_key_curve_get(struct brick_cal_key* cal, uint8_t channel);
+
+/*
+ * Rest-baseline tracking for Hall keys. While a key's gate is closed and
+ * its reading stays in the lower half of the on distance, the idle level is
+ * followed by a slow EMA (time constant 2^shift samples, shift <= 15),
+ * which absorbs temperature drift and magnet tolerance. While the gate is open, the
+ * highest reading extends the key travel. On/off thresholds are derived
+ * from the baseline and the travel (pressed - baseline) as Q8 fractions,
+ * and are only recomputed when the baseline or the travel changes:
+ * brick_cal_rest_next() costs one EMA step per sample.
+ */
+struct brick_cal_rest {
+  int32_t acc[BRICK_NUM_HALL_SENSORS];      /* baseline, Q15 */
+  uint16_t baseline[BRICK_NUM_HALL_SENSORS];
+  uint16_t pressed[BRICK_NUM_HALL_SENSORS];
+  uint16_t on[BRICK_NUM_HALL_SENSORS];
+  uint16_t off[BRICK_NUM_HALL_SENSORS];
+  uint8_t primed[BRICK_NUM_HALL_SENSORS];
+  uint8_t shift;
+  uint8_t on_q8;
+  uint8_t hyst_q8;
+};
+
+/* on_q8 and hyst_q8 are fractions of the travel (x/256), hyst_q8 < on_q8. */
+int brick_cal_rest_init(struct brick_cal_rest* rest, uint16_t baseline, uint16_t pressed,
+                        uint8_t shift, uint8_t on_q8, uint8_t hyst_q8);
+void brick_cal_rest_next(struct brick_cal_rest* rest, uint8_t channel, uint16_t value, bool gate);
+int brick_cal_rest_get(struct brick_cal_rest* rest, uint8_t channel, uint16_t* baseline,
+                       uint16_t* on, uint16_t* off);
+
 struct brick_cal_model {
   struct brick_cal_pot potmeter;
+  struct brick_cal_key key;
+  struct brick_cal_rest rest;
 };
 
 extern struct brick_cal_model brick_cal_state;
@@ -0,0 +1,217 @@
+#include "brick_cal_store.h"
+
+#include "drv_flash.h"
+#include "hal_mfs.h"
+
+#include <string.h>
+
+#define STORE_KEYS      BRICK_NUM_HALL_SENSORS
+#define STORE_ID(k)     ((mfs_id_t)(BRICK_CAL_STORE_ID_BASE + (k)))
+
+/* Toutes les touches tiennent dans une transaction, chaque écriture MFS
+   commence sur une unité vierge de drv_flash. */
+BRICK_STATIC_ASSERT(STORE_KEYS <= MFS_CFG_TRANSACTION_MAX, cal_store_transaction);
+BRICK_STATIC_ASSERT(BRICK_CAL_STORE_ID_BASE + STORE_KEYS - 1U <= MFS_CFG_MAX_RECORDS,
+                    cal_store_ids);
+BRICK_STATIC_ASSERT(MFS_CFG_MEMORY_ALIGNMENT == DRV_FLASH_UNIT, cal_store_alignment);
+BRICK_STATIC_ASSERT(DRV_FLASH_SECTORS >= 2U, cal_store_banks);
+
+static MFSDriver mfs;
+static mfs_nocache_buffer_t mfs_buf;
+static MFSConfig mfs_cfg;
+static bool mounted = false;
+
+/* Dernier contenu connu en flash, par touche (taille 0 : absent). */
+static brick_cal_key_rec_t saved[STORE_KEYS];
+static uint8_t saved_size[STORE_KEYS];
+
+/* Enregistrements candidats d'une sauvegarde. */
+static brick_cal_key_rec_t pending[STORE_KEYS];
+static uint8_t pending_size[STORE_KEYS];
+
+static brick_cal_store_stats_t stats;
+
+/* ====================================================================== */
+/*                            ENREGISTREMENTS                             */
+/* ====================================================================== */
+
+static uint8_t rec_build(const struct brick_cal_model *cal, uint8_t k,
+                         brick_cal_key_rec_t *rec) {
+  memset(rec, 0, sizeof(*rec));
+  rec->version = BRICK_CAL_STORE_VERSION;
+  rec->flags = (uint8_t)((cal->potmeter.enable[k] ? BRICK_CAL_REC_ENABLE : 0U) |
+                         (cal->key.curve_set[k] ? BRICK_CAL_REC_CURVE : 0U));
+  rec->offset = cal->key.offset[k];
+  rec->min = cal->potmeter.min[k];
+  rec->max = cal->potmeter.max[k];
+  rec->detentlo = cal->potmeter.detentlo[k];
+  rec->detenthi = cal->potmeter.detenthi[k];
+
+  if ((rec->flags & BRICK_CAL_REC_CURVE) == 0U) {
+    return (uint8_t)BRICK_CAL_REC_BASE_SIZE;
+  }
+  memcpy(rec->curve, cal->key.curve[k], BRICK_CAL_CURVE_LEN);
+  return (uint8_t)sizeof(*rec);
+}
+
+static bool rec_valid(const brick_cal_key_rec_t *rec, size_t n) {
+  if (n < BRICK_CAL_REC_BASE_SIZE || rec->version != BRICK_CAL_STORE_VERSION) {
+    return false;
+  }
+  if ((rec->flags & BRICK_CAL_REC_CURVE) != 0U) {
+    return n == sizeof(*rec);
+  }
+  return n == BRICK_CAL_REC_BASE_SIZE;
+}
+
+static void rec_apply(struct brick_cal_model *cal, uint8_t k,
+                      const brick_cal_key_rec_t *rec) {
+  cal->potmeter.enable[k] = (rec->flags & BRICK_CAL_REC_ENABLE) ? 1U : 0U;
+  cal->potmeter.min[k] = rec->min;
+  cal->potmeter.max[k] = rec->max;
+  cal->potmeter.detentlo[k] = rec->detentlo;
+  cal->potmeter.detenthi[k] = rec->detenthi;
+  cal->key.offset[k] = rec->offset;
+  (void)brick_cal_key_curve_set(&cal->key, k,
+                                (rec->flags & BRICK_CAL_REC_CURVE) ? rec->curve : NULL);
+}
+
+/* ====================================================================== */
+/*                                  API                                   */
+/* ====================================================================== */
+
+bool brick_cal_store_start(void) {
+  if (mounted) {
+    return true;
+  }
+
+  BaseFlash *flashp = drv_flash_init();
+  if (flashp == NULL) {
+    stats.errors++;
+    return false;
+  }
+
+  /* Un secteur logique par banque MFS. */
+  mfs_cfg.flashp = flashp;
+  mfs_cfg.erased = 0xFFFFFFFFU;
+  mfs_cfg.bank_size = DRV_FLASH_LOGICAL_SECTOR;
+  mfs_cfg.bank0_start = 0U;
+  mfs_cfg.bank0_sectors = 1U;
+  mfs_cfg.bank1_start = 1U;
+  mfs_cfg.bank1_sectors = 1U;
+
+  mfsObjectInit(&mfs, &mfs_buf);
+  if (MFS_IS_ERROR(mfsStart(&mfs, &mfs_cfg))) {
+    stats.errors++;
+    return false;
+  }
+
+  memset(saved_size, 0, sizeof(saved_size));
+  mounted = true;
+  return true;
+}
+
+void brick_cal_store_stop(void) {
+  if (mounted) {
+    mfsStop(&mfs);
+    mounted = false;
+  }
+}
+
+uint8_t brick_cal_store_load(struct brick_cal_model *cal) {
+  uint8_t restored = 0U;
+
+  if (!mounted || cal == NULL) {
+    return 0U;
+  }
+
+  for (uint8_t k = 0U; k < STORE_KEYS; k++) {
+    brick_cal_key_rec_t rec;
+    size_t n = sizeof(rec);
+    const mfs_error_t err = mfsReadRecord(&mfs, STORE_ID(k), &n, (uint8_t *)&rec);
+
+    saved_size[k] = 0U;
+    if (MFS_IS_ERROR(err)) {
+      if (err != MFS_ERR_NOT_FOUND && err != MFS_ERR_INV_SIZE) {
+        stats.errors++;
+      }
+      continue;
+    }
+    if (!rec_valid(&rec, n)) {
+      continue;
+    }
+
+    rec_apply(cal, k, &rec);
+    saved[k] = rec;
+    saved_size[k] = (uint8_t)n;
+    restored++;
+  }
+
+  stats.restored = restored;
+  return restored;
+}
+
+int brick_cal_store_save(const struct brick_cal_model *cal) {
+  uint8_t dirty[STORE_KEYS];
+  uint8_t count = 0U;
+  size_t total = 0U;
+  mfs_error_t err;
+
+  if (!mounted || cal == NULL) {
+    return -1;
+  }
+
+  for (uint8_t k = 0U; k < STORE_KEYS; k++) {
+    const uint8_t n = rec_build(cal, k, &pending[k]);
+
+    pending_size[k] = n;
+    if (n == saved_size[k] && memcmp(&pending[k], &saved[k], n) == 0) {
+      stats.skipped++;
+      continue;
+    }
+    dirty[count++] = k;
+    total += sizeof(mfs_data_header_t) + MFS_ALIGN_NEXT(n);
+  }
+
+  if (count == 0U) {
+    return 0;
+  }
+
+  /* Tout ou rien : les « magic » ne sont scellés qu'au commit. */
+  err = mfsStartTransaction(&mfs, total);
+  if (MFS_IS_ERROR(err)) {
+    stats.errors++;
+    return -1;
+  }
+
+  for (uint8_t i = 0U; i < count; i++) {
+    const uint8_t k = dirty[i];
+
+    err = mfsWriteRecord(&mfs, STORE_ID(k), pending_size[k], (const uint8_t *)&pending[k]);
+    if (MFS_IS_ERROR(err)) {
+      (void)mfsRollbackTransaction(&mfs);
+      stats.errors++;
+      return -1;
+    }
+  }
+
+  err = mfsCommitTransaction(&mfs);
+  if (MFS_IS_ERROR(err)) {
+    stats.errors++;
+    return -1;
+  }
+
+  for (uint8_t i = 0U; i < count; i++) {
+    const uint8_t k = dirty[i];
+
+    saved[k] = pending[k];
+    saved_size[k] = pending_size[k];
+  }
+  stats.saves++;
+  stats.writes += count;
+  return count;
+}
+
+void brick_cal_store_get_stats(brick_cal_store_stats_t *out) {
+  *out = stats;
+}
@@ -0,0 +1,107 @@
+/**
+ * @file brick_cal_store.h
+ * @brief Calibration des touches persistée en flash interne (MFS).
+ *
+ * Un enregistrement MFS par touche (id = touche + 1) : structure packée et
+ * versionnée (@ref brick_cal_key_rec_t) avec offset, min/max, détentes,
+ * activation et, seulement si elle n'est pas linéaire, la courbe de
+ * vélocité.
+ *
+ * - Restauration : un mfsReadRecord() par touche, directement dans la
+ *   structure packée, puis copie dans le modèle @ref brick_cal_model.
+ *   Enregistrement absent, tronqué ou d'une autre version : la touche garde
+ *   ses valeurs par défaut.
+ * - Sauvegarde incrémentale : seules les touches dont l'enregistrement
+ *   diffère du dernier écrit (ou lu) sont réécrites, dans une transaction
+ *   MFS : après une coupure, soit toutes les touches modifiées sont à jour,
+ *   soit aucune. L'usure reste bornée : une sauvegarde sans changement
+ *   n'écrit rien, le ramasse-miettes MFS efface un secteur à la fois.
+ *
+ * Support : drv_flash (banque 2), flash en RAM en SIMULATOR.
+ * Contexte d'appel : thread non temps réel (programmation et effacement
+ * flash bloquants, jusqu'à ~1 s si MFS doit compacter).
+ */
+
+#ifndef BRICK_CAL_STORE_H
+#define BRICK_CAL_STORE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "brick_cal.h"
+
+/* ====================================================================== */
+/*                             CONFIGURATION                              */
+/* ====================================================================== */
+
+/** @brief Version du format d'enregistrement (incrémentée à chaque changement). */
+#define BRICK_CAL_STORE_VERSION       1U
+
+/** @brief Identifiant MFS de la touche 0 (les suivantes sont consécutives). */
+#define BRICK_CAL_STORE_ID_BASE       1U
+
+/* ====================================================================== */
+/*                                 TYPES                                  */
+/* ====================================================================== */
+
+#define BRICK_CAL_REC_ENABLE          0x01U   /**< Potentiomètre activé */
+#define BRICK_CAL_REC_CURVE           0x02U   /**< Courbe de vélocité présente */
+
+/**
+ * @struct brick_cal_key_rec_t
+ * @brief Enregistrement d'une touche tel qu'écrit en flash.
+ * @note  Sans courbe, seuls @ref BRICK_CAL_REC_BASE_SIZE octets sont écrits.
+ */
+typedef struct __attribute__((packed)) {
+  uint8_t  version;
+  uint8_t  flags;
+  int16_t  offset;
+  uint16_t min;
+  uint16_t max;
+  uint16_t detentlo;
+  uint16_t detenthi;
+  uint8_t  curve[BRICK_CAL_CURVE_LEN];
+} brick_cal_key_rec_t;
+
+#define BRICK_CAL_REC_BASE_SIZE       offsetof(brick_cal_key_rec_t, curve)
+
+typedef struct {
+  uint32_t restored;      /**< Touches restaurées au dernier chargement */
+  uint32_t saves;         /**< Sauvegardes ayant écrit au moins une touche */
+  uint32_t writes;        /**< Enregistrements écrits */
+  uint32_t skipped;       /**< Touches inchangées, non réécrites */
+  uint32_t errors;        /**< Erreurs MFS (montage, lecture, écriture) */
+} brick_cal_store_stats_t;
+
+/* ====================================================================== */
+/*                                  API                                   */
+/* ====================================================================== */
+
+/**
+ * @brief Monte le stockage (formate une flash vierge).
+ * @return false si la flash n'est pas utilisable : la calibration reste
+ *         alors en RAM uniquement.
+ */
+bool brick_cal_store_start(void);
+
+/** @brief Démonte le stockage (tests : simulation d'un redémarrage). */
+void brick_cal_store_stop(void);
+
+/**
+ * @brief Restaure chaque touche présente en flash dans @p cal.
+ * @return Nombre de touches restaurées.
+ */
+uint8_t brick_cal_store_load(struct brick_cal_model *cal);
+
+/**
+ * @brief Écrit les touches de @p cal qui ont changé depuis la dernière
+ *        sauvegarde ou le dernier chargement.
+ * @return Nombre d'enregistrements écrits (0 : rien à faire), -1 en cas
+ *         d'erreur (rien n'est validé).
+ */
+int brick_cal_store_save(const struct brick_cal_model *cal);
+
+void brick_cal_store_get_stats(brick_cal_store_stats_t *stats);
+
+#endif /* BRICK_CAL_STORE_H */
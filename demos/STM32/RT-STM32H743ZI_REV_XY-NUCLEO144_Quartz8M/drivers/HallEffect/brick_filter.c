@@ -0,0 +1,113 @@
+#include "brick_filter.h"
+
+#include <string.h>
+
+static uint8_t clamp_channels(uint8_t channels) {
+  return (channels > BRICK_FILTER_MAX_CHANNELS) ? (uint8_t)BRICK_FILTER_MAX_CHANNELS
+                                                : channels;
+}
+
+/* ====================================================================== */
+/*                            MOYENNE MOBILE                              */
+/* ====================================================================== */
+
+void brick_ma_init(brick_ma_t *f, uint8_t channels, uint8_t shift) {
+  if (f == NULL) {
+    return;
+  }
+  memset(f, 0, sizeof(*f));
+  f->channels = clamp_channels(channels);
+  f->shift = (shift > BRICK_FILTER_MA_MAX_SHIFT) ? (uint8_t)BRICK_FILTER_MA_MAX_SHIFT : shift;
+}
+
+bool brick_ma_process(brick_ma_t *f, const uint16_t *in, uint16_t *out) {
+  const uint8_t len = (uint8_t)(1U << f->shift);
+  const uint8_t n = f->channels;
+  uint16_t *row = f->hist[f->head];
+  uint32_t *sum = f->sum;
+
+  /* La ligne remplacée est la plus ancienne (zéros pendant le remplissage). */
+  for (uint8_t c = 0U; c < n; c++) {
+    const uint16_t x = in[c];
+    sum[c] += (uint32_t)x - row[c];
+    row[c] = x;
+  }
+  f->head = (uint8_t)((f->head + 1U) & (len - 1U));
+
+  if (f->count < len) {
+    const uint32_t count = ++f->count;
+    for (uint8_t c = 0U; c < n; c++) {
+      out[c] = (uint16_t)(sum[c] / count);
+    }
+    return count == len;
+  }
+
+  const uint8_t shift = f->shift;
+  for (uint8_t c = 0U; c < n; c++) {
+    out[c] = (uint16_t)(sum[c] >> shift);
+  }
+  return true;
+}
+
+/* ====================================================================== */
+/*                           PASSE-BAS 1 PÔLE                             */
+/* ====================================================================== */
+
+void brick_ema_init(brick_ema_t *f, uint8_t channels, uint8_t shift) {
+  if (f == NULL) {
+    return;
+  }
+  memset(f, 0, sizeof(*f));
+  f->channels = clamp_channels(channels);
+  f->shift = (shift > 15U) ? 15U : shift;
+}
+
+void brick_ema_process(brick_ema_t *f, const uint16_t *in, uint16_t *out) {
+  const uint8_t n = f->channels;
+  const uint8_t shift = f->shift;
+  int32_t *acc = f->acc;
+
+  if (!f->primed) {
+    for (uint8_t c = 0U; c < n; c++) {
+      acc[c] = (int32_t)in[c] << 8;
+    }
+    f->primed = true;
+  }
+
+  for (uint8_t c = 0U; c < n; c++) {
+    acc[c] += (((int32_t)in[c] << 8) - acc[c]) >> shift;
+    out[c] = (uint16_t)((acc[c] + 128) >> 8);
+  }
+}
+
+/* ====================================================================== */
+/*                                MÉDIANE                                 */
+/* ====================================================================== */
+
+void brick_median_init(brick_median_t *f, uint8_t channels, uint8_t size) {
+  if (f == NULL) {
+    return;
+  }
+  if (size < 3U) {
+    size = 3U;
+  }
+  if (size > BRICK_FILTER_MEDIAN_MAX) {
+    size = BRICK_FILTER_MEDIAN_MAX;
+  }
+  size |= 1U;
+
+  /* Paires à zéro : aucune n'est encore chaînée. */
+  memset(f->pairs, 0, sizeof(f->pairs));
+  f->channels = clamp_channels(channels);
+  for (uint8_t c = 0U; c < f->channels; c++) {
+    median_init(&f->m[c], 0U, f->pairs[c], size);
+  }
+}
+
+void brick_median_process(brick_median_t *f, const uint16_t *in, uint16_t *out) {
+  const uint8_t n = f->channels;
+
+  for (uint8_t c = 0U; c < n; c++) {
+    out[c] = median_filter(&f->m[c], in[c]);
+  }
+}
@@ -0,0 +1,120 @@
+/**
+ * @file brick_filter.h
+ * @brief Filtres de lissage par lot : tous les canaux d'un scan en un appel.
+ *
+ * Disposition « structure de tableaux » : l'historique est rangé par
+ * échantillon puis par canal (`hist[n][canal]`), une passe parcourt des
+ * tableaux contigus sans modulo ni division par canal.
+ *
+ * - Moyenne mobile 2^k (@ref brick_ma_t) : somme glissante, sortie par
+ *   décalage. Résultats identiques à brick_asc_process() avec factor = 2^k
+ *   (y compris pendant le remplissage, seul moment où une division reste).
+ * - Passe-bas à un pôle (@ref brick_ema_t) : y += (x - y) / 2^k, état en
+ *   virgule fixe Q8, amorcé sur le premier échantillon.
+ * - Médiane glissante (@ref brick_median_t) : `median_filter()` de
+ *   ChibiOS-Contrib par canal, pour rejeter les pointes isolées.
+ *
+ * Aucune allocation : les états sont des structures statiques de l'appelant.
+ * Contexte d'appel : non réentrant par filtre (un seul thread de scan).
+ */
+
+#ifndef BRICK_FILTER_H
+#define BRICK_FILTER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "brick_config.h"
+#include "median.h"
+
+/* ====================================================================== */
+/*                             CONFIGURATION                              */
+/* ====================================================================== */
+
+/** @brief Canaux par filtre (un scan Hall complet). */
+#ifndef BRICK_FILTER_MAX_CHANNELS
+#define BRICK_FILTER_MAX_CHANNELS     BRICK_NUM_HALL_SENSORS
+#endif
+
+/** @brief Longueur maximale de moyenne mobile : 2^BRICK_FILTER_MA_MAX_SHIFT. */
+#ifndef BRICK_FILTER_MA_MAX_SHIFT
+#define BRICK_FILTER_MA_MAX_SHIFT     4U
+#endif
+#define BRICK_FILTER_MA_MAX_LEN       (1U << BRICK_FILTER_MA_MAX_SHIFT)
+
+/** @brief Fenêtre maximale de médiane (impaire, ≥ 3). */
+#ifndef BRICK_FILTER_MEDIAN_MAX
+#define BRICK_FILTER_MEDIAN_MAX       5U
+#endif
+
+BRICK_STATIC_ASSERT(BRICK_FILTER_MAX_CHANNELS <= 255U, filter_channels_u8);
+BRICK_STATIC_ASSERT(BRICK_FILTER_MA_MAX_SHIFT <= 7U, filter_ma_len_u8);
+BRICK_STATIC_ASSERT((BRICK_FILTER_MEDIAN_MAX & 1U) == 1U &&
+                    BRICK_FILTER_MEDIAN_MAX >= 3U, filter_median_odd);
+
+/* ====================================================================== */
+/*                                 TYPES                                  */
+/* ====================================================================== */
+
+/**
+ * @struct brick_ma_t
+ * @brief Moyenne mobile sur 2^shift échantillons.
+ */
+typedef struct {
+  uint32_t sum[BRICK_FILTER_MAX_CHANNELS];
+  uint16_t hist[BRICK_FILTER_MA_MAX_LEN][BRICK_FILTER_MAX_CHANNELS];
+  uint8_t  channels;
+  uint8_t  shift;
+  uint8_t  head;          /**< Ligne d'historique à remplacer */
+  uint8_t  count;         /**< Échantillons reçus (≤ 2^shift) */
+} brick_ma_t;
+
+/**
+ * @struct brick_ema_t
+ * @brief Passe-bas à un pôle, constante 2^shift échantillons.
+ */
+typedef struct {
+  int32_t acc[BRICK_FILTER_MAX_CHANNELS];   /**< Sortie en Q8 */
+  uint8_t channels;
+  uint8_t shift;
+  bool    primed;
+} brick_ema_t;
+
+/**
+ * @struct brick_median_t
+ * @brief Médiane glissante sur @p size échantillons, par canal.
+ */
+typedef struct {
+  median_t m[BRICK_FILTER_MAX_CHANNELS];
+  pair_t   pairs[BRICK_FILTER_MAX_CHANNELS][BRICK_FILTER_MEDIAN_MAX];
+  uint8_t  channels;
+} brick_median_t;
+
+/* ====================================================================== */
+/*                                  API                                   */
+/* ====================================================================== */
+
+/**
+ * @brief Historique vide.
+ * @param shift Longueur 2^shift (borné à BRICK_FILTER_MA_MAX_SHIFT).
+ */
+void brick_ma_init(brick_ma_t *f, uint8_t channels, uint8_t shift);
+
+/**
+ * @brief Un scan : @p in et @p out ont @p channels valeurs (peuvent coïncider).
+ * @return true une fois la fenêtre pleine (comme brick_asc_process()).
+ */
+bool brick_ma_process(brick_ma_t *f, const uint16_t *in, uint16_t *out);
+
+void brick_ema_init(brick_ema_t *f, uint8_t channels, uint8_t shift);
+void brick_ema_process(brick_ema_t *f, const uint16_t *in, uint16_t *out);
+
+/**
+ * @brief Fenêtre de @p size échantillons (impaire, 3..BRICK_FILTER_MEDIAN_MAX).
+ * @note  La valeur 0 est lue comme 1 (0 sert de butée à median_filter()).
+ */
+void brick_median_init(brick_median_t *f, uint8_t channels, uint8_t size);
+void brick_median_process(brick_median_t *f, const uint16_t *in, uint16_t *out);
+
+#endif /* BRICK_FILTER_H */
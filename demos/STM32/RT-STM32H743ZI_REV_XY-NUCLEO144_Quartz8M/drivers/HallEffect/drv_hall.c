@@ -1,31 +1,55 @@
 #include "drv_hall.h"
+#include "hall_scan.h"
+#include "hall_events.h"
+#include "hall_velocity.h"
+#include "brick_cal.h"
+#include "brick_cal_store.h"
 
 #include "ch.h"
 #include "hal.h"
 
 #include <limits.h>
-
-#define ADC_NUM_CHANNELS        2
-#define ADC_DMA_DEPTH          16
+#include <string.h>
 
 #define HALL_SENSOR_COUNT       16U
-/* Paramètres réglables (échelle ADC 16-bit). */
-#define HALL_RAW_REST           36000U
-#define HALL_RAW_PRESSED        64000U
-#define HALL_ON_THRESHOLD       40000U
-#define HALL_HYSTERESIS         1500U
+/*
+ * Seuils par touche (échelle ADC 16-bit), suivis en ligne par
+ * brick_cal_state.rest : repos et course nominaux au démarrage, puis
+ * repos suivi par EMA porte fermée (dérive thermique) et course étendue
+ * par le maximum atteint porte ouverte. Seuil ON et hystérésis en
+ * fraction de la course (x/256) : 37 -> ~4000, 14 -> ~1500 au nominal.
+ */
+#define HALL_REST_NOMINAL       36000U
+#define HALL_PRESSED_NOMINAL    64000U
+#define HALL_ON_Q8              37U
+#define HALL_HYST_Q8            14U
+#define HALL_ON_NOMINAL \
+  (HALL_REST_NOMINAL + (((HALL_PRESSED_NOMINAL - HALL_REST_NOMINAL) * HALL_ON_Q8) >> 8))
+
+/* Constante de temps du suivi du repos : 2^14 trames (~10 s à ~1,5 kHz). */
+#ifndef HALL_REST_EMA_SHIFT
+#define HALL_REST_EMA_SHIFT     14U
+#endif
 
 /*
- * Vélocité par dérivée :
- *   deriv = d(value)/dt, exprimée en "counts par milliseconde".
- *   velocity = map(deriv, 0..HALL_DERIV_MAX_COUNTS_PER_MS) -> 1..127
- *
- * Ajuste HALL_DERIV_MAX_COUNTS_PER_MS après observation (logs) :
- * - frappe la plus rapide -> deriv_max_typique -> mets cette valeur ici.
+ * Vélocité par temps de vol (voir hall_velocity.h) :
+ *   seuil bas  = HALL_VEL_LOW_THRESHOLD
+ *   seuil haut = seuil ON de la touche (vélocité prête au NOTE ON)
+ * Les deux seuils sont décalés de (seuil ON de la touche - HALL_ON_NOMINAL).
+ * Le réglage HALL_DERIV_* (vitesse max, zone morte, temps max) est dans
+ * hall_velocity.h.
  */
-#define HALL_DERIV_MAX_COUNTS_PER_MS  1000U  /* à régler */
-#define HALL_DERIV_DV_DEAD_COUNTS     4U      /* ignore micro-variations */
-#define HALL_DERIV_DT_MAX_US          100000U  /* au-delà: on considère "trop lent" */
+#define HALL_VEL_LOW_THRESHOLD        37500U
+
+/* Écart minimal de pression (0..127) pour publier un événement PRESSURE. */
+#define HALL_PRESSURE_EVT_DELTA       2U
+
+/* Les courbes de brick_cal_state sont passées telles quelles à hall_velocity. */
+BRICK_STATIC_ASSERT(sizeof(hall_velocity_curve_t) == BRICK_CAL_CURVE_LEN, hall_curve_len);
+
+/* Thread de traitement des trames de scan (producteur d'événements). */
+#define HALL_THREAD_PRIO              (NORMALPRIO + 2)
+#define HALL_FRAME_WAIT_MS            10
 
 #define MUX_S0_PORT GPIOA
 #define MUX_S0_PIN  5
@@ -34,67 +58,22 @@
 #define MUX_S2_PORT GPIOA
 #define MUX_S2_PIN  6
 
-#define ADC_CH_MUXA   ADC_CHANNEL_IN4
-#define ADC_CH_MUXB   ADC_CHANNEL_IN7
-
-#define ADC_PCSEL     (ADC_SELMASK_IN4 | ADC_SELMASK_IN7)
-
-__attribute__((section(".ramd2")))
-static adcsample_t adc_buffer[ADC_DMA_DEPTH * ADC_NUM_CHANNELS];
-
 static uint16_t hall_values[HALL_SENSOR_COUNT];
 static bool hall_gate[HALL_SENSOR_COUNT];
-static bool hall_note_on[HALL_SENSOR_COUNT];
-static bool hall_note_off[HALL_SENSOR_COUNT];
 static uint8_t hall_velocity[HALL_SENSOR_COUNT];
 static uint8_t hall_pressure[HALL_SENSOR_COUNT];
+static uint8_t hall_pressure_sent[HALL_SENSOR_COUNT];
 static uint8_t hall_midi_value[HALL_SENSOR_COUNT];
-static int16_t hall_offsets[HALL_SENSOR_COUNT] = {0};
 static bool hall_initialized;
 
-/* Historique pour dérivée (par capteur). */
+/* Historique pour le temps de vol (par capteur). */
 static uint16_t hall_prev_value[HALL_SENSOR_COUNT];
-static systime_t hall_prev_time[HALL_SENSOR_COUNT];
+static rtcnt_t hall_prev_time[HALL_SENSOR_COUNT];
 
-static void adc_cb(ADCDriver *adcp) {
-  (void)adcp;
-}
+/* Dernière trame de scan consommée. */
+static hall_scan_frame_t hall_frame;
 
-static const ADCConversionGroup adcgrpcfg = {
-  .circular     = true,
-  .num_channels = ADC_NUM_CHANNELS,
-  .end_cb       = adc_cb,
-  .error_cb     = NULL,
-
-  .cfgr         = ADC_CFGR_CONT,
-  .cfgr2        = 0,
-
-  .ltr1         = 0,
-  .htr1         = 0,
-  .ltr2         = 0,
-  .htr2         = 0,
-  .ltr3         = 0,
-  .htr3         = 0,
-
-  .awd2cr       = 0,
-  .awd3cr       = 0,
-
-  .pcsel        = ADC_PCSEL,
-
-  .smpr         = {
-    ADC_SMPR1_SMP_AN4(ADC_SMPR_SMP_384P5) |
-    ADC_SMPR1_SMP_AN7(ADC_SMPR_SMP_384P5),
-    0
-  },
-
-  .sqr          = {
-    ADC_SQR1_SQ1_N(ADC_CH_MUXA) |
-    ADC_SQR1_SQ2_N(ADC_CH_MUXB),
-    0,
-    0,
-    0
-  }
-};
+static THD_WORKING_AREA(waHallScan, 512);
 
 static void mux_select(uint8_t ch) {
   palWritePad(MUX_S0_PORT, MUX_S0_PIN, (ch >> 0) & 1U);
@@ -102,12 +81,6 @@ static void mux_select(uint8_t ch) {
   palWritePad(MUX_S2_PORT, MUX_S2_PIN, (ch >> 2) & 1U);
 }
 
-static void get_last_samples(uint16_t *a, uint16_t *b) {
-  size_t idx = (ADC_DMA_DEPTH - 1U) * ADC_NUM_CHANNELS;
-  *a = adc_buffer[idx + 0U];
-  *b = adc_buffer[idx + 1U];
-}
-
 static uint16_t clamp_u16(int32_t value) {
   if (value < 0) {
     return 0U;
@@ -137,79 +110,109 @@ static uint8_t hall_map_to_midi(uint16_t value, uint16_t min, uint16_t max) {
   return (uint8_t)(scaled / span);
 }
 
-static uint8_t hall_velocity_from_derivate(uint32_t deriv_counts_per_ms) {
-  if (HALL_DERIV_MAX_COUNTS_PER_MS == 0U) {
-    return 1U;
-  }
-
-  uint32_t v = (deriv_counts_per_ms * 127U) / HALL_DERIV_MAX_COUNTS_PER_MS;
-  if (v > 127U) v = 127U;
-  if (v < 1U) v = 1U;
-  return (uint8_t)v;
+static void hall_emit(hall_event_type_t type, uint8_t index, uint8_t value, rtcnt_t now) {
+  hall_event_t evt = {
+    .stamp = now,
+    .type = (uint8_t)type,
+    .key = index,
+    .value = value,
+    .reserved = 0U
+  };
+  (void)hall_events_push(&evt);
 }
 
-static void hall_process_channel(uint8_t index, uint16_t raw, systime_t now) {
-  int16_t offset = hall_offsets[index];
-  uint16_t adjusted = hall_apply_offset(raw, offset);
+static void hall_process_channel(uint8_t index, uint16_t raw, rtcnt_t now) {
+  struct brick_cal_rest *rest = &brick_cal_state.rest;
+  uint16_t adjusted = hall_apply_offset(raw, brick_cal_state.key.offset[index]);
 
-  uint16_t on_threshold  = clamp_u16((int32_t)HALL_ON_THRESHOLD + offset);
-  uint16_t off_threshold = clamp_u16((int32_t)HALL_ON_THRESHOLD - (int32_t)HALL_HYSTERESIS + offset);
-  uint16_t min_value = clamp_u16((int32_t)HALL_RAW_REST + offset);
-  uint16_t max_value = clamp_u16((int32_t)HALL_RAW_PRESSED + offset);
+  /* --- Suivi du repos et de la course, seuils dérivés --- */
+  brick_cal_rest_next(rest, index, adjusted, hall_gate[index]);
+
+  uint16_t on_threshold  = rest->on[index];
+  uint16_t off_threshold = rest->off[index];
+  uint16_t min_value = rest->baseline[index];
+  uint16_t max_value = rest->pressed[index];
+  int16_t vel_offset = (int16_t)((int32_t)on_threshold - (int32_t)HALL_ON_NOMINAL);
   if (max_value <= min_value) {
     max_value = (uint16_t)(min_value + 1U);
   }
 
   hall_midi_value[index] = hall_map_to_midi(adjusted, min_value, max_value);
 
-  /* --- Vélocité par dérivée (signal monte quand on appuie) --- */
-  uint16_t prev = hall_prev_value[index];
-  systime_t tprev = hall_prev_time[index];
-
-  uint32_t dt_us = TIME_I2US(chTimeDiffX(tprev, now));
-  if (dt_us == 0U) {
-    dt_us = 1U;
-  }
-
-  int32_t dv_signed = (int32_t)adjusted - (int32_t)prev;
-  uint32_t dv = (dv_signed > 0) ? (uint32_t)dv_signed : 0U;
-
-  uint32_t deriv_counts_per_ms = 0U;
-  if (dt_us <= HALL_DERIV_DT_MAX_US && dv >= HALL_DERIV_DV_DEAD_COUNTS) {
-    /* counts/ms = counts * 1000 / us */
-    deriv_counts_per_ms = (dv * 1000U) / dt_us;
-  }
-
-  uint8_t computed_velocity = hall_velocity_from_derivate(deriv_counts_per_ms);
+  /* --- Vélocité par temps de vol (signal monte quand on appuie) --- */
+  hall_velocity_track(index, vel_offset,
+                      hall_prev_value[index], hall_prev_time[index],
+                      adjusted, now);
 
   /* --- NOTE ON / NOTE OFF avec hystérésis --- */
   if (!hall_gate[index]) {
     if (adjusted >= on_threshold) {
       hall_gate[index] = true;
-      hall_note_on[index] = true;
 
       /* fige la vélocité au NOTE ON */
-      hall_velocity[index] = computed_velocity;
+      hall_velocity[index] = hall_velocity_get(index);
+      hall_pressure_sent[index] = 0U;
+      hall_emit(HALL_EVT_NOTE_ON, index, hall_velocity[index], now);
     }
   } else {
     if (adjusted <= off_threshold) {
       hall_gate[index] = false;
-      hall_note_off[index] = true;
+      hall_velocity_rearm(index);
+      hall_emit(HALL_EVT_NOTE_OFF, index, 0U, now);
     }
   }
 
   /* --- Pressure (aftertouch) --- */
   if (hall_gate[index]) {
-    hall_pressure[index] = hall_map_to_midi(adjusted, min_value, max_value);
+    uint8_t pressure = hall_map_to_midi(adjusted, min_value, max_value);
+    uint8_t sent = hall_pressure_sent[index];
+    uint8_t delta = (pressure > sent) ? (uint8_t)(pressure - sent) : (uint8_t)(sent - pressure);
+
+    hall_pressure[index] = pressure;
+    if (delta >= HALL_PRESSURE_EVT_DELTA) {
+      hall_pressure_sent[index] = pressure;
+      hall_emit(HALL_EVT_PRESSURE, index, pressure, now);
+    }
   } else {
     hall_pressure[index] = 0U;
   }
 
-  /* --- MàJ historique dérivée --- */
+  /* --- MàJ historique (temps de vol) --- */
   hall_prev_value[index] = adjusted;
   hall_prev_time[index] = now;
 }
 
+static void hall_process_frame(const hall_scan_frame_t *frame) {
+  for (uint8_t mux_ch = 0; mux_ch < BRICK_HALL_MUX_CHANNELS; mux_ch++) {
+    uint16_t vA = frame->raw[mux_ch + 0U];
+    uint16_t vB = frame->raw[mux_ch + 8U];
+    rtcnt_t now = frame->stamp[mux_ch];
+
+    hall_values[mux_ch + 0U] = vA;
+    hall_values[mux_ch + 8U] = vB;
+    hall_process_channel(mux_ch + 0U, vA, now);
+    hall_process_channel(mux_ch + 8U, vB, now);
+  }
+}
+
+/*
+ * Thread Hall : réveillé à chaque trame publiée par le moteur de scan,
+ * traite les 16 capteurs et publie les fronts/pressions dans la file
+ * d'événements. Seul producteur de hall_events.
+ */
+static THD_FUNCTION(thdHallScan, arg) {
+  (void)arg;
+#if CH_CFG_USE_REGISTRY
+  chRegSetThreadName("HALL_SCAN");
+#endif
+
+  while (true) {
+    if (hall_scan_wait_frame(&hall_frame, TIME_MS2I(HALL_FRAME_WAIT_MS)) == MSG_OK) {
+      hall_process_frame(&hall_frame);
+    }
+  }
+}
+
 void hall_init(void) {
   if (hall_initialized) {
     return;
@@ -222,52 +225,41 @@ void hall_init(void) {
   palSetPadMode(GPIOC, 4, PAL_MODE_INPUT_ANALOG);
   palSetPadMode(GPIOA, 7, PAL_MODE_INPUT_ANALOG);
 
-  for (unsigned i = 0; i < ADC_DMA_DEPTH * ADC_NUM_CHANNELS; i++) {
-    adc_buffer[i] = 0x1234;
-  }
-
-  systime_t now = chVTGetSystemTimeX();
+  rtcnt_t now = chSysGetRealtimeCounterX();
 
   for (uint8_t i = 0; i < HALL_SENSOR_COUNT; i++) {
     hall_values[i] = 0U;
     hall_gate[i] = false;
-    hall_note_on[i] = false;
-    hall_note_off[i] = false;
     hall_velocity[i] = 0U;
     hall_pressure[i] = 0U;
+    hall_pressure_sent[i] = 0U;
     hall_midi_value[i] = 0U;
 
-    /* init historique dérivée: évite un gros dv au premier passage */
-    hall_prev_value[i] = (uint16_t)HALL_RAW_REST;
+    /* init historique : évite un faux franchissement au premier passage */
+    hall_prev_value[i] = (uint16_t)HALL_REST_NOMINAL;
     hall_prev_time[i] = now;
   }
 
-  adcStart(&ADCD1, NULL);
-  adcStartConversion(&ADCD1, &adcgrpcfg, adc_buffer, ADC_DMA_DEPTH);
-
-  hall_initialized = true;
-}
+  memset(&hall_frame, 0, sizeof(hall_frame));
+  hall_events_reset();
+  hall_velocity_init(STM32_CORE_CK);
+  hall_velocity_set_thresholds(HALL_VEL_LOW_THRESHOLD, HALL_ON_NOMINAL);
+  (void)brick_cal_rest_init(&brick_cal_state.rest, HALL_REST_NOMINAL, HALL_PRESSED_NOMINAL,
+                            HALL_REST_EMA_SHIFT, HALL_ON_Q8, HALL_HYST_Q8);
 
-void hall_update(void) {
+  /* Calibration persistée : restaurée avant le premier scan. */
+  if (brick_cal_store_start()) {
+    (void)brick_cal_store_load(&brick_cal_state);
+  }
   for (uint8_t i = 0; i < HALL_SENSOR_COUNT; i++) {
-    hall_note_on[i] = false;
-    hall_note_off[i] = false;
+    hall_velocity_set_curve(i, brick_cal_key_curve_get(&brick_cal_state.key, i));
   }
+  hall_scan_start(mux_select);
 
-  for (uint8_t mux_ch = 0; mux_ch < 8U; mux_ch++) {
-    mux_select(mux_ch);
-    chThdSleepMilliseconds(2);
-
-    uint16_t vA;
-    uint16_t vB;
-    get_last_samples(&vA, &vB);
+  chThdCreateStatic(waHallScan, sizeof(waHallScan),
+                    HALL_THREAD_PRIO, thdHallScan, NULL);
 
-    hall_values[mux_ch + 0U] = vA;
-    hall_values[mux_ch + 8U] = vB;
-    systime_t now = chVTGetSystemTimeX();
-    hall_process_channel(mux_ch + 0U, vA, now);
-    hall_process_channel(mux_ch + 8U, vB, now);
-  }
+  hall_initialized = true;
 }
 
 uint16_t hall_get(uint8_t index) {
@@ -277,20 +269,6 @@ uint16_t hall_get(uint8_t index) {
   return hall_values[index];
 }
 
-bool hall_get_note_on(uint8_t index) {
-  if (index >= HALL_SENSOR_COUNT) {
-    return false;
-  }
-  return hall_note_on[index];
-}
-
-bool hall_get_note_off(uint8_t index) {
-  if (index >= HALL_SENSOR_COUNT) {
-    return false;
-  }
-  return hall_note_off[index];
-}
-
 uint8_t hall_get_velocity(uint8_t index) {
   if (index >= HALL_SENSOR_COUNT) {
     return 0U;
@@ -311,3 +289,7 @@ uint8_t hall_get_midi_value(uint8_t index) {
   }
   return hall_midi_value[index];
 }
+
+int hall_cal_save(void) {
+  return brick_cal_store_save(&brick_cal_state);
+}
@@ -4,13 +4,25 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#include "hall_events.h"
+
+/*
+ * hall_init() démarre le scan DMA et le thread Hall. Les fronts NOTE ON /
+ * NOTE OFF et les variations de pression sont publiés dans la file
+ * d'événements (hall_events_read()) ; les getters ci-dessous restent
+ * disponibles pour l'affichage et le debug.
+ */
 void hall_init(void);
-void hall_update(void);
 uint16_t hall_get(uint8_t index);
-bool hall_get_note_on(uint8_t index);
-bool hall_get_note_off(uint8_t index);
 uint8_t hall_get_velocity(uint8_t index);
 uint8_t hall_get_pressure(uint8_t index);
 uint8_t hall_get_midi_value(uint8_t index);
 
+/*
+ * Écrit en flash la calibration (brick_cal_state) des touches modifiées.
+ * Bloquant : à appeler depuis un thread non temps réel (UI).
+ * Retourne le nombre de touches écrites, -1 en cas d'erreur.
+ */
+int hall_cal_save(void);
+
 #endif /* DRV_HALL_H */
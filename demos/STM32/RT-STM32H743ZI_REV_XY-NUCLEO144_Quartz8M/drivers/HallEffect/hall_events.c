@@ -0,0 +1,80 @@
+#include "hall_events.h"
+
+#if (HALL_EVQ_SIZE & (HALL_EVQ_SIZE - 1U)) != 0U
+#error "HALL_EVQ_SIZE doit être une puissance de 2"
+#endif
+
+#if HALL_EVQ_EDGE_RESERVE >= HALL_EVQ_SIZE
+#error "HALL_EVQ_EDGE_RESERVE doit être inférieur à HALL_EVQ_SIZE"
+#endif
+
+#define HALL_EVQ_MASK  (HALL_EVQ_SIZE - 1U)
+
+static hall_event_t evq_buf[HALL_EVQ_SIZE];
+
+/* head : écrit par le producteur, tail : écrit par le consommateur.
+   Compteurs libres (modulo 2^32), l'index réel est masqué. */
+static volatile uint32_t evq_head;
+static volatile uint32_t evq_tail;
+
+static volatile uint32_t evq_pressure_drops;
+static volatile uint32_t evq_edge_drops;
+
+void hall_events_reset(void) {
+  __atomic_store_n(&evq_head, 0U, __ATOMIC_RELAXED);
+  __atomic_store_n(&evq_tail, 0U, __ATOMIC_RELAXED);
+  evq_pressure_drops = 0U;
+  evq_edge_drops = 0U;
+}
+
+bool hall_events_push(const hall_event_t *evt) {
+  if (evt == NULL) {
+    return false;
+  }
+
+  const uint32_t head = __atomic_load_n(&evq_head, __ATOMIC_RELAXED);
+  const uint32_t tail = __atomic_load_n(&evq_tail, __ATOMIC_ACQUIRE);
+  const uint32_t used = head - tail;
+
+  if (evt->type == HALL_EVT_PRESSURE) {
+    if (used >= (HALL_EVQ_SIZE - HALL_EVQ_EDGE_RESERVE)) {
+      evq_pressure_drops++;
+      return false;
+    }
+  } else if (used >= HALL_EVQ_SIZE) {
+    evq_edge_drops++;
+    return false;
+  }
+
+  evq_buf[head & HALL_EVQ_MASK] = *evt;
+  __atomic_store_n(&evq_head, head + 1U, __ATOMIC_RELEASE);
+  return true;
+}
+
+size_t hall_events_read(hall_event_t *out, size_t max) {
+  if ((out == NULL) || (max == 0U)) {
+    return 0U;
+  }
+
+  const uint32_t tail = __atomic_load_n(&evq_tail, __ATOMIC_RELAXED);
+  const uint32_t head = __atomic_load_n(&evq_head, __ATOMIC_ACQUIRE);
+  uint32_t avail = head - tail;
+  if (avail > max) {
+    avail = (uint32_t)max;
+  }
+
+  for (uint32_t i = 0U; i < avail; i++) {
+    out[i] = evq_buf[(tail + i) & HALL_EVQ_MASK];
+  }
+
+  __atomic_store_n(&evq_tail, tail + avail, __ATOMIC_RELEASE);
+  return avail;
+}
+
+uint32_t hall_events_pressure_drops(void) {
+  return evq_pressure_drops;
+}
+
+uint32_t hall_events_edge_drops(void) {
+  return evq_edge_drops;
+}
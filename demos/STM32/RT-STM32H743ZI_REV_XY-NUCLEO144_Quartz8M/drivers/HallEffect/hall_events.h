@@ -0,0 +1,71 @@
+/**
+ * @file hall_events.h
+ * @brief File d'événements touches Hall (un producteur, un consommateur).
+ *
+ * Le thread de scan Hall est l'unique producteur ; un seul thread consomme
+ * (boucle principale / MIDI). Aucune section critique : les index tête/queue
+ * sont publiés avec des accès atomiques acquire/release.
+ *
+ * Les fronts (NOTE ON / NOTE OFF) disposent d'une réserve de places que les
+ * événements de pression ne peuvent pas consommer : sous charge, ce sont les
+ * mises à jour de pression qui sont perdues, jamais les fronts.
+ */
+
+#ifndef HALL_EVENTS_H
+#define HALL_EVENTS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "ch.h"
+
+/** @brief Capacité de la file (puissance de 2). */
+#ifndef HALL_EVQ_SIZE
+#define HALL_EVQ_SIZE          128U
+#endif
+
+/** @brief Places réservées aux fronts NOTE ON / NOTE OFF. */
+#ifndef HALL_EVQ_EDGE_RESERVE
+#define HALL_EVQ_EDGE_RESERVE  32U
+#endif
+
+typedef enum {
+  HALL_EVT_NOTE_ON = 0,   /**< value = vélocité 1..127 */
+  HALL_EVT_NOTE_OFF,      /**< value = 0 */
+  HALL_EVT_PRESSURE       /**< value = pression 0..127 */
+} hall_event_type_t;
+
+/**
+ * @brief Événement touche horodaté (compteur temps réel).
+ */
+typedef struct {
+  rtcnt_t stamp;
+  uint8_t type;           /**< @ref hall_event_type_t */
+  uint8_t key;            /**< Index capteur 0..15 */
+  uint8_t value;
+  uint8_t reserved;
+} hall_event_t;
+
+/** @brief Vide la file et remet les compteurs à zéro. */
+void hall_events_reset(void);
+
+/**
+ * @brief Publie un événement (producteur uniquement).
+ * @return false si la file est pleine (événement compté comme perdu).
+ */
+bool hall_events_push(const hall_event_t *evt);
+
+/**
+ * @brief Récupère jusqu'à @p max événements (consommateur uniquement).
+ * @return Nombre d'événements copiés dans @p out.
+ */
+size_t hall_events_read(hall_event_t *out, size_t max);
+
+/** @brief Nombre d'événements de pression écartés (file presque pleine). */
+uint32_t hall_events_pressure_drops(void);
+
+/** @brief Nombre de fronts perdus (file entièrement pleine). */
+uint32_t hall_events_edge_drops(void);
+
+#endif /* HALL_EVENTS_H */
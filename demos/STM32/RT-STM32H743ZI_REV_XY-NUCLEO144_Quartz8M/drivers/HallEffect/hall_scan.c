@@ -0,0 +1,260 @@
+#include "hall_scan.h"
+
+#include "ch.h"
+#include "hal.h"
+
+#include <string.h>
+
+/*
+ * Principe :
+ *   - ADC1 convertit en continu MUXA (IN4), MUXB (IN7) puis le mux des pots
+ *     (IN5), DMA circulaire.
+ *   - Chaque demi-buffer = une position de mux (Hall et pots ensemble).
+ *   - Au callback demi/plein buffer, on moyenne la fin du demi-buffer qui
+ *     vient d'être rempli, puis on commute le mux pour le demi-buffer suivant.
+ *   - Les HALL_SCAN_SETTLE_SEQS premières séquences couvrent l'établissement.
+ *
+ * Durée d'un scan complet ≈ 8 × (SETTLE_SEQS + AVG_SEQS) × durée séquence.
+ */
+
+#define ADC_NUM_CHANNELS        (BRICK_HALL_MUX_COUNT + 1U)
+
+#define ADC_CH_MUXA   ADC_CHANNEL_IN4
+#define ADC_CH_MUXB   ADC_CHANNEL_IN7
+#define ADC_CH_POT    ADC_CHANNEL_IN5
+
+#define ADC_PCSEL     (ADC_SELMASK_IN4 | ADC_SELMASK_IN7 | ADC_SELMASK_IN5)
+
+/*
+ * Temps d'échantillonnage : 64.5 cycles (sortie capteur basse impédance).
+ * Conversion 16 bits : 8.5 cycles. Exprimés en demi-cycles pour rester entiers.
+ */
+#define HALL_SCAN_SMP            ADC_SMPR_SMP_64P5
+#define HALL_SCAN_SMP_HALFCYC    129U
+#define HALL_SCAN_CONV_HALFCYC   17U
+
+/* Durée d'une séquence (3 canaux) en ns. */
+#if defined(STM32_ADC12_CLOCK)
+#define HALL_SCAN_SEQ_NS                                                    \
+  ((uint32_t)(((uint64_t)ADC_NUM_CHANNELS *                                 \
+               (HALL_SCAN_SMP_HALFCYC + HALL_SCAN_CONV_HALFCYC) *           \
+               500000000ULL) / STM32_ADC12_CLOCK))
+#else
+#define HALL_SCAN_SEQ_NS         16000U   /* source simulée */
+#endif
+
+/* Séquences ignorées après commutation (au moins une : la commutation
+   tombe au milieu d'une séquence déjà en cours). */
+#define HALL_SCAN_SETTLE_SEQS_RAW                                           \
+  ((HALL_SCAN_SETTLE_US * 1000U + HALL_SCAN_SEQ_NS - 1U) / HALL_SCAN_SEQ_NS)
+#define HALL_SCAN_SETTLE_SEQS                                               \
+  ((HALL_SCAN_SETTLE_SEQS_RAW > 0U) ? HALL_SCAN_SETTLE_SEQS_RAW : 1U)
+
+/* Profondeur DMA : deux demi-buffers d'une position de mux chacun. */
+#define HALL_SCAN_HALF_DEPTH     (HALL_SCAN_SETTLE_SEQS + HALL_SCAN_AVG_SEQS)
+#define HALL_SCAN_DMA_DEPTH      (HALL_SCAN_HALF_DEPTH * 2U)
+
+#if HALL_SCAN_AVG_SEQS == 0
+#error "HALL_SCAN_AVG_SEQS doit valoir au moins 1"
+#endif
+
+/* ====================================================================== */
+/*                                 ÉTAT                                   */
+/* ====================================================================== */
+
+static hall_scan_mux_fn_t scan_mux;
+static hall_scan_mux_fn_t scan_pot_mux;
+static uint8_t            scan_step;
+static rtcnt_t            scan_switch_time;
+static hall_scan_frame_t  scan_work;
+static hall_scan_frame_t  scan_published;
+static uint32_t           scan_seq;
+static binary_semaphore_t scan_sem;
+
+/* ====================================================================== */
+/*                          CŒUR (ISR / SIMULATION)                       */
+/* ====================================================================== */
+
+void hall_scan_init(hall_scan_mux_fn_t mux_fn) {
+  scan_mux = mux_fn;
+  scan_step = 0U;
+  scan_seq = 0U;
+  scan_switch_time = chSysGetRealtimeCounterX();
+  memset(&scan_work, 0, sizeof(scan_work));
+  memset(&scan_published, 0, sizeof(scan_published));
+  chBSemObjectInit(&scan_sem, true);
+
+  if (scan_mux != NULL) {
+    scan_mux(0U);
+  }
+  if (scan_pot_mux != NULL) {
+    scan_pot_mux(0U);
+  }
+}
+
+void hall_scan_set_pot_mux(hall_scan_mux_fn_t mux_fn) {
+  scan_pot_mux = mux_fn;
+}
+
+void hall_scan_feed_i(const uint16_t *samples, size_t seqs) {
+  if ((samples == NULL) || (seqs == 0U)) {
+    return;
+  }
+
+  size_t skip = HALL_SCAN_SETTLE_SEQS;
+  if (skip >= seqs) {
+    skip = seqs - 1U;
+  }
+
+  uint32_t acc_a = 0U;
+  uint32_t acc_b = 0U;
+  uint32_t acc_p = 0U;
+  for (size_t i = skip; i < seqs; i++) {
+    acc_a += samples[(i * ADC_NUM_CHANNELS) + 0U];
+    acc_b += samples[(i * ADC_NUM_CHANNELS) + 1U];
+    acc_p += samples[(i * ADC_NUM_CHANNELS) + 2U];
+  }
+  const uint32_t n = (uint32_t)(seqs - skip);
+
+  const rtcnt_t now = chSysGetRealtimeCounterX();
+  const uint8_t step = scan_step;
+
+  if (step == 0U) {
+    scan_work.t_start = scan_switch_time;
+  }
+  scan_work.raw[step + 0U] = (uint16_t)(acc_a / n);
+  scan_work.raw[step + BRICK_HALL_MUX_CHANNELS] = (uint16_t)(acc_b / n);
+  scan_work.pot[step] = (uint16_t)(acc_p / n);
+  scan_work.stamp[step] = now;
+
+  /* Commutation pour le demi-buffer suivant. */
+  scan_step = (uint8_t)((step + 1U) % BRICK_HALL_MUX_CHANNELS);
+  if (scan_mux != NULL) {
+    scan_mux(scan_step);
+  }
+  if (scan_pot_mux != NULL) {
+    scan_pot_mux(scan_step);
+  }
+  scan_switch_time = chSysGetRealtimeCounterX();
+
+  if (scan_step == 0U) {
+    scan_work.t_end = now;
+    scan_work.seq = ++scan_seq;
+
+    osalSysLockFromISR();
+    scan_published = scan_work;
+    chBSemSignalI(&scan_sem);
+    osalSysUnlockFromISR();
+  }
+}
+
+/* ====================================================================== */
+/*                            LECTURE (THREADS)                           */
+/* ====================================================================== */
+
+bool hall_scan_get_frame(hall_scan_frame_t *out, uint32_t last_seq) {
+  bool fresh = false;
+
+  if (out == NULL) {
+    return false;
+  }
+
+  osalSysLock();
+  if (scan_published.seq != last_seq) {
+    *out = scan_published;
+    fresh = true;
+  }
+  osalSysUnlock();
+
+  return fresh;
+}
+
+msg_t hall_scan_wait_frame(hall_scan_frame_t *out, sysinterval_t timeout) {
+  if (out == NULL) {
+    return MSG_RESET;
+  }
+
+  msg_t res = chBSemWaitTimeout(&scan_sem, timeout);
+  if (res == MSG_OK) {
+    osalSysLock();
+    *out = scan_published;
+    osalSysUnlock();
+  }
+  return res;
+}
+
+size_t hall_scan_settle_seqs(void) {
+  return (size_t)HALL_SCAN_SETTLE_SEQS;
+}
+
+/* ====================================================================== */
+/*                          ACQUISITION MATÉRIELLE                        */
+/* ====================================================================== */
+
+#if HAL_USE_ADC == TRUE
+
+__attribute__((section(".ramd2"), aligned(32)))
+static adcsample_t adc_buffer[HALL_SCAN_DMA_DEPTH * ADC_NUM_CHANNELS];
+
+static void adc_cb(ADCDriver *adcp) {
+  const size_t half = adcp->depth / 2U;
+  const adcsample_t *s = adcp->samples;
+
+  /* Second demi-buffer rempli quand l'état passe à ADC_COMPLETE. */
+  if (adcIsBufferComplete(adcp)) {
+    s += half * ADC_NUM_CHANNELS;
+  }
+
+  hall_scan_feed_i(s, half);
+}
+
+static const ADCConversionGroup adcgrpcfg = {
+  .circular     = true,
+  .num_channels = ADC_NUM_CHANNELS,
+  .end_cb       = adc_cb,
+  .error_cb     = NULL,
+
+  .cfgr         = ADC_CFGR_CONT,
+  .cfgr2        = 0,
+
+  .ltr1         = 0,
+  .htr1         = 0,
+  .ltr2         = 0,
+  .htr2         = 0,
+  .ltr3         = 0,
+  .htr3         = 0,
+
+  .awd2cr       = 0,
+  .awd3cr       = 0,
+
+  .pcsel        = ADC_PCSEL,
+
+  .smpr         = {
+    ADC_SMPR1_SMP_AN4(HALL_SCAN_SMP) |
+    ADC_SMPR1_SMP_AN5(HALL_SCAN_SMP) |
+    ADC_SMPR1_SMP_AN7(HALL_SCAN_SMP),
+    0
+  },
+
+  .sqr          = {
+    ADC_SQR1_SQ1_N(ADC_CH_MUXA) |
+    ADC_SQR1_SQ2_N(ADC_CH_MUXB) |
+    ADC_SQR1_SQ3_N(ADC_CH_POT),
+    0,
+    0,
+    0
+  }
+};
+
+void hall_scan_start(hall_scan_mux_fn_t mux_fn) {
+  for (unsigned i = 0; i < HALL_SCAN_DMA_DEPTH * ADC_NUM_CHANNELS; i++) {
+    adc_buffer[i] = 0U;
+  }
+
+  hall_scan_init(mux_fn);
+
+  adcStart(&ADCD1, NULL);
+  adcStartConversion(&ADCD1, &adcgrpcfg, adc_buffer, HALL_SCAN_DMA_DEPTH);
+}
+
+#endif /* HAL_USE_ADC == TRUE */
@@ -0,0 +1,116 @@
+/**
+ * @file hall_scan.h
+ * @brief Moteur de scan Hall piloté par DMA (sans attente active).
+ *
+ * Le mux analogique est avancé depuis le callback ADC (événements demi/plein
+ * buffer DMA) : chaque demi-buffer correspond à une position de mux. Les
+ * premières séquences d'un demi-buffer couvrent le temps d'établissement du
+ * mux et sont ignorées, les suivantes sont moyennées.
+ *
+ * Une trame complète (16 capteurs) est publiée toutes les 8 positions, avec
+ * un horodatage par position (compteur temps réel, `rtcnt_t`).
+ *
+ * Le mux des potentiomètres (8 voies) est converti dans la même séquence ADC
+ * et commuté en même temps que le mux Hall : la trame porte aussi une valeur
+ * par voie de pot, lue par le scanner d'entrées (`drv_input`).
+ *
+ * Aucun thread n'est bloqué par le scan : les consommateurs lisent la
+ * dernière trame (`hall_scan_get_frame()`) ou attendent la suivante
+ * (`hall_scan_wait_frame()`).
+ *
+ * Pour un test sur Linux, une source d'échantillons simulée appelle
+ * directement `hall_scan_feed_i()` après `hall_scan_init()`.
+ */
+
+#ifndef HALL_SCAN_H
+#define HALL_SCAN_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "ch.h"
+#include "brick_config.h"
+
+/* ====================================================================== */
+/*                             CONFIGURATION                              */
+/* ====================================================================== */
+
+/**
+ * @brief Temps d'établissement du mux après commutation (µs).
+ */
+#ifndef HALL_SCAN_SETTLE_US
+#define HALL_SCAN_SETTLE_US      10U
+#endif
+
+/**
+ * @brief Nombre de séquences ADC moyennées par position de mux.
+ */
+#ifndef HALL_SCAN_AVG_SEQS
+#define HALL_SCAN_AVG_SEQS       2U
+#endif
+
+/* ====================================================================== */
+/*                                 TYPES                                  */
+/* ====================================================================== */
+
+/**
+ * @brief Trame de scan complète (une valeur brute par capteur).
+ */
+typedef struct {
+  uint16_t raw[BRICK_NUM_HALL_SENSORS];      /**< Valeurs ADC moyennées */
+  uint16_t pot[BRICK_POT_MUX_CHANNELS];      /**< Voies du mux potentiomètres */
+  rtcnt_t  stamp[BRICK_HALL_MUX_CHANNELS];   /**< Horodatage de chaque position mux */
+  rtcnt_t  t_start;                          /**< Début du scan */
+  rtcnt_t  t_end;                            /**< Fin du scan */
+  uint32_t seq;                              /**< Numéro de trame (croissant) */
+} hall_scan_frame_t;
+
+/** @brief Sélection d'une position de mux (GPIO réels ou simulateur). */
+typedef void (*hall_scan_mux_fn_t)(uint8_t ch);
+
+/* ====================================================================== */
+/*                                  API                                   */
+/* ====================================================================== */
+
+/**
+ * @brief Réinitialise l'état du moteur et enregistre la fonction de mux.
+ * @param mux_fn Fonction de sélection mux (peut être NULL).
+ */
+void hall_scan_init(hall_scan_mux_fn_t mux_fn);
+
+/**
+ * @brief Enregistre la sélection du mux potentiomètres (NULL : aucune).
+ * @note  Conservée par hall_scan_init() ; à appeler avant le démarrage.
+ */
+void hall_scan_set_pot_mux(hall_scan_mux_fn_t mux_fn);
+
+/**
+ * @brief Démarre l'acquisition matérielle (ADC1 circulaire + DMA).
+ * @param mux_fn Fonction de sélection mux GPIO.
+ */
+void hall_scan_start(hall_scan_mux_fn_t mux_fn);
+
+/**
+ * @brief Traite un demi-buffer DMA (contexte ISR, verrou non tenu).
+ * @param samples Séquences entrelacées (MUXA, MUXB, POT, MUXA, MUXB, POT, ...).
+ * @param seqs    Nombre de séquences dans le demi-buffer.
+ */
+void hall_scan_feed_i(const uint16_t *samples, size_t seqs);
+
+/**
+ * @brief Copie la dernière trame si elle est plus récente que @p last_seq.
+ * @return true si une nouvelle trame a été copiée.
+ */
+bool hall_scan_get_frame(hall_scan_frame_t *out, uint32_t last_seq);
+
+/**
+ * @brief Attend la prochaine trame publiée puis la copie.
+ * @return MSG_OK, ou MSG_TIMEOUT si aucune trame n'est arrivée.
+ */
+msg_t hall_scan_wait_frame(hall_scan_frame_t *out, sysinterval_t timeout);
+
+/** @brief Nombre de séquences ignorées après chaque commutation du mux. */
+size_t hall_scan_settle_seqs(void);
+
+#endif /* HALL_SCAN_H */
@@ -0,0 +1,170 @@
+#include "hall_velocity.h"
+
+#include <stddef.h>
+
+#define HALL_VEL_KEYS  BRICK_NUM_HALL_SENSORS
+
+typedef struct {
+  rtcnt_t  t_low;         /* franchissement interpolé du seuil bas */
+  uint32_t tof_us;
+  uint8_t  velocity;
+  bool     low_seen;
+  bool     high_done;
+} hall_vel_state_t;
+
+static hall_vel_state_t vel_state[HALL_VEL_KEYS];
+static const uint8_t   *vel_curve[HALL_VEL_KEYS];
+static uint32_t         vel_rtc_hz = 1000000U;
+static uint16_t         vel_low;
+static uint16_t         vel_high;
+
+static uint16_t clamp_u16(int32_t value) {
+  if (value < 0) {
+    return 0U;
+  }
+  if (value > UINT16_MAX) {
+    return UINT16_MAX;
+  }
+  return (uint16_t)value;
+}
+
+/* Instant où le segment (v0,t0) -> (v1,t1) atteint th (v0 < th <= v1). */
+static rtcnt_t interp_crossing(uint16_t th,
+                               uint16_t v0, rtcnt_t t0,
+                               uint16_t v1, rtcnt_t t1) {
+  if (v1 <= v0) {
+    return t1;
+  }
+  const uint64_t dt = (uint64_t)(rtcnt_t)(t1 - t0);
+  const uint64_t num = (uint64_t)(th - v0);
+  const uint64_t den = (uint64_t)(v1 - v0);
+  return (rtcnt_t)(t0 + (rtcnt_t)((dt * num) / den));
+}
+
+static uint8_t velocity_from_speed(uint64_t counts_per_ms) {
+  if (HALL_DERIV_MAX_COUNTS_PER_MS == 0U) {
+    return 1U;
+  }
+
+  uint64_t v = (counts_per_ms * 127U) / HALL_DERIV_MAX_COUNTS_PER_MS;
+  if (v > 127U) v = 127U;
+  if (v < 1U) v = 1U;
+  return (uint8_t)v;
+}
+
+static uint8_t apply_curve(uint8_t key, uint8_t raw) {
+  const uint8_t *curve = vel_curve[key];
+  uint8_t v = (curve != NULL) ? curve[raw & 0x7FU] : raw;
+  return (v == 0U) ? 1U : (uint8_t)(v & 0x7FU);
+}
+
+void hall_velocity_init(uint32_t rtc_hz) {
+  vel_rtc_hz = (rtc_hz >= 1000000U) ? rtc_hz : 1000000U;
+
+  for (uint8_t i = 0; i < HALL_VEL_KEYS; i++) {
+    vel_state[i].t_low = 0U;
+    vel_state[i].tof_us = 0U;
+    vel_state[i].velocity = 1U;
+    vel_state[i].low_seen = false;
+    vel_state[i].high_done = false;
+    vel_curve[i] = NULL;
+  }
+}
+
+void hall_velocity_set_thresholds(uint16_t low, uint16_t high) {
+  if (high <= low) {
+    high = (uint16_t)(low + 1U);
+  }
+  vel_low = low;
+  vel_high = high;
+}
+
+void hall_velocity_set_curve(uint8_t key, const uint8_t *curve) {
+  if (key >= HALL_VEL_KEYS) {
+    return;
+  }
+  vel_curve[key] = curve;
+}
+
+void hall_velocity_track(uint8_t key, int16_t offset,
+                         uint16_t v0, rtcnt_t t0,
+                         uint16_t v1, rtcnt_t t1) {
+  if (key >= HALL_VEL_KEYS) {
+    return;
+  }
+
+  hall_vel_state_t *st = &vel_state[key];
+  const uint16_t lo = clamp_u16((int32_t)vel_low + offset);
+  const uint16_t hi = clamp_u16((int32_t)vel_high + offset);
+
+  /* Retour sous le seuil bas : ré-armement pour la frappe suivante. */
+  if (v1 < lo) {
+    st->low_seen = false;
+    st->high_done = false;
+    return;
+  }
+
+  if (!st->low_seen && (v0 < lo)) {
+    st->t_low = interp_crossing(lo, v0, t0, v1, t1);
+    st->low_seen = true;
+  }
+
+  if (st->high_done || (v1 < hi) || (v0 >= hi)) {
+    return;
+  }
+  st->high_done = true;
+
+  const uint32_t cycles_per_ms = vel_rtc_hz / 1000U;
+  uint8_t raw;
+
+  if (st->low_seen) {
+    const rtcnt_t t_high = interp_crossing(hi, v0, t0, v1, t1);
+    const uint32_t tof = (uint32_t)(rtcnt_t)(t_high - st->t_low);
+    const uint32_t span = (uint32_t)(hi - lo);
+
+    st->tof_us = tof / (vel_rtc_hz / 1000000U);
+    if (st->tof_us > HALL_DERIV_DT_MAX_US) {
+      raw = 1U;
+    } else if (tof == 0U) {
+      raw = 127U;
+    } else {
+      raw = velocity_from_speed(((uint64_t)span * cycles_per_ms) / tof);
+    }
+  } else {
+    /* Repli : dérivée sur le dernier segment. */
+    const uint32_t dt = (uint32_t)(rtcnt_t)(t1 - t0);
+    const uint32_t dv = (uint32_t)(v1 - v0);
+
+    st->tof_us = 0U;
+    if ((dt == 0U) || (dv < HALL_DERIV_DV_DEAD_COUNTS) ||
+        ((dt / (vel_rtc_hz / 1000000U)) > HALL_DERIV_DT_MAX_US)) {
+      raw = 1U;
+    } else {
+      raw = velocity_from_speed(((uint64_t)dv * cycles_per_ms) / dt);
+    }
+  }
+
+  st->velocity = apply_curve(key, raw);
+}
+
+void hall_velocity_rearm(uint8_t key) {
+  if (key >= HALL_VEL_KEYS) {
+    return;
+  }
+  vel_state[key].low_seen = false;
+  vel_state[key].high_done = false;
+}
+
+uint8_t hall_velocity_get(uint8_t key) {
+  if (key >= HALL_VEL_KEYS) {
+    return 1U;
+  }
+  return vel_state[key].velocity;
+}
+
+uint32_t hall_velocity_last_tof_us(uint8_t key) {
+  if (key >= HALL_VEL_KEYS) {
+    return 0U;
+  }
+  return vel_state[key].tof_us;
+}
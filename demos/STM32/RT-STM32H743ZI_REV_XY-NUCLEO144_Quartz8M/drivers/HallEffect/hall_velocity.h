@@ -0,0 +1,98 @@
+/**
+ * @file hall_velocity.h
+ * @brief Vélocité par temps de vol entre deux seuils (résolution compteur DWT).
+ *
+ * Pour chaque touche, on horodate le franchissement montant d'un seuil bas
+ * puis d'un seuil haut. Les instants de franchissement sont interpolés
+ * linéairement entre les deux échantillons qui encadrent le seuil, ce qui
+ * affranchit la mesure de la période de scan.
+ *
+ *   vitesse (counts/ms) = (seuil_haut - seuil_bas) / (t_haut - t_bas)
+ *   vélocité brute      = map(vitesse, 0..HALL_DERIV_MAX_COUNTS_PER_MS) -> 1..127
+ *   vélocité finale     = courbe[touche][vélocité brute]
+ *
+ * Si le seuil bas n'a pas été vu (touche déjà enfoncée au démarrage), on
+ * retombe sur la dérivée du dernier segment (modèle HALL_DERIV_* d'origine).
+ *
+ * Module sans dépendance HAL : seul `rtcnt_t` et la fréquence du compteur
+ * (passée à hall_velocity_init()) sont nécessaires.
+ */
+
+#ifndef HALL_VELOCITY_H
+#define HALL_VELOCITY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "ch.h"
+#include "brick_config.h"
+
+/*
+ * Modèle de réglage (échelle ADC 16-bit) :
+ * - HALL_DERIV_MAX_COUNTS_PER_MS : vitesse donnant la vélocité 127.
+ *   Frappe la plus rapide -> vitesse max typique -> mets cette valeur ici.
+ * - HALL_DERIV_DV_DEAD_COUNTS : ignore les micro-variations (repli dérivée).
+ * - HALL_DERIV_DT_MAX_US : temps de vol au-delà duquel la frappe est
+ *   considérée "trop lente" (vélocité 1).
+ */
+#ifndef HALL_DERIV_MAX_COUNTS_PER_MS
+#define HALL_DERIV_MAX_COUNTS_PER_MS  1000U  /* à régler */
+#endif
+#ifndef HALL_DERIV_DV_DEAD_COUNTS
+#define HALL_DERIV_DV_DEAD_COUNTS     4U      /* ignore micro-variations */
+#endif
+#ifndef HALL_DERIV_DT_MAX_US
+#define HALL_DERIV_DT_MAX_US          100000U  /* au-delà: on considère "trop lent" */
+#endif
+
+/** @brief Courbe de vélocité : entrée brute 0..127 -> sortie 0..127. */
+typedef uint8_t hall_velocity_curve_t[128];
+
+/**
+ * @brief Réinitialise l'état de toutes les touches.
+ * @param rtc_hz Fréquence du compteur temps réel (ex. STM32_CORE_CK).
+ */
+void hall_velocity_init(uint32_t rtc_hz);
+
+/**
+ * @brief Règle les deux seuils de temps de vol (avant offset par touche).
+ * @note  @p high doit rester <= seuil NOTE ON pour que la vélocité soit
+ *        disponible au moment du NOTE ON.
+ */
+void hall_velocity_set_thresholds(uint16_t low, uint16_t high);
+
+/**
+ * @brief Associe une courbe à une touche (NULL = linéaire).
+ * @note  La table doit rester valide tant qu'elle est associée.
+ */
+void hall_velocity_set_curve(uint8_t key, const uint8_t *curve);
+
+/**
+ * @brief Suit un nouvel échantillon d'une touche.
+ *
+ * @param key    Index touche.
+ * @param offset Offset de calibration appliqué aux seuils.
+ * @param v0,t0  Échantillon précédent (valeur ajustée, horodatage).
+ * @param v1,t1  Échantillon courant.
+ */
+void hall_velocity_track(uint8_t key, int16_t offset,
+                         uint16_t v0, rtcnt_t t0,
+                         uint16_t v1, rtcnt_t t1);
+
+/**
+ * @brief Ré-arme la mesure d'une touche (à appeler au NOTE OFF).
+ * @note  Le seuil OFF est au-dessus du seuil bas : un relâchement partiel
+ *        ferme la porte sans repasser sous le seuil bas. Sans ré-armement,
+ *        la frappe suivante reprendrait la vélocité de la précédente.
+ */
+void hall_velocity_rearm(uint8_t key);
+
+/**
+ * @brief Vélocité 1..127 à figer au NOTE ON (dernière mesure de la touche).
+ */
+uint8_t hall_velocity_get(uint8_t key);
+
+/** @brief Dernier temps de vol mesuré (µs), 0 si repli dérivée. */
+uint32_t hall_velocity_last_tof_us(uint8_t key);
+
+#endif /* HALL_VELOCITY_H */
@@ -30,6 +30,14 @@
 #define BRICK_WS2812_DYNAMIC_MAP     1
 
 
+/* ========================================================= */
+/* ======================== BOUTONS ======================== */
+/* ========================================================= */
+
+/* 25 boutons (1 LED chacun), lus par registres à décalage 74HC165 */
+#define BRICK_NUM_BUTTONS            25
+
+
 /* ========================================================= */
 /* ==================== POTENTIOMÈTRES ===================== */
 /* ========================================================= */
@@ -136,6 +144,13 @@ BRICK_STATIC_ASSERT(BRICK_POT_MUX_COUNT == 1,
 BRICK_STATIC_ASSERT(BRICK_HALL_MUX_CHANNELS * BRICK_HALL_MUX_COUNT == BRICK_NUM_HALL_SENSORS,
                     hall_mux_mismatch);
 
+/* Boutons : un masque 32 bits */
+BRICK_STATIC_ASSERT(BRICK_NUM_BUTTONS <= 32, buttons_fit_u32_mask);
+
+/* Pots et capteurs Hall balayés au même rythme (même séquence ADC) */
+BRICK_STATIC_ASSERT(BRICK_POT_MUX_CHANNELS == BRICK_HALL_MUX_CHANNELS,
+                    pot_mux_follows_hall_mux);
+
 /* Séquenceur figé V1 */
 BRICK_STATIC_ASSERT(BRICK_NUM_TRACKS == 16, tracks_must_be_16);
 BRICK_STATIC_ASSERT(BRICK_STEPS_PER_TRACK == 64, steps_must_be_64);
@@ -14,15 +14,15 @@ void drivers_init_all(void) {
     /* Contrat de démarrage :
        - drv_display   : init uniquement (rendu déclenché côté UI)
        - drv_leds_addr : init uniquement (rendu déclenché côté UI)
-       - drv_buttons   : start = init + thread de scan
-       - drv_encoders  : start = init + thread de scan
-       - drv_pots      : start = init + thread de scan */
+       - drv_input     : start = init + thread de scan unique
+                         (boutons, encodeurs, pots) */
     drv_display_init();
-
+    drv_leds_addr_init();
+    drv_input_start();
 }
 
-/* Mise à jour périodique : surtout pour l’écran (les LEDs sont rendues via ui_led_backend_refresh). */
+/* Mise à jour périodique : surtout pour l’écran (les LEDs sont rendues par la boucle UI). */
 void drivers_update_all(void) {
-    /* ⚠️ Ne **pas** appeler drv_leds_addr_update() ici.
-       Le pipeline LED passe par ui_led_backend_refresh() → drv_leds_addr_render(). */
+    /* ⚠️ Ne **pas** rendre les LEDs ici.
+       Le pipeline LED passe par la boucle UI → drv_leds_addr_render(). */
 }
@@ -25,6 +25,8 @@ extern mutex_t spi5_mutex;
  * @brief Drivers matériels composant le système Brick.
  */
 #include "drv_display.h"
+#include "drv_leds_addr.h"
+#include "drv_input.h"
 
 
 /* ====================================================================== */
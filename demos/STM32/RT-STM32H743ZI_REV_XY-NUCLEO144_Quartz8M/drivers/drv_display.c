@@ -2,17 +2,28 @@
 #include "ch.h"
 #include "hal.h"
 #include "brick_config.h"
+#include "tribuf.h"
 #include <string.h>
 #include <stdio.h>
 
+#if defined(SIMULATOR)
+/* Build hôte (RT-Posix-Simulator) : le SPI est remplacé par un SSD130x
+   émulé, cf. sim/ssd130x_sim.h. */
+#include "ssd130x_sim.h"
+#endif
+
+#if !defined(SIMULATOR)
+
 /* ====================================================================== */
 /*                        CONFIGURATION MATÉRIELLE                        */
 /* ====================================================================== */
 
+static void spi_done_cb(SPIDriver *spip);
+
 static const SPIConfig spicfg = {
     .circular = false,
     .slave    = false,
-    .data_cb  = NULL,
+    .data_cb  = spi_done_cb,
     .error_cb = NULL,
 
     /* ~10–15 MHz selon clock SPI */
@@ -23,16 +34,42 @@ static const SPIConfig spicfg = {
             SPI_CFG2_SSM
 };
 
+#endif /* !SIMULATOR */
+
 /* ====================================================================== */
 /*                             VARIABLES INTERNES                         */
 /* ====================================================================== */
 
-static uint8_t buffer[BRICK_OLED_WIDTH * BRICK_OLED_HEIGHT / 8];
+#define OLED_PAGES  (BRICK_OLED_HEIGHT / 8)
+#define FB_SIZE     (BRICK_OLED_WIDTH * BRICK_OLED_HEIGHT / 8)
+
+/* Triple buffer (tribuf) + copie de ce que l'écran affiche réellement.
+   En .bss (AXI SRAM) : accessible au DMA1/2, contrairement aux piles (DTCM). */
+static uint8_t fb[3][FB_SIZE] __attribute__((aligned(32)));
+static uint8_t fb_sent[FB_SIZE] __attribute__((aligned(32)));
+static tribuf_t fb_tribuf;
+
+/* Buffer arrière : seule cible de dessin de l'UI. */
+static uint8_t *buffer = fb[0];
 static const font_t *current_font = NULL;
 
-/* Dirty tracking */
-static volatile bool display_dirty = false;
-static uint8_t dirty_pages = 0;
+/* Région modifiée, par page : colonnes [lo, hi] (lo > hi = page intacte).
+   dirty_* suit le buffer arrière ; pending_* cumule les images publiées
+   depuis le dernier flush (protégé par le verrou système). */
+static uint8_t dirty_lo[OLED_PAGES], dirty_hi[OLED_PAGES];
+static uint8_t pending_lo[OLED_PAGES], pending_hi[OLED_PAGES];
+
+/* Flush asynchrone */
+static bool fb_sent_valid = false;
+#if !defined(SIMULATOR)
+static binary_semaphore_t spi_done;
+#endif
+static drv_display_flush_cb_t flush_cb = NULL;
+static bool display_initialized = false;
+
+static THD_WORKING_AREA(waDisplay, 512);
+
+#if !defined(SIMULATOR)
 
 /* ====================================================================== */
 /*                              UTILITAIRES GPIO                          */
@@ -47,20 +84,124 @@ static inline void dc_data(void) { palSetLine  (LINE_SPI5_DC_OLED); }
 /*                              UTILITAIRES SPI                           */
 /* ====================================================================== */
 
-static void send_cmd(uint8_t cmd) {
+/* Commandes en mode polling (quelques octets). */
+static void send_cmds(const uint8_t *cmds, size_t n) {
     dc_cmd();
     cs_low();
-    spiPolledExchange(&SPID2, cmd);
+    for (size_t i = 0; i < n; i++)
+        spiPolledExchange(&SPID2, cmds[i]);
     cs_high();
 }
 
-static void send_data(const uint8_t *data, size_t len) {
+/* Fin de DMA : relâche CS et réveille le thread d'affichage (ISR). */
+static void spi_done_cb(SPIDriver *spip) {
+    (void)spip;
+    cs_high();
+    chSysLockFromISR();
+    chBSemSignalI(&spi_done);
+    chSysUnlockFromISR();
+}
+
+/* Une page (ou une portion) en un seul transfert DMA. */
+static void send_data_dma(const uint8_t *data, size_t len) {
+    cacheBufferFlush(data, len);
     dc_data();
-    for (size_t i = 0; i < len; i++) {
-        cs_low();
-        spiPolledExchange(&SPID2, data[i]);
-        cs_high();
-    }
+    cs_low();
+    spiStartSend(&SPID2, len, data);
+    chBSemWait(&spi_done);
+}
+
+static void bus_acquire(void) { spiAcquireBus(&SPID2); }
+static void bus_release(void) { spiReleaseBus(&SPID2); }
+
+/* GPIO, SPI2 et reset matériel du contrôleur. */
+static void bus_init(void) {
+    /* GPIO OLED */
+    palSetLineMode(LINE_SPI5_CS_OLED,  PAL_MODE_OUTPUT_PUSHPULL);
+    palSetLineMode(LINE_SPI5_DC_OLED,  PAL_MODE_OUTPUT_PUSHPULL);
+    palSetLineMode(LINE_SPI5_RES_OLED, PAL_MODE_OUTPUT_PUSHPULL);
+
+    cs_high();
+    dc_data();
+    palSetLine(LINE_SPI5_RES_OLED);
+
+    /* SPI2 pins */
+    palSetLineMode(LINE_SPI2_SCK,
+                   PAL_MODE_ALTERNATE(5) | PAL_STM32_OSPEED_HIGHEST);
+    palSetLineMode(LINE_SPI2_MOSI,
+                   PAL_MODE_ALTERNATE(5) | PAL_STM32_OSPEED_HIGHEST);
+
+    chBSemObjectInit(&spi_done, true);
+    spiStart(&SPID2, &spicfg);
+
+    /* Reset OLED */
+    palClearLine(LINE_SPI5_RES_OLED);
+    chThdSleepMilliseconds(50);
+    palSetLine(LINE_SPI5_RES_OLED);
+    chThdSleepMilliseconds(50);
+}
+
+#else /* SIMULATOR */
+
+static void send_cmds(const uint8_t *cmds, size_t n) {
+    ssd130x_sim_write(false, cmds, n);
+}
+
+static void send_data_dma(const uint8_t *data, size_t len) {
+    ssd130x_sim_write(true, data, len);
+}
+
+static void bus_acquire(void) { }
+static void bus_release(void) { }
+
+static void bus_init(void) {
+    ssd130x_sim_reset();
+}
+
+#endif /* SIMULATOR */
+
+static void send_cmd(uint8_t cmd) {
+    send_cmds(&cmd, 1);
+}
+
+/* Fenêtre SSD130x (mode horizontal) : colonnes [x0, x1] de la page. */
+static void set_window(uint8_t page, uint8_t x0, uint8_t x1) {
+    const uint8_t cmds[6] = { 0x21, x0, x1, 0x22, page, page };
+    send_cmds(cmds, sizeof(cmds));
+}
+
+/* ====================================================================== */
+/*                                 DIFF                                   */
+/* ====================================================================== */
+
+/* Plage [x0, x1] des octets différents entre deux pages, cherchée dans les
+   mots couvrant [*x0, *x1] ; false si identiques. */
+static bool page_diff(const uint8_t *cur, const uint8_t *sent,
+                      uint8_t *x0, uint8_t *x1) {
+    const uint32_t *a = (const uint32_t *)cur;
+    const uint32_t *b = (const uint32_t *)sent;
+    const int end = *x1 / 4;
+
+    int lo = *x0 / 4;
+    while (lo <= end && a[lo] == b[lo])
+        lo++;
+    if (lo > end)
+        return false;
+
+    int hi = end;
+    while (a[hi] == b[hi])
+        hi--;
+
+    int first = lo * 4;
+    while (cur[first] == sent[first])
+        first++;
+    int last = hi * 4 + 3;
+    while (cur[last] == sent[last])
+        last--;
+
+    *x0 = (uint8_t)first;
+    *x1 = (uint8_t)last;
+    return true;
 }
 
 /* ====================================================================== */
@@ -71,6 +212,33 @@ uint8_t* drv_display_get_buffer(void) {
     return buffer;
 }
 
+static inline void mark_dirty(int page, int x0, int x1) {
+    if (x0 < dirty_lo[page])
+        dirty_lo[page] = (uint8_t)x0;
+    if (x1 > dirty_hi[page])
+        dirty_hi[page] = (uint8_t)x1;
+}
+
+static void dirty_reset(uint8_t *lo, uint8_t *hi) {
+    memset(lo, 0xFF, OLED_PAGES);
+    memset(hi, 0x00, OLED_PAGES);
+}
+
+void drv_display_invalidate(int x, int y, int w, int h) {
+    if (w <= 0 || h <= 0)
+        return;
+
+    const int x0 = (x < 0) ? 0 : x;
+    const int y0 = (y < 0) ? 0 : y;
+    const int x1 = (x + w > BRICK_OLED_WIDTH)  ? BRICK_OLED_WIDTH  : x + w;
+    const int y1 = (y + h > BRICK_OLED_HEIGHT) ? BRICK_OLED_HEIGHT : y + h;
+    if (x0 >= x1 || y0 >= y1)
+        return;
+
+    for (int page = y0 >> 3; page <= (y1 - 1) >> 3; page++)
+        mark_dirty(page, x0, x1 - 1);
+}
+
 /* ====================================================================== */
 /*                              PIXELS                                    */
 /* ====================================================================== */
@@ -83,17 +251,13 @@ static inline void set_pixel(int x, int y, bool on) {
     const int index = x + (y >> 3) * BRICK_OLED_WIDTH;
     const uint8_t mask = (uint8_t)(1U << (y & 7));
 
-    uint8_t old = buffer[index];
+    mark_dirty(y >> 3, x, x);
 
     if (on)
         buffer[index] |= mask;
     else
         buffer[index] &= (uint8_t)~mask;
 
-    if (buffer[index] != old) {
-        display_dirty = true;
-        dirty_pages |= (1U << (y >> 3));
-    }
 }
 
 void drv_display_draw_pixel(int x, int y, bool on) {
@@ -104,39 +268,173 @@ void drv_display_draw_pixel(int x, int y, bool on) {
 /*                              PRIMITIVES                                */
 /* ====================================================================== */
 
-void drv_display_draw_rect(int x, int y, int w, int h) {
+/* Les primitives travaillent par spans : pour chaque page touchée, un même
+   masque vertical est appliqué à une suite d'octets consécutifs, par mots
+   de 32 bits au milieu de la suite. */
+
+typedef enum {
+    SPAN_SET,
+    SPAN_CLEAR,
+    SPAN_INVERT
+} span_op_t;
+
+static void span_apply(uint8_t *p, int n, uint8_t mask, span_op_t op) {
+    while (n > 0 && ((uintptr_t)p & 3U) != 0U) {
+        if (op == SPAN_SET)        *p |= mask;
+        else if (op == SPAN_CLEAR) *p &= (uint8_t)~mask;
+        else                       *p ^= mask;
+        p++;
+        n--;
+    }
+
+    const uint32_t m32 = (uint32_t)mask * 0x01010101U;
+    uint32_t *w = (uint32_t *)p;
+    for (; n >= 4; n -= 4, w++) {
+        if (op == SPAN_SET)        *w |= m32;
+        else if (op == SPAN_CLEAR) *w &= ~m32;
+        else                       *w ^= m32;
+    }
+
+    p = (uint8_t *)w;
+    while (n-- > 0) {
+        if (op == SPAN_SET)        *p |= mask;
+        else if (op == SPAN_CLEAR) *p &= (uint8_t)~mask;
+        else                       *p ^= mask;
+        p++;
+    }
+}
+
+/* Applique op au rectangle (découpé à l'écran), une span par page. */
+static void rect_apply(int x, int y, int w, int h, span_op_t op) {
     if (w <= 0 || h <= 0)
         return;
 
-    for (int ix = 0; ix < w; ix++) {
-        set_pixel(x + ix, y, true);
-        set_pixel(x + ix, y + h - 1, true);
-    }
+    const int x0 = (x < 0) ? 0 : x;
+    const int y0 = (y < 0) ? 0 : y;
+    const int x1 = (x + w > BRICK_OLED_WIDTH)  ? BRICK_OLED_WIDTH  : x + w;
+    const int y1 = (y + h > BRICK_OLED_HEIGHT) ? BRICK_OLED_HEIGHT : y + h;
+    if (x0 >= x1 || y0 >= y1)
+        return;
 
-    for (int iy = 0; iy < h; iy++) {
-        set_pixel(x, y + iy, true);
-        set_pixel(x + w - 1, y + iy, true);
+    const int first = y0 >> 3;
+    const int last  = (y1 - 1) >> 3;
+
+    for (int page = first; page <= last; page++) {
+        uint8_t mask = 0xFF;
+        if (page == first)
+            mask &= (uint8_t)(0xFFU << (y0 & 7));
+        if (page == last)
+            mask &= (uint8_t)(0xFFU >> (7 - ((y1 - 1) & 7)));
+        span_apply(&buffer[page * BRICK_OLED_WIDTH + x0], x1 - x0, mask, op);
+        mark_dirty(page, x0, x1 - 1);
     }
 }
 
-void drv_display_fill_rect(int x, int y, int w, int h) {
+void drv_display_draw_hline(int x, int y, int w, bool on) {
+    rect_apply(x, y, w, 1, on ? SPAN_SET : SPAN_CLEAR);
+}
+
+void drv_display_draw_vline(int x, int y, int h, bool on) {
+    rect_apply(x, y, 1, h, on ? SPAN_SET : SPAN_CLEAR);
+}
+
+void drv_display_draw_rect(int x, int y, int w, int h) {
     if (w <= 0 || h <= 0)
         return;
 
-    for (int iy = 0; iy < h; iy++) {
-        for (int ix = 0; ix < w; ix++) {
-            set_pixel(x + ix, y + iy, true);
+    rect_apply(x, y, w, 1, SPAN_SET);
+    rect_apply(x, y + h - 1, w, 1, SPAN_SET);
+    rect_apply(x, y, 1, h, SPAN_SET);
+    rect_apply(x + w - 1, y, 1, h, SPAN_SET);
+}
+
+void drv_display_fill_rect(int x, int y, int w, int h) {
+    rect_apply(x, y, w, h, SPAN_SET);
+}
+
+void drv_display_clear_rect(int x, int y, int w, int h) {
+    rect_apply(x, y, w, h, SPAN_CLEAR);
+}
+
+void drv_display_invert_rect(int x, int y, int w, int h) {
+    rect_apply(x, y, w, h, SPAN_INVERT);
+}
+
+/* Bresenham ; les pixels consécutifs d'une même ligne ou colonne sont
+   regroupés en une span au lieu d'être posés un par un. */
+void drv_display_draw_line(int x0, int y0, int x1, int y1, bool on) {
+    const span_op_t op = on ? SPAN_SET : SPAN_CLEAR;
+    const int dx =  (x1 > x0) ? x1 - x0 : x0 - x1;
+    const int dy = -((y1 > y0) ? y1 - y0 : y0 - y1);
+    const int sx = (x0 < x1) ? 1 : -1;
+    const int sy = (y0 < y1) ? 1 : -1;
+    int err = dx + dy;
+
+    /* Span courante : rectangle rw x rh dont une dimension vaut 1. */
+    int rx = x0, ry = y0, rw = 1, rh = 1;
+
+    while (x0 != x1 || y0 != y1) {
+        const int e2 = 2 * err;
+        if (e2 >= dy) { err += dy; x0 += sx; }
+        if (e2 <= dx) { err += dx; y0 += sy; }
+
+        if (rh == 1 && y0 == ry && (x0 == rx - 1 || x0 == rx + rw)) {
+            if (x0 < rx)
+                rx = x0;
+            rw++;
+        } else if (rw == 1 && x0 == rx && (y0 == ry - 1 || y0 == ry + rh)) {
+            if (y0 < ry)
+                ry = y0;
+            rh++;
+        } else {
+            rect_apply(rx, ry, rw, rh, op);
+            rx = x0; ry = y0; rw = 1; rh = 1;
         }
     }
+    rect_apply(rx, ry, rw, rh, op);
 }
 
-void drv_display_clear_rect(int x, int y, int w, int h) {
-    if (w <= 0 || h <= 0)
+/* Copie opaque d'un bitmap au format page (w octets par page source,
+   bit0 = pixel haut) : chaque octet source touche au plus deux pages. */
+void drv_display_draw_bitmap(int x, int y, int w, int h, const uint8_t *bmp) {
+    if (!bmp || w <= 0 || h <= 0)
+        return;
+
+    const int c0 = (x < 0) ? -x : 0;
+    const int c1 = (x + w > BRICK_OLED_WIDTH) ? BRICK_OLED_WIDTH - x : w;
+    if (c0 >= c1)
         return;
 
-    for (int iy = 0; iy < h; iy++) {
-        for (int ix = 0; ix < w; ix++) {
-            set_pixel(x + ix, y + iy, false);
+    const int src_pages = (h + 7) >> 3;
+
+    for (int sp = 0; sp < src_pages; sp++) {
+        const int dy = y + sp * 8;
+        const int rows = h - sp * 8;
+        const uint8_t smask = (rows >= 8) ? 0xFF : (uint8_t)((1U << rows) - 1U);
+        const int page  = dy >> 3;          /* plancher, y compris dy < 0 */
+        const int shift = dy & 7;
+        const uint8_t *src = &bmp[sp * w];
+
+        if (page >= OLED_PAGES || page + 1 < 0)
+            continue;
+
+        if (page >= 0) {
+            uint8_t *dst = &buffer[page * BRICK_OLED_WIDTH];
+            mark_dirty(page, x + c0, x + c1 - 1);
+            const uint8_t m = (uint8_t)(smask << shift);
+            for (int c = c0; c < c1; c++)
+                dst[x + c] = (uint8_t)((dst[x + c] & ~m) | ((src[c] << shift) & m));
+        }
+
+        if (shift != 0 && page + 1 < OLED_PAGES) {
+            uint8_t *dst = &buffer[(page + 1) * BRICK_OLED_WIDTH];
+            const uint8_t m = (uint8_t)(smask >> (8 - shift));
+            if (m == 0)
+                continue;
+            mark_dirty(page + 1, x + c0, x + c1 - 1);
+            for (int c = c0; c < c1; c++)
+                dst[x + c] = (uint8_t)((dst[x + c] & ~m) |
+                                       ((src[c] >> (8 - shift)) & m));
         }
     }
 }
@@ -149,37 +447,112 @@ void drv_display_set_font(const font_t *font) {
     current_font = font;
 }
 
+const font_t *drv_display_get_font(void) {
+    return current_font;
+}
+
 static inline uint8_t font_advance(const font_t *f) {
     return (uint8_t)(f->width + f->spacing);
 }
 
-void drv_display_draw_char(uint8_t x, uint8_t y, char c) {
-    if (!current_font)
-        return;
+/* Destination d'une ligne de texte : la hauteur d'un glyphe (<= 8) couvre
+   au plus deux pages, calculées une seule fois par chaîne. */
+typedef struct {
+    uint8_t *p0;     /* page contenant y */
+    uint8_t *p1;     /* page suivante, NULL si hors écran ou inutile */
+    uint8_t  page;   /* index de p0 */
+    uint8_t  shift;  /* y & 7 */
+    uint8_t  mask;   /* bits utiles d'une colonne (hauteur de la police) */
+} glyph_dst_t;
+
+static bool glyph_dst(const font_t *f, uint8_t y, glyph_dst_t *d) {
+    if (y >= BRICK_OLED_HEIGHT)
+        return false;
+
+    const uint8_t page = (uint8_t)(y >> 3);
+
+    d->page  = page;
+    d->shift = (uint8_t)(y & 7);
+    d->mask  = (f->height >= 8) ? 0xFF : (uint8_t)((1U << f->height) - 1U);
+    d->p0    = &buffer[page * BRICK_OLED_WIDTH];
+    d->p1    = (d->shift != 0 && page + 1 < OLED_PAGES &&
+                (d->mask >> (8 - d->shift)) != 0)
+             ? d->p0 + BRICK_OLED_WIDTH : NULL;
+    return true;
+}
 
-    if ((uint8_t)c < current_font->first ||
-        (uint8_t)c > current_font->last)
+/* Blitte un glyphe : chaque colonne est décalée puis combinée (OR) dans
+   une ou deux pages, un octet par page au lieu d'un RMW par pixel. */
+static void blit_glyph(const font_t *f, const glyph_dst_t *d,
+                       uint8_t x, char c) {
+    if ((uint8_t)c < f->first || (uint8_t)c > f->last)
         c = '?';
 
-    for (uint8_t col = 0; col < current_font->width; col++) {
-        uint8_t bits = current_font->get_col(c, col);
-        for (uint8_t row = 0; row < current_font->height; row++) {
-            if (bits & (1U << row))
-                set_pixel(x + col, y + row, true);
-        }
+    uint8_t w = f->width;
+    if (w > BRICK_OLED_WIDTH - x)
+        w = (uint8_t)(BRICK_OLED_WIDTH - x);
+
+    const uint8_t *cols = f->atlas
+        ? &f->atlas[((uint8_t)c - f->first) * f->stride] : NULL;
+    uint8_t *p0 = d->p0 + x;
+    uint8_t *p1 = d->p1 ? d->p1 + x : NULL;
+
+    for (uint8_t col = 0; col < w; col++) {
+        const uint8_t bits = (uint8_t)((cols ? cols[col] : f->get_col(c, col))
+                                       & d->mask);
+        if (!bits)
+            continue;
+        p0[col] |= (uint8_t)(bits << d->shift);
+        if (p1)
+            p1[col] |= (uint8_t)(bits >> (8 - d->shift));
     }
 }
 
-void drv_display_draw_text(uint8_t x, uint8_t y, const char *txt) {
-    if (!current_font || !txt)
+/* Région modifiée d'une chaîne : colonnes [x0, x1] des pages p0 (et p1). */
+static void glyph_dst_mark(const glyph_dst_t *d, uint8_t x0, int x1) {
+    if (x1 >= BRICK_OLED_WIDTH)
+        x1 = BRICK_OLED_WIDTH - 1;
+    mark_dirty(d->page, x0, x1);
+    if (d->p1)
+        mark_dirty(d->page + 1, x0, x1);
+}
+
+void drv_display_draw_char(uint8_t x, uint8_t y, char c) {
+    glyph_dst_t d;
+
+    if (!current_font || x >= BRICK_OLED_WIDTH ||
+        !glyph_dst(current_font, y, &d))
+        return;
+
+    blit_glyph(current_font, &d, x, c);
+    glyph_dst_mark(&d, x, x + current_font->width - 1);
+}
+
+void drv_display_draw_text_with_font(const font_t *font,
+                                     uint8_t x, uint8_t y,
+                                     const char *txt) {
+    glyph_dst_t d;
+
+    if (!font || !txt || !glyph_dst(font, y, &d))
         return;
 
-    const uint8_t adv = font_advance(current_font);
+    const uint8_t adv = font_advance(font);
+    const uint8_t x0 = x;
 
-    while (*txt && x < BRICK_OLED_WIDTH) {
-        drv_display_draw_char(x, y, *txt++);
+    if (!*txt || x >= BRICK_OLED_WIDTH)
+        return;
+
+    while (true) {
+        blit_glyph(font, &d, x, *txt++);
+        if (!*txt || adv >= BRICK_OLED_WIDTH - x)
+            break;
         x = (uint8_t)(x + adv);
     }
+    glyph_dst_mark(&d, x0, x + font->width - 1);
+}
+
+void drv_display_draw_text(uint8_t x, uint8_t y, const char *txt) {
+    drv_display_draw_text_with_font(current_font, x, y, txt);
 }
 
 void drv_display_draw_number(uint8_t x, uint8_t y, int num) {
@@ -193,29 +566,90 @@ void drv_display_draw_number(uint8_t x, uint8_t y, int num) {
 /* ====================================================================== */
 
 void drv_display_clear(void) {
-    memset(buffer, 0x00, sizeof(buffer));
-    display_dirty = true;
-    dirty_pages = 0xFF;
+    memset(buffer, 0x00, FB_SIZE);
+    memset(dirty_lo, 0x00, OLED_PAGES);
+    memset(dirty_hi, BRICK_OLED_WIDTH - 1, OLED_PAGES);
 }
 
 void drv_display_update(void) {
-    if (!display_dirty)
-        return;
+    /* Publie le buffer arrière comme image la plus récente (non bloquant).
+       Le nouveau buffer arrière repart de cette image : le dessin reste
+       incrémental côté UI. */
+    uint8_t *done = buffer;
+
+    /* Région et image sont publiées ensemble : le thread ne peut pas
+       prendre l'une sans l'autre. */
+    osalSysLock();
+    for (uint8_t page = 0; page < OLED_PAGES; page++) {
+        if (dirty_lo[page] < pending_lo[page])
+            pending_lo[page] = dirty_lo[page];
+        if (dirty_hi[page] > pending_hi[page])
+            pending_hi[page] = dirty_hi[page];
+    }
+    tribufSwapBackI(&fb_tribuf);
+    osalOsRescheduleS();
+    osalSysUnlock();
 
-    for (uint8_t page = 0; page < 8; page++) {
-        if (!(dirty_pages & (1U << page)))
-            continue;
+    dirty_reset(dirty_lo, dirty_hi);
+    buffer = tribufGetBack(&fb_tribuf);
+    memcpy(buffer, done, FB_SIZE);
+}
 
-        send_cmd(0xB0 + page);
-        send_cmd(0x00);
-        send_cmd(0x10);
+void drv_display_set_flush_callback(drv_display_flush_cb_t cb) {
+    flush_cb = cb;
+}
 
-        send_data(&buffer[page * BRICK_OLED_WIDTH],
-                  BRICK_OLED_WIDTH);
-    }
+/* ====================================================================== */
+/*                           THREAD D'AFFICHAGE                           */
+/* ====================================================================== */
 
-    display_dirty = false;
-    dirty_pages = 0;
+static THD_FUNCTION(thdDisplay, arg) {
+    (void)arg;
+    chRegSetThreadName("DISPLAY");
+
+    while (true) {
+        /* Seule l'image la plus récente est consommée : les images
+           intermédiaires publiées pendant un envoi sont sautées. */
+        uint8_t lo[OLED_PAGES], hi[OLED_PAGES];
+
+        tribufWaitReady(&fb_tribuf);
+        osalSysLock();
+        tribufSwapFrontI(&fb_tribuf);
+        memcpy(lo, pending_lo, OLED_PAGES);
+        memcpy(hi, pending_hi, OLED_PAGES);
+        dirty_reset(pending_lo, pending_hi);
+        osalSysUnlock();
+        const uint8_t *front = tribufGetFront(&fb_tribuf);
+
+        bool sent = false;
+        bus_acquire();
+        for (uint8_t page = 0; page < OLED_PAGES; page++) {
+            const size_t off = (size_t)page * BRICK_OLED_WIDTH;
+            uint8_t x0 = 0, x1 = BRICK_OLED_WIDTH - 1;
+
+            /* Seules les colonnes touchées depuis le dernier flush sont
+               comparées à ce que l'écran affiche. */
+            if (fb_sent_valid) {
+                if (lo[page] > hi[page])
+                    continue;
+                x0 = lo[page];
+                x1 = hi[page];
+                if (!page_diff(&front[off], &fb_sent[off], &x0, &x1))
+                    continue;
+            }
+
+            const size_t len = (size_t)(x1 - x0) + 1U;
+            set_window(page, x0, x1);
+            send_data_dma(&front[off + x0], len);
+            memcpy(&fb_sent[off + x0], &front[off + x0], len);
+            sent = true;
+        }
+        bus_release();
+        fb_sent_valid = true;
+
+        if (sent && flush_cb)
+            flush_cb();
+    }
 }
 
 /* ====================================================================== */
@@ -224,28 +658,16 @@ void drv_display_update(void) {
 
 void drv_display_init(void) {
 
-    /* GPIO OLED */
-    palSetLineMode(LINE_SPI5_CS_OLED,  PAL_MODE_OUTPUT_PUSHPULL);
-    palSetLineMode(LINE_SPI5_DC_OLED,  PAL_MODE_OUTPUT_PUSHPULL);
-    palSetLineMode(LINE_SPI5_RES_OLED, PAL_MODE_OUTPUT_PUSHPULL);
-
-    cs_high();
-    dc_data();
-    palSetLine(LINE_SPI5_RES_OLED);
-
-    /* SPI2 pins */
-    palSetLineMode(LINE_SPI2_SCK,
-                   PAL_MODE_ALTERNATE(5) | PAL_STM32_OSPEED_HIGHEST);
-    palSetLineMode(LINE_SPI2_MOSI,
-                   PAL_MODE_ALTERNATE(5) | PAL_STM32_OSPEED_HIGHEST);
+    if (display_initialized)
+        return;
+    display_initialized = true;
 
-    spiStart(&SPID2, &spicfg);
+    tribufObjectInit(&fb_tribuf, fb[1], fb[0], fb[2]);
+    buffer = tribufGetBack(&fb_tribuf);
+    dirty_reset(dirty_lo, dirty_hi);
+    dirty_reset(pending_lo, pending_hi);
 
-    /* Reset OLED */
-    palClearLine(LINE_SPI5_RES_OLED);
-    chThdSleepMilliseconds(50);
-    palSetLine(LINE_SPI5_RES_OLED);
-    chThdSleepMilliseconds(50);
+    bus_init();
 
     /* Init SSD130x */
     send_cmd(0xAE);
@@ -260,6 +682,9 @@ void drv_display_init(void) {
     send_cmd(0xDA); send_cmd(0x12);
     send_cmd(0xAF);
 
+    chThdCreateStatic(waDisplay, sizeof(waDisplay), NORMALPRIO,
+                      thdDisplay, NULL);
+
     drv_display_clear();
     drv_display_update();
 
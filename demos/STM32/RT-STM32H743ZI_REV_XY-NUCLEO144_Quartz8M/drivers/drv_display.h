@@ -15,16 +15,29 @@
 /*                              API PUBLIQUE                              */
 /* ====================================================================== */
 
+/* Appelé par le thread d'affichage à la fin d'un flush (toutes pages envoyées). */
+typedef void (*drv_display_flush_cb_t)(void);
+
 void drv_display_init(void);
 void drv_display_clear(void);
+/* Non bloquant : publie l'image dessinée (triple buffer) ; le thread
+   d'affichage n'envoie que les octets différents de la dernière image envoyée. */
 void drv_display_update(void);
+void drv_display_set_flush_callback(drv_display_flush_cb_t cb);
+/* Buffer arrière courant (change à chaque drv_display_update()).
+   Toute écriture directe doit être signalée par drv_display_invalidate(). */
 uint8_t* drv_display_get_buffer(void);
+/* Ajoute un rectangle à la région modifiée de l'image en cours. Les
+   primitives de dessin le font d'elles-mêmes ; le thread d'affichage ne
+   compare à l'écran que cette région. */
+void drv_display_invalidate(int x, int y, int w, int h);
 
 /* ====================================================================== */
 /*                           GESTION DES POLICES                          */
 /* ====================================================================== */
 
 void drv_display_set_font(const font_t *font);
+const font_t *drv_display_get_font(void);
 
 /* ====================================================================== */
 /*                           DESSIN ET TEXTE                              */
@@ -60,5 +73,16 @@ void drv_display_fill_rect(int x, int y, int w, int h);
 /* Optionnel mais utile */
 void drv_display_clear_rect(int x, int y, int w, int h);
 
+/* Inverse la zone (surbrillance d'une sélection) */
+void drv_display_invert_rect(int x, int y, int w, int h);
+
+/* Lignes */
+void drv_display_draw_hline(int x, int y, int w, bool on);
+void drv_display_draw_vline(int x, int y, int h, bool on);
+void drv_display_draw_line(int x0, int y0, int x1, int y1, bool on);
+
+/* Bitmap au format page (w octets par page, bit0 = pixel haut), opaque */
+void drv_display_draw_bitmap(int x, int y, int w, int h, const uint8_t *bmp);
+
 
 #endif /* DRV_DISPLAY_H */
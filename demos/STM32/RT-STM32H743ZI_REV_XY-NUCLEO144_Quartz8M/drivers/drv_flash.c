@@ -0,0 +1,366 @@
+/**
+ * @file drv_flash.c
+ * @brief @p BaseFlash sur les derniers secteurs de la banque 2 du STM32H743.
+ *
+ * Correspondance logique → physique : l'octet logique `o` est rangé à
+ * `(o / DRV_FLASH_UNIT) * DRV_FLASH_WORD + o % DRV_FLASH_UNIT`. Une
+ * programmation complète chaque unité touchée avec 0xFF et écrit un mot
+ * flash par unité ; elle est refusée si l'unité n'est pas vierge (l'ECC
+ * serait corrompu).
+ *
+ * Le firmware s'exécute depuis la banque 1 : programmer ou effacer la
+ * banque 2 ne bloque pas l'exécution. L'effacement est asynchrone
+ * (flashStartEraseSector() puis flashQueryErase()), comme dans EFL.
+ *
+ * @ingroup drivers
+ */
+
+#include "drv_flash.h"
+#include <string.h>
+
+#define UNITS_PER_SECTOR    (DRV_FLASH_SECTOR_SIZE / DRV_FLASH_WORD)
+#define PHYS_SIZE           (DRV_FLASH_SECTORS * DRV_FLASH_SECTOR_SIZE)
+
+/* ====================================================================== */
+/*                             VARIABLES INTERNES                         */
+/* ====================================================================== */
+
+static const flash_descriptor_t descriptor = {
+    .attributes    = FLASH_ATTR_ERASED_IS_ONE,
+    .page_size     = DRV_FLASH_UNIT,
+    .sectors_count = DRV_FLASH_SECTORS,
+    .sectors       = NULL,
+    .sectors_size  = DRV_FLASH_LOGICAL_SECTOR,
+    .address       = NULL,
+    .size          = DRV_FLASH_SECTORS * DRV_FLASH_LOGICAL_SECTOR
+};
+
+static BaseFlash flash;
+static drv_flash_stats_t stats;
+
+/* ====================================================================== */
+/*                          ACCÈS PHYSIQUE (CIBLE)                        */
+/* ====================================================================== */
+
+#if !defined(SIMULATOR)
+
+#define FLASH_BASE_ADDR     (FLASH_BANK2_BASE + DRV_FLASH_FIRST_SECTOR * DRV_FLASH_SECTOR_SIZE)
+#define FLASH_SR_ERRORS     (FLASH_SR_WRPERR | FLASH_SR_PGSERR | FLASH_SR_STRBERR | \
+                             FLASH_SR_INCERR | FLASH_SR_OPERR)
+#define FLASH_SR_PENDING    (FLASH_SR_BSY | FLASH_SR_QW | FLASH_SR_WBNE)
+
+/* Fins des régions de code du script de liens (STM32H743xI_brick.ld) :
+   l'éditeur de liens y borne tout ce qui est chargé en flash, images
+   .data et *_init comprises. */
+extern uint8_t __flash0_end__[];
+extern uint8_t __flash2_end__[];
+
+static const uint8_t *phys_ptr(uint32_t poff) {
+    return (const uint8_t *)(FLASH_BASE_ADDR + poff);
+}
+
+static void bank_unlock(void) {
+    if (FLASH->CR2 & FLASH_CR_LOCK) {
+        FLASH->KEYR2 = 0x45670123U;
+        FLASH->KEYR2 = 0xCDEF89ABU;
+    }
+    FLASH->CCR2 = FLASH_SR_ERRORS | FLASH_SR_EOP;
+}
+
+static void bank_lock(void) {
+    FLASH->CR2 |= FLASH_CR_LOCK;
+}
+
+static bool word_program(uint32_t poff, const uint32_t *w) {
+    volatile uint32_t *dst = (volatile uint32_t *)(FLASH_BASE_ADDR + poff);
+    bool ok;
+
+    bank_unlock();
+    FLASH->CR2 = (FLASH->CR2 & ~FLASH_CR_PSIZE) | FLASH_CR_PSIZE_1 | FLASH_CR_PG;
+    __ISB();
+    __DSB();
+
+    for (uint32_t i = 0; i < DRV_FLASH_WORD / 4U; i++)
+        dst[i] = w[i];
+
+    __ISB();
+    __DSB();
+    while (FLASH->SR2 & FLASH_SR_PENDING) {
+    }
+
+    ok = (FLASH->SR2 & FLASH_SR_ERRORS) == 0U;
+    FLASH->CR2 &= ~FLASH_CR_PG;
+    bank_lock();
+
+    cacheBufferInvalidate((void *)dst, DRV_FLASH_WORD);
+    return ok;
+}
+
+static void sector_erase_start(flash_sector_t sector) {
+    bank_unlock();
+    FLASH->CR2 = (FLASH->CR2 & ~(FLASH_CR_SNB | FLASH_CR_PSIZE)) |
+                 FLASH_CR_PSIZE_1 | FLASH_CR_SER |
+                 ((DRV_FLASH_FIRST_SECTOR + sector) << FLASH_CR_SNB_Pos);
+    FLASH->CR2 |= FLASH_CR_START;
+}
+
+static bool sector_erase_busy(void) {
+    return (FLASH->SR2 & FLASH_SR_PENDING) != 0U;
+}
+
+/* Fin d'effacement : false si le contrôleur a signalé une erreur. */
+static bool sector_erase_end(flash_sector_t sector) {
+    const bool ok = (FLASH->SR2 & FLASH_SR_ERRORS) == 0U;
+
+    FLASH->CR2 &= ~(FLASH_CR_SER | FLASH_CR_SNB);
+    bank_lock();
+    cacheBufferInvalidate((void *)phys_ptr(sector * DRV_FLASH_SECTOR_SIZE),
+                          DRV_FLASH_SECTOR_SIZE);
+    return ok;
+}
+
+static bool region_free(void) {
+    return ((uintptr_t)__flash0_end__ <= FLASH_BASE_ADDR) &&
+           ((uintptr_t)__flash2_end__ <= FLASH_BASE_ADDR);
+}
+
+#else /* SIMULATOR */
+
+/* ====================================================================== */
+/*                      ACCÈS PHYSIQUE (FLASH EN RAM)                     */
+/* ====================================================================== */
+
+/* Conservée d'un drv_flash_init() à l'autre : un « redémarrage » relit. */
+static uint8_t sim_image[PHYS_SIZE];
+static bool    sim_ready = false;
+
+static const uint8_t *phys_ptr(uint32_t poff) {
+    return &sim_image[poff];
+}
+
+static bool word_program(uint32_t poff, const uint32_t *w) {
+    memcpy(&sim_image[poff], w, DRV_FLASH_WORD);
+    return true;
+}
+
+static void sector_erase_start(flash_sector_t sector) {
+    memset(&sim_image[sector * DRV_FLASH_SECTOR_SIZE], 0xFF, DRV_FLASH_SECTOR_SIZE);
+}
+
+static bool sector_erase_busy(void) {
+    return false;
+}
+
+static bool sector_erase_end(flash_sector_t sector) {
+    (void)sector;
+    return true;
+}
+
+static bool region_free(void) {
+    if (!sim_ready) {
+        memset(sim_image, 0xFF, sizeof(sim_image));
+        sim_ready = true;
+    }
+    return true;
+}
+
+uint8_t *drv_flash_sim_image(void) {
+    return sim_image;
+}
+
+#endif /* SIMULATOR */
+
+/* ====================================================================== */
+/*                             UNITÉS LOGIQUES                            */
+/* ====================================================================== */
+
+static uint32_t phys_offset(flash_offset_t offset) {
+    return (offset / DRV_FLASH_UNIT) * DRV_FLASH_WORD + offset % DRV_FLASH_UNIT;
+}
+
+static bool word_erased(uint32_t poff) {
+    const uint8_t *p = phys_ptr(poff);
+
+    for (uint32_t i = 0; i < DRV_FLASH_WORD; i++) {
+        if (p[i] != 0xFFU)
+            return false;
+    }
+    return true;
+}
+
+static bool range_valid(flash_offset_t offset, size_t n) {
+    return offset <= descriptor.size && n <= descriptor.size - offset;
+}
+
+/* ====================================================================== */
+/*                              MÉTHODES VMT                              */
+/* ====================================================================== */
+
+static const flash_descriptor_t *lld_get_descriptor(void *instance) {
+    (void)instance;
+    return &descriptor;
+}
+
+static flash_error_t lld_read(void *instance, flash_offset_t offset,
+                              size_t n, uint8_t *rp) {
+    (void)instance;
+
+    if (!range_valid(offset, n))
+        return FLASH_ERROR_READ;
+    if (flash.state == FLASH_ERASE)
+        return FLASH_BUSY_ERASING;
+
+    while (n > 0U) {
+        size_t chunk = DRV_FLASH_UNIT - offset % DRV_FLASH_UNIT;
+        if (chunk > n)
+            chunk = n;
+
+        memcpy(rp, phys_ptr(phys_offset(offset)), chunk);
+        rp += chunk;
+        offset += (flash_offset_t)chunk;
+        n -= chunk;
+    }
+    return FLASH_NO_ERROR;
+}
+
+static flash_error_t lld_program(void *instance, flash_offset_t offset,
+                                 size_t n, const uint8_t *pp) {
+    (void)instance;
+
+    if (!range_valid(offset, n) || (offset % DRV_FLASH_UNIT) != 0U) {
+        stats.errors++;
+        return FLASH_ERROR_PROGRAM;
+    }
+    if (flash.state == FLASH_ERASE)
+        return FLASH_BUSY_ERASING;
+
+    flash.state = FLASH_PGM;
+    while (n > 0U) {
+        const size_t chunk = (n < DRV_FLASH_UNIT) ? n : DRV_FLASH_UNIT;
+        const uint32_t poff = phys_offset(offset);
+        uint32_t w[DRV_FLASH_WORD / 4U];
+
+        /* Mot déjà écrit : le reprogrammer casserait l'ECC */
+        if (!word_erased(poff)) {
+            stats.errors++;
+            flash.state = FLASH_READY;
+            return FLASH_ERROR_PROGRAM;
+        }
+
+        memset(w, 0xFF, sizeof(w));
+        memcpy(w, pp, chunk);
+        if (!word_program(poff, w)) {
+            stats.errors++;
+            flash.state = FLASH_READY;
+            return FLASH_ERROR_PROGRAM;
+        }
+        stats.programs++;
+
+        pp += chunk;
+        offset += (flash_offset_t)chunk;
+        n -= chunk;
+    }
+    flash.state = FLASH_READY;
+    return FLASH_NO_ERROR;
+}
+
+static flash_error_t lld_start_erase_all(void *instance) {
+    (void)instance;
+    return FLASH_ERROR_UNIMPLEMENTED;
+}
+
+static flash_sector_t erasing_sector;
+
+static flash_error_t lld_start_erase_sector(void *instance, flash_sector_t sector) {
+    (void)instance;
+
+    if (sector >= DRV_FLASH_SECTORS)
+        return FLASH_ERROR_ERASE;
+    if (flash.state == FLASH_ERASE)
+        return FLASH_BUSY_ERASING;
+
+    flash.state = FLASH_ERASE;
+    erasing_sector = sector;
+    sector_erase_start(sector);
+    return FLASH_NO_ERROR;
+}
+
+static flash_error_t lld_query_erase(void *instance, uint32_t *msec) {
+    (void)instance;
+
+    if (flash.state != FLASH_ERASE)
+        return FLASH_NO_ERROR;
+
+    if (sector_erase_busy()) {
+        if (msec != NULL)
+            *msec = DRV_FLASH_ERASE_POLL_MS;
+        return FLASH_BUSY_ERASING;
+    }
+
+    flash.state = FLASH_READY;
+    stats.erases++;
+    if (!sector_erase_end(erasing_sector)) {
+        stats.errors++;
+        return FLASH_ERROR_ERASE;
+    }
+    return FLASH_NO_ERROR;
+}
+
+static flash_error_t lld_verify_erase(void *instance, flash_sector_t sector) {
+    (void)instance;
+
+    if (sector >= DRV_FLASH_SECTORS)
+        return FLASH_ERROR_VERIFY;
+    if (flash.state == FLASH_ERASE)
+        return FLASH_BUSY_ERASING;
+
+    for (uint32_t u = 0; u < UNITS_PER_SECTOR; u++) {
+        if (!word_erased(sector * DRV_FLASH_SECTOR_SIZE + u * DRV_FLASH_WORD))
+            return FLASH_ERROR_VERIFY;
+    }
+    return FLASH_NO_ERROR;
+}
+
+/* Un seul utilisateur (le stockage de calibration) : pas d'exclusion. */
+static flash_error_t lld_acquire_exclusive(void *instance) {
+    (void)instance;
+    return FLASH_ERROR_UNIMPLEMENTED;
+}
+
+static flash_error_t lld_release_exclusive(void *instance) {
+    (void)instance;
+    return FLASH_ERROR_UNIMPLEMENTED;
+}
+
+static const struct BaseFlashVMT vmt = {
+    (size_t)0,
+    lld_get_descriptor,
+    lld_read,
+    lld_program,
+    lld_start_erase_all,
+    lld_start_erase_sector,
+    lld_query_erase,
+    lld_verify_erase,
+    lld_acquire_exclusive,
+    lld_release_exclusive
+};
+
+/* ====================================================================== */
+/*                                   API                                  */
+/* ====================================================================== */
+
+BaseFlash *drv_flash_init(void) {
+    flash.vmt = &vmt;
+    flash.state = FLASH_STOP;
+    memset(&stats, 0, sizeof(stats));
+
+    if (!region_free())
+        return NULL;
+
+    flash.state = FLASH_READY;
+    return &flash;
+}
+
+void drv_flash_get_stats(drv_flash_stats_t *out) {
+    *out = stats;
+}
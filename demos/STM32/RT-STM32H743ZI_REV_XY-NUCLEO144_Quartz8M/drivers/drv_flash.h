@@ -0,0 +1,75 @@
+/**
+ * @file drv_flash.h
+ * @brief Flash interne (fin de banque 2) exposée comme un @p BaseFlash pour MFS.
+ *
+ * ChibiOS 21.11 ne fournit pas de driver EFL pour le STM32H7 : ce module
+ * implémente directement l'interface @p BaseFlash (celle qu'expose
+ * EFlashDriver), seule chose dont MFS a besoin.
+ *
+ * Contrainte H7 : la flash se programme par mots de 256 bits (32 octets)
+ * protégés par ECC, et un mot déjà écrit ne se reprogramme pas. MFS écrit
+ * pourtant l'en-tête d'un enregistrement en deux fois (le « magic » en
+ * dernier, pour sceller). On présente donc une flash logique où chaque
+ * unité de DRV_FLASH_UNIT octets occupe un mot physique entier : avec
+ * MFS_CFG_MEMORY_ALIGNMENT = DRV_FLASH_UNIT, chaque écriture MFS commence
+ * sur une unité vierge. Capacité logique = capacité physique / 4.
+ *
+ * En SIMULATOR, les secteurs sont un tableau en RAM qui applique la même
+ * règle (une unité ne s'écrit qu'une fois entre deux effacements).
+ *
+ * @ingroup drivers
+ */
+
+#ifndef DRV_FLASH_H
+#define DRV_FLASH_H
+
+#include "ch.h"
+#include "hal.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ====================================================================== */
+/*                             CONFIGURATION                              */
+/* ====================================================================== */
+
+/* Premier secteur utilisé dans la banque 2 (0..7) et nombre de secteurs.
+   Doit rester hors de flash0/flash2 dans STM32H743xI_brick.ld. */
+#ifndef DRV_FLASH_FIRST_SECTOR
+#define DRV_FLASH_FIRST_SECTOR      6U
+#endif
+#ifndef DRV_FLASH_SECTORS
+#define DRV_FLASH_SECTORS           2U
+#endif
+
+/* Géométrie H7 : secteurs de 128 Ko, mot flash de 32 octets. */
+#define DRV_FLASH_SECTOR_SIZE       0x20000U
+#define DRV_FLASH_WORD              32U
+
+/* Unité logique : un mot flash par unité. */
+#define DRV_FLASH_UNIT              8U
+#define DRV_FLASH_LOGICAL_SECTOR    (DRV_FLASH_SECTOR_SIZE / DRV_FLASH_WORD * DRV_FLASH_UNIT)
+
+/* Attente conseillée entre deux interrogations d'effacement (ms). */
+#define DRV_FLASH_ERASE_POLL_MS     10U
+
+/* ====================================================================== */
+/*                              API PUBLIQUE                              */
+/* ====================================================================== */
+
+typedef struct {
+    uint32_t programs;          /* Mots flash programmés */
+    uint32_t erases;            /* Secteurs effacés */
+    uint32_t errors;            /* Écritures refusées ou en échec */
+} drv_flash_stats_t;
+
+/* Prépare le périphérique ; NULL si la zone chevauche l'image firmware. */
+BaseFlash *drv_flash_init(void);
+
+void drv_flash_get_stats(drv_flash_stats_t *stats);
+
+#if defined(SIMULATOR)
+/* Secteurs physiques émulés (tests : corruption, « coupure » d'alimentation). */
+uint8_t *drv_flash_sim_image(void);
+#endif
+
+#endif /* DRV_FLASH_H */
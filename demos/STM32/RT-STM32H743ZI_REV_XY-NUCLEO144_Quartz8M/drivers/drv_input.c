@@ -0,0 +1,356 @@
+/**
+ * @file drv_input.c
+ * @brief Thread de scan unique : 74HC165, QEI, pots (via le scan Hall).
+ *
+ * Encodeurs → timers : ENC1 = TIM3 (PC6/PC7), ENC2 = TIM4 (PD12/PD13),
+ * ENC3 = TIM5 (PH10/PH11), tous en AF2. Aucun autre timer à deux voies n'a
+ * de broches libres sur ce boîtier (USART1, SPI3, SAI2 et FMC les occupent) :
+ * ENC4 reste sur ses broches du board (PF10/PI9), décodé à chaque passe.
+ *
+ * @ingroup drivers
+ */
+
+#include "drv_input.h"
+#include "hall_scan.h"
+#include "brick_filter.h"
+#include <string.h>
+
+#if (INPUT_EVQ_SIZE & (INPUT_EVQ_SIZE - 1U)) != 0U
+#error "INPUT_EVQ_SIZE doit être une puissance de 2"
+#endif
+
+#define EVQ_MASK      (INPUT_EVQ_SIZE - 1U)
+
+/*
+ * Chaîne 74HC165 : QH du boîtier le plus proche du MCU sur LINE_INPUT_SR_DATA,
+ * SER de chaque boîtier sur le QH du suivant. Après le chargement, le premier
+ * bit lu est H du boîtier le plus proche, le dernier A du plus éloigné.
+ * Seuls les BRICK_NUM_BUTTONS premiers bits sont des boutons : le premier lu
+ * est le bouton BRICK_NUM_BUTTONS - 1, le BRICK_NUM_BUTTONS-ième le bouton 0 ;
+ * les SR_BITS - BRICK_NUM_BUTTONS dernières entrées du dernier boîtier sont
+ * ignorées.
+ */
+#define SR_BITS       (((BRICK_NUM_BUTTONS + 7U) / 8U) * 8U)
+#define BTN_MASK      ((BRICK_NUM_BUTTONS >= 32) ? 0xFFFFFFFFU : \
+                       ((1UL << BRICK_NUM_BUTTONS) - 1U))
+
+#define INPUT_THREAD_PRIO   (NORMALPRIO + 1)
+
+/* ====================================================================== */
+/*                                 CŒUR                                   */
+/* ====================================================================== */
+
+/*
+ * Compteurs verticaux : (cnt1, cnt0) forment un compteur 2 bits par bouton,
+ * remis à 3 tant que l'échantillon égale l'état, décrémenté sinon ; l'état
+ * bascule quand il repasse par 3, soit à la 4e lecture différente de suite.
+ */
+uint32_t input_debounce(uint32_t sample, uint32_t *state,
+                        uint32_t *cnt0, uint32_t *cnt1) {
+    const uint32_t delta = sample ^ *state;
+
+    *cnt0 = ~(*cnt0 & delta);
+    *cnt1 = *cnt0 ^ (*cnt1 & delta);
+
+    const uint32_t toggle = delta & *cnt0 & *cnt1;
+    *state ^= toggle;
+    return toggle;
+}
+
+uint32_t input_sr_buttons(uint32_t raw) {
+#if INPUT_BTN_ACTIVE_LOW
+    raw = ~raw;
+#endif
+    return (raw >> (SR_BITS - BRICK_NUM_BUTTONS)) & BTN_MASK;
+}
+
+int8_t input_quad_step(uint8_t prev_ab, uint8_t ab) {
+    /* A en avance sur B : +1 (même sens que le QEI). */
+    static const int8_t quad[16] = {
+         0, -1,  1,  0,
+         1,  0,  0, -1,
+        -1,  0,  0,  1,
+         0,  1, -1,  0
+    };
+    return quad[((prev_ab & 3U) << 2) | (ab & 3U)];
+}
+
+#if !defined(SIMULATOR)
+
+/* ====================================================================== */
+/*                        CONFIGURATION MATÉRIELLE                        */
+/* ====================================================================== */
+
+#if HAL_USE_QEI != TRUE
+#error "drv_input.c requiert HAL_USE_QEI = TRUE (halconf.h)"
+#endif
+
+static const QEIConfig qeicfg = {
+    .mode        = QEI_MODE_QUADRATURE,
+    .resolution  = QEI_BOTH_EDGES,
+    .dirinv      = QEI_DIRINV_FALSE,
+    .overflow    = QEI_OVERFLOW_WRAP,
+    .min         = 0,
+    .max         = 0,
+    .notify_cb   = NULL,
+    .overflow_cb = NULL
+};
+
+static const struct {
+    QEIDriver *drv;
+    ioline_t   a;
+    ioline_t   b;
+} enc_qei[] = {
+    { &QEID3, PAL_LINE(GPIOC, 6U),  PAL_LINE(GPIOC, 7U)  },
+    { &QEID4, PAL_LINE(GPIOD, 12U), PAL_LINE(GPIOD, 13U) },
+    { &QEID5, PAL_LINE(GPIOH, 10U), PAL_LINE(GPIOH, 11U) }
+};
+
+#define ENC_QEI_COUNT  (sizeof(enc_qei) / sizeof(enc_qei[0]))
+#define ENC_GPIO       ENC_QEI_COUNT          /* ENC4 */
+
+BRICK_STATIC_ASSERT(sizeof(enc_qei) / sizeof(enc_qei[0]) + 1U == BRICK_NUM_ENCODERS,
+                    input_encoder_map);
+
+/* ====================================================================== */
+/*                             VARIABLES INTERNES                         */
+/* ====================================================================== */
+
+static input_event_t evq_buf[INPUT_EVQ_SIZE];
+static volatile uint32_t evq_head;
+static volatile uint32_t evq_tail;
+
+static uint32_t btn_state, btn_cnt0, btn_cnt1;
+static int16_t  enc_acc[BRICK_NUM_ENCODERS];
+static uint8_t  enc_gpio_ab;
+static uint16_t pot_sent_raw[BRICK_POT_COUNT];
+static uint16_t pot_value[BRICK_POT_COUNT];
+static uint32_t pot_seq;
+static hall_scan_frame_t pot_frame;
+static brick_ema_t pot_ema;
+static uint16_t pot_smooth[BRICK_POT_MUX_CHANNELS];
+
+static drv_input_stats_t stats;
+static bool input_started = false;
+
+static THD_WORKING_AREA(waInput, 512);
+
+/* ====================================================================== */
+/*                                 FILE                                   */
+/* ====================================================================== */
+
+static void emit(input_event_type_t type, uint8_t id, int16_t value, rtcnt_t stamp) {
+    const uint32_t head = __atomic_load_n(&evq_head, __ATOMIC_RELAXED);
+    const uint32_t tail = __atomic_load_n(&evq_tail, __ATOMIC_ACQUIRE);
+
+    if (head - tail >= INPUT_EVQ_SIZE) {
+        stats.drops++;
+        return;
+    }
+    evq_buf[head & EVQ_MASK] = (input_event_t){
+        .stamp = stamp, .type = (uint8_t)type, .id = id, .value = value
+    };
+    __atomic_store_n(&evq_head, head + 1U, __ATOMIC_RELEASE);
+}
+
+/* ====================================================================== */
+/*                                 SOURCES                                */
+/* ====================================================================== */
+
+/* Quelques cycles entre fronts (tW 74HC165 ≈ 20 ns à 3,3 V). */
+static inline void sr_delay(void) {
+    __NOP(); __NOP(); __NOP(); __NOP();
+}
+
+/* Capture parallèle puis décalage ; le premier bit lu finit au bit SR_BITS - 1. */
+static uint32_t sr_read(void) {
+    uint32_t v = 0;
+
+    palClearLine(LINE_INPUT_SR_LOAD);
+    sr_delay();
+    palSetLine(LINE_INPUT_SR_LOAD);
+    sr_delay();
+    for (uint8_t i = 0; i < SR_BITS; i++) {
+        v = (v << 1) | (palReadLine(LINE_INPUT_SR_DATA) & 1U);
+        palSetLine(LINE_INPUT_SR_CLK);
+        sr_delay();
+        palClearLine(LINE_INPUT_SR_CLK);
+    }
+    return v;
+}
+
+static void scan_buttons(rtcnt_t now) {
+    uint32_t changed = input_debounce(input_sr_buttons(sr_read()),
+                                      &btn_state, &btn_cnt0, &btn_cnt1);
+
+    while (changed != 0U) {
+        const uint8_t b = (uint8_t)__builtin_ctz(changed);
+        changed &= changed - 1U;
+        emit((btn_state >> b) & 1U ? INPUT_EVT_BUTTON_DOWN : INPUT_EVT_BUTTON_UP,
+             b, 0, now);
+    }
+}
+
+/* Cumule les impulsions, publie les crans entiers (le reste est gardé). */
+static void enc_accumulate(uint8_t e, int32_t delta, rtcnt_t now) {
+    const int32_t acc = enc_acc[e] + delta;
+    const int32_t detents = acc / INPUT_ENC_COUNTS_PER_DETENT;
+
+    enc_acc[e] = (int16_t)(acc - detents * INPUT_ENC_COUNTS_PER_DETENT);
+    if (detents != 0)
+        emit(INPUT_EVT_ENCODER, e, (int16_t)detents, now);
+}
+
+static uint8_t enc_gpio_read(void) {
+    return (uint8_t)((palReadLine(LINE_ENC4_A) << 1) | palReadLine(LINE_ENC4_B));
+}
+
+static void scan_encoders(rtcnt_t now) {
+    for (uint8_t e = 0; e < ENC_QEI_COUNT; e++) {
+        osalSysLock();
+        const qeidelta_t d = qeiUpdateI(enc_qei[e].drv);
+        osalSysUnlock();
+        if (d != 0)
+            enc_accumulate(e, d, now);
+    }
+
+    const uint8_t ab = enc_gpio_read();
+    if (ab != enc_gpio_ab) {
+        enc_accumulate(ENC_GPIO, input_quad_step(enc_gpio_ab, ab), now);
+        enc_gpio_ab = ab;
+    }
+}
+
+static void pot_mux_select(uint8_t ch) {
+    palWriteLine(LINE_MXP_S0, (ch >> 0) & 1U);
+    palWriteLine(LINE_MXP_S1, (ch >> 1) & 1U);
+    palWriteLine(LINE_MXP_S2, (ch >> 2) & 1U);
+}
+
+/* Pots : dernière trame Hall, si nouvelle ; horodatage de la voie de mux. */
+static void scan_pots(void) {
+    if (!hall_scan_get_frame(&pot_frame, pot_seq))
+        return;
+    pot_seq = pot_frame.seq;
+
+    /* Lissage avant la bande morte : moins d'événements sur le bruit ADC */
+    brick_ema_process(&pot_ema, pot_frame.pot, pot_smooth);
+
+    for (uint8_t p = 0; p < BRICK_POT_COUNT; p++) {
+        const uint16_t raw = pot_smooth[p];
+        const uint16_t sent = pot_sent_raw[p];
+        const uint16_t dist = (raw > sent) ? (uint16_t)(raw - sent) : (uint16_t)(sent - raw);
+
+        if (dist >= INPUT_POT_DEADBAND) {
+            pot_sent_raw[p] = raw;
+            pot_value[p] = (uint16_t)(raw >> 6);
+            emit(INPUT_EVT_POT, p, (int16_t)pot_value[p], pot_frame.stamp[p]);
+        }
+    }
+}
+
+/* ====================================================================== */
+/*                                 THREAD                                 */
+/* ====================================================================== */
+
+static THD_FUNCTION(thdInput, arg) {
+    (void)arg;
+#if CH_CFG_USE_REGISTRY
+    chRegSetThreadName("INPUT_SCAN");
+#endif
+
+    systime_t prev = chVTGetSystemTimeX();
+    while (true) {
+        const rtcnt_t now = chSysGetRealtimeCounterX();
+
+        scan_buttons(now);
+        scan_encoders(now);
+        scan_pots();
+        stats.scans++;
+
+        const systime_t next = chTimeAddX(prev, TIME_US2I(INPUT_SCAN_PERIOD_US));
+        if (!chTimeIsInRangeX(chVTGetSystemTimeX(), prev, next))
+            stats.late++;
+        prev = chThdSleepUntilWindowed(prev, next);
+    }
+}
+
+/* ====================================================================== */
+/*                                   API                                  */
+/* ====================================================================== */
+
+void drv_input_start(void) {
+    if (input_started)
+        return;
+
+    /* 74HC165 */
+    palSetLineMode(LINE_INPUT_SR_LOAD, PAL_MODE_OUTPUT_PUSHPULL);
+    palSetLineMode(LINE_INPUT_SR_CLK,  PAL_MODE_OUTPUT_PUSHPULL);
+    palSetLineMode(LINE_INPUT_SR_DATA, PAL_MODE_INPUT);
+    palSetLine(LINE_INPUT_SR_LOAD);
+    palClearLine(LINE_INPUT_SR_CLK);
+
+    /* Encodeurs : QEI avec filtre d'entrée maximal (fDTS/32, N = 8) */
+    for (uint8_t e = 0; e < ENC_QEI_COUNT; e++) {
+        palSetLineMode(enc_qei[e].a, PAL_MODE_ALTERNATE(2) | PAL_STM32_PUPDR_PULLUP);
+        palSetLineMode(enc_qei[e].b, PAL_MODE_ALTERNATE(2) | PAL_STM32_PUPDR_PULLUP);
+        qeiStart(enc_qei[e].drv, &qeicfg);
+        enc_qei[e].drv->tim->CCMR1 |= TIM_CCMR1_IC1F | TIM_CCMR1_IC2F;
+        qeiEnable(enc_qei[e].drv);
+    }
+    palSetLineMode(LINE_ENC4_A, PAL_MODE_INPUT_PULLUP);
+    palSetLineMode(LINE_ENC4_B, PAL_MODE_INPUT_PULLUP);
+    enc_gpio_ab = enc_gpio_read();
+
+    /* Pots : converti par le scan Hall, mux commuté avec le mux Hall */
+    palSetLineMode(LINE_MXP_S0, PAL_MODE_OUTPUT_PUSHPULL);
+    palSetLineMode(LINE_MXP_S1, PAL_MODE_OUTPUT_PUSHPULL);
+    palSetLineMode(LINE_MXP_S2, PAL_MODE_OUTPUT_PUSHPULL);
+    palSetLineMode(LINE_MXP_ANALOG, PAL_MODE_INPUT_ANALOG);
+    hall_scan_set_pot_mux(pot_mux_select);
+
+    btn_state = 0U;
+    btn_cnt0 = btn_cnt1 = 0xFFFFFFFFU;
+    memset(enc_acc, 0, sizeof(enc_acc));
+    memset(pot_sent_raw, 0, sizeof(pot_sent_raw));
+    memset(pot_value, 0, sizeof(pot_value));
+    pot_seq = 0U;
+    brick_ema_init(&pot_ema, BRICK_POT_COUNT, INPUT_POT_EMA_SHIFT);
+    memset(&stats, 0, sizeof(stats));
+    __atomic_store_n(&evq_head, 0U, __ATOMIC_RELAXED);
+    __atomic_store_n(&evq_tail, 0U, __ATOMIC_RELAXED);
+
+    chThdCreateStatic(waInput, sizeof(waInput), INPUT_THREAD_PRIO, thdInput, NULL);
+    input_started = true;
+}
+
+size_t drv_input_read(input_event_t *out, size_t max) {
+    if (out == NULL || max == 0U)
+        return 0U;
+
+    const uint32_t tail = __atomic_load_n(&evq_tail, __ATOMIC_RELAXED);
+    const uint32_t head = __atomic_load_n(&evq_head, __ATOMIC_ACQUIRE);
+    uint32_t avail = head - tail;
+    if (avail > max)
+        avail = (uint32_t)max;
+
+    for (uint32_t i = 0; i < avail; i++)
+        out[i] = evq_buf[(tail + i) & EVQ_MASK];
+
+    __atomic_store_n(&evq_tail, tail + avail, __ATOMIC_RELEASE);
+    return avail;
+}
+
+uint32_t drv_input_buttons(void) {
+    return __atomic_load_n(&btn_state, __ATOMIC_RELAXED);
+}
+
+uint16_t drv_input_pot(uint8_t index) {
+    return (index < BRICK_POT_COUNT) ? pot_value[index] : 0U;
+}
+
+void drv_input_get_stats(drv_input_stats_t *out) {
+    *out = stats;
+}
+
+#endif /* !SIMULATOR */
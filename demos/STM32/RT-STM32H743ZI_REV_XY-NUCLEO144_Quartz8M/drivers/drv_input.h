@@ -0,0 +1,135 @@
+/**
+ * @file drv_input.h
+ * @brief Scanner unique des contrôles : boutons, encodeurs, potentiomètres.
+ *
+ * Un seul thread, cadencé à @ref INPUT_SCAN_PERIOD_US, lit à chaque passe :
+ *   - les boutons : chaîne de 74HC165 (bit-bang), anti-rebond par compteurs
+ *     verticaux (un état n'est pris qu'après INPUT_BTN_STABLE_SCANS lectures
+ *     identiques) ;
+ *   - les encodeurs : compteurs matériels QEI (TIM3/4/5, driver contrib
+ *     `hal_qei`), ou décodage quadrature par GPIO pour un encodeur sans
+ *     timer disponible (ENC4, broches du board) ;
+ *   - les potentiomètres : dernière trame du scan Hall, qui convertit le mux
+ *     des pots dans la même séquence ADC/DMA que les capteurs Hall.
+ *
+ * Tout sort dans une seule file d'événements horodatés (un producteur : le
+ * thread de scan, un consommateur). Latence bornée : une période de scan
+ * (+ la durée d'anti-rebond pour les boutons, + une trame Hall pour les pots).
+ *
+ * @ingroup drivers
+ */
+
+#ifndef DRV_INPUT_H
+#define DRV_INPUT_H
+
+#include "ch.h"
+#include "hal.h"
+#include "brick_config.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* ====================================================================== */
+/*                             CONFIGURATION                              */
+/* ====================================================================== */
+
+/* Période du thread de scan (µs). */
+#ifndef INPUT_SCAN_PERIOD_US
+#define INPUT_SCAN_PERIOD_US        1000U
+#endif
+
+/* Capacité de la file d'événements (puissance de 2). */
+#ifndef INPUT_EVQ_SIZE
+#define INPUT_EVQ_SIZE              64U
+#endif
+
+/* Boutons actifs à l'état bas (rappel au +3V3, contact à la masse). */
+#ifndef INPUT_BTN_ACTIVE_LOW
+#define INPUT_BTN_ACTIVE_LOW        1
+#endif
+
+/* Impulsions de comptage par cran d'encodeur (quadrature ×4). */
+#ifndef INPUT_ENC_COUNTS_PER_DETENT
+#define INPUT_ENC_COUNTS_PER_DETENT 4
+#endif
+
+/* Écart minimal (échelle ADC 16 bits) pour publier un mouvement de pot. */
+#ifndef INPUT_POT_DEADBAND
+#define INPUT_POT_DEADBAND          512U
+#endif
+
+/* Lissage des pots (passe-bas 1 pôle, constante 2^n trames Hall). */
+#ifndef INPUT_POT_EMA_SHIFT
+#define INPUT_POT_EMA_SHIFT         2U
+#endif
+
+/* Chaîne 74HC165 : SH/LD, CLK, QH (broches libres, absentes du board). */
+#ifndef LINE_INPUT_SR_LOAD
+#define LINE_INPUT_SR_LOAD          PAL_LINE(GPIOH, 12U)
+#endif
+#ifndef LINE_INPUT_SR_CLK
+#define LINE_INPUT_SR_CLK           PAL_LINE(GPIOH, 13U)
+#endif
+#ifndef LINE_INPUT_SR_DATA
+#define LINE_INPUT_SR_DATA          PAL_LINE(GPIOH, 14U)
+#endif
+
+/* Anti-rebond par compteurs verticaux 2 bits : 4 lectures stables. */
+#define INPUT_BTN_STABLE_SCANS      4U
+
+/* ====================================================================== */
+/*                              API PUBLIQUE                              */
+/* ====================================================================== */
+
+typedef enum {
+    INPUT_EVT_BUTTON_DOWN = 0,  /* id = bouton, value = 0 */
+    INPUT_EVT_BUTTON_UP,        /* id = bouton, value = 0 */
+    INPUT_EVT_ENCODER,          /* id = encodeur, value = crans (signés) */
+    INPUT_EVT_POT               /* id = pot, value = 0..1023 */
+} input_event_type_t;
+
+/* Événement horodaté (compteur temps réel, instant de la lecture). */
+typedef struct {
+    rtcnt_t stamp;
+    uint8_t type;               /* input_event_type_t */
+    uint8_t id;
+    int16_t value;
+} input_event_t;
+
+typedef struct {
+    uint32_t scans;             /* Passes du thread */
+    uint32_t drops;             /* Événements perdus (file pleine) */
+    uint32_t late;              /* Passes en retard sur leur échéance */
+} drv_input_stats_t;
+
+/* Broches, QEI, état initial, puis thread de scan. */
+void drv_input_start(void);
+
+/* Récupère jusqu'à max événements (consommateur unique). */
+size_t drv_input_read(input_event_t *out, size_t max);
+
+/* État anti-rebondi courant des boutons (bit n = bouton n appuyé). */
+uint32_t drv_input_buttons(void);
+
+/* Dernière valeur publiée d'un pot (0..1023). */
+uint16_t drv_input_pot(uint8_t index);
+
+void drv_input_get_stats(drv_input_stats_t *stats);
+
+/* ====================================================================== */
+/*                      CŒUR (TESTABLE HORS CIBLE)                        */
+/* ====================================================================== */
+
+/* Anti-rebond d'un échantillon brut (bit = appuyé) ; retourne les bits dont
+   l'état stable vient de changer et met à jour *state. */
+uint32_t input_debounce(uint32_t sample, uint32_t *state,
+                        uint32_t *cnt0, uint32_t *cnt1);
+
+/* Mot lu sur la chaîne 74HC165 (premier bit au bit SR_BITS - 1) → boutons
+   (bit n = bouton n appuyé), polarité INPUT_BTN_ACTIVE_LOW appliquée. */
+uint32_t input_sr_buttons(uint32_t raw);
+
+/* Pas de quadrature entre deux états (A << 1 | B) : -1, 0 ou +1. */
+int8_t input_quad_step(uint8_t prev_ab, uint8_t ab);
+
+#endif /* DRV_INPUT_H */
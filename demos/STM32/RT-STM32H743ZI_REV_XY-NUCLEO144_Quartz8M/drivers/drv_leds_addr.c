@@ -0,0 +1,199 @@
+/**
+ * @file drv_leds_addr.c
+ * @brief WS2812 sur SPI4_MOSI : chaque bit de donnée devient 4 bits SPI.
+ *
+ * SPI4 (PCLK2 100 MHz, /32) sort 3,125 MHz, soit 320 ns par bit SPI :
+ *   bit 0 → 1000 (haut 320 ns), bit 1 → 1100 (haut 640 ns), 1,28 µs par bit.
+ * Un octet de couleur donne donc un symbole de 32 bits : la table `sym_lut`
+ * associe à chaque valeur 0..255 le symbole de la valeur corrigée (gamma 2,
+ * puis luminosité). Sur H743, seuls SPI1–3 acceptent des trames de plus de
+ * 16 bits : SPI4 envoie chaque symbole en deux demi-mots (DSIZE = 16, MSB en
+ * premier), demi-mot haut d’abord, ce qui donne le même train de bits.
+ *
+ * Trame : G, R, B par LED puis DRV_LEDS_ADDR_RESET_HALFWORDS demi-mots à
+ * zéro (le reset qui valide les couleurs). La broche est tirée au niveau bas entre
+ * deux trames.
+ *
+ * @ingroup drivers
+ */
+
+#include "drv_leds_addr.h"
+#include <string.h>
+
+#define FRAME_HALFWORDS  (2U * DRV_LEDS_ADDR_COUNT * 3U + DRV_LEDS_ADDR_RESET_HALFWORDS)
+
+/* ====================================================================== */
+/*                        CONFIGURATION MATÉRIELLE                        */
+/* ====================================================================== */
+
+#if !defined(SIMULATOR)
+
+static void spi_done_cb(SPIDriver *spip);
+
+static const SPIConfig spicfg = {
+    .circular = false,
+    .slave    = false,
+    .data_cb  = spi_done_cb,
+    .error_cb = NULL,
+
+    /* PCLK2 100 MHz / 32 = 3,125 MHz, trames de 16 bits (maximum de SPI4) */
+    .cfg1 = SPI_CFG1_MBR_2 |
+            SPI_CFG1_DSIZE_VALUE(15),
+
+    .cfg2 = SPI_CFG2_MASTER |
+            SPI_CFG2_SSM
+};
+
+#endif /* !SIMULATOR */
+
+/* ====================================================================== */
+/*                             VARIABLES INTERNES                         */
+/* ====================================================================== */
+
+/* Image logique, dans l’ordre du fil (G, R, B). */
+static uint8_t leds_grb[DRV_LEDS_ADDR_COUNT][3];
+static bool    leds_dirty = false;
+
+/* Octet → symbole SPI, gamma et luminosité compris. */
+static uint32_t sym_lut[256];
+static uint8_t  brightness = DRV_LEDS_ADDR_BRIGHTNESS;
+
+/* Trame encodée. En .bss (AXI SRAM) : accessible au DMA2. */
+static uint16_t frame[FRAME_HALFWORDS] __attribute__((aligned(32)));
+static bool     frame_busy = false;
+
+static drv_leds_addr_stats_t stats;
+
+/* ====================================================================== */
+/*                                 ENCODAGE                               */
+/* ====================================================================== */
+
+static void lut_build(void) {
+    for (uint32_t v = 0; v < 256U; v++) {
+        /* v² / 255 puis × luminosité / 255, arrondi */
+        const uint32_t level = (v * v * brightness + 32512U) / 65025U;
+        uint32_t sym = 0;
+
+        for (uint8_t bit = 0; bit < 8U; bit++) {
+            const uint32_t nib = ((level >> bit) & 1U) ? 0xCU : 0x8U;
+            sym |= nib << (bit * 4U);
+        }
+        sym_lut[v] = sym;
+    }
+}
+
+static void frame_encode(void) {
+    const uint8_t *src = &leds_grb[0][0];
+
+    for (size_t i = 0; i < DRV_LEDS_ADDR_COUNT * 3U; i++) {
+        const uint32_t sym = sym_lut[src[i]];
+        frame[2U * i]      = (uint16_t)(sym >> 16);
+        frame[2U * i + 1U] = (uint16_t)sym;
+    }
+}
+
+/* ====================================================================== */
+/*                                 SORTIE                                 */
+/* ====================================================================== */
+
+#if !defined(SIMULATOR)
+
+/* Fin de DMA (ISR). */
+static void spi_done_cb(SPIDriver *spip) {
+    (void)spip;
+    __atomic_store_n(&frame_busy, false, __ATOMIC_RELEASE);
+}
+
+static void bus_init(void) {
+    palSetLineMode(LINE_WS2812_DIN,
+                   PAL_MODE_ALTERNATE(5) | PAL_STM32_OSPEED_MID2 |
+                   PAL_STM32_PUPDR_PULLDOWN);
+    spiStart(&SPID4, &spicfg);
+}
+
+static void bus_send(void) {
+    cacheBufferFlush(frame, sizeof(frame));
+    spiStartSend(&SPID4, FRAME_HALFWORDS, frame);
+}
+
+#else /* SIMULATOR */
+
+static uint16_t sim_sent[FRAME_HALFWORDS];
+
+static void bus_init(void) { }
+
+static void bus_send(void) {
+    memcpy(sim_sent, frame, sizeof(frame));
+    __atomic_store_n(&frame_busy, false, __ATOMIC_RELEASE);
+}
+
+const uint16_t *drv_leds_addr_sim_frame(void) {
+    return sim_sent;
+}
+
+#endif /* SIMULATOR */
+
+/* ====================================================================== */
+/*                                   API                                  */
+/* ====================================================================== */
+
+void drv_leds_addr_init(void) {
+    memset(leds_grb, 0, sizeof(leds_grb));
+    memset(frame, 0, sizeof(frame));
+    memset(&stats, 0, sizeof(stats));
+    lut_build();
+    frame_busy = false;
+    leds_dirty = true;
+    bus_init();
+}
+
+void drv_leds_addr_set(uint8_t index, uint8_t r, uint8_t g, uint8_t b) {
+    if (index >= DRV_LEDS_ADDR_COUNT)
+        return;
+
+    uint8_t *p = leds_grb[index];
+    if (p[0] != g || p[1] != r || p[2] != b) {
+        p[0] = g;
+        p[1] = r;
+        p[2] = b;
+        leds_dirty = true;
+    }
+}
+
+void drv_leds_addr_set_all(uint8_t r, uint8_t g, uint8_t b) {
+    for (uint8_t i = 0; i < DRV_LEDS_ADDR_COUNT; i++)
+        drv_leds_addr_set(i, r, g, b);
+}
+
+void drv_leds_addr_clear(void) {
+    drv_leds_addr_set_all(0, 0, 0);
+}
+
+void drv_leds_addr_set_brightness(uint8_t level) {
+    if (level == brightness)
+        return;
+    brightness = level;
+    lut_build();
+    leds_dirty = true;
+}
+
+bool drv_leds_addr_render(void) {
+    if (!leds_dirty)
+        return false;
+
+    if (__atomic_load_n(&frame_busy, __ATOMIC_ACQUIRE)) {
+        stats.busy++;
+        return false;
+    }
+
+    frame_encode();
+    leds_dirty = false;
+    stats.frames++;
+    frame_busy = true;
+    bus_send();
+    return true;
+}
+
+void drv_leds_addr_get_stats(drv_leds_addr_stats_t *out) {
+    *out = stats;
+}
@@ -0,0 +1,78 @@
+/**
+ * @file drv_leds_addr.h
+ * @brief LEDs adressables WS2812 (une par bouton) : image RGB logique,
+ *        encodage par table, sortie SPI4 + DMA.
+ *
+ * L’UI écrit des couleurs dans l’image logique (aucun accès matériel) ;
+ * @ref drv_leds_addr_render encode puis envoie la trame, uniquement si
+ * l’image a changé. Luminosité et gamma sont pris en compte dans la table
+ * d’encodage (256 entrées octet → symbole), recalculée au seul changement
+ * de luminosité : un rendu coûte 3 lectures de table par LED.
+ *
+ * Contexte d’appel : un seul thread (UI). La fin de DMA est gérée en IRQ.
+ *
+ * @ingroup drivers
+ */
+
+#ifndef DRV_LEDS_ADDR_H
+#define DRV_LEDS_ADDR_H
+
+#include "ch.h"
+#include "hal.h"
+#include "brick_config.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ====================================================================== */
+/*                             CONFIGURATION                              */
+/* ====================================================================== */
+
+#define DRV_LEDS_ADDR_COUNT         BRICK_NUM_WS2812_LEDS
+
+/* Sortie DIN de la chaîne : SPI4_MOSI (AF5), absente du board. */
+#ifndef LINE_WS2812_DIN
+#define LINE_WS2812_DIN             PAL_LINE(GPIOE, 6U)
+#endif
+
+/* Demi-mots à zéro en fin de trame (reset ≥ 280 µs à 3,125 MHz). */
+#ifndef DRV_LEDS_ADDR_RESET_HALFWORDS
+#define DRV_LEDS_ADDR_RESET_HALFWORDS 60U
+#endif
+
+/* Luminosité au démarrage (0..255). */
+#ifndef DRV_LEDS_ADDR_BRIGHTNESS
+#define DRV_LEDS_ADDR_BRIGHTNESS    64U
+#endif
+
+/* ====================================================================== */
+/*                              API PUBLIQUE                              */
+/* ====================================================================== */
+
+typedef struct {
+    uint32_t frames;        /* Trames envoyées */
+    uint32_t busy;          /* Rendus différés : trame précédente en cours */
+} drv_leds_addr_stats_t;
+
+/* SPI4 + broche DIN, image éteinte (envoyée au premier rendu). */
+void drv_leds_addr_init(void);
+
+/* Image logique : ne touche pas au matériel, marque l’image modifiée. */
+void drv_leds_addr_set(uint8_t index, uint8_t r, uint8_t g, uint8_t b);
+void drv_leds_addr_set_all(uint8_t r, uint8_t g, uint8_t b);
+void drv_leds_addr_clear(void);
+
+/* Luminosité globale (0..255), appliquée après gamma ; reconstruit la table. */
+void drv_leds_addr_set_brightness(uint8_t level);
+
+/* Non bloquant : encode et lance le DMA si l’image a changé et que la
+   trame précédente est partie. Retourne true si une trame a été lancée. */
+bool drv_leds_addr_render(void);
+
+void drv_leds_addr_get_stats(drv_leds_addr_stats_t *stats);
+
+#if defined(SIMULATOR)
+/* Build hôte : dernière trame « envoyée » (demi-mots SPI, reset compris). */
+const uint16_t *drv_leds_addr_sim_frame(void);
+#endif
+
+#endif /* DRV_LEDS_ADDR_H */
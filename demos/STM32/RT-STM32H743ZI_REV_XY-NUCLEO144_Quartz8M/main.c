@@ -4,10 +4,34 @@
 #include "drv_display.h"
 #include "drivers/HallEffect/drv_hall.h"
 #include "midi/midi.h"
+#include "midi/midi_aftertouch.h"
 #include "usb/usb_device.h"
-#include <stdio.h>
+#include "audio/audio_engine.h"
+#include "cart/cart_bus.h"
+#include "seq/seq_engine.h"
+#include "ui/ui_model.h"
+#include "ui/ui_widget.h"
 #include <string.h>
 
+static const char *const gate_labels[] = { "OFF", "ON " };
+
+static ui_widget_t ui_root  = { .type = UI_WIDGET_GROUP, .field = UI_FIELD_NONE };
+static ui_widget_t ui_title = { .type = UI_WIDGET_LABEL, .x = 0, .y = 0,  .w = 128, .h = 8,
+                                .field = UI_FIELD_NONE, .text = "HALL B5 DEBUG" };
+static ui_widget_t ui_raw   = { .type = UI_WIDGET_VALUE, .x = 0, .y = 12, .w = 128, .h = 8,
+                                .field = UI_FIELD_HALL_RAW, .text = "RAW = %4ld" };
+static ui_widget_t ui_midi  = { .type = UI_WIDGET_VALUE, .x = 0, .y = 20, .w = 128, .h = 8,
+                                .field = UI_FIELD_HALL_MIDI, .text = "MIDI = %3ld" };
+static ui_widget_t ui_gate  = { .type = UI_WIDGET_VALUE, .x = 0, .y = 28, .w = 128, .h = 8,
+                                .field = UI_FIELD_HALL_GATE, .text = "ON/OFF = %s",
+                                .items = gate_labels, .count = 2 };
+static ui_widget_t ui_vel   = { .type = UI_WIDGET_VALUE, .x = 0, .y = 36, .w = 128, .h = 8,
+                                .field = UI_FIELD_HALL_VELOCITY, .text = "VEL = %3ld" };
+static ui_widget_t ui_pres  = { .type = UI_WIDGET_VALUE, .x = 0, .y = 44, .w = 128, .h = 8,
+                                .field = UI_FIELD_HALL_PRESSURE, .text = "PRES = %3ld" };
+static ui_widget_t ui_keys  = { .type = UI_WIDGET_STEPS, .x = 0, .y = 56, .w = 128, .h = 8,
+                                .field = UI_FIELD_HALL_MASK, .max = 16 };
+
 int main(void) {
 
   halInit();
@@ -18,61 +42,84 @@ int main(void) {
   hall_init();
   usb_device_start();
   midi_init();
+  audio_engine_init();
+  cart_bus_init();
+  cart_bus_start();
+  audio_engine_set_input(cart_bus_audio_input);
+  audio_engine_set_block_hook(cart_bus_frame_start);
+  (void)audio_engine_start();
+  seq_engine_init();
+  seq_engine_set_cart_sink(cart_bus_seq_sink);
 
-  char line[32];
   const uint8_t sensor_index = 4U;
   const uint8_t base_note = 60U;
   bool note_active[16];
-  uint8_t last_pressure[16];
+  uint16_t key_mask = 0U;
+  hall_event_t events[32];
 
   memset(note_active, 0, sizeof(note_active));
-  memset(last_pressure, 0, sizeof(last_pressure));
-
-  while (true) {
-    hall_update();
+  midi_at_init(MIDI_DEST_BOTH, 0U, base_note);
 
-    drv_display_clear();
-    drv_display_draw_text(0, 0, "HALL B5 DEBUG");
+  ui_widget_add(&ui_root, &ui_title);
+  ui_widget_add(&ui_root, &ui_raw);
+  ui_widget_add(&ui_root, &ui_midi);
+  ui_widget_add(&ui_root, &ui_gate);
+  ui_widget_add(&ui_root, &ui_vel);
+  ui_widget_add(&ui_root, &ui_pres);
+  ui_widget_add(&ui_root, &ui_keys);
 
-    for (uint8_t i = 0U; i < 16U; i++) {
-      bool note_on = hall_get_note_on(i);
-      bool note_off = hall_get_note_off(i);
-      uint8_t velocity = hall_get_velocity(i);
-      uint8_t pressure = hall_get_pressure(i);
-      uint8_t note_number = (uint8_t)(base_note + i);
-
-      if (note_on) {
-        note_active[i] = true;
-        midi_note_on(MIDI_DEST_BOTH, 0U, note_number, velocity);
-      }
-      if (note_off) {
-        note_active[i] = false;
-        midi_note_off(MIDI_DEST_BOTH, 0U, note_number, 0U);
+  while (true) {
+    size_t n;
+    while ((n = hall_events_read(events, 32U)) > 0U) {
+      for (size_t e = 0U; e < n; e++) {
+        const hall_event_t *evt = &events[e];
+        uint8_t note_number = (uint8_t)(base_note + evt->key);
+
+        switch (evt->type) {
+          case HALL_EVT_NOTE_ON:
+            note_active[evt->key] = true;
+            key_mask |= (uint16_t)(1U << evt->key);
+            midi_note_on(MIDI_DEST_BOTH, 0U, note_number, evt->value);
+            midi_at_note_on(evt->key);
+            break;
+          case HALL_EVT_NOTE_OFF:
+            note_active[evt->key] = false;
+            key_mask &= (uint16_t)~(1U << evt->key);
+            midi_at_note_off(evt->key);
+            midi_note_off(MIDI_DEST_BOTH, 0U, note_number, 0U);
+            break;
+          case HALL_EVT_PRESSURE:
+            midi_at_submit(evt->key, evt->value);
+            break;
+          default:
+            break;
+        }
       }
-
     }
 
-    uint16_t raw = hall_get(sensor_index);
-    uint8_t midi_value = hall_get_midi_value(sensor_index);
-    uint8_t velocity = hall_get_velocity(sensor_index);
-    uint8_t pressure = hall_get_pressure(sensor_index);
-
-    snprintf(line, sizeof(line), "RAW = %4u", raw);
-    drv_display_draw_text(0, 12, line);
-
-    snprintf(line, sizeof(line), "MIDI = %3u", midi_value);
-    drv_display_draw_text(0, 20, line);
+    midi_at_poll();
 
-    snprintf(line, sizeof(line), "ON/OFF = %s", note_active[sensor_index] ? "ON " : "OFF");
-    drv_display_draw_text(0, 28, line);
+    /* Le modèle n'avance que sur changement : seuls les widgets concernés
+       sont redessinés, et l'image n'est publiée que s'il y en a. */
+    ui_model_set_hall_mask(key_mask);
+    ui_model_set(UI_FIELD_HALL_RAW, hall_get(sensor_index));
+    ui_model_set(UI_FIELD_HALL_MIDI, hall_get_midi_value(sensor_index));
+    ui_model_set(UI_FIELD_HALL_GATE, note_active[sensor_index] ? 1 : 0);
+    ui_model_set(UI_FIELD_HALL_VELOCITY, hall_get_velocity(sensor_index));
+    ui_model_set(UI_FIELD_HALL_PRESSURE, hall_get_pressure(sensor_index));
 
-    snprintf(line, sizeof(line), "VEL = %3u", velocity);
-    drv_display_draw_text(0, 36, line);
-
-    snprintf(line, sizeof(line), "PRES = %3u", pressure);
-    drv_display_draw_text(0, 44, line);
+    if (ui_tree_render(&ui_root)) {
+      drv_display_update();
+    }
 
-    drv_display_update();
+    /* Retour LED des boutons et des touches : une trame ne part que si une
+       LED a changé. */
+    const uint32_t lit = drv_input_buttons() | key_mask;
+    for (uint8_t k = 0U; k < DRV_LEDS_ADDR_COUNT; k++) {
+      const bool on = (lit & (1UL << k)) != 0U;
+      drv_leds_addr_set(k, 0U, on ? 255U : 0U, on ? 96U : 0U);
+    }
+    (void)drv_leds_addr_render();
 
     chThdSleepMilliseconds(1);
   }
@@ -3,18 +3,22 @@
  * @brief Implémentation du module MIDI (UART + USB) pour ChibiOS.
  *
  * Ce module fournit l’envoi de messages MIDI vers deux destinations :
- * - **DIN UART** (31250 bauds) via `SD2`,
+ * - **DIN UART** (31250 bauds) via `BRICK_MIDI_UART`, à travers l’ordonnanceur
+ *   `midi_din` (running status, realtime entrelacés entre les octets),
  * - **USB MIDI** (class compliant) via l’endpoint IN (EP2).
  *
  * Principes d’implémentation :
- * - Un **thread dédié** agrège les paquets USB-MIDI en trames de 64 octets (EP IN bulk)
- *   à partir d’une **mailbox** non bloquante.
+ * - Les producteurs écrivent les paquets USB-MIDI **directement** dans un anneau de
+ *   trames de 64 octets (EP IN bulk) placé en RAM non cacheable ; une trame pleine
+ *   part telle quelle via `usbStartTransmitI()` (aucune copie), une trame partielle
+ *   est vidée au **SOF** suivant.
  * - Les messages “Realtime” (F8, FA/FB/FC/FE/FF) bénéficient d’un **chemin rapide**
  *   avec micro-attente pour l’envoi immédiat si l’endpoint est libre.
  * - Les statistiques d’envoi sont tenues dans `midi_tx_stats` pour le diagnostic.
  *
  * Contraintes temps réel :
- * - Le thread de TX USB doit avoir une priorité **au moins égale ou supérieure à l’UI**.
+ * - La réception USB (parseur, SysEx, dispatch) est déléguée à `midi_rx` ; son thread
+ *   doit avoir une priorité **au moins égale ou supérieure à l’UI**.
  * - Les callbacks d’USB doivent rester **courts** (signalement de sémaphore/flags uniquement).
  * - Aucun appel bloquant en ISR ; pas d’allocations dynamiques à l’exécution.
  *
@@ -26,7 +30,15 @@
 #include "hal.h"
 #include "brick_config.h"
 #include "midi.h"
+#include "midi_din.h"
+#include "midi_rx.h"
+#if defined(SIMULATOR)
+/* Build hôte (RT-Posix-Simulator) : l’EP IN et la sortie DIN sont émulés,
+   cf. sim/midi_sim.h. */
+#include "midi_sim.h"
+#else
 #include "usbcfg.h"
+#endif
 #include <stdbool.h>
 #include <stdint.h>
 
@@ -39,14 +51,6 @@ extern volatile bool usb_midi_tx_ready;
 
 static bool midi_initialized = false;
 
-static inline bool midi_usb_ready(void) {
-  bool ready;
-  osalSysLock();
-  ready = usb_midi_tx_ready;
-  osalSysUnlock();
-  return ready;
-}
-
 /* Nettoyage/invalidations D-Cache pour les buffers USB (OTG FS accède au D2). */
 #if defined(STM32H7xx) && defined(STM32_DCACHE_ENABLED)
 static inline void midi_usb_flush_tx_cache(const void *addr, size_t len) {
@@ -61,149 +65,176 @@ static inline void midi_usb_flush_tx_cache(const void *addr, size_t len) {
 }
 #endif
 
-/* Callback faible pour injection dans le moteur MIDI interne. */
-__attribute__((weak)) void midi_internal_receive(const uint8_t *msg, size_t len) {
-  (void)msg; (void)len;
-}
-
 /* ====================================================================== */
 /*                         CONFIGURATION / ÉTAT                            */
 /* ====================================================================== */
 
 /**
- * @brief Priorité du thread de transmission USB-MIDI.
- * @details Doit être ≥ priorité UI pour garantir une latence stable des I/O.
+ * @brief Périphérique série utilisé pour la sortie DIN MIDI.
+ * @details Déplacé dans brick_config.h pour faciliter le portage carte ;
+ *          sans objet dans le simulateur (sortie DIN émulée).
  */
-#ifndef MIDI_USB_TX_PRIO
-#define MIDI_USB_TX_PRIO   (NORMALPRIO + 1)
+#if defined(SIMULATOR)
+#define MIDI_UART   NULL
+#else
+#define MIDI_UART   BRICK_MIDI_UART
+#endif
+
+/** @brief Démarre l’émission d’une trame sur l’EP IN (sous verrou système). */
+#if defined(SIMULATOR)
+#define midi_usb_start_tx_i(buf, len)  midi_sim_usb_transmit_i((buf), (len))
+#else
+#define midi_usb_start_tx_i(buf, len)  usbStartTransmitI(&USBD1, MIDI_EP_IN, (buf), (len))
 #endif
 
 /**
- * @brief Timeout d’attente du sémaphore TX en thread (ms).
- * @details Évite les blocages si l’hôte USB ne réarme pas l’endpoint.
+ * @brief Nombre de trames de 64 octets dans l’anneau TX USB-MIDI.
+ * @details 16 trames × 16 paquets = 256 paquets, soit la capacité de l’ancienne
+ *          mailbox. Doit être une puissance de 2.
  */
-#ifndef MIDI_USB_TX_WAIT_MS
-#define MIDI_USB_TX_WAIT_MS  2
+#ifndef MIDI_USB_TX_FRAMES
+#define MIDI_USB_TX_FRAMES   16U
+#endif
+
+#if (MIDI_USB_TX_FRAMES < 2U) || ((MIDI_USB_TX_FRAMES & (MIDI_USB_TX_FRAMES - 1U)) != 0U)
+#error "MIDI_USB_TX_FRAMES doit être une puissance de 2 (>= 2)"
 #endif
 
+#define MIDI_USB_TX_MASK     (MIDI_USB_TX_FRAMES - 1U)
+#define MIDI_USB_PKT_PER_FRAME  (MIDI_EP_SIZE / 4U)
+
 /**
- * @brief Périphérique série utilisé pour la sortie DIN MIDI.
- * @details Déplacé dans brick_config.h pour faciliter le portage carte.
+ * @brief Anneau de trames EP IN.
+ * @details Section `.nocache` (SRAM3, domaine D2, non cacheable via la MPU) :
+ *          le contrôleur OTG lit les trames sans maintenance de cache.
+ *          Alignement sur la ligne de cache (32 octets).
  */
-#define MIDI_UART   BRICK_MIDI_UART
+static uint8_t midi_usb_tx_ring[MIDI_USB_TX_FRAMES][MIDI_EP_SIZE]
+    __attribute__((section(".nocache"), aligned(32)));
 
 /**
- * @brief Taille de la file (mailbox) de messages USB-MIDI (en éléments de 32 bits).
- * @details Chaque élément correspond à un paquet USB-MIDI de 4 octets packé dans un `msg_t`.
+ * @brief Nombre de slots d’envoi immédiat (puissance de 2).
+ * @details Un seul slot est en vol à la fois (un seul EP IN) ; la rotation
+ *          garantit qu’un slot abandonné par un reset USB n’est pas réécrit
+ *          tant que le contrôleur peut encore le lire.
  */
-#define MIDI_USB_QUEUE_LEN   256
+#ifndef MIDI_USB_IMM_SLOTS
+#define MIDI_USB_IMM_SLOTS   4U
+#endif
 
-/** @brief Mailbox de transmission USB-MIDI (producteur/consommateur). */
-static mailbox_t midi_usb_mb;
-/** @brief Buffer circulaire pour la mailbox USB-MIDI. */
-static msg_t     midi_usb_queue[MIDI_USB_QUEUE_LEN];
-static uint16_t  midi_usb_queue_fill = 0;
-static uint16_t  midi_usb_queue_high_water = 0;
+#if (MIDI_USB_IMM_SLOTS & (MIDI_USB_IMM_SLOTS - 1U)) != 0U
+#error "MIDI_USB_IMM_SLOTS doit être une puissance de 2"
+#endif
 
 /**
- * @brief Taille de la file (mailbox) de réception USB-MIDI (paquets 4 octets).
+ * @brief Slots d’envoi immédiat (notes, realtime).
+ * @details Un slot par ligne de cache : le nettoyage d’un slot ne touche
+ *          jamais une autre donnée. Possédés par le module, ils survivent à
+ *          l’appel de `send_usb()` pendant toute la durée du transfert.
  */
-#define MIDI_USB_RX_QUEUE_LEN 128
-
-/** @brief Mailbox de réception brute USB-MIDI (alimentée en ISR). */
-static mailbox_t midi_usb_rx_mb;
-/** @brief Buffer circulaire pour la mailbox de réception. */
-static msg_t     midi_usb_rx_queue[MIDI_USB_RX_QUEUE_LEN];
-static uint16_t midi_usb_rx_queue_fill = 0;
-static uint16_t midi_usb_rx_queue_high_water = 0;
-volatile uint32_t midi_usb_rx_drops = 0;
-
-static inline void midi_usb_queue_increment(void) {
-  osalSysLock();
-  if (midi_usb_queue_fill < MIDI_USB_QUEUE_LEN) {
-    midi_usb_queue_fill++;
-    if (midi_usb_queue_fill > midi_usb_queue_high_water) {
-      midi_usb_queue_high_water = midi_usb_queue_fill;
-    }
+static uint8_t midi_usb_imm_slots[MIDI_USB_IMM_SLOTS][32]
+    __attribute__((section(".nocache"), aligned(32)));
+static uint8_t midi_usb_imm_next;
+
+/*
+ * État de l’anneau (protégé par le verrou système) :
+ * - `tx_frame_len` : longueur de chaque trame validée (64, ou moins si vidée au SOF),
+ * - `tx_fill_idx`  : trame en cours de remplissage, `tx_fill_len` octets écrits,
+ * - `tx_send_idx`  : plus ancienne trame validée, `tx_ready` trames validées,
+ * - `tx_ring_busy` : une trame de l’anneau est en cours d’émission (slot réservé),
+ * - `tx_ep_busy`   : l’endpoint IN est occupé (anneau ou envoi immédiat).
+ */
+static uint8_t  tx_frame_len[MIDI_USB_TX_FRAMES];
+static uint8_t  tx_fill_idx;
+static uint8_t  tx_fill_len;
+static uint8_t  tx_send_idx;
+static uint8_t  tx_ready;
+static bool     tx_ring_busy;
+static bool     tx_ep_busy;
+static uint16_t midi_usb_queue_high_water = 0;
+
+/* Paquets en attente dans l’anneau (trames validées + trame en remplissage). */
+static inline void midi_usb_tx_note_fill_i(void) {
+  const uint16_t fill = (uint16_t)((tx_ready * MIDI_USB_PKT_PER_FRAME) +
+                                   (tx_fill_len / 4U));
+  if (fill > midi_usb_queue_high_water) {
+    midi_usb_queue_high_water = fill;
   }
-  osalSysUnlock();
 }
 
-static inline void midi_usb_queue_decrement(void) {
-  osalSysLock();
-  if (midi_usb_queue_fill > 0U) {
-    midi_usb_queue_fill--;
+/**
+ * @brief Démarre l’émission de la plus ancienne trame validée si l’EP est libre.
+ * @note  Appelée sous verrou système (thread ou ISR).
+ */
+static void midi_usb_tx_kick_i(void) {
+  if (tx_ep_busy || (tx_ready == 0U) || !usb_midi_tx_ready) {
+    return;
   }
-  osalSysUnlock();
-}
 
-static inline void midi_usb_rx_queue_increment_i(void) {
-  /* Les compteurs RX sont manipulés sous verrou système (ISR ou lock explicite). */
-  if (midi_usb_rx_queue_fill < MIDI_USB_RX_QUEUE_LEN) {
-    midi_usb_rx_queue_fill++;
-    if (midi_usb_rx_queue_fill > midi_usb_rx_queue_high_water) {
-      midi_usb_rx_queue_high_water = midi_usb_rx_queue_fill;
-    }
-  }
+  const uint8_t idx = tx_send_idx;
+  tx_send_idx = (uint8_t)((tx_send_idx + 1U) & MIDI_USB_TX_MASK);
+  tx_ready--;
+  tx_ring_busy = true;
+  tx_ep_busy = true;
+  midi_usb_start_tx_i(midi_usb_tx_ring[idx], tx_frame_len[idx]);
+  midi_tx_stats.tx_sent_batched++;
 }
 
-static inline void midi_usb_rx_queue_decrement(void) {
-  /* Les compteurs RX sont manipulés sous verrou système (ISR ou lock explicite). */
-  if (midi_usb_rx_queue_fill > 0U) {
-    midi_usb_rx_queue_fill--;
+/**
+ * @brief Valide la trame en remplissage (pleine ou partielle).
+ * @return false si aucun slot n’est libre pour la trame suivante.
+ */
+static bool midi_usb_tx_commit_i(void) {
+  const uint8_t used = (uint8_t)(tx_ready + (tx_ring_busy ? 1U : 0U) + 1U);
+  if (used >= MIDI_USB_TX_FRAMES) {
+    return false;
   }
+  tx_frame_len[tx_fill_idx] = tx_fill_len;
+  tx_ready++;
+  tx_fill_idx = (uint8_t)((tx_fill_idx + 1U) & MIDI_USB_TX_MASK);
+  tx_fill_len = 0U;
+  return true;
 }
 
-static inline void midi_usb_start_tx(const uint8_t *buffer, size_t len) {
-  midi_usb_flush_tx_cache(buffer, len);
-  osalSysLock();
-  usbStartTransmitI(&USBD1, MIDI_EP_IN, buffer, len);
-  osalSysUnlock();
+/* Vide l’anneau (déconnexion) : les paquets en attente sont comptés perdus. */
+static void midi_usb_tx_flush_ring_i(void) {
+  midi_tx_stats.usb_not_ready_drops +=
+      (uint32_t)(tx_ready * MIDI_USB_PKT_PER_FRAME) + (tx_fill_len / 4U);
+  tx_fill_idx = 0U;
+  tx_fill_len = 0U;
+  tx_send_idx = 0U;
+  tx_ready = 0U;
+  tx_ring_busy = false;
+  tx_ep_busy = false;
 }
 
-void midi_usb_rx_submit_from_isr(const uint8_t *packet, size_t len) {
-  if ((packet == NULL) || (len < 4U)) {
-    return;
-  }
-
-  const size_t packets = len / 4U;
+void midi_usb_tx_reset_i(void) {
+  /* Sur (re)configuration comme sur reset, l’EP repart libre et l’anneau vide. */
+  midi_usb_tx_flush_ring_i();
+}
 
+void midi_usb_tx_done_from_isr(void) {
   osalSysLockFromISR();
-  if (midi_usb_rx_mb.buffer == NULL) {
-    osalSysUnlockFromISR();
-    return;
+  tx_ring_busy = false;
+  tx_ep_busy = false;
+  if (tx_fill_len == MIDI_EP_SIZE) {
+    /* Trame pleine restée en place faute de slot : un slot vient de se libérer. */
+    (void)midi_usb_tx_commit_i();
   }
+  midi_usb_tx_kick_i();
+  osalSysUnlockFromISR();
+}
 
-  for (size_t i = 0; i < packets; i++) {
-    if (midi_usb_rx_queue_fill >= MIDI_USB_RX_QUEUE_LEN) {
-      midi_usb_rx_drops++;
-      midi_rx_stats.usb_rx_drops++;
-    } else {
-      msg_t m = ((msg_t)packet[0] << 24) |
-                ((msg_t)packet[1] << 16) |
-                ((msg_t)packet[2] << 8)  |
-                ((msg_t)packet[3]);
-
-      if (chMBPostI(&midi_usb_rx_mb, m) == MSG_OK) {
-        midi_usb_rx_queue_increment_i();
-        midi_rx_stats.usb_rx_enqueued++;
-      } else {
-        midi_usb_rx_drops++;
-        midi_rx_stats.usb_rx_drops++;
-      }
-    }
-    packet += 4U;
+void midi_usb_sof_from_isr(void) {
+  osalSysLockFromISR();
+  if ((tx_ready == 0U) && (tx_fill_len > 0U)) {
+    /* Rien d’autre en attente : la trame partielle part (ou suit celle en vol). */
+    (void)midi_usb_tx_commit_i();
+    midi_usb_tx_kick_i();
   }
   osalSysUnlockFromISR();
 }
 
-/**
- * @brief Sémaphore “endpoint libre”.
- * @details Signalé dans le callback d’EP IN (ex. `ep2_in_cb()` côté `usbcfg.c`).
- */
-binary_semaphore_t tx_sem;
-binary_semaphore_t sof_sem;
-
 /** @brief Statistiques globales de transmission MIDI (USB/DIN). */
 midi_tx_stats_t midi_tx_stats = {0};
 
@@ -227,89 +258,6 @@ static midi_dest_t midi_rx_dest = MIDI_DEST_BOTH;
 #error "MIDI_EP_SIZE doit valoir 64."
 #endif
 
-static void midi_process_usb_rx(void);
-
-/* ====================================================================== */
-/*                        THREAD DE TRANSMISSION USB                      */
-/* ====================================================================== */
-
-/**
- * @brief Zone de travail du thread de transmission USB-MIDI.
- */
-static THD_WORKING_AREA(waMidiUsbTx, 512);
-
-/**
- * @brief Thread d’agrégation et d’envoi USB-MIDI.
- *
- * Récupère des paquets USB-MIDI (4 octets packés dans un `msg_t`) depuis
- * la mailbox @ref midi_usb_mb, les agrège dans un buffer de 64 octets et
- * déclenche `usbStartTransmitI()` sur EP IN (EP2).
- *
- * Politique de robustesse :
- * - Si l’USB n’est pas prêt, les paquets sont comptabilisés en
- *   @ref midi_tx_stats.usb_not_ready_drops.
- * - Si le sémaphore n’est pas obtenu dans @ref MIDI_USB_TX_WAIT_MS ms,
- *   le lot courant est **abandonné** (drop contrôlé) pour éviter tout blocage.
- *
- * @param arg Argument inutilisé.
- */
-static THD_FUNCTION(thdMidiUsbTx, arg) {
-  (void)arg;
-#if CH_CFG_USE_REGISTRY
-  chRegSetThreadName("MIDI_USB_TX");
-#endif
-  uint8_t buf[64];
-  size_t n = 0;
-
-  while (true) {
-    midi_process_usb_rx();
-
-    msg_t msg;
-    msg_t res = chMBFetchTimeout(&midi_usb_mb, &msg, TIME_MS2I(1));
-
-    if (res == MSG_OK) {
-      midi_usb_queue_decrement();
-      buf[n++] = (uint8_t)((msg >> 24) & 0xFF);
-      buf[n++] = (uint8_t)((msg >> 16) & 0xFF);
-      buf[n++] = (uint8_t)((msg >> 8)  & 0xFF);
-      buf[n++] = (uint8_t)( msg        & 0xFF);
-
-      if (n == sizeof(buf)) {
-        const bool ready = midi_usb_ready();
-        if (ready) {
-          const systime_t tw = TIME_MS2I(MIDI_USB_TX_WAIT_MS);
-          if (chBSemWaitTimeout(&tx_sem, tw) == MSG_OK) {
-            midi_usb_start_tx(buf, n);
-            midi_tx_stats.tx_sent_batched++;
-          } else {
-            /* Endpoint non réarmé à temps : abandon contrôlé du lot. */
-            midi_tx_stats.usb_not_ready_drops += n / 4;
-          }
-        } else {
-          midi_tx_stats.usb_not_ready_drops += n / 4;
-        }
-        n = 0;
-      }
-    } else if (n > 0U) {
-      /* Flush du lot partiel déclenché sur le prochain SOF ou après timeout. */
-      chBSemWaitTimeout(&sof_sem, TIME_MS2I(1));
-      const bool ready = midi_usb_ready();
-      if (ready) {
-        const systime_t tw = TIME_MS2I(MIDI_USB_TX_WAIT_MS);
-        if (chBSemWaitTimeout(&tx_sem, tw) == MSG_OK) {
-          midi_usb_start_tx(buf, n);
-          midi_tx_stats.tx_sent_batched++;
-        } else {
-          midi_tx_stats.usb_not_ready_drops += n / 4;
-        }
-      } else {
-        midi_tx_stats.usb_not_ready_drops += n / 4;
-      }
-      n = 0;
-    }
-  }
-}
-
 /* ====================================================================== */
 /*                          INITIALISATION DU MODULE                      */
 /* ====================================================================== */
@@ -317,10 +265,9 @@ static THD_FUNCTION(thdMidiUsbTx, arg) {
 /**
  * @brief Initialise le sous-système MIDI.
  *
- * - Configure l’UART DIN à 31250 bauds,
- * - Initialise la mailbox et son buffer circulaire,
- * - Initialise le sémaphore d’EP libre,
- * - Démarre le thread de transmission USB-MIDI.
+ * - Démarre la sortie DIN (UART 31250 bauds + ordonnanceur running status),
+ * - Vide l’anneau TX USB,
+ * - Démarre l’étage de réception USB (`midi_rx`).
  */
 void midi_init(void) {
   osalSysLock();
@@ -331,19 +278,12 @@ void midi_init(void) {
   midi_initialized = true;
   osalSysUnlock();
 
-  static const SerialConfig uart_cfg = { 31250, 0, 0, 0 };
-  sdStart(MIDI_UART, &uart_cfg);
-  midi_usb_queue_fill = 0;
+  midi_din_start(MIDI_UART);
+  osalSysLock();
+  midi_usb_tx_flush_ring_i();
   midi_usb_queue_high_water = 0;
-  midi_usb_rx_queue_fill = 0;
-  midi_usb_rx_queue_high_water = 0;
-  midi_usb_rx_drops = 0;
-  chMBObjectInit(&midi_usb_mb, midi_usb_queue, MIDI_USB_QUEUE_LEN);
-  chMBObjectInit(&midi_usb_rx_mb, midi_usb_rx_queue, MIDI_USB_RX_QUEUE_LEN);
-  chBSemObjectInit(&tx_sem, true);
-  chBSemObjectInit(&sof_sem, true);
-  chThdCreateStatic(waMidiUsbTx, sizeof(waMidiUsbTx),
-                    MIDI_USB_TX_PRIO, thdMidiUsbTx, NULL);
+  osalSysUnlock();
+  midi_rx_start();
 }
 
 bool midi_is_initialized(void) {
@@ -361,140 +301,109 @@ bool midi_is_initialized(void) {
 /* ====================================================================== */
 
 /**
- * @brief Envoie un message brut sur la sortie DIN (UART).
+ * @brief Dépose un message sur la sortie DIN (ordonnanceur `midi_din`).
  * @param msg Pointeur sur les octets du message MIDI.
  * @param len Longueur en octets du message.
  */
-static void send_uart(const uint8_t *msg, size_t len) { sdWrite(MIDI_UART, msg, len); }
+static void send_uart(const uint8_t *msg, size_t len) { (void)midi_din_send(msg, len); }
 
 /**
- * @brief Poste un paquet USB-MIDI (4 octets packés) dans la mailbox, sinon le supprime.
+ * @brief Écrit un paquet USB-MIDI dans la trame en remplissage, sinon le supprime.
  *
- * @param m Paquet USB-MIDI encodé dans un `msg_t` (octet 0 dans bits 31..24).
- * @param force_drop_oldest Si vrai, retire le plus ancien élément de la mailbox
- *                          pour insérer le nouveau (politique “drop-oldest”).
- *                          Sinon, le paquet courant est perdu si la file est pleine.
+ * Une seule section critique par paquet : réservation du slot, écriture des
+ * 4 octets en place, validation de la trame si elle est pleine et démarrage
+ * de l’émission si l’endpoint est libre.
+ *
+ * @param packet Paquet USB-MIDI (4 octets).
+ * @param force_drop_oldest Si vrai, la plus ancienne trame validée est abandonnée
+ *                          pour faire de la place (politique “drop-oldest”).
+ *                          Sinon, le paquet courant est perdu si l’anneau est plein.
  */
-static void post_mb_or_drop(msg_t m, bool force_drop_oldest) {
-  if (chMBPostTimeout(&midi_usb_mb, m, TIME_IMMEDIATE) != MSG_OK) {
-    if (force_drop_oldest || MIDI_MB_DROP_OLDEST) {
-      msg_t throwaway;
-      if (chMBFetchTimeout(&midi_usb_mb, &throwaway, TIME_IMMEDIATE) == MSG_OK) {
-        midi_usb_queue_decrement();
-      }
-      if (chMBPostTimeout(&midi_usb_mb, m, TIME_IMMEDIATE) != MSG_OK)
-        midi_tx_stats.tx_mb_drops++;
-      else
-        midi_usb_queue_increment();
-    } else {
-      midi_tx_stats.tx_mb_drops++;
-    }
-  } else {
-    midi_usb_queue_increment();
-  }
-}
-
-/* ====================================================================== */
-/*                        RÉCEPTION USB (DÉCODAGE)                        */
-/* ====================================================================== */
-
-static bool usb_midi_decode_packet(const uint8_t pkt[4], midi_msg_t *out) {
-  if (out == NULL) {
-    return false;
+static void post_ring_or_drop(const uint8_t packet[4], bool force_drop_oldest) {
+  osalSysLock();
+  if (!usb_midi_tx_ready) {
+    midi_tx_stats.usb_not_ready_drops++;
+    osalSysUnlock();
+    return;
   }
 
-  const uint8_t cin = (uint8_t)(pkt[0] & 0x0F);
-
-  switch (cin) {
-    case 0x08: /* Note Off */
-    case 0x09: /* Note On */
-    case 0x0A: /* Poly Aftertouch */
-    case 0x0B: /* Control Change */
-    case 0x0E: /* Pitch Bend */
-      out->len = 3U;
-      out->data[0] = pkt[1];
-      out->data[1] = pkt[2];
-      out->data[2] = pkt[3];
-      return true;
-
-    case 0x0C: /* Program Change */
-    case 0x0D: /* Channel Pressure */
-      out->len = 2U;
-      out->data[0] = pkt[1];
-      out->data[1] = pkt[2];
-      return true;
-
-    case 0x02: /* System Common 2 bytes (MTC Quarter Frame / Song Select) */
-      out->len = 2U;
-      out->data[0] = pkt[1];
-      out->data[1] = pkt[2];
-      return true;
-
-    case 0x03: /* System Common 3 bytes (Song Position Pointer) */
-      out->len = 3U;
-      out->data[0] = pkt[1];
-      out->data[1] = pkt[2];
-      out->data[2] = pkt[3];
-      return true;
-
-    case 0x0F: /* Single-byte real-time */
-      switch (pkt[1]) {
-        case 0xF8: /* Clock */
-        case 0xFA: /* Start */
-        case 0xFB: /* Continue */
-        case 0xFC: /* Stop */
-        case 0xFE: /* Active Sensing */
-        case 0xFF: /* System Reset */
-          out->len = 1U;
-          out->data[0] = pkt[1];
-          return true;
-        default:
-          return false;
-      }
-      break;
-
-    default:
-      break;
+  if (tx_fill_len >= MIDI_EP_SIZE) {
+    /* Trame pleine restée en place faute de slot libre. */
+    if ((force_drop_oldest || MIDI_MB_DROP_OLDEST) && (tx_ready > 0U)) {
+      tx_send_idx = (uint8_t)((tx_send_idx + 1U) & MIDI_USB_TX_MASK);
+      tx_ready--;
+      midi_tx_stats.tx_mb_drops += MIDI_USB_PKT_PER_FRAME;
+    }
+    if (!midi_usb_tx_commit_i()) {
+      midi_tx_stats.tx_mb_drops++;
+      osalSysUnlock();
+      return;
+    }
   }
 
-  return false;
-}
-
-static void midi_dispatch_rx_message(const midi_msg_t *msg) {
-  midi_internal_receive(msg->data, msg->len);
-
-  if ((midi_rx_dest == MIDI_DEST_UART) || (midi_rx_dest == MIDI_DEST_BOTH)) {
-    send_uart(msg->data, msg->len);
+  uint8_t *slot = &midi_usb_tx_ring[tx_fill_idx][tx_fill_len];
+  slot[0] = packet[0];
+  slot[1] = packet[1];
+  slot[2] = packet[2];
+  slot[3] = packet[3];
+  tx_fill_len = (uint8_t)(tx_fill_len + 4U);
+  midi_usb_tx_note_fill_i();
+
+  if (tx_fill_len == MIDI_EP_SIZE) {
+    (void)midi_usb_tx_commit_i();
+    midi_usb_tx_kick_i();
   }
+  osalSysUnlock();
 }
 
-static void midi_process_usb_rx(void) {
-  const uint32_t max_burst = 16U;
-  uint32_t processed = 0U;
-  msg_t raw;
-
-  while ((processed < max_burst) &&
-         (chMBFetchTimeout(&midi_usb_rx_mb, &raw, TIME_IMMEDIATE) == MSG_OK)) {
-    osalSysLock();
-    midi_usb_rx_queue_decrement();
-    osalSysUnlock();
+/**
+ * @brief Envoi immédiat d’un paquet si l’endpoint est libre.
+ *
+ * Le paquet est copié dans un slot persistant du module (jamais de pointeur
+ * vers la pile de l’appelant) puis émis dans la même section critique.
+ * Si une trame partielle attend le SOF, le paquet y est ajouté et la trame
+ * part aussitôt : il ne double jamais les paquets déjà déposés.
+ *
+ * @return true si le paquet est parti, false si l’USB n’est pas prêt, l’EP
+ *         occupé ou des trames validées en attente (l’appelant bascule sur
+ *         l’anneau pour préserver l’ordre).
+ */
+static bool midi_usb_send_immediate(const uint8_t packet[4]) {
+  bool sent = false;
 
-    uint8_t pkt[4];
-    pkt[0] = (uint8_t)((raw >> 24) & 0xFF);
-    pkt[1] = (uint8_t)((raw >> 16) & 0xFF);
-    pkt[2] = (uint8_t)((raw >> 8)  & 0xFF);
-    pkt[3] = (uint8_t)( raw        & 0xFF);
+  osalSysLock();
+  if (usb_midi_tx_ready && !tx_ep_busy && (tx_ready == 0U) && (tx_fill_len < MIDI_EP_SIZE)) {
+    uint8_t *slot;
 
-    midi_msg_t msg;
-    if (usb_midi_decode_packet(pkt, &msg)) {
-      midi_dispatch_rx_message(&msg);
-      midi_rx_stats.usb_rx_decoded++;
+    if (tx_fill_len > 0U) {
+      slot = &midi_usb_tx_ring[tx_fill_idx][tx_fill_len];
     } else {
-      midi_rx_stats.usb_rx_ignored++;
+      slot = midi_usb_imm_slots[midi_usb_imm_next];
+      midi_usb_imm_next = (uint8_t)((midi_usb_imm_next + 1U) & (MIDI_USB_IMM_SLOTS - 1U));
     }
 
-    processed++;
+    slot[0] = packet[0];
+    slot[1] = packet[1];
+    slot[2] = packet[2];
+    slot[3] = packet[3];
+
+    if (tx_fill_len > 0U) {
+      /* Trame partielle : validée et émise maintenant, paquet en queue. */
+      tx_fill_len = (uint8_t)(tx_fill_len + 4U);
+      midi_usb_tx_note_fill_i();
+      (void)midi_usb_tx_commit_i();
+      midi_usb_tx_kick_i();
+    } else {
+      midi_usb_flush_tx_cache(slot, 4U);
+      tx_ep_busy = true;
+      midi_usb_start_tx_i(slot, 4U);
+      midi_tx_stats.tx_sent_immediate++;
+    }
+    sent = true;
   }
+  osalSysUnlock();
+
+  return sent;
 }
 
 /* ====================================================================== */
@@ -508,7 +417,7 @@ static void midi_process_usb_rx(void) {
  * - Mappage correct du **CIN** selon le type de message (NoteOn=0x9, CC=0xB, Realtime=0xF, etc.),
  * - Zéro-padding pour les messages courts (1 ou 2 octets),
  * - Priorité aux **Realtime** :
- *   - `0xF8` (Clock) : tentative immédiate, sinon file pour flush au prochain SOF,
+ *   - `0xF8` (Clock) : tentative immédiate, sinon anneau pour flush au prochain SOF,
  *   - `FA/FB/FC/FE/FF` : idem.
  * - Pour les **Notes** : tentative immédiate (sans attente active), sinon agrégation.
  *
@@ -542,44 +451,33 @@ static void send_usb(const uint8_t *msg, size_t len) {
     packet[0]=cable|0x0F; packet[1]=st;
 
     if (st==0xF8){
-      if (midi_usb_ready() && chBSemWaitTimeout(&tx_sem, TIME_IMMEDIATE)==MSG_OK){
-        midi_usb_start_tx(packet, 4);
-        midi_tx_stats.tx_sent_immediate++;
-      } else {
-        msg_t m=((msg_t)packet[0]<<24)|((msg_t)packet[1]<<16)|((msg_t)packet[2]<<8)|packet[3];
-        post_mb_or_drop(m,false);
+      if (!midi_usb_send_immediate(packet)){
+        post_ring_or_drop(packet,false);
       }
       return;
     }
 
     if (st==0xFA || st==0xFB || st==0xFC || st==0xFE || st==0xFF){
-      if (midi_usb_ready() && chBSemWaitTimeout(&tx_sem, TIME_IMMEDIATE)==MSG_OK){
-        midi_usb_start_tx(packet, 4);
-        midi_tx_stats.tx_sent_immediate++;
-      } else {
+      if (!midi_usb_send_immediate(packet)){
         midi_tx_stats.rt_other_enq_fallback++;
-        msg_t m=((msg_t)packet[0]<<24)|((msg_t)packet[1]<<16)|((msg_t)packet[2]<<8)|packet[3];
-        post_mb_or_drop(m,true);
+        post_ring_or_drop(packet,true);
       }
       return;
     }
 
-    msg_t m3=((msg_t)packet[0]<<24)|((msg_t)packet[1]<<16)|((msg_t)packet[2]<<8)|packet[3];
-    post_mb_or_drop(m3,false);
+    post_ring_or_drop(packet,false);
     return;
   }
 
   else { packet[0]=cable|0x0F; packet[1]=len>0?msg[0]:0; packet[2]=len>1?msg[1]:0; packet[3]=len>2?msg[2]:0; }
 
   if (is_note){
-    if (midi_usb_ready() && chBSemWaitTimeout(&tx_sem, TIME_IMMEDIATE)==MSG_OK){
-      midi_usb_start_tx(packet, 4);
-      midi_tx_stats.tx_sent_immediate++; return;
+    if (midi_usb_send_immediate(packet)){
+      return;
     }
   }
 
-  msg_t m=((msg_t)packet[0]<<24)|((msg_t)packet[1]<<16)|((msg_t)packet[2]<<8)|packet[3];
-  post_mb_or_drop(m,false);
+  post_ring_or_drop(packet,false);
 }
 
 /* ====================================================================== */
@@ -757,10 +655,6 @@ uint16_t midi_usb_queue_high_watermark(void) {
   return midi_usb_queue_high_water;
 }
 
-uint16_t midi_usb_rx_high_watermark(void) {
-  return midi_usb_rx_queue_high_water;
-}
-
 /**
  * @brief Réinitialise les statistiques de transmission MIDI.
  */
@@ -768,4 +662,5 @@ void midi_stats_reset(void){
   midi_tx_stats=(midi_tx_stats_t){0};
   midi_rx_stats=(midi_rx_stats_t){0};
   midi_usb_rx_drops = 0;
+  midi_din_stats_reset();
 }
@@ -11,6 +11,7 @@
  * - Gestion des messages “System Common” et “System Realtime”
  * - Statistiques de transmission détaillées
  * - Routage entre plusieurs destinations : UART, USB, ou les deux
+ * - Réception USB : gestionnaires par status, voir `midi_rx.h`
  *
  * @note L’implémentation est dans `midi.c`
  * @ingroup drivers
@@ -28,9 +29,10 @@
 /* ====================================================================== */
 
 /**
- * @brief Comportement en cas de débordement de la file d’attente USB MIDI.
+ * @brief Comportement en cas de débordement de l’anneau TX USB MIDI.
  *
- * Si défini à 1, le message le plus ancien est supprimé pour insérer le nouveau.
+ * Si défini à 1, la trame validée la plus ancienne (16 messages) est supprimée
+ * pour insérer le nouveau message.
  * Sinon, le nouveau message est perdu.
  */
 #ifndef MIDI_MB_DROP_OLDEST
@@ -75,11 +77,11 @@ typedef enum {
  */
 typedef struct {
   volatile uint32_t tx_sent_immediate;      /**< Messages envoyés immédiatement (EP libre) */
-  volatile uint32_t tx_sent_batched;        /**< Messages regroupés et envoyés par lot */
+  volatile uint32_t tx_sent_batched;        /**< Trames (jusqu’à 16 messages) envoyées depuis l’anneau */
   volatile uint32_t rt_f8_drops;            /**< Messages Clock (0xF8) perdus faute de place */
   volatile uint32_t rt_f8_burst_sent;       /**< Groupes de messages Clock envoyés en rafale */
   volatile uint32_t rt_other_enq_fallback;  /**< Autres messages temps réel mis en file (fallback) */
-  volatile uint32_t tx_mb_drops;            /**< Messages perdus (mailbox pleine) */
+  volatile uint32_t tx_mb_drops;            /**< Messages perdus (anneau TX plein) */
   volatile uint32_t usb_not_ready_drops;    /**< Messages perdus (USB non prêt) */
 } midi_tx_stats_t;
 
@@ -95,6 +97,8 @@ typedef struct {
   volatile uint32_t usb_rx_drops;      /**< Paquets USB-MIDI perdus (file pleine) */
   volatile uint32_t usb_rx_decoded;    /**< Messages MIDI décodés et injectés */
   volatile uint32_t usb_rx_ignored;    /**< Paquets/CIN ignorés */
+  volatile uint32_t usb_rx_sysex;      /**< SysEx complets réassemblés et dispatchés */
+  volatile uint32_t usb_rx_sysex_overflows; /**< SysEx perdus (plus longs que le buffer) */
 } midi_rx_stats_t;
 
 /** @brief Statistiques globales de réception MIDI. */
@@ -103,24 +107,17 @@ extern midi_rx_stats_t midi_rx_stats;
 /** @brief Compteur de paquets USB-MIDI rejetés faute de place (RX). */
 extern volatile uint32_t midi_usb_rx_drops;
 
-/**
- * @struct midi_msg_t
- * @brief Message MIDI décodé (1 à 3 octets).
- */
-typedef struct {
-  uint8_t data[3];
-  uint8_t len;
-} midi_msg_t;
-
 /* ====================================================================== */
 /*                              INITIALISATION                            */
 /* ====================================================================== */
 
 /**
- * @brief Initialise le module MIDI (UART + thread TX USB).
+ * @brief Initialise le module MIDI (DIN, anneau TX USB, réception USB).
  *
- * Configure le port UART DIN à 31250 bauds, initialise la mailbox et crée
- * le thread responsable de l’envoi USB.
+ * Démarre le port UART DIN à 31250 bauds et son thread d’émission, vide
+ * l’anneau de trames TX et démarre le thread `midi_rx` de réception USB.
+ * L’émission USB n’a pas de thread : elle est enchaînée depuis les IRQ
+ * (fin d’EP IN, SOF).
  */
 void midi_init(void);
 
@@ -227,25 +224,43 @@ void midi_poly_mode_on(midi_dest_t dest, uint8_t ch);
  */
 void midi_stats_reset(void);
 
-/** @brief Retourne le plus haut niveau de remplissage observé sur la mailbox USB. */
+/** @brief Retourne le plus haut niveau de remplissage observé sur l’anneau TX USB (paquets). */
 uint16_t midi_usb_queue_high_watermark(void);
 
-/** @brief Retourne le plus haut niveau de remplissage observé sur la file RX USB. */
+/** @brief Retourne le plus haut niveau de remplissage observé sur la file RX USB (paquets). */
 uint16_t midi_usb_rx_high_watermark(void);
 
 /**
- * @brief Callback faible injectant un message MIDI dans le moteur interne.
- *
- * Peut être redéfini par une autre unité de compilation pour brancher le
- * moteur MIDI applicatif. Par défaut, cette implémentation est vide.
+ * @brief Buffer à armer sur l’EP OUT à la configuration USB.
+ * @note  À appeler sous verrou système.
+ */
+uint8_t *midi_usb_rx_arm_i(void);
+
+/**
+ * @brief Rend un buffer EP OUT rempli à l’étage de réception (appel depuis l’ISR).
+ * @param buf Buffer armé précédemment (retour de `midi_usb_rx_arm_i()` ou de cet appel).
+ * @param len Taille reçue en octets (1 à 16 paquets de 4 octets).
+ * @return Buffer à réarmer sur l’EP OUT.
+ */
+uint8_t *midi_usb_rx_submit_from_isr(uint8_t *buf, size_t len);
+
+/**
+ * @brief Fin d’émission sur l’EP IN (appel depuis `ep2_in_cb()`).
+ * @details Libère l’endpoint et enchaîne la trame validée suivante.
+ */
+void midi_usb_tx_done_from_isr(void);
+
+/**
+ * @brief Start Of Frame (appel depuis le callback SOF).
+ * @details Si aucune trame complète n’attend, valide la trame partielle en
+ *          cours ; elle part depuis l’IRQ, ou à la suite de celle en vol.
  */
-void midi_internal_receive(const uint8_t *msg, size_t len);
+void midi_usb_sof_from_isr(void);
 
 /**
- * @brief Alimente la file RX USB (appel depuis l’ISR USB OUT).
- * @param packet Paquet USB-MIDI (1 à 16 messages de 4 octets agrégés).
- * @param len    Taille réelle en octets (multiple de 4 attendu).
+ * @brief Remet l’anneau TX à zéro (configuration / reset / suspend USB).
+ * @note  À appeler sous verrou système.
  */
-void midi_usb_rx_submit_from_isr(const uint8_t *packet, size_t len);
+void midi_usb_tx_reset_i(void);
 
 #endif /* MIDI_H */
@@ -0,0 +1,173 @@
+/**
+ * @file midi_aftertouch.c
+ * @brief Streaming de l’aftertouch polyphonique avec limitation de débit.
+ *
+ * Une seule entrée en attente par touche : une nouvelle valeur remplace la
+ * précédente tant qu’elle n’est pas partie (coalescence). Le seau à jetons est
+ * compté en "ticks × messages" pour rester en arithmétique entière :
+ * un message coûte `CH_CFG_ST_FREQUENCY` unités, le seau gagne
+ * `MIDI_AT_RATE_PER_S` unités par tick système.
+ *
+ * @ingroup drivers
+ */
+
+#include "ch.h"
+#include "midi_aftertouch.h"
+
+/* ====================================================================== */
+/*                         DÉBIT / SEAU À JETONS                          */
+/* ====================================================================== */
+
+/** @brief Octets/s sur la ligne DIN (1 start + 8 data + 1 stop). */
+#define MIDI_AT_DIN_BYTES_PER_S   (31250U / 10U)
+
+/** @brief Messages aftertouch/s autorisés (3 octets par message). */
+#define MIDI_AT_RATE_PER_S \
+  ((MIDI_AT_DIN_BYTES_PER_S * MIDI_AT_DIN_SHARE_PCT) / (3U * 100U))
+
+#define MIDI_AT_TOKEN_UNIT        ((uint32_t)CH_CFG_ST_FREQUENCY)
+#define MIDI_AT_TOKEN_CAP         (MIDI_AT_TOKEN_UNIT * MIDI_AT_BURST)
+
+#if MIDI_AT_RATE_PER_S == 0
+#error "MIDI_AT_DIN_SHARE_PCT trop faible"
+#endif
+
+/* ====================================================================== */
+/*                                 ÉTAT                                   */
+/* ====================================================================== */
+
+typedef struct {
+  systime_t last_time;
+  uint8_t   last_sent;
+  uint8_t   pending_value;
+  bool      pending;
+  bool      active;
+  bool      first;        /* aucun envoi depuis le NOTE ON */
+} midi_at_key_t;
+
+static midi_at_key_t   at_keys[MIDI_AT_KEYS];
+static midi_at_stats_t at_stats;
+static midi_dest_t     at_dest;
+static uint8_t         at_channel;
+static uint8_t         at_base_note;
+static uint8_t         at_rr;
+static uint32_t        at_tokens;
+static systime_t       at_refill_time;
+
+static void midi_at_refill(systime_t now) {
+  const uint32_t dt = (uint32_t)chTimeDiffX(at_refill_time, now);
+  at_refill_time = now;
+
+  const uint64_t tokens = (uint64_t)at_tokens + ((uint64_t)dt * MIDI_AT_RATE_PER_S);
+  at_tokens = (tokens > MIDI_AT_TOKEN_CAP) ? MIDI_AT_TOKEN_CAP : (uint32_t)tokens;
+}
+
+/* ====================================================================== */
+/*                                  API                                   */
+/* ====================================================================== */
+
+void midi_at_init(midi_dest_t dest, uint8_t ch, uint8_t base_note) {
+  at_dest = dest;
+  at_channel = ch;
+  at_base_note = base_note;
+  at_rr = 0U;
+  at_tokens = MIDI_AT_TOKEN_CAP;
+  at_refill_time = chVTGetSystemTimeX();
+  at_stats = (midi_at_stats_t){0};
+
+  for (uint8_t i = 0U; i < MIDI_AT_KEYS; i++) {
+    at_keys[i] = (midi_at_key_t){0};
+  }
+}
+
+void midi_at_note_on(uint8_t key) {
+  if (key >= MIDI_AT_KEYS) {
+    return;
+  }
+  midi_at_key_t *k = &at_keys[key];
+  k->active = true;
+  k->first = true;
+  k->pending = false;
+  k->last_sent = 0U;
+}
+
+void midi_at_note_off(uint8_t key) {
+  if (key >= MIDI_AT_KEYS) {
+    return;
+  }
+  midi_at_key_t *k = &at_keys[key];
+  if (k->pending) {
+    at_stats.cancelled++;
+  }
+  k->active = false;
+  k->pending = false;
+}
+
+void midi_at_submit(uint8_t key, uint8_t pressure) {
+  if (key >= MIDI_AT_KEYS) {
+    return;
+  }
+  midi_at_key_t *k = &at_keys[key];
+  if (!k->active) {
+    return;
+  }
+
+  pressure &= 0x7FU;
+  const uint8_t delta = (pressure > k->last_sent) ?
+                        (uint8_t)(pressure - k->last_sent) :
+                        (uint8_t)(k->last_sent - pressure);
+
+  if (delta < MIDI_AT_DEADBAND) {
+    /* Revenu près de la dernière valeur émise : rien à envoyer. */
+    if (k->pending) {
+      k->pending = false;
+      at_stats.coalesced++;
+    }
+    at_stats.deadband++;
+    return;
+  }
+
+  if (k->pending) {
+    at_stats.coalesced++;
+  }
+  k->pending_value = pressure;
+  k->pending = true;
+}
+
+void midi_at_poll(void) {
+  const systime_t now = chVTGetSystemTimeX();
+  const sysinterval_t min_interval = TIME_MS2I(MIDI_AT_MIN_INTERVAL_MS);
+
+  midi_at_refill(now);
+
+  /* Parcours circulaire : aucune touche n’est privilégiée sous contrainte. */
+  for (uint8_t n = 0U; n < MIDI_AT_KEYS; n++) {
+    const uint8_t key = (uint8_t)((at_rr + n) % MIDI_AT_KEYS);
+    midi_at_key_t *k = &at_keys[key];
+
+    if (!k->pending) {
+      continue;
+    }
+    if (!k->first && (chTimeDiffX(k->last_time, now) < min_interval)) {
+      continue;
+    }
+    if (at_tokens < MIDI_AT_TOKEN_UNIT) {
+      at_stats.throttled++;
+      at_rr = key;
+      return;
+    }
+
+    at_tokens -= MIDI_AT_TOKEN_UNIT;
+    midi_poly_aftertouch(at_dest, at_channel,
+                         (uint8_t)(at_base_note + key), k->pending_value);
+    k->last_sent = k->pending_value;
+    k->last_time = now;
+    k->first = false;
+    k->pending = false;
+    at_stats.sent++;
+  }
+}
+
+const midi_at_stats_t *midi_at_get_stats(void) {
+  return &at_stats;
+}
@@ -0,0 +1,108 @@
+/**
+ * @file midi_aftertouch.h
+ * @brief Étage de streaming de l’aftertouch polyphonique (Hall → MIDI).
+ *
+ * Les valeurs de pression reçues par touche sont filtrées avant d’atteindre
+ * `midi_poly_aftertouch()` :
+ * - **zone morte** : pas d’envoi si la valeur a peu changé depuis le dernier envoi,
+ * - **intervalle minimal par touche** : au plus un message par touche et par période,
+ * - **seau à jetons global** : débit total borné à une fraction de la bande
+ *   passante DIN (31250 bauds), pour ne pas affamer notes et clock,
+ * - **coalescence** : une valeur en attente est remplacée par la plus récente
+ *   (une seule entrée en attente par touche, jamais de file qui grossit).
+ *
+ * Les fronts NOTE ON / NOTE OFF réinitialisent l’état de la touche ; un NOTE OFF
+ * annule toute pression en attente (jamais d’aftertouch après le relâchement).
+ *
+ * Contexte d’appel : un seul thread (celui qui consomme les événements Hall).
+ *
+ * @ingroup drivers
+ */
+
+#ifndef MIDI_AFTERTOUCH_H
+#define MIDI_AFTERTOUCH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "midi.h"
+
+/* ====================================================================== */
+/*                             CONFIGURATION                              */
+/* ====================================================================== */
+
+/** @brief Nombre de touches suivies. */
+#ifndef MIDI_AT_KEYS
+#define MIDI_AT_KEYS            16U
+#endif
+
+/** @brief Écart minimal (0..127) avec la dernière valeur envoyée. */
+#ifndef MIDI_AT_DEADBAND
+#define MIDI_AT_DEADBAND        2U
+#endif
+
+/** @brief Intervalle minimal entre deux messages d’une même touche (ms). */
+#ifndef MIDI_AT_MIN_INTERVAL_MS
+#define MIDI_AT_MIN_INTERVAL_MS 10U
+#endif
+
+/**
+ * @brief Part de la bande passante DIN allouée à l’aftertouch (%).
+ * @details 31250 bauds = 3125 octets/s, soit ~1041 messages de 3 octets/s.
+ */
+#ifndef MIDI_AT_DIN_SHARE_PCT
+#define MIDI_AT_DIN_SHARE_PCT   40U
+#endif
+
+/** @brief Taille de rafale du seau à jetons (messages). */
+#ifndef MIDI_AT_BURST
+#define MIDI_AT_BURST           8U
+#endif
+
+/* ====================================================================== */
+/*                                 TYPES                                  */
+/* ====================================================================== */
+
+/**
+ * @struct midi_at_stats_t
+ * @brief Statistiques de l’étage aftertouch.
+ */
+typedef struct {
+  uint32_t sent;          /**< Messages émis */
+  uint32_t coalesced;     /**< Valeurs en attente remplacées par une plus récente */
+  uint32_t deadband;      /**< Valeurs ignorées (zone morte) */
+  uint32_t throttled;     /**< Envois différés faute de jeton */
+  uint32_t cancelled;     /**< Valeurs annulées par un NOTE OFF */
+} midi_at_stats_t;
+
+/* ====================================================================== */
+/*                                  API                                   */
+/* ====================================================================== */
+
+/**
+ * @brief Initialise l’étage (état des touches + seau à jetons plein).
+ * @param dest      Destination MIDI.
+ * @param ch        Canal MIDI [0–15].
+ * @param base_note Note associée à la touche 0.
+ */
+void midi_at_init(midi_dest_t dest, uint8_t ch, uint8_t base_note);
+
+/** @brief Front NOTE ON : repart d’une pression nulle. */
+void midi_at_note_on(uint8_t key);
+
+/** @brief Front NOTE OFF : annule la valeur en attente. */
+void midi_at_note_off(uint8_t key);
+
+/** @brief Nouvelle valeur de pression (0..127) pour une touche. */
+void midi_at_submit(uint8_t key, uint8_t pressure);
+
+/**
+ * @brief Émet les valeurs en attente dont l’intervalle est écoulé,
+ *        dans la limite des jetons disponibles.
+ */
+void midi_at_poll(void);
+
+/** @brief Statistiques de l’étage. */
+const midi_at_stats_t *midi_at_get_stats(void);
+
+#endif /* MIDI_AFTERTOUCH_H */
@@ -0,0 +1,254 @@
+/**
+ * @file midi_din.c
+ * @brief Ordonnanceur de sortie MIDI DIN : running status + entrelacement realtime.
+ *
+ * Le thread ne laisse jamais plus de @ref MIDI_DIN_AHEAD octets dans la file
+ * du driver série ; il est réveillé par `CHN_OUTPUT_EMPTY` (file vidée) ou
+ * par un dépôt. À chaque emplacement libre, un realtime en attente passe
+ * avant l’octet suivant du message courant.
+ *
+ * @ingroup drivers
+ */
+
+#include "ch.h"
+#include "hal.h"
+#include "midi_din.h"
+
+#if (MIDI_DIN_QUEUE_LEN & (MIDI_DIN_QUEUE_LEN - 1U)) != 0U
+#error "MIDI_DIN_QUEUE_LEN doit être une puissance de 2"
+#endif
+#if (MIDI_DIN_RT_QUEUE_LEN & (MIDI_DIN_RT_QUEUE_LEN - 1U)) != 0U
+#error "MIDI_DIN_RT_QUEUE_LEN doit être une puissance de 2"
+#endif
+#if MIDI_DIN_AHEAD < 1U
+#error "MIDI_DIN_AHEAD doit valoir au moins 1"
+#endif
+
+#define MIDI_DIN_EVT_SERIAL   EVENT_MASK(0)
+#define MIDI_DIN_EVT_WORK     EVENT_MASK(1)
+
+/* ====================================================================== */
+/*                                 ÉTAT                                   */
+/* ====================================================================== */
+
+typedef struct {
+  rtcnt_t stamp;
+  uint8_t data[3];
+  uint8_t len;
+} midi_din_msg_t;
+
+static midi_din_msg_t din_q[MIDI_DIN_QUEUE_LEN];
+static uint32_t       din_q_head;
+static uint32_t       din_q_tail;
+
+static uint8_t        din_rt_q[MIDI_DIN_RT_QUEUE_LEN];
+static rtcnt_t        din_rt_stamp[MIDI_DIN_RT_QUEUE_LEN];
+static uint32_t       din_rt_head;
+static uint32_t       din_rt_tail;
+
+static SerialDriver    *din_sdp;
+static thread_t        *din_thread;
+static midi_din_stats_t din_stats;
+
+static THD_WORKING_AREA(waMidiDin, 256);
+
+static uint32_t midi_din_delay_us(rtcnt_t stamp) {
+  const rtcnt_t dt = (rtcnt_t)(chSysGetRealtimeCounterX() - stamp);
+  return (dt == 0U) ? 0U : (uint32_t)RTC2US(STM32_CORE_CK, dt);
+}
+
+static void midi_din_note_delay(uint32_t us) {
+  din_stats.delay_last_us = us;
+  din_stats.delay_sum_us += us;
+  if (us > din_stats.delay_max_us) {
+    din_stats.delay_max_us = us;
+  }
+}
+
+static void midi_din_note_rt_delay(uint32_t us) {
+  din_stats.rt_delay_last_us = us;
+  if (us > din_stats.rt_delay_max_us) {
+    din_stats.rt_delay_max_us = us;
+  }
+}
+
+/* ====================================================================== */
+/*                            ENCODAGE                                    */
+/* ====================================================================== */
+
+/**
+ * @brief Encode un message avec running status.
+ * @return Nombre d’octets à émettre dans @p out.
+ */
+static uint8_t midi_din_encode(const midi_din_msg_t *m, uint8_t *running,
+                               systime_t *last_status_time, uint8_t out[3]) {
+  uint8_t st = m->data[0];
+  uint8_t d2 = (m->len > 2U) ? m->data[2] : 0U;
+
+#if MIDI_DIN_NOTE_OFF_AS_ON
+  /* NOTE OFF vélocité 0 ≡ NOTE ON vélocité 0 : prolonge une suite de NOTE ON. */
+  if (((st & 0xF0U) == 0x80U) && (m->len == 3U) && (d2 == 0U) &&
+      (*running == (uint8_t)(0x90U | (st & 0x0FU)))) {
+    st = *running;
+  }
+#endif
+
+  uint8_t n = 0U;
+  if (st >= 0xF0U) {
+    /* System Common / SysEx : status toujours émis, running status annulé. */
+    *running = 0U;
+    out[n++] = st;
+  } else {
+    const systime_t now = chVTGetSystemTimeX();
+    if ((st == *running) &&
+        (chTimeDiffX(*last_status_time, now) < TIME_MS2I(MIDI_DIN_RS_REFRESH_MS))) {
+      din_stats.bytes_saved++;
+    } else {
+      out[n++] = st;
+      *running = st;
+      *last_status_time = now;
+    }
+  }
+
+  if (m->len > 1U) {
+    out[n++] = m->data[1];
+  }
+  if (m->len > 2U) {
+    out[n++] = d2;
+  }
+  return n;
+}
+
+/* ====================================================================== */
+/*                                THREAD                                  */
+/* ====================================================================== */
+
+static THD_FUNCTION(thdMidiDin, arg) {
+  (void)arg;
+#if CH_CFG_USE_REGISTRY
+  chRegSetThreadName("MIDI_DIN");
+#endif
+
+  event_listener_t el;
+  chEvtRegisterMaskWithFlags(chnGetEventSource(din_sdp), &el,
+                             MIDI_DIN_EVT_SERIAL, CHN_OUTPUT_EMPTY);
+
+  uint8_t   cur[3];
+  uint8_t   cur_len = 0U;
+  uint8_t   cur_pos = 0U;
+  uint8_t   running = 0U;
+  systime_t last_status_time = chVTGetSystemTimeX();
+
+  while (true) {
+    (void)chEvtWaitAny(MIDI_DIN_EVT_SERIAL | MIDI_DIN_EVT_WORK);
+    (void)chEvtGetAndClearFlags(&el);
+
+    while (true) {
+      osalSysLock();
+      const bool room = oqGetFullI(&din_sdp->oqueue) < MIDI_DIN_AHEAD;
+      osalSysUnlock();
+      if (!room) {
+        break;  /* CHN_OUTPUT_EMPTY réveillera le thread. */
+      }
+
+      uint8_t b;
+      const uint32_t rt_tail = din_rt_tail;
+      if (__atomic_load_n(&din_rt_head, __ATOMIC_ACQUIRE) != rt_tail) {
+        const uint32_t i = rt_tail & (MIDI_DIN_RT_QUEUE_LEN - 1U);
+        b = din_rt_q[i];
+        midi_din_note_rt_delay(midi_din_delay_us(din_rt_stamp[i]));
+        __atomic_store_n(&din_rt_tail, rt_tail + 1U, __ATOMIC_RELEASE);
+        din_stats.rt_msgs++;
+        if (cur_pos < cur_len) {
+          din_stats.rt_interleaved++;
+        }
+      } else if (cur_pos < cur_len) {
+        b = cur[cur_pos++];
+      } else {
+        const uint32_t tail = din_q_tail;
+        if (__atomic_load_n(&din_q_head, __ATOMIC_ACQUIRE) == tail) {
+          break;
+        }
+        const midi_din_msg_t *m = &din_q[tail & (MIDI_DIN_QUEUE_LEN - 1U)];
+        cur_len = midi_din_encode(m, &running, &last_status_time, cur);
+        cur_pos = 0U;
+        midi_din_note_delay(midi_din_delay_us(m->stamp));
+        __atomic_store_n(&din_q_tail, tail + 1U, __ATOMIC_RELEASE);
+        din_stats.msgs++;
+        continue;
+      }
+
+      (void)sdPutTimeout(din_sdp, b, TIME_IMMEDIATE);
+      din_stats.bytes++;
+    }
+  }
+}
+
+/* ====================================================================== */
+/*                                  API                                   */
+/* ====================================================================== */
+
+void midi_din_start(SerialDriver *sdp) {
+  static const SerialConfig uart_cfg = { 31250, 0, 0, 0 };
+
+  din_q_head = din_q_tail = 0U;
+  din_rt_head = din_rt_tail = 0U;
+  din_stats = (midi_din_stats_t){0};
+  din_sdp = sdp;
+
+  sdStart(sdp, &uart_cfg);
+  din_thread = chThdCreateStatic(waMidiDin, sizeof(waMidiDin),
+                                 MIDI_DIN_THREAD_PRIO, thdMidiDin, NULL);
+}
+
+bool midi_din_send(const uint8_t *msg, size_t len) {
+  if ((din_thread == NULL) || (msg == NULL) || (len == 0U) || (len > 3U)) {
+    return false;
+  }
+
+  const rtcnt_t now = chSysGetRealtimeCounterX();
+  bool queued = false;
+
+  /* Producteurs multiples : réservation + écriture sous verrou (quelques octets). */
+  osalSysLock();
+  if (msg[0] >= 0xF8U) {
+    if ((din_rt_head - din_rt_tail) < MIDI_DIN_RT_QUEUE_LEN) {
+      const uint32_t i = din_rt_head & (MIDI_DIN_RT_QUEUE_LEN - 1U);
+      din_rt_q[i] = msg[0];
+      din_rt_stamp[i] = now;
+      __atomic_store_n(&din_rt_head, din_rt_head + 1U, __ATOMIC_RELEASE);
+      queued = true;
+    } else {
+      din_stats.rt_drops++;
+    }
+  } else if ((din_q_head - din_q_tail) < MIDI_DIN_QUEUE_LEN) {
+    midi_din_msg_t *m = &din_q[din_q_head & (MIDI_DIN_QUEUE_LEN - 1U)];
+    m->stamp = now;
+    m->len = (uint8_t)len;
+    for (size_t i = 0U; i < len; i++) {
+      m->data[i] = msg[i];
+    }
+    __atomic_store_n(&din_q_head, din_q_head + 1U, __ATOMIC_RELEASE);
+    queued = true;
+  } else {
+    din_stats.drops++;
+  }
+
+  if (queued) {
+    chEvtSignalI(din_thread, MIDI_DIN_EVT_WORK);
+    chSchRescheduleS();
+  }
+  osalSysUnlock();
+
+  return queued;
+}
+
+const midi_din_stats_t *midi_din_get_stats(void) {
+  return &din_stats;
+}
+
+void midi_din_stats_reset(void) {
+  osalSysLock();
+  din_stats = (midi_din_stats_t){0};
+  osalSysUnlock();
+}
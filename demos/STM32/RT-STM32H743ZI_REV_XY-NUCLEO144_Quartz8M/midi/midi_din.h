@@ -0,0 +1,115 @@
+/**
+ * @file midi_din.h
+ * @brief Ordonnanceur de sortie MIDI DIN (UART 31250 bauds).
+ *
+ * Au-dessus du driver série, un thread dédié alimente la file de sortie
+ * **octet par octet** (au plus @ref MIDI_DIN_AHEAD octets d’avance) :
+ * - **running status** : l’octet de status est omis s’il est identique au
+ *   précédent (messages canal uniquement), jusqu’à 33 % de bande gagnée ;
+ * - **entrelacement realtime** : F8/FA/FB/FC/FE/FF passent devant l’octet
+ *   suivant du message en cours, comme l’autorise la norme MIDI ;
+ * - **délai de file** mesuré par message (dépôt → premier octet remis à l’UART).
+ *
+ * Les messages System Common / SysEx annulent le running status ;
+ * les realtime ne le modifient pas.
+ *
+ * Contexte d’appel : `midi_din_send()` depuis n’importe quel thread.
+ *
+ * @ingroup drivers
+ */
+
+#ifndef MIDI_DIN_H
+#define MIDI_DIN_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "hal.h"
+
+/* ====================================================================== */
+/*                             CONFIGURATION                              */
+/* ====================================================================== */
+
+/** @brief Messages canal/common en attente (puissance de 2). */
+#ifndef MIDI_DIN_QUEUE_LEN
+#define MIDI_DIN_QUEUE_LEN        64U
+#endif
+
+/** @brief Octets realtime en attente (puissance de 2). */
+#ifndef MIDI_DIN_RT_QUEUE_LEN
+#define MIDI_DIN_RT_QUEUE_LEN     16U
+#endif
+
+/**
+ * @brief Octets confiés d’avance à la file du driver série.
+ * @details Borne la latence d’un realtime à (AHEAD + 1) × 320 µs.
+ */
+#ifndef MIDI_DIN_AHEAD
+#define MIDI_DIN_AHEAD            1U
+#endif
+
+/**
+ * @brief Silence (ms) après lequel le status est ré-émis.
+ * @details Permet à un récepteur branché en cours de route de se resynchroniser.
+ */
+#ifndef MIDI_DIN_RS_REFRESH_MS
+#define MIDI_DIN_RS_REFRESH_MS    300U
+#endif
+
+/** @brief Envoie les NOTE OFF vélocité 0 en NOTE ON vélocité 0 (running status). */
+#ifndef MIDI_DIN_NOTE_OFF_AS_ON
+#define MIDI_DIN_NOTE_OFF_AS_ON   1
+#endif
+
+/** @brief Priorité du thread d’émission DIN. */
+#ifndef MIDI_DIN_THREAD_PRIO
+#define MIDI_DIN_THREAD_PRIO      (NORMALPRIO + 2)
+#endif
+
+/* ====================================================================== */
+/*                                 TYPES                                  */
+/* ====================================================================== */
+
+/**
+ * @struct midi_din_stats_t
+ * @brief Statistiques de la sortie DIN.
+ */
+typedef struct {
+  uint32_t msgs;            /**< Messages canal/common émis */
+  uint32_t rt_msgs;         /**< Octets realtime émis */
+  uint32_t bytes;           /**< Octets remis à l’UART */
+  uint32_t bytes_saved;     /**< Octets de status économisés (running status) */
+  uint32_t rt_interleaved;  /**< Realtime insérés au milieu d’un message */
+  uint32_t drops;           /**< Messages perdus (file pleine) */
+  uint32_t rt_drops;        /**< Realtime perdus (file pleine) */
+  uint32_t delay_last_us;   /**< Délai de file du dernier message (µs) */
+  uint32_t delay_max_us;    /**< Délai de file maximal (µs) */
+  uint64_t delay_sum_us;    /**< Somme des délais (moyenne = somme / msgs) */
+  uint32_t rt_delay_last_us;/**< Délai de file du dernier realtime (µs) */
+  uint32_t rt_delay_max_us; /**< Délai de file maximal d’un realtime (µs) */
+} midi_din_stats_t;
+
+/* ====================================================================== */
+/*                                  API                                   */
+/* ====================================================================== */
+
+/**
+ * @brief Démarre l’UART à 31250 bauds et le thread d’émission.
+ * @param sdp Driver série de la sortie DIN.
+ */
+void midi_din_start(SerialDriver *sdp);
+
+/**
+ * @brief Dépose un message complet (1 à 3 octets, status en tête).
+ * @return false si le message a été perdu (file pleine ou module arrêté).
+ */
+bool midi_din_send(const uint8_t *msg, size_t len);
+
+/** @brief Statistiques de la sortie DIN. */
+const midi_din_stats_t *midi_din_get_stats(void);
+
+/** @brief Remet les statistiques à zéro. */
+void midi_din_stats_reset(void);
+
+#endif /* MIDI_DIN_H */
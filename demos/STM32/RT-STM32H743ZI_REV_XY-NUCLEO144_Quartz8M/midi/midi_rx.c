@@ -0,0 +1,276 @@
+/**
+ * @file midi_rx.c
+ * @brief Réception USB-MIDI : pool de buffers EP OUT, parseur CIN, SysEx, dispatch.
+ *
+ * Les buffers sont utilisés strictement en rotation : l’ISR remplit le buffer
+ * armé, le thread consomme les buffers [rx_read, rx_read + rx_pending[.
+ * Si aucun buffer n’est libre, l’ISR réarme le même buffer et compte les
+ * paquets perdus (jamais de blocage en ISR).
+ *
+ * @ingroup drivers
+ */
+
+#include "ch.h"
+#include "hal.h"
+#include "midi.h"
+#include "midi_din.h"
+#include "midi_rx.h"
+#include "usbcfg.h"
+
+#if (MIDI_RX_USB_BUFS < 2U) || ((MIDI_RX_USB_BUFS & (MIDI_RX_USB_BUFS - 1U)) != 0U)
+#error "MIDI_RX_USB_BUFS doit être une puissance de 2 (>= 2)"
+#endif
+
+#define MIDI_RX_BUF_MASK        (MIDI_RX_USB_BUFS - 1U)
+#define MIDI_RX_HANDLERS        (7U + 16U)   /* 0x8n..0xEn puis 0xF0..0xFF */
+
+/* ====================================================================== */
+/*                                 ÉTAT                                   */
+/* ====================================================================== */
+
+/** @brief Buffers EP OUT (non cacheables, une ligne de cache par 32 octets). */
+static uint8_t rx_bufs[MIDI_RX_USB_BUFS][MIDI_EP_SIZE]
+    __attribute__((section(".nocache"), aligned(32)));
+static uint8_t rx_len[MIDI_RX_USB_BUFS];
+
+/* Protégés par le verrou système. */
+static uint8_t  rx_read;
+static uint8_t  rx_pending;
+static uint16_t rx_high_water;
+
+volatile uint32_t midi_usb_rx_drops = 0;
+
+static binary_semaphore_t rx_sem;
+static midi_rx_handler_t  rx_handlers[MIDI_RX_HANDLERS];
+
+/* SysEx en cours (thread de réception uniquement). */
+static uint8_t  sysex_buf[MIDI_RX_SYSEX_MAX];
+static size_t   sysex_len;
+static bool     sysex_active;
+static bool     sysex_overflow;
+
+static THD_WORKING_AREA(waMidiUsbRx, 512);
+
+static inline uint8_t rx_armed_index_i(void) {
+  return (uint8_t)((rx_read + rx_pending) & MIDI_RX_BUF_MASK);
+}
+
+/* ====================================================================== */
+/*                               ISR USB                                  */
+/* ====================================================================== */
+
+uint8_t *midi_usb_rx_arm_i(void) {
+  /* Les buffers déjà rendus au thread restent à lui : ils seront parsés. */
+  return rx_bufs[rx_armed_index_i()];
+}
+
+uint8_t *midi_usb_rx_submit_from_isr(uint8_t *buf, size_t len) {
+  osalSysLockFromISR();
+  const uint8_t idx = rx_armed_index_i();
+
+  if ((buf != rx_bufs[idx]) || (len < 4U)) {
+    osalSysUnlockFromISR();
+    return rx_bufs[idx];
+  }
+
+  const uint32_t packets = (uint32_t)(len / 4U);
+  if ((uint8_t)(rx_pending + 1U) >= MIDI_RX_USB_BUFS) {
+    /* Pool plein : le buffer est réarmé tel quel, son contenu est perdu. */
+    midi_usb_rx_drops += packets;
+    midi_rx_stats.usb_rx_drops += packets;
+    osalSysUnlockFromISR();
+    return buf;
+  }
+
+  rx_len[idx] = (uint8_t)(len & ~3U);
+  rx_pending++;
+  midi_rx_stats.usb_rx_enqueued += packets;
+
+  const uint16_t fill = (uint16_t)(rx_pending * (MIDI_EP_SIZE / 4U));
+  if (fill > rx_high_water) {
+    rx_high_water = fill;
+  }
+
+  chBSemSignalI(&rx_sem);
+  osalSysUnlockFromISR();
+  return rx_bufs[rx_armed_index_i()];
+}
+
+/* ====================================================================== */
+/*                               DISPATCH                                 */
+/* ====================================================================== */
+
+static inline uint8_t rx_handler_index(uint8_t status) {
+  return (status < 0xF0U) ? (uint8_t)((status >> 4) - 8U)
+                          : (uint8_t)(7U + (status & 0x0FU));
+}
+
+static void rx_dispatch(const uint8_t *msg, size_t len) {
+  const midi_rx_handler_t h = rx_handlers[rx_handler_index(msg[0])];
+  if (h != NULL) {
+    h(msg, len);
+  }
+  midi_rx_stats.usb_rx_decoded++;
+
+  const midi_dest_t dest = midi_get_rx_destination();
+  if ((msg[0] != 0xF0U) && ((dest == MIDI_DEST_UART) || (dest == MIDI_DEST_BOTH))) {
+    (void)midi_din_send(msg, len);
+  }
+}
+
+/* ====================================================================== */
+/*                                SYSEX                                   */
+/* ====================================================================== */
+
+static void sysex_append(const uint8_t *data, size_t n) {
+  for (size_t i = 0U; i < n; i++) {
+    const uint8_t b = data[i];
+
+    if (b == 0xF0U) {
+      if (sysex_active) {
+        midi_rx_stats.usb_rx_ignored++;   /* SysEx précédent jamais terminé */
+      }
+      sysex_active = true;
+      sysex_overflow = false;
+      sysex_len = 0U;
+    } else if (!sysex_active) {
+      midi_rx_stats.usb_rx_ignored++;     /* continuation orpheline */
+      return;
+    }
+
+    if (sysex_len < MIDI_RX_SYSEX_MAX) {
+      sysex_buf[sysex_len++] = b;
+    } else {
+      sysex_overflow = true;
+    }
+
+    if (b == 0xF7U) {
+      sysex_active = false;
+      if (sysex_overflow) {
+        midi_rx_stats.usb_rx_sysex_overflows++;
+      } else {
+        midi_rx_stats.usb_rx_sysex++;
+        rx_dispatch(sysex_buf, sysex_len);
+      }
+      return;
+    }
+  }
+}
+
+/* ====================================================================== */
+/*                                PARSEUR                                 */
+/* ====================================================================== */
+
+/** @brief Octets MIDI portés par chaque CIN (0 = réservé). */
+static const uint8_t cin_len[16] = {
+  0U, 0U, 2U, 3U, 3U, 1U, 2U, 3U, 3U, 3U, 3U, 3U, 2U, 2U, 3U, 1U
+};
+
+static void rx_parse_packet(const uint8_t *pkt) {
+  const uint8_t cin = (uint8_t)(pkt[0] & 0x0FU);
+  const uint8_t n = cin_len[cin];
+
+  switch (cin) {
+    case 0x04: /* SysEx début / suite */
+    case 0x06: /* SysEx fin, 2 octets */
+    case 0x07: /* SysEx fin, 3 octets */
+      sysex_append(&pkt[1], n);
+      return;
+
+    case 0x05: /* 1 octet : fin de SysEx ou System Common (F6…) */
+      if (pkt[1] == 0xF7U) {
+        sysex_append(&pkt[1], 1U);
+        return;
+      }
+      if (pkt[1] < 0xF0U) {
+        midi_rx_stats.usb_rx_ignored++;
+        return;
+      }
+      break;
+
+    case 0x0F: /* Octet isolé : realtime (tolère F6) */
+      if ((pkt[1] < 0xF8U) && (pkt[1] != 0xF6U)) {
+        midi_rx_stats.usb_rx_ignored++;
+        return;
+      }
+      break;
+
+    default:
+      if ((n == 0U) || ((pkt[1] & 0x80U) == 0U)) {
+        midi_rx_stats.usb_rx_ignored++;
+        return;
+      }
+      break;
+  }
+
+  rx_dispatch(&pkt[1], n);
+}
+
+/* ====================================================================== */
+/*                                THREAD                                  */
+/* ====================================================================== */
+
+static THD_FUNCTION(thdMidiUsbRx, arg) {
+  (void)arg;
+#if CH_CFG_USE_REGISTRY
+  chRegSetThreadName("MIDI_USB_RX");
+#endif
+
+  while (true) {
+    (void)chBSemWait(&rx_sem);
+
+    uint8_t batch;
+    osalSysLock();
+    batch = rx_pending;
+    osalSysUnlock();
+
+    /* Les buffers [rx_read, rx_read + batch[ n’appartiennent plus à l’ISR. */
+    for (uint8_t b = 0U; b < batch; b++) {
+      const uint8_t idx = (uint8_t)((rx_read + b) & MIDI_RX_BUF_MASK);
+      const uint8_t *p = rx_bufs[idx];
+      for (uint8_t off = 0U; off < rx_len[idx]; off = (uint8_t)(off + 4U)) {
+        rx_parse_packet(&p[off]);
+      }
+    }
+
+    osalSysLock();
+    rx_read = (uint8_t)((rx_read + batch) & MIDI_RX_BUF_MASK);
+    rx_pending = (uint8_t)(rx_pending - batch);
+    if (rx_pending > 0U) {
+      chBSemSignalI(&rx_sem);
+    }
+    osalSysUnlock();
+  }
+}
+
+/* ====================================================================== */
+/*                                  API                                   */
+/* ====================================================================== */
+
+void midi_rx_start(void) {
+  osalSysLock();
+  rx_read = 0U;
+  rx_pending = 0U;
+  rx_high_water = 0U;
+  osalSysUnlock();
+
+  midi_usb_rx_drops = 0;
+  sysex_len = 0U;
+  sysex_active = false;
+  sysex_overflow = false;
+
+  chBSemObjectInit(&rx_sem, true);
+  chThdCreateStatic(waMidiUsbRx, sizeof(waMidiUsbRx),
+                    MIDI_RX_THREAD_PRIO, thdMidiUsbRx, NULL);
+}
+
+void midi_rx_set_handler(uint8_t status, midi_rx_handler_t handler) {
+  if (status < 0x80U) {
+    return;
+  }
+  rx_handlers[rx_handler_index(status)] = handler;
+}
+
+uint16_t midi_usb_rx_high_watermark(void) {
+  return rx_high_water;
+}
@@ -0,0 +1,75 @@
+/**
+ * @file midi_rx.h
+ * @brief Étage de réception USB-MIDI : parseur complet + table de dispatch.
+ *
+ * L’ISR de l’EP OUT rend le buffer brut reçu (jusqu’à 16 paquets) et réarme
+ * aussitôt un autre buffer d’un petit pool ; un thread dédié parse ensuite
+ * les buffers par lots, directement en place :
+ * - tous les CIN USB-MIDI 1.0 (0x2–0xF), y compris SysEx (0x4–0x7) et
+ *   System Common 1 octet (0x5),
+ * - SysEx réassemblé dans un buffer statique borné (@ref MIDI_RX_SYSEX_MAX),
+ * - dispatch par une table de fonctions indexée par status (aucune allocation).
+ *
+ * Les messages courts sont aussi renvoyés sur la sortie DIN selon
+ * `midi_set_rx_destination()` ; les SysEx ne le sont pas.
+ *
+ * @ingroup drivers
+ */
+
+#ifndef MIDI_RX_H
+#define MIDI_RX_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* ====================================================================== */
+/*                             CONFIGURATION                              */
+/* ====================================================================== */
+
+/** @brief Buffers de réception EP OUT de 64 octets (puissance de 2). */
+#ifndef MIDI_RX_USB_BUFS
+#define MIDI_RX_USB_BUFS       8U
+#endif
+
+/** @brief Taille maximale d’un SysEx réassemblé (F0 et F7 compris). */
+#ifndef MIDI_RX_SYSEX_MAX
+#define MIDI_RX_SYSEX_MAX      1024U
+#endif
+
+/** @brief Priorité du thread de réception USB-MIDI. */
+#ifndef MIDI_RX_THREAD_PRIO
+#define MIDI_RX_THREAD_PRIO    (NORMALPRIO + 1)
+#endif
+
+/* ====================================================================== */
+/*                                 TYPES                                  */
+/* ====================================================================== */
+
+/**
+ * @brief Gestionnaire d’un message reçu.
+ * @param msg Message complet (status en tête ; SysEx : F0 … F7).
+ * @param len Longueur en octets.
+ * @note  Appelé depuis le thread de réception : doit rester court.
+ */
+typedef void (*midi_rx_handler_t)(const uint8_t *msg, size_t len);
+
+/* ====================================================================== */
+/*                                  API                                   */
+/* ====================================================================== */
+
+/** @brief Initialise le pool de buffers et démarre le thread de réception. */
+void midi_rx_start(void);
+
+/**
+ * @brief Associe un gestionnaire à un status.
+ *
+ * - 0x80–0xEF : un gestionnaire par type de message canal (le canal est ignoré),
+ * - 0xF0      : SysEx complet,
+ * - 0xF1–0xFF : un gestionnaire par message système.
+ *
+ * @param status  Octet de status.
+ * @param handler Gestionnaire, ou NULL pour ignorer ce status.
+ */
+void midi_rx_set_handler(uint8_t status, midi_rx_handler_t handler);
+
+#endif /* MIDI_RX_H */
@@ -0,0 +1,213 @@
+/**
+ * @file sdram_alloc.c
+ * @brief Pools à taille fixe (memory_pool_t) et arène par incrément en SDRAM.
+ *
+ * Les objets gérés par les `memory_pool_t` sont les descripteurs
+ * `sdram_slot_t` (RAM interne) : le lien de liste libre écrit par oslib
+ * n’atterrit jamais en SDRAM. L’emplacement SDRAM d’un descripteur est fixé
+ * une fois pour toutes à l’initialisation.
+ *
+ * @ingroup sdram
+ */
+
+#include "ch.h"
+#include "hal.h"
+#include "sdram_alloc.h"
+
+/* ====================================================================== */
+/*                                 ÉTAT                                   */
+/* ====================================================================== */
+
+typedef struct {
+  uint32_t slot_words;
+  uint16_t count;
+} pool_cfg_t;
+
+static const pool_cfg_t pool_cfg[SDRAM_POOL_COUNT] = {
+  [SDRAM_POOL_PATTERN] = { SDRAM_POOL_PATTERN_WORDS, SDRAM_POOL_PATTERN_COUNT },
+  [SDRAM_POOL_KIT]     = { SDRAM_POOL_KIT_WORDS,     SDRAM_POOL_KIT_COUNT },
+  [SDRAM_POOL_SAMPLE]  = { SDRAM_POOL_SAMPLE_WORDS,  SDRAM_POOL_SAMPLE_COUNT }
+};
+
+#define SLOTS_TOTAL  (SDRAM_POOL_PATTERN_COUNT + SDRAM_POOL_KIT_COUNT + \
+                      SDRAM_POOL_SAMPLE_COUNT)
+
+static sdram_slot_t slot_desc[SLOTS_TOTAL];
+
+typedef struct {
+  memory_pool_t mp;
+  uint16_t used;
+  uint16_t high_water;
+  uint32_t failures;
+  uint32_t requested;         /* Mots demandés par les emplacements alloués */
+} pool_state_t;
+
+static pool_state_t pools[SDRAM_POOL_COUNT];
+
+static struct {
+  uint32_t top;               /* Mots consommés depuis SDRAM_ARENA_BASE_WORD */
+  uint32_t pad;               /* Dont perte d’alignement */
+  uint32_t high_water;
+  uint32_t failures;
+} arena;
+
+#define ARENA_WORDS  (SDRAM_ALLOC_END_WORD - SDRAM_ARENA_BASE_WORD)
+
+static uint8_t pct(uint32_t part, uint32_t whole) {
+  return (whole == 0U) ? 0U : (uint8_t)(((uint64_t)part * 100U) / whole);
+}
+
+/* ====================================================================== */
+/*                                  API                                   */
+/* ====================================================================== */
+
+void sdram_alloc_init(void) {
+  uint32_t word = SDRAM_ALLOC_BASE_WORD;
+  sdram_slot_t *d = slot_desc;
+
+  for (uint8_t p = 0U; p < SDRAM_POOL_COUNT; p++) {
+    pool_state_t *ps = &pools[p];
+
+    chPoolObjectInit(&ps->mp, sizeof(sdram_slot_t), NULL);
+    for (uint16_t i = 0U; i < pool_cfg[p].count; i++) {
+      d[i].word = word;
+      d[i].words = 0U;
+      d[i].pool = p;
+      word += pool_cfg[p].slot_words;
+    }
+    chPoolLoadArray(&ps->mp, d, pool_cfg[p].count);
+    d += pool_cfg[p].count;
+
+    ps->used = 0U;
+    ps->high_water = 0U;
+    ps->failures = 0U;
+    ps->requested = 0U;
+  }
+
+  arena.top = 0U;
+  arena.pad = 0U;
+  arena.high_water = 0U;
+  arena.failures = 0U;
+}
+
+const sdram_slot_t *sdram_pool_alloc(sdram_pool_id_t pool, uint32_t words) {
+  sdram_slot_t *s = NULL;
+
+  if ((unsigned)pool >= SDRAM_POOL_COUNT) {
+    return NULL;
+  }
+  pool_state_t *ps = &pools[pool];
+
+  chSysLock();
+  if (words <= pool_cfg[pool].slot_words) {
+    s = chPoolAllocI(&ps->mp);
+  }
+  if (s == NULL) {
+    ps->failures++;
+  }
+  else {
+    s->words = words;
+    ps->requested += words;
+    ps->used++;
+    if (ps->used > ps->high_water) {
+      ps->high_water = ps->used;
+    }
+  }
+  chSysUnlock();
+  return s;
+}
+
+void sdram_pool_free(const sdram_slot_t *slot) {
+  if (slot == NULL) {
+    return;
+  }
+  sdram_slot_t *s = (sdram_slot_t *)slot;
+  pool_state_t *ps = &pools[s->pool];
+
+  chSysLock();
+  ps->requested -= s->words;
+  ps->used--;
+  chPoolFreeI(&ps->mp, s);
+  chSysUnlock();
+}
+
+uint32_t sdram_arena_alloc(uint32_t words, uint32_t align_words) {
+  uint32_t at = SDRAM_ALLOC_NONE;
+
+  if (align_words == 0U) {
+    align_words = 1U;
+  }
+  if ((align_words & (align_words - 1U)) != 0U) {
+    return SDRAM_ALLOC_NONE;
+  }
+
+  chSysLock();
+  const uint32_t base = SDRAM_ARENA_BASE_WORD + arena.top;
+  const uint32_t pad = (uint32_t)(-base) & (align_words - 1U);
+  if (pad <= ARENA_WORDS - arena.top && words <= ARENA_WORDS - arena.top - pad) {
+    at = base + pad;
+    arena.top += pad + words;
+    arena.pad += pad;
+    if (arena.top > arena.high_water) {
+      arena.high_water = arena.top;
+    }
+  }
+  else {
+    arena.failures++;
+  }
+  chSysUnlock();
+  return at;
+}
+
+sdram_arena_mark_t sdram_arena_mark(void) {
+  sdram_arena_mark_t m;
+
+  chSysLock();
+  m.top = arena.top;
+  m.pad = arena.pad;
+  chSysUnlock();
+  return m;
+}
+
+void sdram_arena_release(sdram_arena_mark_t mark) {
+  chSysLock();
+  if (mark.top <= arena.top) {
+    arena.top = mark.top;
+    arena.pad = mark.pad;
+  }
+  chSysUnlock();
+}
+
+void sdram_arena_reset(void) {
+  chSysLock();
+  arena.top = 0U;
+  arena.pad = 0U;
+  chSysUnlock();
+}
+
+void sdram_pool_get_stats(sdram_pool_id_t pool, sdram_pool_stats_t *stats) {
+  if ((unsigned)pool >= SDRAM_POOL_COUNT) {
+    return;
+  }
+  const pool_state_t *ps = &pools[pool];
+
+  chSysLock();
+  stats->slot_words = pool_cfg[pool].slot_words;
+  stats->capacity = pool_cfg[pool].count;
+  stats->used = ps->used;
+  stats->high_water = ps->high_water;
+  stats->failures = ps->failures;
+  const uint32_t alloc_words = (uint32_t)ps->used * pool_cfg[pool].slot_words;
+  stats->frag_pct = pct(alloc_words - ps->requested, alloc_words);
+  chSysUnlock();
+}
+
+void sdram_arena_get_stats(sdram_arena_stats_t *stats) {
+  chSysLock();
+  stats->size_words = ARENA_WORDS;
+  stats->used_words = arena.top;
+  stats->high_water = arena.high_water;
+  stats->failures = arena.failures;
+  stats->frag_pct = pct(arena.pad, arena.top);
+  chSysUnlock();
+}
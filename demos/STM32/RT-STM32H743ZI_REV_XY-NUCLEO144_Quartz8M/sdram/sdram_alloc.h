@@ -0,0 +1,177 @@
+/**
+ * @file sdram_alloc.h
+ * @brief Répartition de la SDRAM : pools typés à taille fixe + arène projet.
+ *
+ * Carte (mots de 32 bits, depuis @ref SDRAM_ALLOC_BASE_WORD) :
+ *   pool patterns | pool kits | pool blocs d’échantillons | arène projet
+ * jusqu’à @ref SDRAM_ALLOC_END_WORD (la banque de patterns `seq_bank` est
+ * au-delà).
+ *
+ * - **pools** : emplacements de taille fixe, alloués / libérés en O(1) par un
+ *   `memory_pool_t` d’oslib. Aucune fragmentation externe ; la perte interne
+ *   (taille demandée < taille d’emplacement) est comptée.
+ * - **arène** : allocation par incrément pour les chargements d’un projet,
+ *   libérée d’un coup en O(1) au changement de projet (@ref sdram_arena_reset)
+ *   ou jusqu’à un repère (@ref sdram_arena_release).
+ *
+ * Contrat x16 (`sdram_ext.c`) : la SDRAM n’est jamais adressée par pointeur.
+ * Une allocation est un index de mot, à lire et écrire avec l’API
+ * `sdram_ext_*` (vue « swappée » explicite). Les descripteurs et listes
+ * libres restent en RAM interne : aucune structure système en SDRAM
+ * (agent.md).
+ *
+ * Contexte d’appel : thread ; allocations et libérations sous verrou
+ * système, durée bornée (utilisables pendant la lecture).
+ *
+ * @ingroup sdram
+ */
+
+#ifndef SDRAM_ALLOC_H
+#define SDRAM_ALLOC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "brick_config.h"
+#include "sdram_ext.h"
+
+/* ====================================================================== */
+/*                             CONFIGURATION                              */
+/* ====================================================================== */
+
+/** @brief Premier mot géré. */
+#ifndef SDRAM_ALLOC_BASE_WORD
+#define SDRAM_ALLOC_BASE_WORD       0U
+#endif
+
+/** @brief Fin (exclue) de la zone gérée : 16 Mo, la banque de patterns suit. */
+#ifndef SDRAM_ALLOC_END_WORD
+#define SDRAM_ALLOC_END_WORD        (16UL * 1024UL * 1024UL / 4UL)
+#endif
+
+/** @brief Pattern de travail (undo, presse-papiers) : ≥ SEQ_PATTERN_MAX_WORDS. */
+#ifndef SDRAM_POOL_PATTERN_WORDS
+#define SDRAM_POOL_PATTERN_WORDS    1088U
+#endif
+#ifndef SDRAM_POOL_PATTERN_COUNT
+#define SDRAM_POOL_PATTERN_COUNT    64U
+#endif
+
+/** @brief Kit (réglages de toutes les voix d’une cartouche), 8 Ko. */
+#ifndef SDRAM_POOL_KIT_WORDS
+#define SDRAM_POOL_KIT_WORDS        2048U
+#endif
+#ifndef SDRAM_POOL_KIT_COUNT
+#define SDRAM_POOL_KIT_COUNT        32U
+#endif
+
+/** @brief Bloc d’échantillons, 64 Ko (32768 échantillons 16 bits). */
+#ifndef SDRAM_POOL_SAMPLE_WORDS
+#define SDRAM_POOL_SAMPLE_WORDS     16384U
+#endif
+#ifndef SDRAM_POOL_SAMPLE_COUNT
+#define SDRAM_POOL_SAMPLE_COUNT     128U
+#endif
+
+#define SDRAM_POOLS_WORDS   (SDRAM_POOL_PATTERN_WORDS * SDRAM_POOL_PATTERN_COUNT + \
+                             SDRAM_POOL_KIT_WORDS * SDRAM_POOL_KIT_COUNT +         \
+                             SDRAM_POOL_SAMPLE_WORDS * SDRAM_POOL_SAMPLE_COUNT)
+
+/** @brief Début de l’arène (après les pools). */
+#define SDRAM_ARENA_BASE_WORD       (SDRAM_ALLOC_BASE_WORD + SDRAM_POOLS_WORDS)
+
+BRICK_STATIC_ASSERT(SDRAM_ALLOC_END_WORD <= SDRAM_EXT_WORDS, sdram_alloc_fits_device);
+BRICK_STATIC_ASSERT(SDRAM_ARENA_BASE_WORD < SDRAM_ALLOC_END_WORD, sdram_pools_fit);
+
+/** @brief Index invalide (arène pleine). */
+#define SDRAM_ALLOC_NONE            0xFFFFFFFFUL
+
+/* ====================================================================== */
+/*                                 TYPES                                  */
+/* ====================================================================== */
+
+typedef enum {
+  SDRAM_POOL_PATTERN = 0,
+  SDRAM_POOL_KIT,
+  SDRAM_POOL_SAMPLE,
+  SDRAM_POOL_COUNT
+} sdram_pool_id_t;
+
+/**
+ * @struct sdram_slot_t
+ * @brief Emplacement de pool (descripteur en RAM interne, lecture seule).
+ */
+typedef struct {
+  void     *link;         /**< Réservé au memory_pool_t (liste libre) */
+  uint32_t  word;         /**< Premier mot en SDRAM (API sdram_ext) */
+  uint32_t  words;        /**< Taille demandée, en mots */
+  uint8_t   pool;         /**< @ref sdram_pool_id_t */
+} sdram_slot_t;
+
+/**
+ * @struct sdram_pool_stats_t
+ * @brief État d’un pool.
+ */
+typedef struct {
+  uint32_t slot_words;    /**< Taille d’un emplacement */
+  uint16_t capacity;      /**< Emplacements */
+  uint16_t used;          /**< Emplacements alloués */
+  uint16_t high_water;    /**< Maximum de @p used */
+  uint32_t failures;      /**< Allocations refusées (pool plein, trop grand) */
+  uint8_t  frag_pct;      /**< Perte interne : % des mots alloués inutilisés */
+} sdram_pool_stats_t;
+
+/**
+ * @struct sdram_arena_stats_t
+ * @brief État de l’arène.
+ */
+typedef struct {
+  uint32_t size_words;    /**< Taille de l’arène */
+  uint32_t used_words;    /**< Mots consommés (alignements compris) */
+  uint32_t high_water;    /**< Maximum de @p used_words */
+  uint32_t failures;      /**< Allocations refusées */
+  uint8_t  frag_pct;      /**< Perte d’alignement : % de @p used_words */
+} sdram_arena_stats_t;
+
+/** @brief Repère d’arène (@ref sdram_arena_mark). */
+typedef struct {
+  uint32_t top;
+  uint32_t pad;
+} sdram_arena_mark_t;
+
+/* ====================================================================== */
+/*                                  API                                   */
+/* ====================================================================== */
+
+/** @brief Pools pleins de libres, arène vide, statistiques à zéro. */
+void sdram_alloc_init(void);
+
+/**
+ * @brief Alloue un emplacement de @p words mots (≤ taille d’emplacement).
+ * @return NULL si le pool est plein ou @p words trop grand.
+ */
+const sdram_slot_t *sdram_pool_alloc(sdram_pool_id_t pool, uint32_t words);
+
+/** @brief Rend un emplacement à son pool (NULL accepté). */
+void sdram_pool_free(const sdram_slot_t *slot);
+
+/**
+ * @brief Alloue @p words mots dans l’arène.
+ * @param align_words Alignement en mots (puissance de 2, 0 ou 1 : aucun).
+ * @return Premier mot, ou @ref SDRAM_ALLOC_NONE si l’arène est pleine.
+ */
+uint32_t sdram_arena_alloc(uint32_t words, uint32_t align_words);
+
+/** @brief Repère courant, pour libérer plus tard tout ce qui suit. */
+sdram_arena_mark_t sdram_arena_mark(void);
+
+/** @brief Libère tout ce qui a été alloué après @p mark. */
+void sdram_arena_release(sdram_arena_mark_t mark);
+
+/** @brief Vide l’arène (changement de projet). */
+void sdram_arena_reset(void);
+
+void sdram_pool_get_stats(sdram_pool_id_t pool, sdram_pool_stats_t *stats);
+void sdram_arena_get_stats(sdram_arena_stats_t *stats);
+
+#endif /* SDRAM_ALLOC_H */
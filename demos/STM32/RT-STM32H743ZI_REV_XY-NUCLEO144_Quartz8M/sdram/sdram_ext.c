@@ -67,6 +67,8 @@
 #include "hal.h"
 #include "sdram_ext.h"
 
+#if !defined(SIMULATOR)
+
 /* =========================================================
  * SDRAM CONFIGURATION (STM32H7 + W9825G6KH, x16)
  * ========================================================= */
@@ -93,6 +95,24 @@ static const SDRAMConfig sdram_cfg = {
   .sdrtr = (781U << FMC_SDRTR_COUNT_Pos)
 };
 
+#define SDRAM_MEM  ((uint32_t *)SDRAM_EXT_BASE)
+
+#else /* SIMULATOR */
+
+/*
+ * Host build: the SDRAM is a plain array holding the raw layout
+ * the FMC produces, i.e. every logical word stored halfword-swapped.
+ */
+static uint32_t sdram_sim[SDRAM_EXT_WORDS];
+
+#define SDRAM_MEM  (sdram_sim)
+
+uint32_t *sdram_ext_sim_raw(void) {
+  return sdram_sim;
+}
+
+#endif /* SIMULATOR */
+
 /* =========================================================
  * INTERNAL UTIL
  * ========================================================= */
@@ -102,22 +122,220 @@ static inline uint32_t swap16(uint32_t v) {
   return (v >> 16) | (v << 16);
 }
 
+static inline bool range_ok(uint32_t index, size_t words) {
+  return index <= SDRAM_EXT_WORDS && words <= (size_t)(SDRAM_EXT_WORDS - index);
+}
+
+/*
+ * Bulk kernels, 8 words per iteration.
+ * All loads are issued before the stores so that GCC emits LDM/STM
+ * bursts (one FMC burst per 8 words instead of 8 single accesses).
+ * The swap itself is a single ROR #16 per word: nothing to gain
+ * from SIMD here, the loop is bound by the FMC.
+ */
+static void copy_swap(uint32_t *dst, const uint32_t *src, size_t words) {
+
+  while (words >= 8U) {
+    const uint32_t a = src[0], b = src[1], c = src[2], d = src[3];
+    const uint32_t e = src[4], f = src[5], g = src[6], h = src[7];
+    dst[0] = swap16(a); dst[1] = swap16(b);
+    dst[2] = swap16(c); dst[3] = swap16(d);
+    dst[4] = swap16(e); dst[5] = swap16(f);
+    dst[6] = swap16(g); dst[7] = swap16(h);
+    src += 8;
+    dst += 8;
+    words -= 8U;
+  }
+  while (words > 0U) {
+    *dst++ = swap16(*src++);
+    words--;
+  }
+}
+
+static void copy_raw(uint32_t *dst, const uint32_t *src, size_t words) {
+
+  while (words >= 8U) {
+    const uint32_t a = src[0], b = src[1], c = src[2], d = src[3];
+    const uint32_t e = src[4], f = src[5], g = src[6], h = src[7];
+    dst[0] = a; dst[1] = b; dst[2] = c; dst[3] = d;
+    dst[4] = e; dst[5] = f; dst[6] = g; dst[7] = h;
+    src += 8;
+    dst += 8;
+    words -= 8U;
+  }
+  while (words > 0U) {
+    *dst++ = *src++;
+    words--;
+  }
+}
+
+/* =========================================================
+ * ASYNCHRONOUS TRANSFERS (MDMA)
+ * =========================================================
+ *
+ * One software-triggered MDMA channel, word to word, bursts
+ * of 8 beats. The halfword swap is done by the MDMA itself
+ * (CCR.HEX) for read/write, not for SDRAM to SDRAM copies.
+ * Transfers longer than SDRAM_EXT_MDMA_CHUNK are chained
+ * chunk by chunk from the completion ISR.
+ */
+
+static sdram_ext_cb_t xfer_cb;
+static void          *xfer_arg;
+static bool           xfer_busy;
+
+#if !defined(SIMULATOR)
+
+#define MDMA_CTCR  (STM32_MDMA_CTCR_SINC_INC | STM32_MDMA_CTCR_DINC_INC |     \
+                    STM32_MDMA_CTCR_SSIZE_WORD | STM32_MDMA_CTCR_DSIZE_WORD | \
+                    STM32_MDMA_CTCR_SINCOS_WORD | STM32_MDMA_CTCR_DINCOS_WORD | \
+                    STM32_MDMA_CTCR_SBURST_8 | STM32_MDMA_CTCR_DBURST_8 |   \
+                    STM32_MDMA_CTCR_TLEN(127U) |                            \
+                    STM32_MDMA_CTCR_TRGM_WHOLE | STM32_MDMA_CTCR_SWRM |     \
+                    STM32_MDMA_CTCR_BWM_NON_BUFF)
+
+static const stm32_mdma_channel_t *xfer_mdma;
+static uint32_t xfer_src;
+static uint32_t xfer_dst;
+static uint32_t xfer_left;      /* bytes */
+static uint32_t xfer_ccr;
+static void    *xfer_inv;       /* destination to invalidate on completion */
+static size_t   xfer_bytes;
+
+static void mdma_next_chunk(void) {
+  const uint32_t n = (xfer_left > SDRAM_EXT_MDMA_CHUNK) ? SDRAM_EXT_MDMA_CHUNK
+                                                        : xfer_left;
+
+  mdmaChannelSetSourceX(xfer_mdma, xfer_src);
+  mdmaChannelSetDestinationX(xfer_mdma, xfer_dst);
+  mdmaChannelSetTransactionSizeX(xfer_mdma, n, 0U, 0U);
+  mdmaChannelSetModeX(xfer_mdma, MDMA_CTCR, xfer_ccr);
+  mdmaChannelClearInterruptX(xfer_mdma);
+  mdmaChannelEnableX(xfer_mdma);
+  xfer_mdma->channel->CCR |= STM32_MDMA_CCR_SWRQ;
+
+  xfer_src  += n;
+  xfer_dst  += n;
+  xfer_left -= n;
+}
+
+static void mdma_serve(void *p, uint32_t flags) {
+  const bool ok = (flags & STM32_MDMA_CISR_TEIF) == 0U;
+  (void)p;
+
+  if (ok && xfer_left > 0U) {
+    mdma_next_chunk();
+    return;
+  }
+  mdmaChannelDisableX(xfer_mdma);
+
+  /* Drop lines speculatively refilled while the MDMA was writing. */
+  cacheBufferInvalidate(xfer_inv, xfer_bytes);
+
+  osalSysLockFromISR();
+  const sdram_ext_cb_t cb = xfer_cb;
+  void *arg = xfer_arg;
+  xfer_busy = false;
+  osalSysUnlockFromISR();
+
+  if (cb != NULL) {
+    cb(arg, ok);
+  }
+}
+
+static bool start_async(uintptr_t dst, uintptr_t src, size_t words, bool swap,
+                        sdram_ext_cb_t cb, void *arg) {
+
+  osalSysLock();
+  if (xfer_busy || xfer_mdma == NULL) {
+    osalSysUnlock();
+    return false;
+  }
+  xfer_busy = true;
+  xfer_cb   = cb;
+  xfer_arg  = arg;
+  if (words == 0U) {
+    xfer_busy = false;
+    osalSysUnlock();
+    if (cb != NULL) {
+      cb(arg, true);
+    }
+    return true;
+  }
+  xfer_src  = (uint32_t)src;
+  xfer_dst  = (uint32_t)dst;
+  xfer_left = (uint32_t)(words * 4U);
+  xfer_ccr  = STM32_MDMA_CCR_PL(1U) | STM32_MDMA_CCR_CTCIE | STM32_MDMA_CCR_TEIE |
+              (swap ? STM32_MDMA_CCR_HEX : 0U);
+  xfer_inv   = (void *)dst;
+  xfer_bytes = words * 4U;
+  /* Write back the source, then drop the destination so no dirty line
+     gets evicted over the MDMA data. No-op on the non-cacheable SDRAM. */
+  cacheBufferFlush((const void *)src, xfer_bytes);
+  cacheBufferInvalidate(xfer_inv, xfer_bytes);
+  mdma_next_chunk();
+  osalSysUnlock();
+  return true;
+}
+
+#else /* SIMULATOR */
+
+/* Host build: done synchronously, the callback runs before returning. */
+static bool start_async(uintptr_t dst, uintptr_t src, size_t words, bool swap,
+                        sdram_ext_cb_t cb, void *arg) {
+
+  osalSysLock();
+  if (xfer_busy) {
+    osalSysUnlock();
+    return false;
+  }
+  xfer_busy = true;
+  xfer_cb   = cb;
+  xfer_arg  = arg;
+  osalSysUnlock();
+
+  if (swap) {
+    copy_swap((uint32_t *)dst, (const uint32_t *)src, words);
+  }
+  else {
+    copy_raw((uint32_t *)dst, (const uint32_t *)src, words);
+  }
+
+  osalSysLock();
+  xfer_busy = false;
+  osalSysUnlock();
+  if (cb != NULL) {
+    cb(arg, true);
+  }
+  return true;
+}
+
+#endif /* SIMULATOR */
+
 /* =========================================================
  * PUBLIC API
  * ========================================================= */
 
 void sdram_ext_init(void) {
 
+#if !defined(SIMULATOR)
   /* Initialize SDRAM subsystem */
   sdramInit();
 
   /* Start SDRAM with fixed configuration */
   sdramStart(&SDRAMD1, &sdram_cfg);
+
+  /* MDMA channel for asynchronous transfers */
+  if (xfer_mdma == NULL) {
+    xfer_mdma = mdmaChannelAlloc(STM32_MDMA_CHANNEL_ID_ANY, mdma_serve, NULL);
+  }
+#endif
+  xfer_busy = false;
 }
 
 void sdram_ext_write32(uint32_t index, uint32_t value) {
 
-  volatile uint32_t *mem = (uint32_t *)SDRAM_EXT_BASE;
+  volatile uint32_t *mem = SDRAM_MEM;
 
   /* Write with halfword swap */
   mem[index] = swap16(value);
@@ -125,8 +343,66 @@ void sdram_ext_write32(uint32_t index, uint32_t value) {
 
 uint32_t sdram_ext_read32(uint32_t index) {
 
-  volatile uint32_t *mem = (uint32_t *)SDRAM_EXT_BASE;
+  volatile uint32_t *mem = SDRAM_MEM;
 
   /* Read and unswap */
   return swap16(mem[index]);
 }
+
+void sdram_ext_write_block(uint32_t index, const uint32_t *src, size_t words) {
+
+  if (!range_ok(index, words)) {
+    return;
+  }
+  copy_swap(&SDRAM_MEM[index], src, words);
+}
+
+void sdram_ext_read_block(uint32_t index, uint32_t *dst, size_t words) {
+
+  if (!range_ok(index, words)) {
+    return;
+  }
+  copy_swap(dst, &SDRAM_MEM[index], words);
+}
+
+void sdram_ext_copy(uint32_t dst_index, uint32_t src_index, size_t words) {
+
+  if (!range_ok(dst_index, words) || !range_ok(src_index, words)) {
+    return;
+  }
+  copy_raw(&SDRAM_MEM[dst_index], &SDRAM_MEM[src_index], words);
+}
+
+bool sdram_ext_write_block_async(uint32_t index, const uint32_t *src, size_t words,
+                                 sdram_ext_cb_t cb, void *arg) {
+
+  if (!range_ok(index, words)) {
+    return false;
+  }
+  return start_async((uintptr_t)&SDRAM_MEM[index], (uintptr_t)src, words, true,
+                     cb, arg);
+}
+
+bool sdram_ext_read_block_async(uint32_t index, uint32_t *dst, size_t words,
+                                sdram_ext_cb_t cb, void *arg) {
+
+  if (!range_ok(index, words)) {
+    return false;
+  }
+  return start_async((uintptr_t)dst, (uintptr_t)&SDRAM_MEM[index], words, true,
+                     cb, arg);
+}
+
+bool sdram_ext_copy_async(uint32_t dst_index, uint32_t src_index, size_t words,
+                          sdram_ext_cb_t cb, void *arg) {
+
+  if (!range_ok(dst_index, words) || !range_ok(src_index, words)) {
+    return false;
+  }
+  return start_async((uintptr_t)&SDRAM_MEM[dst_index], (uintptr_t)&SDRAM_MEM[src_index],
+                     words, false, cb, arg);
+}
+
+bool sdram_ext_busy(void) {
+  return __atomic_load_n(&xfer_busy, __ATOMIC_RELAXED);
+}
@@ -10,10 +10,29 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 /* Base address of external SDRAM */
 #define SDRAM_EXT_BASE   0xC0000000U
 
+/* W9825G6KH: 32 MB, i.e. 8M words of 32 bits */
+#define SDRAM_EXT_SIZE   (32U * 1024U * 1024U)
+#define SDRAM_EXT_WORDS  (SDRAM_EXT_SIZE / 4U)
+
+/*
+ * Asynchronous transfers (MDMA) are split in chunks of this many bytes
+ * (hardware limit: 0x1FFFF per block).
+ */
+#ifndef SDRAM_EXT_MDMA_CHUNK
+#define SDRAM_EXT_MDMA_CHUNK  65536U
+#endif
+
+/*
+ * Completion callback of an asynchronous transfer.
+ * Called from the MDMA ISR; ok is false on a bus error.
+ */
+typedef void (*sdram_ext_cb_t)(void *arg, bool ok);
+
 /* Initialize and start external SDRAM */
 void sdram_ext_init(void);
 
@@ -21,4 +40,44 @@ void sdram_ext_init(void);
 void     sdram_ext_write32(uint32_t index, uint32_t value);
 uint32_t sdram_ext_read32(uint32_t index);
 
+/*
+ * Block helpers: same layout as write32/read32 on every word,
+ * without the per-word call. src/dst are plain RAM buffers.
+ */
+void sdram_ext_write_block(uint32_t index, const uint32_t *src, size_t words);
+void sdram_ext_read_block(uint32_t index, uint32_t *dst, size_t words);
+
+/*
+ * SDRAM to SDRAM copy (both sides swapped: raw copy, no swap).
+ * Ranges must not overlap, unless dst_index < src_index.
+ */
+void sdram_ext_copy(uint32_t dst_index, uint32_t src_index, size_t words);
+
+/*
+ * Asynchronous versions (MDMA, halfword swap done by the MDMA).
+ * One transfer at a time: return false if one is already running
+ * or the arguments are out of range.
+ * RAM buffers must be reachable by the MDMA (AXI SRAM, not DTCM/stack)
+ * and stay valid until the callback.
+ * The D-cache is maintained here (source cleaned, destination invalidated
+ * before the start and again before the callback), so RAM buffers must be
+ * 32-byte aligned and span whole cache lines: data sharing a line with a
+ * read destination would be lost. Do not touch the destination until the
+ * callback.
+ */
+bool sdram_ext_write_block_async(uint32_t index, const uint32_t *src, size_t words,
+                                 sdram_ext_cb_t cb, void *arg);
+bool sdram_ext_read_block_async(uint32_t index, uint32_t *dst, size_t words,
+                                sdram_ext_cb_t cb, void *arg);
+bool sdram_ext_copy_async(uint32_t dst_index, uint32_t src_index, size_t words,
+                          sdram_ext_cb_t cb, void *arg);
+
+/* True while an asynchronous transfer is running */
+bool sdram_ext_busy(void);
+
+#if defined(SIMULATOR)
+/* Host build: raw view of the emulated SDRAM (as laid out by the FMC) */
+uint32_t *sdram_ext_sim_raw(void);
+#endif
+
 #endif /* SDRAM_EXT_H */
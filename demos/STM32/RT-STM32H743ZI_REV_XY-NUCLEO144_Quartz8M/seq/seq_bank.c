@@ -0,0 +1,81 @@
+/**
+ * @file seq_bank.c
+ * @brief Emplacements fixes de patterns sérialisés en SDRAM.
+ *
+ * @ingroup seq
+ */
+
+#include "seq_bank.h"
+#include "sdram_ext.h"
+#include "sdram_alloc.h"
+
+/* SDRAM 32 Mo : la banque doit tenir derrière son offset. */
+BRICK_STATIC_ASSERT((SEQ_BANK_SDRAM_WORD + SEQ_BANK_PATTERNS * SEQ_BANK_SLOT_WORDS) <=
+                    SDRAM_EXT_WORDS, seq_bank_fits_sdram);
+
+/* La banque suit la zone des pools / de l’arène, qui accueille des patterns. */
+BRICK_STATIC_ASSERT(SEQ_BANK_SDRAM_WORD >= SDRAM_ALLOC_END_WORD, seq_bank_after_alloc);
+BRICK_STATIC_ASSERT(SEQ_PATTERN_MAX_WORDS <= SDRAM_POOL_PATTERN_WORDS, pattern_fits_pool_slot);
+
+/* Tampon de sérialisation (un seul thread utilise la banque). */
+static uint32_t bank_buf[SEQ_BANK_SLOT_WORDS];
+
+static inline uint32_t slot_base(uint16_t slot) {
+  return SEQ_BANK_SDRAM_WORD + (uint32_t)slot * SEQ_BANK_SLOT_WORDS;
+}
+
+void seq_bank_format(void) {
+  for (uint16_t s = 0U; s < SEQ_BANK_PATTERNS; s++) {
+    seq_bank_erase(s);
+  }
+}
+
+bool seq_bank_used(uint16_t slot) {
+  if (slot >= SEQ_BANK_PATTERNS) {
+    return false;
+  }
+
+  uint32_t hdr[SEQ_PATTERN_HDR_WORDS];
+  sdram_ext_read_block(slot_base(slot), hdr, SEQ_PATTERN_HDR_WORDS);
+  return seq_pattern_serialized_words(hdr) != 0U;
+}
+
+bool seq_bank_store(uint16_t slot, const seq_pattern_t *p) {
+  if (slot >= SEQ_BANK_PATTERNS) {
+    return false;
+  }
+
+  const size_t words = seq_pattern_serialize(p, bank_buf, SEQ_BANK_SLOT_WORDS);
+  const uint32_t base = slot_base(slot);
+
+  /* En-tête en dernier : un emplacement interrompu reste invalide. */
+  sdram_ext_write32(base, 0U);
+  if (words > 1U) {
+    sdram_ext_write_block(base + 1U, &bank_buf[1], words - 1U);
+  }
+  sdram_ext_write32(base, bank_buf[0]);
+  return true;
+}
+
+bool seq_bank_load(uint16_t slot, seq_pattern_t *p) {
+  if (slot >= SEQ_BANK_PATTERNS) {
+    seq_pattern_init(p);
+    return false;
+  }
+
+  const uint32_t base = slot_base(slot);
+  sdram_ext_read_block(base, bank_buf, SEQ_PATTERN_HDR_WORDS);
+
+  const size_t words = seq_pattern_serialized_words(bank_buf);
+  if (words > SEQ_PATTERN_HDR_WORDS) {
+    sdram_ext_read_block(base + SEQ_PATTERN_HDR_WORDS, &bank_buf[SEQ_PATTERN_HDR_WORDS],
+                         words - SEQ_PATTERN_HDR_WORDS);
+  }
+  return seq_pattern_deserialize(p, bank_buf, words);
+}
+
+void seq_bank_erase(uint16_t slot) {
+  if (slot < SEQ_BANK_PATTERNS) {
+    sdram_ext_write32(slot_base(slot), 0U);
+  }
+}
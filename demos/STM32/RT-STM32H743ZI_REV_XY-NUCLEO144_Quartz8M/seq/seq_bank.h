@@ -0,0 +1,57 @@
+/**
+ * @file seq_bank.h
+ * @brief Banque de patterns en SDRAM externe.
+ *
+ * Chaque pattern occupe un emplacement de taille fixe
+ * (@ref SEQ_PATTERN_MAX_WORDS mots) : stocker, remplacer ou effacer un
+ * pattern ne déplace rien et ne peut pas fragmenter la zone. Seule la forme
+ * sérialisée utile est écrite/relue (en-tête + trigs + p-locks posés).
+ *
+ * Tous les accès passent par l’API `sdram_ext` (blocs + mot d’en-tête)
+ * (contrat de swap des demi-mots du bus x16).
+ *
+ * @ingroup seq
+ */
+
+#ifndef SEQ_BANK_H
+#define SEQ_BANK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "seq_pattern.h"
+
+/** @brief Nombre d’emplacements de patterns. */
+#ifndef SEQ_BANK_PATTERNS
+#define SEQ_BANK_PATTERNS       128U
+#endif
+
+/** @brief Début de la banque en SDRAM (index de mot 32 bits depuis la base). */
+#ifndef SEQ_BANK_SDRAM_WORD
+#define SEQ_BANK_SDRAM_WORD     (0x01000000U / 4U)   /* 16 Mo */
+#endif
+
+#define SEQ_BANK_SLOT_WORDS     SEQ_PATTERN_MAX_WORDS
+
+/** @brief Efface la banque (tous les emplacements vides). */
+void seq_bank_format(void);
+
+/** @brief true si l’emplacement contient un pattern valide. */
+bool seq_bank_used(uint16_t slot);
+
+/**
+ * @brief Sérialise @p p dans l’emplacement @p slot.
+ * @return false si l’emplacement est hors bornes.
+ */
+bool seq_bank_store(uint16_t slot, const seq_pattern_t *p);
+
+/**
+ * @brief Recharge l’emplacement @p slot dans @p p.
+ * @return false si l’emplacement est vide ou invalide (@p p laissé vide).
+ */
+bool seq_bank_load(uint16_t slot, seq_pattern_t *p);
+
+/** @brief Marque l’emplacement comme vide. */
+void seq_bank_erase(uint16_t slot);
+
+#endif /* SEQ_BANK_H */
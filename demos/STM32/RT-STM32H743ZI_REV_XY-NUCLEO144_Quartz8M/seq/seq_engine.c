@@ -0,0 +1,548 @@
+/**
+ * @file seq_engine.c
+ * @brief Rendu en avance des pas et dispatch horodaté des événements.
+ *
+ * File d’événements : tas binaire (min) sur (date, type), protégé par le
+ * verrou système ; insertion et extraction en O(log n).
+ *
+ * Le thread de dispatch est suspendu jusqu’à la date de la tête de file
+ * (`chThdSuspendTimeoutS`) ; une insertion qui devient la nouvelle tête le
+ * réveille pour recalculer son échéance. Le thread de rendu attend de même
+ * l’heure du prochain pas moins @ref SEQ_LOOKAHEAD_STEPS pas ; start / stop
+ * le réveillent. Toutes les échéances sont absolues : aucun cumul d’erreur.
+ *
+ * @ingroup seq
+ */
+
+#include "ch.h"
+#include "hal.h"
+#include "seq_engine.h"
+
+BRICK_STATIC_ASSERT(SEQ_LOOKAHEAD_STEPS >= 2, seq_lookahead_for_micro);
+BRICK_STATIC_ASSERT(SEQ_PARAM_STEP_FIRST > 0, seq_step_params_fit);
+BRICK_STATIC_ASSERT(SEQ_MAX_RATCHETS <= 0xFF, seq_ratchet_bits);
+BRICK_STATIC_ASSERT(SEQ_EVENT_QUEUE_LEN <= 0xFFFF, seq_queue_bits);
+
+#define SEQ_CLOCKS_PER_STEP   6U      /* 24 ppqn, 4 pas par noire */
+#define SEQ_TRACK_NONE        0xFFU
+
+/* Événements maximum d’une piste sur un pas : ratchets + p-locks de son. */
+#define SEQ_TRACK_EVENTS      (2U * SEQ_MAX_RATCHETS + SEQ_PARAM_STEP_FIRST)
+
+/* ====================================================================== */
+/*                                 ÉTAT                                   */
+/* ====================================================================== */
+
+/* File (sous verrou système). */
+static seq_event_t ev_q[SEQ_EVENT_QUEUE_LEN];
+static uint16_t    ev_n;
+
+/* Transport (sous verrou système). */
+static bool        eng_running;
+static uint32_t    eng_gen;           /* Incrémenté à chaque start / stop */
+static systime_t   eng_base;          /* Tick du pas 0 */
+static uint64_t    eng_next_q16;      /* Date du prochain pas à rendre (Q16) */
+static uint8_t     eng_next_step;
+static uint64_t    eng_step_q16;      /* Durée d’un pas (ticks Q16) */
+static uint8_t     eng_swing;
+static midi_dest_t eng_clock_dest;
+static seq_cart_sink_t eng_cart_sink;
+
+static const seq_pattern_t *eng_pattern;
+static seq_track_cfg_t      eng_tracks[BRICK_NUM_TRACKS];
+static mutex_t              eng_mtx;
+
+static thread_reference_t render_tr;
+static thread_reference_t disp_tr;
+static seq_engine_stats_t eng_stats;
+
+/* Notes tenues par piste : un NOTE OFF ne part qu’au dernier relâchement,
+   pour que deux notes identiques qui se chevauchent ne se coupent pas.
+   Accès : thread de dispatch uniquement. */
+static uint8_t note_held[BRICK_NUM_TRACKS][128];
+
+/* Événements d’une piste en cours de rendu (thread de rendu uniquement). */
+static seq_event_t track_buf[SEQ_TRACK_EVENTS];
+
+static THD_WORKING_AREA(waSeqRender, 512);
+static THD_WORKING_AREA(waSeqDispatch, 512);
+
+/* ====================================================================== */
+/*                          FILE (TAS BINAIRE)                            */
+/* ====================================================================== */
+
+static inline bool ev_before(const seq_event_t *a, const seq_event_t *b) {
+  const int32_t dt = (int32_t)(a->time - b->time);
+  return (dt < 0) || ((dt == 0) && (a->type < b->type));
+}
+
+static void heap_down(uint16_t i) {
+  const seq_event_t e = ev_q[i];
+
+  for (;;) {
+    uint16_t c = (uint16_t)(2U * i + 1U);
+    if (c >= ev_n) {
+      break;
+    }
+    if (((c + 1U) < ev_n) && ev_before(&ev_q[c + 1U], &ev_q[c])) {
+      c++;
+    }
+    if (!ev_before(&ev_q[c], &e)) {
+      break;
+    }
+    ev_q[i] = ev_q[c];
+    i = c;
+  }
+  ev_q[i] = e;
+}
+
+/* Insère ; true si l’événement devient la tête de file. */
+static bool heap_push_i(const seq_event_t *e) {
+  if (ev_n >= SEQ_EVENT_QUEUE_LEN) {
+    eng_stats.queue_drops++;
+    return false;
+  }
+
+  uint16_t i = ev_n++;
+  while (i > 0U) {
+    const uint16_t parent = (uint16_t)((i - 1U) / 2U);
+    if (!ev_before(e, &ev_q[parent])) {
+      break;
+    }
+    ev_q[i] = ev_q[parent];
+    i = parent;
+  }
+  ev_q[i] = *e;
+
+  if (ev_n > eng_stats.queue_peak) {
+    eng_stats.queue_peak = ev_n;
+  }
+  return i == 0U;
+}
+
+static void heap_pop_i(seq_event_t *out) {
+  *out = ev_q[0];
+  ev_n--;
+  if (ev_n > 0U) {
+    ev_q[0] = ev_q[ev_n];
+    heap_down(0U);
+  }
+}
+
+/* Vide la file d’une génération révolue (start / stop) : seuls les NOTE OFF
+   restent, tous dus maintenant. Même date, même type : le tableau compacté
+   est déjà un tas valide. */
+static void heap_purge_i(void) {
+  const systime_t now = chVTGetSystemTimeX();
+  uint16_t kept = 0U;
+
+  for (uint16_t i = 0U; i < ev_n; i++) {
+    if (ev_q[i].type == SEQ_EV_NOTE_OFF) {
+      ev_q[kept] = ev_q[i];
+      ev_q[kept].time = now;
+      kept++;
+    }
+  }
+  ev_n = kept;
+}
+
+/* ====================================================================== */
+/*                                 RENDU                                  */
+/* ====================================================================== */
+
+static inline systime_t q16_to_time(systime_t base, uint64_t q16) {
+  return (systime_t)(base + (systime_t)((q16 + 0x8000U) >> 16));
+}
+
+/* Traduit un pas d’une piste en événements ; retourne leur nombre. */
+static size_t render_track(const seq_pattern_t *p, const seq_track_cfg_t *cfg,
+                           uint8_t track, uint8_t step, systime_t base,
+                           uint64_t start_q16, uint64_t step_q16) {
+  uint8_t note = cfg->note;
+  uint8_t vel = cfg->velocity;
+  uint32_t length = cfg->length;
+  int32_t micro = 0;
+  uint32_t ratchets = 1U;
+  size_t n = 0U;
+
+  for (const seq_plock_t *q = seq_plock_begin(p, track, step);
+       q != seq_plock_end(p, track, step); q++) {
+    switch (SEQ_PLOCK_PARAM(q->key)) {
+      case SEQ_PARAM_NOTE:     note = (uint8_t)(q->value & 0x7FU); break;
+      case SEQ_PARAM_VELOCITY: vel = (uint8_t)(q->value & 0x7FU); break;
+      case SEQ_PARAM_LENGTH:   length = q->value; break;
+      case SEQ_PARAM_MICRO:    micro = (int16_t)q->value; break;
+      case SEQ_PARAM_RATCHET:  ratchets = q->value; break;
+      default:
+        break;
+    }
+  }
+
+  if (vel == 0U) {
+    vel = 1U;
+  }
+  if (length == 0U) {
+    length = 1U;
+  }
+  if (micro >= (int32_t)SEQ_MICRO_DIV) {
+    micro = (int32_t)SEQ_MICRO_DIV - 1;
+  } else if (micro <= -(int32_t)SEQ_MICRO_DIV) {
+    micro = -((int32_t)SEQ_MICRO_DIV - 1);
+  }
+  if (ratchets == 0U) {
+    ratchets = 1U;
+  } else if (ratchets > SEQ_MAX_RATCHETS) {
+    ratchets = SEQ_MAX_RATCHETS;
+  }
+
+  /* Date du pas : grille + swing (pas impairs) + micro-timing. Le swing
+     allonge les pas pairs et raccourcit les impairs d’autant. */
+  const uint64_t swing_q16 = step_q16 * (uint64_t)(eng_swing - 50U) / 50U;
+  const uint64_t span_q16 = ((step & 1U) != 0U) ? (step_q16 - swing_q16)
+                                                 : (step_q16 + swing_q16);
+  int64_t t = (int64_t)start_q16;
+  if ((step & 1U) != 0U) {
+    t += (int64_t)swing_q16;
+  }
+  t += (int64_t)micro * (int64_t)step_q16 / (int64_t)SEQ_MICRO_DIV;
+  if (t < 0) {
+    t = 0;      /* Micro-timing négatif sur le tout premier pas */
+  }
+  const uint64_t t0 = (uint64_t)t;
+
+  /* P-locks de son : avant la note, à la même date. */
+  if (cfg->cart != SEQ_CART_NONE) {
+    for (const seq_plock_t *q = seq_plock_begin(p, track, step);
+         q != seq_plock_end(p, track, step); q++) {
+      const uint8_t param = SEQ_PLOCK_PARAM(q->key);
+      if (param >= SEQ_PARAM_STEP_FIRST) {
+        continue;
+      }
+      track_buf[n++] = (seq_event_t){ .time = q16_to_time(base, t0),
+                                      .type = SEQ_EV_PLOCK, .track = track,
+                                      .a = param, .value = q->value };
+    }
+  }
+
+  /* Ratchets répartis sur la durée (swinguée) du pas, chacun borné à son
+     intervalle. */
+  const uint64_t spacing = span_q16 / ratchets;
+  uint64_t gate = (uint64_t)length * step_q16 / SEQ_MICRO_DIV;
+  if ((ratchets > 1U) && (gate > spacing)) {
+    gate = spacing;
+  }
+  const uint16_t route = (uint16_t)((cfg->channel & 0x0FU) | ((uint16_t)cfg->dest << 8));
+
+  for (uint32_t r = 0U; r < ratchets; r++) {
+    const uint64_t on = t0 + r * spacing;
+    track_buf[n++] = (seq_event_t){ .time = q16_to_time(base, on),
+                                    .type = SEQ_EV_NOTE_ON, .track = track,
+                                    .a = note, .b = vel, .value = route };
+    track_buf[n++] = (seq_event_t){ .time = q16_to_time(base, on + gate),
+                                    .type = SEQ_EV_NOTE_OFF, .track = track,
+                                    .a = note, .b = 0U, .value = route };
+  }
+  return n;
+}
+
+/* Dépose un lot ; abandonné si le transport a changé entre-temps. */
+static void queue_batch(const seq_event_t *evs, size_t n, uint32_t gen) {
+  bool wake = false;
+
+  osalSysLock();
+  if (eng_running && (gen == eng_gen)) {
+    for (size_t i = 0U; i < n; i++) {
+      wake |= heap_push_i(&evs[i]);
+    }
+    if (wake) {
+      chThdResumeI(&disp_tr, MSG_OK);
+      osalOsRescheduleS();
+    }
+  }
+  osalSysUnlock();
+}
+
+static void render_step(uint8_t step, systime_t base, uint64_t start_q16,
+                        uint64_t step_q16, uint32_t gen) {
+  chMtxLock(&eng_mtx);
+  const seq_pattern_t *p = eng_pattern;
+
+  if (p != NULL) {
+    for (uint8_t t = 0U; t < BRICK_NUM_TRACKS; t++) {
+      if (!seq_trig_get(p, t, step)) {
+        continue;
+      }
+      const size_t n = render_track(p, &eng_tracks[t], t, step, base,
+                                    start_q16, step_q16);
+      queue_batch(track_buf, n, gen);
+    }
+  }
+  chMtxUnlock(&eng_mtx);
+
+  if (eng_clock_dest != MIDI_DEST_NONE) {
+    seq_event_t clk[SEQ_CLOCKS_PER_STEP];
+    for (uint32_t k = 0U; k < SEQ_CLOCKS_PER_STEP; k++) {
+      clk[k] = (seq_event_t){
+        .time = q16_to_time(base, start_q16 + k * step_q16 / SEQ_CLOCKS_PER_STEP),
+        .type = SEQ_EV_CLOCK, .track = SEQ_TRACK_NONE };
+    }
+    queue_batch(clk, SEQ_CLOCKS_PER_STEP, gen);
+  }
+}
+
+static THD_FUNCTION(thdSeqRender, arg) {
+  (void)arg;
+  chRegSetThreadName("seq_render");
+
+  while (true) {
+    osalSysLock();
+    if (!eng_running) {
+      (void)chThdSuspendS(&render_tr);
+      osalSysUnlock();
+      continue;
+    }
+
+    /* Échéance : date du pas moins l’avance (négative au démarrage). */
+    const int64_t due_q16 = (int64_t)eng_next_q16 -
+                            (int64_t)(SEQ_LOOKAHEAD_STEPS * eng_step_q16);
+    const systime_t due = (systime_t)(eng_base + (systime_t)(int32_t)(due_q16 >> 16));
+    const int32_t wait = (int32_t)(due - chVTGetSystemTimeX());
+    if (wait > 0) {
+      (void)chThdSuspendTimeoutS(&render_tr, (sysinterval_t)wait);
+      osalSysUnlock();
+      continue;       /* Échéance atteinte ou transport modifié : on réévalue */
+    }
+
+    const uint8_t step = eng_next_step;
+    const systime_t base = eng_base;
+    const uint64_t start_q16 = eng_next_q16;
+    const uint64_t step_q16 = eng_step_q16;
+    const uint32_t gen = eng_gen;
+    eng_next_q16 += step_q16;
+    eng_next_step = (uint8_t)((step + 1U) % BRICK_STEPS_PER_TRACK);
+    osalSysUnlock();
+
+    render_step(step, base, start_q16, step_q16, gen);
+  }
+}
+
+/* ====================================================================== */
+/*                                DISPATCH                                */
+/* ====================================================================== */
+
+static void dispatch(const seq_event_t *ev) {
+  const midi_dest_t dest = (midi_dest_t)(ev->value >> 8);
+  const uint8_t ch = (uint8_t)(ev->value & 0x0FU);
+  uint8_t *held;
+
+  switch (ev->type) {
+    case SEQ_EV_NOTE_ON:
+      held = &note_held[ev->track][ev->a & 0x7FU];
+      if (*held < 0xFFU) {
+        (*held)++;
+      }
+      if (dest != MIDI_DEST_NONE) {
+        midi_note_on(dest, ch, ev->a, ev->b);
+      }
+      break;
+
+    case SEQ_EV_NOTE_OFF:
+      held = &note_held[ev->track][ev->a & 0x7FU];
+      if ((*held == 0U) || (--(*held) != 0U)) {
+        return;
+      }
+      if (dest != MIDI_DEST_NONE) {
+        midi_note_off(dest, ch, ev->a, 0U);
+      }
+      break;
+
+    case SEQ_EV_START:
+      midi_start(eng_clock_dest);
+      return;
+
+    case SEQ_EV_CLOCK:
+      midi_clock(eng_clock_dest);
+      return;
+
+    default:
+      break;
+  }
+
+  const uint8_t cart = eng_tracks[ev->track].cart;
+  const seq_cart_sink_t sink = eng_cart_sink;
+  if ((cart != SEQ_CART_NONE) && (sink != NULL)) {
+    sink(cart, ev);
+  }
+}
+
+static THD_FUNCTION(thdSeqDispatch, arg) {
+  (void)arg;
+  chRegSetThreadName("seq_dispatch");
+
+  osalSysLock();
+  while (true) {
+    if (ev_n == 0U) {
+      (void)chThdSuspendS(&disp_tr);
+      continue;
+    }
+
+    const int32_t wait = (int32_t)(ev_q[0].time - chVTGetSystemTimeX());
+    if (wait > 0) {
+      (void)chThdSuspendTimeoutS(&disp_tr, (sysinterval_t)wait);
+      continue;       /* Échéance atteinte ou nouvelle tête de file */
+    }
+
+    seq_event_t ev;
+    heap_pop_i(&ev);
+    eng_stats.dispatched++;
+    if (wait < 0) {
+      const uint32_t us = (uint32_t)TIME_I2US((sysinterval_t)(-wait));
+      eng_stats.late++;
+      if (us > eng_stats.late_max_us) {
+        eng_stats.late_max_us = us;
+      }
+    }
+    osalSysUnlock();
+
+    dispatch(&ev);
+
+    osalSysLock();
+  }
+}
+
+/* ====================================================================== */
+/*                                  API                                   */
+/* ====================================================================== */
+
+void seq_engine_init(void) {
+  chMtxObjectInit(&eng_mtx);
+  ev_n = 0U;
+  eng_running = false;
+  eng_pattern = NULL;
+  eng_clock_dest = MIDI_DEST_NONE;
+  eng_cart_sink = NULL;
+  eng_stats = (seq_engine_stats_t){0};
+
+  for (uint8_t t = 0U; t < BRICK_NUM_TRACKS; t++) {
+    eng_tracks[t] = (seq_track_cfg_t){ .dest = MIDI_DEST_BOTH, .channel = t,
+                                       .note = 60U, .velocity = 100U,
+                                       .length = SEQ_MICRO_DIV / 2U,
+                                       .cart = SEQ_CART_NONE };
+  }
+  seq_engine_set_tempo(1200U);
+  seq_engine_set_swing(50U);
+
+  chThdCreateStatic(waSeqDispatch, sizeof(waSeqDispatch),
+                    SEQ_DISPATCH_THREAD_PRIO, thdSeqDispatch, NULL);
+  chThdCreateStatic(waSeqRender, sizeof(waSeqRender),
+                    SEQ_RENDER_THREAD_PRIO, thdSeqRender, NULL);
+}
+
+void seq_engine_set_pattern(const seq_pattern_t *p) {
+  chMtxLock(&eng_mtx);
+  eng_pattern = p;
+  chMtxUnlock(&eng_mtx);
+}
+
+void seq_engine_set_track(uint8_t track, const seq_track_cfg_t *cfg) {
+  if ((track >= BRICK_NUM_TRACKS) || (cfg == NULL)) {
+    return;
+  }
+  chMtxLock(&eng_mtx);
+  eng_tracks[track] = *cfg;
+  chMtxUnlock(&eng_mtx);
+}
+
+void seq_engine_set_tempo(uint16_t bpm_x10) {
+  if (bpm_x10 < 300U) {
+    bpm_x10 = 300U;
+  } else if (bpm_x10 > 3000U) {
+    bpm_x10 = 3000U;
+  }
+
+  /* Pas = double croche : 60 s × 10 / (BPM × 10 × 4). */
+  const uint64_t step_q16 = ((uint64_t)CH_CFG_ST_FREQUENCY * 600U << 16) /
+                            ((uint64_t)bpm_x10 * 4U);
+  osalSysLock();
+  eng_step_q16 = step_q16;
+  osalSysUnlock();
+}
+
+void seq_engine_set_swing(uint8_t percent) {
+  if (percent < 50U) {
+    percent = 50U;
+  } else if (percent > 80U) {
+    percent = 80U;
+  }
+  __atomic_store_n(&eng_swing, percent, __ATOMIC_RELAXED);
+}
+
+void seq_engine_set_clock_dest(midi_dest_t dest) {
+  eng_clock_dest = dest;
+}
+
+void seq_engine_set_cart_sink(seq_cart_sink_t sink) {
+  __atomic_store_n(&eng_cart_sink, sink, __ATOMIC_RELEASE);
+}
+
+void seq_engine_start(void) {
+  osalSysLock();
+  eng_gen++;
+  heap_purge_i();
+  eng_base = (systime_t)(chVTGetSystemTimeX() +
+                         (systime_t)((SEQ_LOOKAHEAD_STEPS * eng_step_q16) >> 16));
+  eng_next_q16 = 0U;
+  eng_next_step = 0U;
+  eng_running = true;
+
+  if (eng_clock_dest != MIDI_DEST_NONE) {
+    const seq_event_t start = { .time = eng_base, .type = SEQ_EV_START,
+                                .track = SEQ_TRACK_NONE };
+    if (heap_push_i(&start)) {
+      chThdResumeI(&disp_tr, MSG_OK);
+    }
+  }
+  chThdResumeI(&render_tr, MSG_RESET);
+  osalOsRescheduleS();
+  osalSysUnlock();
+}
+
+void seq_engine_stop(void) {
+  osalSysLock();
+  eng_gen++;
+  eng_running = false;
+  heap_purge_i();
+
+  chThdResumeI(&disp_tr, MSG_OK);
+  chThdResumeI(&render_tr, MSG_RESET);
+  osalOsRescheduleS();
+  osalSysUnlock();
+
+  if (eng_clock_dest != MIDI_DEST_NONE) {
+    midi_stop(eng_clock_dest);
+  }
+}
+
+bool seq_engine_is_running(void) {
+  return __atomic_load_n(&eng_running, __ATOMIC_RELAXED);
+}
+
+void seq_engine_lock(void) {
+  chMtxLock(&eng_mtx);
+}
+
+void seq_engine_unlock(void) {
+  chMtxUnlock(&eng_mtx);
+}
+
+void seq_engine_get_stats(seq_engine_stats_t *stats) {
+  osalSysLock();
+  *stats = eng_stats;
+  osalSysUnlock();
+}
+
+void seq_engine_stats_reset(void) {
+  osalSysLock();
+  eng_stats = (seq_engine_stats_t){0};
+  osalSysUnlock();
+}
@@ -0,0 +1,195 @@
+/**
+ * @file seq_engine.h
+ * @brief Moteur de lecture du séquenceur : rendu en avance + dispatch horodaté.
+ *
+ * Deux threads, séparés pour que l’émission ne dépende pas du coût du rendu :
+ * - **rendu** : @ref SEQ_LOOKAHEAD_STEPS pas avant leur heure, chaque pas du
+ *   pattern est traduit en événements horodatés (note on/off, p-locks,
+ *   clock MIDI) avec swing, micro-timing, longueur et ratchets, puis déposé
+ *   dans une file triée par date ;
+ * - **dispatch** (priorité haute) : dort jusqu’à la date du premier
+ *   événement (timer virtuel, échéance absolue) et le remet à `midi_*` et
+ *   au bus cartouches à son tick exact.
+ *
+ * Les dates sont en ticks système (`systime_t`, résolution
+ * 1 / CH_CFG_ST_FREQUENCY). La grille des pas est tenue en ticks Q16 depuis
+ * le départ : pas de dérive, même pour des durées de pas non entières, et un
+ * changement de tempo s’applique aux pas pas encore rendus.
+ *
+ * Paramètres de pas : les derniers indices de p-lock (@ref SEQ_PARAM_NOTE …)
+ * règlent la note jouée ; les autres sont des p-locks de son, envoyés tels
+ * quels à la cartouche de la piste.
+ *
+ * Contexte d’appel : API depuis un thread. Les éditions du pattern en cours
+ * de lecture se font entre `seq_engine_lock()` et `seq_engine_unlock()`.
+ *
+ * @ingroup seq
+ */
+
+#ifndef SEQ_ENGINE_H
+#define SEQ_ENGINE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "ch.h"
+#include "midi.h"
+#include "seq_pattern.h"
+
+/* ====================================================================== */
+/*                             CONFIGURATION                              */
+/* ====================================================================== */
+
+/** @brief Pas rendus en avance (le micro-timing négatif exige au moins 2). */
+#ifndef SEQ_LOOKAHEAD_STEPS
+#define SEQ_LOOKAHEAD_STEPS     2U
+#endif
+
+/** @brief Capacité de la file d’événements (16 pistes × ratchets × avance). */
+#ifndef SEQ_EVENT_QUEUE_LEN
+#define SEQ_EVENT_QUEUE_LEN     1024U
+#endif
+
+/** @brief Subdivisions d’un pas pour le micro-timing et la longueur. */
+#ifndef SEQ_MICRO_DIV
+#define SEQ_MICRO_DIV           24U
+#endif
+
+/** @brief Nombre maximal de ratchets (répétitions dans un pas). */
+#ifndef SEQ_MAX_RATCHETS
+#define SEQ_MAX_RATCHETS        8U
+#endif
+
+/** @brief Priorité du thread de dispatch. */
+#ifndef SEQ_DISPATCH_THREAD_PRIO
+#define SEQ_DISPATCH_THREAD_PRIO  (NORMALPRIO + 10)
+#endif
+
+/** @brief Priorité du thread de rendu. */
+#ifndef SEQ_RENDER_THREAD_PRIO
+#define SEQ_RENDER_THREAD_PRIO    (NORMALPRIO + 3)
+#endif
+
+/* ====================================================================== */
+/*                          PARAMÈTRES DE PAS                             */
+/* ====================================================================== */
+
+/** @brief Note MIDI du pas (0–127). */
+#define SEQ_PARAM_NOTE          (BRICK_MAX_PLOCKS_PER_STEP - 1U)
+/** @brief Vélocité du pas (1–127). */
+#define SEQ_PARAM_VELOCITY      (BRICK_MAX_PLOCKS_PER_STEP - 2U)
+/** @brief Longueur de note en 1/@ref SEQ_MICRO_DIV de pas (≥ 1). */
+#define SEQ_PARAM_LENGTH        (BRICK_MAX_PLOCKS_PER_STEP - 3U)
+/** @brief Décalage en 1/@ref SEQ_MICRO_DIV de pas (int16, ± (DIV − 1)). */
+#define SEQ_PARAM_MICRO         (BRICK_MAX_PLOCKS_PER_STEP - 4U)
+/** @brief Nombre de notes réparties dans le pas (1–@ref SEQ_MAX_RATCHETS). */
+#define SEQ_PARAM_RATCHET       (BRICK_MAX_PLOCKS_PER_STEP - 5U)
+/** @brief Premier paramètre de pas ; en dessous : p-locks de son. */
+#define SEQ_PARAM_STEP_FIRST    SEQ_PARAM_RATCHET
+
+/* ====================================================================== */
+/*                                 TYPES                                  */
+/* ====================================================================== */
+
+/** @brief Type d’événement ; à date égale, l’ordre d’émission est celui-ci. */
+typedef enum {
+  SEQ_EV_NOTE_OFF = 0,
+  SEQ_EV_START,
+  SEQ_EV_CLOCK,
+  SEQ_EV_PLOCK,
+  SEQ_EV_NOTE_ON
+} seq_event_type_t;
+
+/**
+ * @struct seq_event_t
+ * @brief Événement horodaté de la file.
+ */
+typedef struct {
+  systime_t time;       /**< Tick d’émission */
+  uint8_t   type;       /**< @ref seq_event_type_t */
+  uint8_t   track;      /**< Piste source */
+  uint8_t   a;          /**< Note (NOTE_*) ou paramètre (PLOCK) */
+  uint8_t   b;          /**< Vélocité (NOTE_*) */
+  uint16_t  value;      /**< Valeur (PLOCK) ; canal | sortie << 8 (NOTE_*) */
+} seq_event_t;
+
+/**
+ * @brief Sortie cartouche : reçoit notes et p-locks de son des pistes
+ *        associées, depuis le thread de dispatch (court, non bloquant).
+ */
+typedef void (*seq_cart_sink_t)(uint8_t cart, const seq_event_t *ev);
+
+/** @brief Pas de cartouche associée à la piste. */
+#define SEQ_CART_NONE           0xFFU
+
+/**
+ * @struct seq_track_cfg_t
+ * @brief Réglages de sortie d’une piste (valeurs par défaut des pas).
+ */
+typedef struct {
+  midi_dest_t dest;     /**< Sortie MIDI des notes (MIDI_DEST_NONE possible) */
+  uint8_t channel;      /**< Canal MIDI [0–15] */
+  uint8_t note;         /**< Note par défaut */
+  uint8_t velocity;     /**< Vélocité par défaut */
+  uint8_t length;       /**< Longueur par défaut, 1/@ref SEQ_MICRO_DIV de pas */
+  uint8_t cart;         /**< Cartouche destinataire ou @ref SEQ_CART_NONE */
+} seq_track_cfg_t;
+
+/**
+ * @struct seq_engine_stats_t
+ * @brief Statistiques de lecture.
+ */
+typedef struct {
+  uint32_t dispatched;      /**< Événements émis */
+  uint32_t late;            /**< Événements émis après leur tick */
+  uint32_t late_max_us;     /**< Retard maximal (µs, résolution d’un tick) */
+  uint32_t queue_drops;     /**< Événements perdus (file pleine) */
+  uint16_t queue_peak;      /**< Remplissage maximal de la file */
+} seq_engine_stats_t;
+
+/* ====================================================================== */
+/*                                  API                                   */
+/* ====================================================================== */
+
+/** @brief Crée les threads (transport à l’arrêt, 120 BPM, sans swing). */
+void seq_engine_init(void);
+
+/** @brief Pattern lu (NULL : silence). Pris en compte au prochain pas rendu. */
+void seq_engine_set_pattern(const seq_pattern_t *p);
+
+/** @brief Réglages d’une piste. */
+void seq_engine_set_track(uint8_t track, const seq_track_cfg_t *cfg);
+
+/** @brief Tempo en dixièmes de BPM (300–3000). */
+void seq_engine_set_tempo(uint16_t bpm_x10);
+
+/** @brief Swing des pas impairs en % (50 = droit, 80 max). */
+void seq_engine_set_swing(uint8_t percent);
+
+/** @brief Sortie de la clock MIDI (24 ppqn) et de Start/Stop. */
+void seq_engine_set_clock_dest(midi_dest_t dest);
+
+/** @brief Sortie vers les cartouches (NULL : aucune). */
+void seq_engine_set_cart_sink(seq_cart_sink_t sink);
+
+/**
+ * @brief Démarre au pas 0, @ref SEQ_LOOKAHEAD_STEPS pas après l’appel.
+ * @details Relance possible en cours de lecture : les événements déjà en file
+ *          sont abandonnés, sauf les NOTE OFF émis immédiatement.
+ */
+void seq_engine_start(void);
+
+/** @brief Arrête : seuls les NOTE OFF en attente sont émis, immédiatement. */
+void seq_engine_stop(void);
+
+bool seq_engine_is_running(void);
+
+/** @brief Protège le pattern lu contre le rendu pendant une édition. */
+void seq_engine_lock(void);
+void seq_engine_unlock(void);
+
+/** @brief Copie des statistiques. */
+void seq_engine_get_stats(seq_engine_stats_t *stats);
+void seq_engine_stats_reset(void);
+
+#endif /* SEQ_ENGINE_H */
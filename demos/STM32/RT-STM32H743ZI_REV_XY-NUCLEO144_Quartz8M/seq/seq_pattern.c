@@ -0,0 +1,330 @@
+/**
+ * @file seq_pattern.c
+ * @brief Pattern creux : pool de p-locks trié + index par (piste, pas).
+ *
+ * Invariants :
+ * - `plocks[0 .. plock_count[` est strictement croissant par clé ;
+ * - les p-locks de (piste, pas) = i sont `plocks[step_start[i] .. step_start[i + 1][`.
+ *
+ * @ingroup seq
+ */
+
+#include <string.h>
+#include "seq_pattern.h"
+
+BRICK_STATIC_ASSERT(BRICK_NUM_TRACKS <= 16, seq_key_track_bits);
+/* (clé >> 6) == index (piste, pas) : 64 pas exactement. */
+BRICK_STATIC_ASSERT(BRICK_STEPS_PER_TRACK == 64, seq_key_step_bits);
+BRICK_STATIC_ASSERT(BRICK_MAX_PLOCKS_PER_STEP <= 64, seq_key_param_bits);
+BRICK_STATIC_ASSERT((BRICK_STEPS_PER_TRACK % SEQ_STEPS_PER_PAGE) == 0, seq_page_size);
+BRICK_STATIC_ASSERT(SEQ_STEPS_PER_PAGE <= 16, seq_clip_trig_bits);
+BRICK_STATIC_ASSERT(SEQ_PLOCK_POOL <= 0xFFFF, seq_pool_index_bits);
+
+#define SEQ_PATTERN_MAGIC     0x31545042U   /* "BPT1" */
+#define SEQ_PATTERN_VERSION   1U
+
+/* Tampon de fusion du collage (un seul éditeur, pas de pile DTCM). */
+static seq_plock_t merge_buf[SEQ_PLOCK_POOL];
+
+static inline uint16_t step_index(uint8_t track, uint8_t step) {
+  return (uint16_t)(track * BRICK_STEPS_PER_TRACK + step);
+}
+
+static inline bool step_valid(uint8_t track, uint8_t step) {
+  return (track < BRICK_NUM_TRACKS) && (step < BRICK_STEPS_PER_TRACK);
+}
+
+/* Recalcule step_start[] à partir du pool trié, O(n + pistes × pas). */
+static void rebuild_index(seq_pattern_t *p) {
+  uint16_t i = 0U;
+
+  for (uint16_t s = 0U; s < SEQ_TRACK_STEPS; s++) {
+    p->step_start[s] = i;
+    while ((i < p->plock_count) && ((p->plocks[i].key >> 6) == s)) {
+      i++;
+    }
+  }
+  p->step_start[SEQ_TRACK_STEPS] = p->plock_count;
+}
+
+/* Décale les débuts des pas suivant @p s (insertion : +1, retrait : -1). */
+static void shift_index(seq_pattern_t *p, uint16_t s, int delta) {
+  for (uint16_t i = (uint16_t)(s + 1U); i <= SEQ_TRACK_STEPS; i++) {
+    p->step_start[i] = (uint16_t)(p->step_start[i] + delta);
+  }
+}
+
+/* Position de @p param dans le pas @p s : trouvé (true) ou point d’insertion. */
+static bool find_param(const seq_pattern_t *p, uint16_t s, uint8_t param,
+                       uint16_t *pos) {
+  const uint16_t key = (uint16_t)((s << 6) | param);
+  uint16_t lo = p->step_start[s];
+  uint16_t hi = p->step_start[s + 1U];
+
+  while (lo < hi) {
+    const uint16_t mid = (uint16_t)((lo + hi) / 2U);
+    if (p->plocks[mid].key < key) {
+      lo = (uint16_t)(mid + 1U);
+    } else {
+      hi = mid;
+    }
+  }
+  *pos = lo;
+  return (lo < p->step_start[s + 1U]) && (p->plocks[lo].key == key);
+}
+
+/* ====================================================================== */
+/*                            TRIGS / P-LOCKS                             */
+/* ====================================================================== */
+
+void seq_pattern_init(seq_pattern_t *p) {
+  memset(p->trigs, 0, sizeof(p->trigs));
+  p->plock_count = 0U;
+  memset(p->step_start, 0, sizeof(p->step_start));
+}
+
+void seq_trig_set(seq_pattern_t *p, uint8_t track, uint8_t step, bool on) {
+  if (!step_valid(track, step)) {
+    return;
+  }
+  if (on) {
+    p->trigs[track] |= (uint64_t)1U << step;
+  } else {
+    p->trigs[track] &= ~((uint64_t)1U << step);
+  }
+}
+
+bool seq_plock_set(seq_pattern_t *p, uint8_t track, uint8_t step,
+                   uint8_t param, uint16_t value) {
+  if (!step_valid(track, step) || (param >= BRICK_MAX_PLOCKS_PER_STEP)) {
+    return false;
+  }
+
+  const uint16_t s = step_index(track, step);
+  uint16_t pos;
+
+  if (find_param(p, s, param, &pos)) {
+    p->plocks[pos].value = value;
+    return true;
+  }
+  if (p->plock_count >= SEQ_PLOCK_POOL) {
+    return false;
+  }
+
+  memmove(&p->plocks[pos + 1U], &p->plocks[pos],
+          (size_t)(p->plock_count - pos) * sizeof(seq_plock_t));
+  p->plocks[pos].key = SEQ_PLOCK_KEY(track, step, param);
+  p->plocks[pos].value = value;
+  p->plock_count++;
+  shift_index(p, s, +1);
+  return true;
+}
+
+bool seq_plock_get(const seq_pattern_t *p, uint8_t track, uint8_t step,
+                   uint8_t param, uint16_t *value) {
+  uint16_t pos;
+
+  if (!step_valid(track, step) || (param >= BRICK_MAX_PLOCKS_PER_STEP) ||
+      !find_param(p, step_index(track, step), param, &pos)) {
+    return false;
+  }
+  *value = p->plocks[pos].value;
+  return true;
+}
+
+bool seq_plock_clear(seq_pattern_t *p, uint8_t track, uint8_t step, uint8_t param) {
+  uint16_t pos;
+
+  if (!step_valid(track, step) || (param >= BRICK_MAX_PLOCKS_PER_STEP)) {
+    return false;
+  }
+
+  const uint16_t s = step_index(track, step);
+  if (!find_param(p, s, param, &pos)) {
+    return false;
+  }
+
+  memmove(&p->plocks[pos], &p->plocks[pos + 1U],
+          (size_t)(p->plock_count - pos - 1U) * sizeof(seq_plock_t));
+  p->plock_count--;
+  shift_index(p, s, -1);
+  return true;
+}
+
+void seq_plock_clear_step(seq_pattern_t *p, uint8_t track, uint8_t step) {
+  if (!step_valid(track, step)) {
+    return;
+  }
+
+  const uint16_t s = step_index(track, step);
+  const uint16_t a = p->step_start[s];
+  const uint16_t n = (uint16_t)(p->step_start[s + 1U] - a);
+  if (n == 0U) {
+    return;
+  }
+
+  memmove(&p->plocks[a], &p->plocks[a + n],
+          (size_t)(p->plock_count - a - n) * sizeof(seq_plock_t));
+  p->plock_count = (uint16_t)(p->plock_count - n);
+  shift_index(p, s, -(int)n);
+}
+
+/* ====================================================================== */
+/*                             PAGES                                      */
+/* ====================================================================== */
+
+void seq_page_copy(const seq_pattern_t *p, uint8_t page, seq_page_clip_t *clip) {
+  const uint8_t s0 = (uint8_t)(page * SEQ_STEPS_PER_PAGE);
+
+  clip->plock_count = 0U;
+  if (page >= SEQ_PAGES) {
+    memset(clip->trigs, 0, sizeof(clip->trigs));
+    return;
+  }
+
+  for (uint8_t t = 0U; t < BRICK_NUM_TRACKS; t++) {
+    clip->trigs[t] = (uint16_t)((p->trigs[t] >> s0) &
+                                ((1UL << SEQ_STEPS_PER_PAGE) - 1U));
+
+    const uint16_t a = p->step_start[step_index(t, s0)];
+    const uint16_t b = p->step_start[step_index(t, s0) + SEQ_STEPS_PER_PAGE];
+    for (uint16_t i = a; (i < b) && (clip->plock_count < SEQ_CLIP_PLOCKS); i++) {
+      const uint16_t key = p->plocks[i].key;
+      const uint8_t step = (uint8_t)(((key >> 6) & 0x3FU) - s0);
+      clip->plocks[clip->plock_count].key = SEQ_PLOCK_KEY(t, step, SEQ_PLOCK_PARAM(key));
+      clip->plocks[clip->plock_count].value = p->plocks[i].value;
+      clip->plock_count++;
+    }
+  }
+}
+
+bool seq_page_paste(seq_pattern_t *p, uint8_t page, const seq_page_clip_t *clip) {
+  if (page >= SEQ_PAGES) {
+    return false;
+  }
+
+  const uint8_t s0 = (uint8_t)(page * SEQ_STEPS_PER_PAGE);
+  uint16_t in_page = 0U;
+
+  for (uint8_t t = 0U; t < BRICK_NUM_TRACKS; t++) {
+    const uint16_t s = step_index(t, s0);
+    in_page = (uint16_t)(in_page + p->step_start[s + SEQ_STEPS_PER_PAGE] -
+                         p->step_start[s]);
+  }
+  if ((uint32_t)p->plock_count - in_page + clip->plock_count > SEQ_PLOCK_POOL) {
+    return false;
+  }
+
+  /* Fusion de deux suites triées : pool hors page + presse-papiers décalé. */
+  uint16_t i = 0U, j = 0U, n = 0U;
+  while ((i < p->plock_count) || (j < clip->plock_count)) {
+    if (i < p->plock_count) {
+      const uint16_t key = p->plocks[i].key;
+      const uint8_t step = (uint8_t)((key >> 6) & 0x3FU);
+      if ((step >= s0) && (step < s0 + SEQ_STEPS_PER_PAGE)) {
+        i++;      /* remplacé par la page collée */
+        continue;
+      }
+    }
+
+    seq_plock_t c = { 0U, 0U };
+    if (j < clip->plock_count) {
+      const uint16_t ck = clip->plocks[j].key;
+      c.key = (uint16_t)(ck + ((uint16_t)s0 << 6));
+      c.value = clip->plocks[j].value;
+    }
+
+    if ((j >= clip->plock_count) ||
+        ((i < p->plock_count) && (p->plocks[i].key < c.key))) {
+      merge_buf[n++] = p->plocks[i++];
+    } else {
+      merge_buf[n++] = c;
+      j++;
+    }
+  }
+
+  memcpy(p->plocks, merge_buf, (size_t)n * sizeof(seq_plock_t));
+  p->plock_count = n;
+  rebuild_index(p);
+
+  const uint64_t mask = ((uint64_t)((1UL << SEQ_STEPS_PER_PAGE) - 1U)) << s0;
+  for (uint8_t t = 0U; t < BRICK_NUM_TRACKS; t++) {
+    p->trigs[t] = (p->trigs[t] & ~mask) | ((uint64_t)clip->trigs[t] << s0);
+  }
+  return true;
+}
+
+/* ====================================================================== */
+/*                            SÉRIALISATION                               */
+/* ====================================================================== */
+
+/*
+ * Mot 0           : SEQ_PATTERN_MAGIC
+ * Mot 1           : version << 16 | nombre de p-locks
+ * Mots 2 ..       : trigs, 2 mots par piste (bits 0–31 puis 32–63)
+ * Mots suivants   : une entrée par mot, clé << 16 | valeur, clés croissantes
+ */
+
+size_t seq_pattern_serialized_words(const uint32_t *hdr) {
+  if ((hdr[0] != SEQ_PATTERN_MAGIC) || ((hdr[1] >> 16) != SEQ_PATTERN_VERSION)) {
+    return 0U;
+  }
+
+  const uint32_t count = hdr[1] & 0xFFFFU;
+  if (count > SEQ_PLOCK_POOL) {
+    return 0U;
+  }
+  return SEQ_PATTERN_HDR_WORDS + 2U * BRICK_NUM_TRACKS + count;
+}
+
+size_t seq_pattern_serialize(const seq_pattern_t *p, uint32_t *out, size_t max_words) {
+  const size_t words = SEQ_PATTERN_HDR_WORDS + 2U * BRICK_NUM_TRACKS + p->plock_count;
+  if (words > max_words) {
+    return 0U;
+  }
+
+  size_t w = 0U;
+  out[w++] = SEQ_PATTERN_MAGIC;
+  out[w++] = (SEQ_PATTERN_VERSION << 16) | p->plock_count;
+  for (uint8_t t = 0U; t < BRICK_NUM_TRACKS; t++) {
+    out[w++] = (uint32_t)p->trigs[t];
+    out[w++] = (uint32_t)(p->trigs[t] >> 32);
+  }
+  for (uint16_t i = 0U; i < p->plock_count; i++) {
+    out[w++] = ((uint32_t)p->plocks[i].key << 16) | p->plocks[i].value;
+  }
+  return w;
+}
+
+bool seq_pattern_deserialize(seq_pattern_t *p, const uint32_t *in, size_t words) {
+  seq_pattern_init(p);
+
+  if ((words < SEQ_PATTERN_HDR_WORDS) ||
+      (seq_pattern_serialized_words(in) == 0U) ||
+      (seq_pattern_serialized_words(in) > words)) {
+    return false;
+  }
+
+  const uint16_t count = (uint16_t)(in[1] & 0xFFFFU);
+  const uint32_t *e = &in[SEQ_PATTERN_HDR_WORDS + 2U * BRICK_NUM_TRACKS];
+
+  for (uint16_t i = 0U; i < count; i++) {
+    const uint16_t key = (uint16_t)(e[i] >> 16);
+    if (((key >> 6) >= SEQ_TRACK_STEPS) ||
+        (SEQ_PLOCK_PARAM(key) >= BRICK_MAX_PLOCKS_PER_STEP) ||
+        ((i > 0U) && (key <= p->plocks[i - 1U].key))) {
+      seq_pattern_init(p);
+      return false;
+    }
+    p->plocks[i].key = key;
+    p->plocks[i].value = (uint16_t)e[i];
+  }
+  p->plock_count = count;
+
+  for (uint8_t t = 0U; t < BRICK_NUM_TRACKS; t++) {
+    p->trigs[t] = (uint64_t)in[SEQ_PATTERN_HDR_WORDS + 2U * t] |
+                  ((uint64_t)in[SEQ_PATTERN_HDR_WORDS + 2U * t + 1U] << 32);
+  }
+  rebuild_index(p);
+  return true;
+}
@@ -0,0 +1,170 @@
+/**
+ * @file seq_pattern.h
+ * @brief Pattern du séquenceur : trigs en bitmaps, p-locks creux et triés.
+ *
+ * Une table dense pistes × pas × paramètres coûterait
+ * 16 × 64 × 64 × 2 = 128 Ko par pattern pour quelques dizaines de p-locks
+ * réellement posés. Ici :
+ * - **trigs** : un mot de 64 bits par piste (bit n = trig sur le pas n) ;
+ * - **p-locks** : un pool d’entrées { clé, valeur } trié par clé
+ *   (piste, pas, paramètre), borné par @ref SEQ_PLOCK_POOL ;
+ * - **index** : début de chaque (piste, pas) dans le pool, ce qui donne les
+ *   p-locks d’un pas en O(1) et leur parcours par simple incrément.
+ *
+ * Les éditions (pose, effacement, collage de page) sont en O(n) sur le pool,
+ * au rythme de l’UI ; la lecture par le séquenceur ne fait que de l’O(1).
+ *
+ * La forme sérialisée (mots de 32 bits : en-tête, trigs, entrées) ne garde
+ * pas l’index, reconstruit au chargement : c’est elle qui est stockée en
+ * SDRAM (`seq_bank.h`) ou en flash.
+ *
+ * Contexte d’appel : un seul thread modifie un pattern donné.
+ *
+ * @ingroup seq
+ */
+
+#ifndef SEQ_PATTERN_H
+#define SEQ_PATTERN_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "brick_config.h"
+
+/* ====================================================================== */
+/*                             CONFIGURATION                              */
+/* ====================================================================== */
+
+/** @brief Nombre maximal de p-locks par pattern (toutes pistes confondues). */
+#ifndef SEQ_PLOCK_POOL
+#define SEQ_PLOCK_POOL          1024U
+#endif
+
+/** @brief Pas par page (copier/coller de page). */
+#ifndef SEQ_STEPS_PER_PAGE
+#define SEQ_STEPS_PER_PAGE      16U
+#endif
+
+/** @brief P-locks maximum d’une page dans le presse-papiers. */
+#ifndef SEQ_CLIP_PLOCKS
+#define SEQ_CLIP_PLOCKS         SEQ_PLOCK_POOL
+#endif
+
+#define SEQ_PAGES               (BRICK_STEPS_PER_TRACK / SEQ_STEPS_PER_PAGE)
+#define SEQ_TRACK_STEPS         (BRICK_NUM_TRACKS * BRICK_STEPS_PER_TRACK)
+
+/** @brief Taille maximale de la forme sérialisée, en mots de 32 bits. */
+#define SEQ_PATTERN_HDR_WORDS   2U
+#define SEQ_PATTERN_MAX_WORDS   (SEQ_PATTERN_HDR_WORDS + 2U * BRICK_NUM_TRACKS + \
+                                 SEQ_PLOCK_POOL)
+
+/* ====================================================================== */
+/*                                 TYPES                                  */
+/* ====================================================================== */
+
+/**
+ * @brief Clé d’un p-lock : piste (4 bits), pas (6 bits), paramètre (6 bits).
+ * @details L’ordre des clés est l’ordre (piste, pas, paramètre).
+ */
+#define SEQ_PLOCK_KEY(track, step, param) \
+  ((uint16_t)(((uint16_t)(track) << 12) | ((uint16_t)(step) << 6) | (uint16_t)(param)))
+#define SEQ_PLOCK_PARAM(key)    ((uint8_t)((key) & 0x3FU))
+
+/** @brief Entrée du pool de p-locks. */
+typedef struct {
+  uint16_t key;       /**< @ref SEQ_PLOCK_KEY */
+  uint16_t value;     /**< Valeur verrouillée */
+} seq_plock_t;
+
+/**
+ * @struct seq_pattern_t
+ * @brief Pattern de travail (RAM interne).
+ */
+typedef struct {
+  uint64_t    trigs[BRICK_NUM_TRACKS];
+  uint16_t    plock_count;
+  /** Début des p-locks de chaque (piste, pas) ; step_start[SEQ_TRACK_STEPS] = count. */
+  uint16_t    step_start[SEQ_TRACK_STEPS + 1U];
+  seq_plock_t plocks[SEQ_PLOCK_POOL];
+} seq_pattern_t;
+
+/**
+ * @struct seq_page_clip_t
+ * @brief Presse-papiers d’une page (toutes les pistes).
+ */
+typedef struct {
+  uint16_t    trigs[BRICK_NUM_TRACKS];   /**< bit n = pas n de la page */
+  uint16_t    plock_count;
+  seq_plock_t plocks[SEQ_CLIP_PLOCKS];   /**< Pas relatifs à la page */
+} seq_page_clip_t;
+
+/* ====================================================================== */
+/*                                  API                                   */
+/* ====================================================================== */
+
+/** @brief Pattern vide (aucun trig, aucun p-lock). */
+void seq_pattern_init(seq_pattern_t *p);
+
+static inline bool seq_trig_get(const seq_pattern_t *p, uint8_t track, uint8_t step) {
+  return ((p->trigs[track] >> step) & 1U) != 0U;
+}
+
+void seq_trig_set(seq_pattern_t *p, uint8_t track, uint8_t step, bool on);
+
+/**
+ * @brief Pose (ou remplace) un p-lock.
+ * @return false si les arguments sont hors bornes ou le pool plein.
+ */
+bool seq_plock_set(seq_pattern_t *p, uint8_t track, uint8_t step,
+                   uint8_t param, uint16_t value);
+
+/** @brief Lit un p-lock ; false s’il n’existe pas. */
+bool seq_plock_get(const seq_pattern_t *p, uint8_t track, uint8_t step,
+                   uint8_t param, uint16_t *value);
+
+/** @brief Efface un p-lock ; false s’il n’existait pas. */
+bool seq_plock_clear(seq_pattern_t *p, uint8_t track, uint8_t step, uint8_t param);
+
+/** @brief Efface tous les p-locks d’un pas. */
+void seq_plock_clear_step(seq_pattern_t *p, uint8_t track, uint8_t step);
+
+/**
+ * @brief Premier p-lock d’un pas (paramètres croissants), O(1).
+ * @details Parcours : `for (q = seq_plock_begin(..); q != seq_plock_end(..); q++)`.
+ */
+static inline const seq_plock_t *seq_plock_begin(const seq_pattern_t *p,
+                                                 uint8_t track, uint8_t step) {
+  return &p->plocks[p->step_start[track * BRICK_STEPS_PER_TRACK + step]];
+}
+
+static inline const seq_plock_t *seq_plock_end(const seq_pattern_t *p,
+                                               uint8_t track, uint8_t step) {
+  return &p->plocks[p->step_start[track * BRICK_STEPS_PER_TRACK + step + 1U]];
+}
+
+/** @brief Copie une page (trigs + p-locks de toutes les pistes). */
+void seq_page_copy(const seq_pattern_t *p, uint8_t page, seq_page_clip_t *clip);
+
+/**
+ * @brief Remplace une page par le presse-papiers.
+ * @return false si le pool déborderait (pattern inchangé).
+ */
+bool seq_page_paste(seq_pattern_t *p, uint8_t page, const seq_page_clip_t *clip);
+
+/**
+ * @brief Forme compacte : en-tête, trigs, puis une entrée par mot.
+ * @return Nombre de mots écrits, 0 si @p max_words est insuffisant.
+ */
+size_t seq_pattern_serialize(const seq_pattern_t *p, uint32_t *out, size_t max_words);
+
+/** @brief Nombre de mots de la forme sérialisée (lu dans l’en-tête), 0 si invalide. */
+size_t seq_pattern_serialized_words(const uint32_t *hdr);
+
+/**
+ * @brief Recharge un pattern et reconstruit l’index.
+ * @return false si les données sont invalides (pattern laissé vide).
+ */
+bool seq_pattern_deserialize(seq_pattern_t *p, const uint32_t *in, size_t words);
+
+#endif /* SEQ_PATTERN_H */
@@ -0,0 +1,1987 @@
+/*
+ * Simulateur hôte de la pile d’affichage et du séquenceur (RT-Posix-Simulator).
+ *
+ * drv_display.c, les polices, ui_widget.c, midi.c et seq/ sont compilés tels
+ * quels avec -DSIMULATOR ; le SPI est remplacé par le SSD130x émulé
+ * (ssd130x_sim.c), la sortie DIN par un journal horodaté et l’EP IN USB par
+ * une capture de paquets (midi_sim.c).
+ * Pour chaque écran de référence :
+ *   - temps de rendu moyen (µs, horloge hôte) sur SIM_RENDER_LOOPS passes,
+ *     et pour le texte celui de l'ancien chemin pixel à pixel, dont l'image
+ *     doit être identique,
+ *   - trafic SPI de l’image publiée (octets commande/données, transferts),
+ *   - vérification que la GDDRAM émulée est identique à l’image publiée,
+ *   - export <out>/<écran>.pgm et .png ; si un dossier de référence est
+ *     donné, comparaison octet à octet avec <ref>/<écran>.pgm.
+ * Puis primitives à spans (rectangles, lignes, inversion, bitmaps) face aux
+ * boucles pixel à pixel d'origine, coordonnées aléatoires et découpées :
+ * framebuffers entiers identiques.
+ * Puis le séquenceur joue 16 pistes chargées à 300 BPM : gigue des NOTE ON
+ * face aux dates musicales idéales, notes perdues ou orphelines, et relance
+ * en cours de lecture. Puis patterns (seq_pattern, seq_bank) face à une
+ * table dense : éditions, copier/coller de page, index par pas, forme BPT1
+ * aller-retour et rejet, emplacements SDRAM remplacés sans toucher aux
+ * voisins.
+ * Puis stress USB-MIDI : plusieurs threads, paquets capturés sur l’EP IN,
+ * suite de chaque canal intacte et dans l’ordre.
+ * Puis coût du mixage audio (4 cartouches × 4 canaux) en cycles hôte par
+ * trame, version C portable des noyaux.
+ * Puis filtres de lissage par lot (brick_filter) : équivalence de la
+ * moyenne mobile avec brick_asc_process(), EMA et médiane face à une
+ * référence, cycles hôte par scan de 16 canaux.
+ * Puis moteur de scan Hall (hall_scan) alimenté par des demi-buffers DMA
+ * simulés : séquences d'établissement ignorées, moyenne, avance du mux,
+ * publication d'une trame toutes les 8 positions, coût du callback.
+ * Puis vélocité par temps de vol (hall_velocity) : frappes rejouées à
+ * plusieurs durées, dispersion face à l'ancienne dérivée à 16 ms,
+ * ré-armement après un relâchement partiel.
+ * Puis calibration persistée (brick_cal_store) sur la flash interne émulée
+ * en RAM : restauration après « redémarrage », écritures incrémentales,
+ * compactage MFS, mot flash jamais reprogrammé. Suivi du repos des touches
+ * Hall (brick_cal_rest) sous dérive thermique simulée, face à des seuils
+ * fixes.
+ * Puis cœur des entrées (drv_input) : anti-rebond face à un compteur par
+ * bouton sous rebonds aléatoires, quadrature, ordre de la chaîne 74HC165.
+ * Puis encodage WS2812 : symboles SPI décodés face aux couleurs corrigées
+ * (gamma, luminosité), aucune trame sans changement d’image.
+ * Enfin, transferts SDRAM en bloc sur la SDRAM émulée (disposition FMC x16,
+ * demi-mots permutés) : équivalence avec les accès mot à mot, copie, bornes,
+ * variantes asynchrones, et débit bloc / mot à mot ; pools et arène SDRAM
+ * (épuisement, recouvrements, repères, statistiques).
+ *
+ * Usage : ./build/brick_sim [out_dir [ref_dir]]   (code retour 0 = OK)
+ */
+
+#include "ch.h"
+#include "hal.h"
+#include "drv_display.h"
+#include "drv_leds_addr.h"
+#include "drv_input.h"
+#include "font.h"
+#include "ui_model.h"
+#include "ui_widget.h"
+#include "ssd130x_sim.h"
+#include "midi.h"
+#include "midi_sim.h"
+#include "seq_engine.h"
+#include "seq_bank.h"
+#include "audio_mix.h"
+#include "brick_asc.h"
+#include "brick_filter.h"
+#include "hall_scan.h"
+#include "hall_velocity.h"
+#include "brick_cal_store.h"
+#include "drv_flash.h"
+#include "sdram_ext.h"
+#include "sdram_alloc.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined(__i386__) || defined(__x86_64__)
+#include <x86intrin.h>
+#define SIM_HAVE_TSC 1
+#define SIM_HAVE_TSC_NAME "cycles"
+#else
+#define SIM_HAVE_TSC_NAME "ns"
+#endif
+
+#define SIM_RENDER_LOOPS   1000U
+#define SIM_SCALE          4U
+
+#define SIM_SEQ_BPM_X10       3000U
+#define SIM_SEQ_SWING         60U
+#define SIM_SEQ_STEPS         128U      /* 2 tours de pattern */
+#define SIM_SEQ_RATCHETS      3U
+#define SIM_SEQ_MICRO         6         /* 1/SEQ_MICRO_DIV de pas */
+#define SIM_SEQ_MAX_JITTER_US 2000.0    /* tick simulateur 1 ms + hôte */
+
+#define SIM_PRIM_OPS          20000U
+
+#define SIM_AUDIO_BLOCKS      200000U
+
+#define SIM_FILTER_SCANS      200000U
+#define SIM_FILTER_CH         BRICK_NUM_HALL_SENSORS
+
+#define SIM_SDRAM_WORDS       (64U * 1024U)   /* 256 Ko, une banque de patterns */
+#define SIM_SDRAM_LOOPS       64U
+
+static binary_semaphore_t flushed;
+
+static void on_flush(void) {
+  chSysLock();
+  chBSemSignalI(&flushed);
+  chSysUnlock();
+}
+
+static double host_us(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec * 1e6 + (double)ts.tv_nsec / 1e3;
+}
+
+/* LCG (Numerical Recipes) partagé par les tests aléatoires : chaque test
+   garde sa propre graine, les séquences restent reproductibles. */
+static uint32_t sim_rand(uint32_t *lcg, uint32_t n) {
+  *lcg = *lcg * 1664525U + 1013904223U;
+  return (*lcg >> 8) % n;
+}
+
+/* ====================================================================== */
+/*                         RÉFÉRENCES PIXEL À PIXEL                       */
+/* ====================================================================== */
+
+/*
+ * Anciens chemins de dessin, un pixel à la fois, gardés comme référence
+ * exacte des blits et spans de drv_display. Ils écrivent directement dans
+ * ref_fb, sans suivi des régions modifiées : leur temps est une borne basse
+ * de l'ancien coût.
+ */
+static uint8_t *ref_fb;
+
+static void ref_pixel(int x, int y, bool on) {
+  if ((x < 0) || (x >= BRICK_OLED_WIDTH) || (y < 0) || (y >= BRICK_OLED_HEIGHT)) {
+    return;
+  }
+  const uint8_t mask = (uint8_t)(1U << (y & 7));
+  if (on) {
+    ref_fb[x + (y >> 3) * BRICK_OLED_WIDTH] |= mask;
+  } else {
+    ref_fb[x + (y >> 3) * BRICK_OLED_WIDTH] &= (uint8_t)~mask;
+  }
+}
+
+static void ref_pixel_xor(int x, int y) {
+  if ((x >= 0) && (x < BRICK_OLED_WIDTH) && (y >= 0) && (y < BRICK_OLED_HEIGHT)) {
+    ref_fb[x + (y >> 3) * BRICK_OLED_WIDTH] ^= (uint8_t)(1U << (y & 7));
+  }
+}
+
+/* op : 0 = effacer, 1 = allumer, 2 = inverser. */
+static void ref_rect_op(int x, int y, int w, int h, int op) {
+  for (int iy = 0; iy < h; iy++) {
+    for (int ix = 0; ix < w; ix++) {
+      if (op == 2) {
+        ref_pixel_xor(x + ix, y + iy);
+      } else {
+        ref_pixel(x + ix, y + iy, op == 1);
+      }
+    }
+  }
+}
+
+static void ref_draw_rect(int x, int y, int w, int h) {
+  if ((w <= 0) || (h <= 0)) {
+    return;
+  }
+  for (int ix = 0; ix < w; ix++) {
+    ref_pixel(x + ix, y, true);
+    ref_pixel(x + ix, y + h - 1, true);
+  }
+  for (int iy = 0; iy < h; iy++) {
+    ref_pixel(x, y + iy, true);
+    ref_pixel(x + w - 1, y + iy, true);
+  }
+}
+
+static void ref_line(int x0, int y0, int x1, int y1, bool on) {
+  const int dx = (x1 > x0) ? x1 - x0 : x0 - x1;
+  const int dy = -((y1 > y0) ? y1 - y0 : y0 - y1);
+  const int sx = (x0 < x1) ? 1 : -1;
+  const int sy = (y0 < y1) ? 1 : -1;
+  int err = dx + dy;
+
+  while (true) {
+    ref_pixel(x0, y0, on);
+    if ((x0 == x1) && (y0 == y1)) {
+      break;
+    }
+    const int e2 = 2 * err;
+    if (e2 >= dy) { err += dy; x0 += sx; }
+    if (e2 <= dx) { err += dx; y0 += sy; }
+  }
+}
+
+/* Bitmap au format page, opaque : chaque pixel source posé ou effacé. */
+static void ref_bitmap(int x, int y, int w, int h, const uint8_t *bmp) {
+  for (int r = 0; r < h; r++) {
+    for (int c = 0; c < w; c++) {
+      ref_pixel(x + c, y + r, ((bmp[(r >> 3) * w + c] >> (r & 7)) & 1U) != 0U);
+    }
+  }
+}
+
+/* get_col() puis un pixel par bit allumé, glyphe après glyphe. */
+static void ref_text(const font_t *f, uint8_t x, uint8_t y, const char *txt) {
+  const uint8_t adv = (uint8_t)(f->width + f->spacing);
+
+  while (*txt && (x < BRICK_OLED_WIDTH)) {
+    char c = *txt++;
+    if (((uint8_t)c < f->first) || ((uint8_t)c > f->last)) {
+      c = '?';
+    }
+    for (uint8_t col = 0U; col < f->width; col++) {
+      const uint8_t bits = f->get_col(c, col);
+      for (uint8_t row = 0U; row < f->height; row++) {
+        if ((bits & (1U << row)) != 0U) {
+          ref_pixel(x + col, y + row, true);
+        }
+      }
+    }
+    x = (uint8_t)(x + adv);
+  }
+}
+
+/* ====================================================================== */
+/*                                ÉCRANS                                  */
+/* ====================================================================== */
+
+static void scene_text_5x7(void) {
+  drv_display_clear();
+  drv_display_set_font(&FONT_5X7);
+  for (uint8_t l = 0U; l < 8U; l++) {
+    drv_display_draw_text(0, (uint8_t)(l * 8U), "ABCDEFGHIJKLMNOPQRSTU");
+  }
+}
+
+static void scene_text_5x7_old(void) {
+  drv_display_clear();
+  ref_fb = drv_display_get_buffer();
+  for (uint8_t l = 0U; l < 8U; l++) {
+    ref_text(&FONT_5X7, 0, (uint8_t)(l * 8U), "ABCDEFGHIJKLMNOPQRSTU");
+  }
+}
+
+static void scene_text_4x6(void) {
+  drv_display_clear();
+  drv_display_draw_text_with_font(&FONT_4X6, 0, 0, "TRK 01  PTN A01  BPM 120");
+  drv_display_draw_text_with_font(&FONT_4X6, 3, 13, "filter cutoff 064 reso 12");
+  drv_display_draw_text_with_font(&FONT_5X8_ELEKTRON, 0, 29, "ELEKTRON 5X8 {}|~");
+  drv_display_draw_text_with_font(&FONT_5X7, 5, 58, "clip at bottom edge");
+}
+
+static void scene_text_4x6_old(void) {
+  drv_display_clear();
+  ref_fb = drv_display_get_buffer();
+  ref_text(&FONT_4X6, 0, 0, "TRK 01  PTN A01  BPM 120");
+  ref_text(&FONT_4X6, 3, 13, "filter cutoff 064 reso 12");
+  ref_text(&FONT_5X8_ELEKTRON, 0, 29, "ELEKTRON 5X8 {}|~");
+  ref_text(&FONT_5X7, 5, 58, "clip at bottom edge");
+}
+
+static void scene_primitives(void) {
+  static const uint8_t checker[2 * 16] = {
+    0xAA, 0x55, 0xAA, 0x55, 0xAA, 0x55, 0xAA, 0x55,
+    0xAA, 0x55, 0xAA, 0x55, 0xAA, 0x55, 0xAA, 0x55,
+    0x0F, 0x0F, 0xF0, 0xF0, 0x0F, 0x0F, 0xF0, 0xF0,
+    0x0F, 0x0F, 0xF0, 0xF0, 0x0F, 0x0F, 0xF0, 0xF0
+  };
+
+  drv_display_clear();
+  drv_display_draw_rect(0, 0, 128, 64);
+  drv_display_fill_rect(4, 4, 40, 13);
+  drv_display_clear_rect(8, 7, 10, 5);
+  drv_display_draw_line(0, 63, 127, 0, true);
+  drv_display_draw_line(10, 20, 60, 60, true);
+  drv_display_draw_hline(50, 30, 70, true);
+  drv_display_draw_vline(100, 5, 50, true);
+  drv_display_draw_bitmap(70, 37, 16, 13, checker);
+  drv_display_invert_rect(60, 44, 60, 12);
+}
+
+static const char *const menu_items[] = {
+  "Filter", "Amp", "LFO 1", "LFO 2", "FX", "Mixer"
+};
+
+static ui_widget_t w_root  = { .type = UI_WIDGET_GROUP, .field = UI_FIELD_NONE };
+static ui_widget_t w_title = { .type = UI_WIDGET_LABEL, .x = 0, .y = 0, .w = 128, .h = 8,
+                               .field = UI_FIELD_NONE, .text = "HALL B5 DEBUG" };
+static ui_widget_t w_raw   = { .type = UI_WIDGET_VALUE, .x = 0, .y = 10, .w = 64, .h = 8,
+                               .field = UI_FIELD_HALL_RAW, .text = "RAW %4ld" };
+static ui_widget_t w_pres  = { .type = UI_WIDGET_METER, .x = 66, .y = 10, .w = 62, .h = 7,
+                               .field = UI_FIELD_HALL_PRESSURE, .max = 127 };
+static ui_widget_t w_menu  = { .type = UI_WIDGET_MENU, .x = 0, .y = 20, .w = 64, .h = 32,
+                               .field = UI_FIELD_HALL_MIDI, .items = menu_items, .count = 6,
+                               .font = &FONT_4X6 };
+static ui_widget_t w_keys  = { .type = UI_WIDGET_STEPS, .x = 0, .y = 56, .w = 128, .h = 8,
+                               .field = UI_FIELD_HALL_MASK, .max = 16 };
+
+static void scene_widgets(void) {
+  static bool built = false;
+  static int32_t t = 0;
+
+  if (!built) {
+    drv_display_clear();
+    drv_display_set_font(&FONT_5X7);
+    ui_widget_add(&w_root, &w_title);
+    ui_widget_add(&w_root, &w_raw);
+    ui_widget_add(&w_root, &w_pres);
+    ui_widget_add(&w_root, &w_menu);
+    ui_widget_add(&w_root, &w_keys);
+    built = true;
+  }
+
+  /* Un seul champ change par passe : coût d’un tick typique. */
+  t++;
+  ui_model_set(UI_FIELD_HALL_RAW, 1000 + (t & 0x3FF));
+  ui_model_set(UI_FIELD_HALL_PRESSURE, 64);
+  ui_model_set(UI_FIELD_HALL_MIDI, 3);
+  ui_model_set_hall_mask(0x0F0FU);
+  (void)ui_tree_render(&w_root);
+}
+
+typedef struct {
+  const char *name;
+  void (*draw)(void);
+  void (*draw_old)(void);   /* Même image par l'ancien chemin, NULL sinon */
+} scene_t;
+
+static const scene_t scenes[] = {
+  { "text_5x7",   scene_text_5x7,   scene_text_5x7_old },
+  { "text_mixed", scene_text_4x6,   scene_text_4x6_old },
+  { "primitives", scene_primitives, NULL               },
+  { "widgets",    scene_widgets,    NULL               },
+};
+
+/*
+ * Primitives à spans face aux boucles pixel à pixel : mêmes opérations
+ * aléatoires, souvent hors écran, sur un framebuffer de départ aléatoire ;
+ * les deux framebuffers entiers doivent rester identiques.
+ */
+static uint32_t prim_lcg = 0x0D15B1A7U;
+
+static int prim_rand(int n) {
+  return (int)sim_rand(&prim_lcg, (uint32_t)n);
+}
+
+static int primitives_test(void) {
+  static uint8_t ref[SSD130X_SIM_PAGES * SSD130X_SIM_COLUMNS];
+  static uint8_t bmp[40 * 4];
+  uint8_t *fb = drv_display_get_buffer();
+  uint32_t bad = 0U, first_bad = 0U;
+
+  for (size_t i = 0U; i < sizeof(ref); i++) {
+    ref[i] = (uint8_t)prim_rand(256);
+  }
+  memcpy(fb, ref, sizeof(ref));
+  ref_fb = ref;
+
+  for (uint32_t n = 0U; n < SIM_PRIM_OPS; n++) {
+    const int x = prim_rand(BRICK_OLED_WIDTH + 48) - 24;
+    const int y = prim_rand(BRICK_OLED_HEIGHT + 32) - 16;
+    const int w = prim_rand(BRICK_OLED_WIDTH + 8) - 4;
+    const int h = prim_rand(BRICK_OLED_HEIGHT + 8) - 4;
+    const bool on = prim_rand(2) != 0;
+
+    switch (prim_rand(9)) {
+    case 0: drv_display_draw_rect(x, y, w, h);   ref_draw_rect(x, y, w, h);   break;
+    case 1: drv_display_fill_rect(x, y, w, h);   ref_rect_op(x, y, w, h, 1);  break;
+    case 2: drv_display_clear_rect(x, y, w, h);  ref_rect_op(x, y, w, h, 0);  break;
+    case 3: drv_display_invert_rect(x, y, w, h); ref_rect_op(x, y, w, h, 2);  break;
+    case 4: drv_display_draw_hline(x, y, w, on); ref_rect_op(x, y, w, 1, on); break;
+    case 5: drv_display_draw_vline(x, y, h, on); ref_rect_op(x, y, 1, h, on); break;
+    case 6: drv_display_draw_pixel(x, y, on);    ref_pixel(x, y, on);         break;
+    case 7: {
+      const int x1 = prim_rand(BRICK_OLED_WIDTH + 48) - 24;
+      const int y1 = prim_rand(BRICK_OLED_HEIGHT + 32) - 16;
+      drv_display_draw_line(x, y, x1, y1, on);
+      ref_line(x, y, x1, y1, on);
+      break;
+    }
+    default: {
+      const int bw = 1 + prim_rand(40);
+      const int bh = 1 + prim_rand(32);
+      for (int i = 0; i < bw * ((bh + 7) / 8); i++) {
+        bmp[i] = (uint8_t)prim_rand(256);
+      }
+      drv_display_draw_bitmap(x, y, bw, bh, bmp);
+      ref_bitmap(x, y, bw, bh, bmp);
+      break;
+    }
+    }
+    if (memcmp(fb, ref, sizeof(ref)) != 0) {
+      if (bad++ == 0U) {
+        first_bad = n;
+      }
+      memcpy(fb, ref, sizeof(ref));
+    }
+  }
+
+  drv_display_clear();
+  printf("\nprimitives %u random ops vs per-pixel: %u mismatch", (unsigned)SIM_PRIM_OPS,
+         (unsigned)bad);
+  if (bad != 0U) {
+    printf(" (first at op %u)\n  FAIL primitives\n", (unsigned)first_bad);
+    return 1;
+  }
+  printf("\n");
+  return 0;
+}
+
+/* ====================================================================== */
+/*                               SÉQUENCEUR                               */
+/* ====================================================================== */
+
+/*
+ * Pistes 0–11 : un trig par pas (0–3 avec un p-lock de son vers une
+ * cartouche) ; 12–13 : ratchets ; 14–15 : micro-timing alterné ±.
+ * Swing sur les pas impairs pour toutes.
+ */
+static seq_pattern_t sim_pattern;
+static uint32_t      sim_cart_plocks;
+static uint32_t      sim_cart_notes;
+
+static void sim_cart_sink(uint8_t cart, const seq_event_t *ev) {
+  (void)cart;
+  if (ev->type == SEQ_EV_PLOCK) {
+    sim_cart_plocks++;
+  } else if (ev->type == SEQ_EV_NOTE_ON) {
+    sim_cart_notes++;
+  }
+}
+
+/* Date idéale (µs depuis le pas 0) du k-ième NOTE ON de la piste. */
+static double seq_ideal_us(uint8_t track, uint32_t k, double step_us) {
+  const double swing_us = step_us * (SIM_SEQ_SWING - 50.0) / 50.0;
+  uint32_t step = k;
+  double t = 0.0;
+
+  if ((track == 12U) || (track == 13U)) {
+    step = k / SIM_SEQ_RATCHETS;
+    const double span_us = (step & 1U) ? (step_us - swing_us) : (step_us + swing_us);
+    t = (double)(k % SIM_SEQ_RATCHETS) * span_us / SIM_SEQ_RATCHETS;
+  } else if (track >= 14U) {
+    t = ((step & 1U) ? -SIM_SEQ_MICRO : SIM_SEQ_MICRO) * step_us / SEQ_MICRO_DIV;
+  }
+  if ((step & 1U) != 0U) {
+    t += swing_us;
+  }
+  return t + (double)step * step_us;
+}
+
+static int seq_jitter_test(void) {
+  const double step_us = 60e6 * 10.0 / (SIM_SEQ_BPM_X10 * 4.0);
+  uint32_t ons[BRICK_NUM_TRACKS] = {0};
+  uint32_t offs[BRICK_NUM_TRACKS] = {0};
+  double sum = 0.0, sum2 = 0.0, lo = 1e30, hi = -1e30, t0 = 0.0;
+  uint32_t n = 0U;
+  int failures = 0;
+  seq_engine_stats_t st;
+
+  seq_pattern_init(&sim_pattern);
+  for (uint8_t t = 0U; t < BRICK_NUM_TRACKS; t++) {
+    const seq_track_cfg_t cfg = { .dest = MIDI_DEST_UART, .channel = t,
+                                  .note = (uint8_t)(36U + t), .velocity = 100U,
+                                  .length = SEQ_MICRO_DIV / 2U,
+                                  .cart = (t < 4U) ? t : SEQ_CART_NONE };
+    seq_engine_set_track(t, &cfg);
+
+    for (uint8_t s = 0U; s < BRICK_STEPS_PER_TRACK; s++) {
+      seq_trig_set(&sim_pattern, t, s, true);
+      if (t < 4U) {
+        (void)seq_plock_set(&sim_pattern, t, s, 0U, s);
+      } else if (t >= 14U) {
+        (void)seq_plock_set(&sim_pattern, t, s, SEQ_PARAM_MICRO,
+                            (uint16_t)(int16_t)((s & 1U) ? -SIM_SEQ_MICRO : SIM_SEQ_MICRO));
+      } else if (t >= 12U) {
+        (void)seq_plock_set(&sim_pattern, t, s, SEQ_PARAM_RATCHET, SIM_SEQ_RATCHETS);
+      }
+    }
+  }
+
+  seq_engine_set_pattern(&sim_pattern);
+  seq_engine_set_cart_sink(sim_cart_sink);
+  seq_engine_set_clock_dest(MIDI_DEST_UART);
+  seq_engine_set_tempo(SIM_SEQ_BPM_X10);
+  seq_engine_set_swing(SIM_SEQ_SWING);
+  seq_engine_stats_reset();
+  midi_sim_reset();
+
+  /* Arrêt au milieu du pas SIM_SEQ_STEPS (avance de rendu incluse) :
+     seuls les SIM_SEQ_STEPS premiers pas sont mesurés. */
+  seq_engine_start();
+  chThdSleepMicroseconds((sysinterval_t)((SEQ_LOOKAHEAD_STEPS + SIM_SEQ_STEPS + 0.5) * step_us));
+  seq_engine_stop();
+  chThdSleepMilliseconds(20);
+  seq_engine_get_stats(&st);
+
+  /* Erreur de chaque NOTE ON face à sa date idéale ; le START fixe l’origine. */
+  const midi_sim_msg_t *log = midi_sim_log();
+  for (size_t i = 0U; i < midi_sim_count(); i++) {
+    const midi_sim_msg_t *m = &log[i];
+    const uint8_t ch = m->status & 0x0FU;
+
+    if (m->status == 0xFAU) {
+      t0 = m->us;
+    } else if ((m->status & 0xF0U) == 0x90U) {
+      const double ideal = seq_ideal_us(ch, ons[ch]++, step_us);
+      if (ideal >= SIM_SEQ_STEPS * step_us) {
+        continue;
+      }
+      const double err = (m->us - t0) - ideal;
+      sum += err;
+      sum2 += err * err;
+      lo = (err < lo) ? err : lo;
+      hi = (err > hi) ? err : hi;
+      n++;
+    } else if ((m->status & 0xF0U) == 0x80U) {
+      offs[ch]++;
+    }
+  }
+
+  const double mean = (n > 0U) ? sum / n : 0.0;
+  const double rms = (n > 0U) ? sqrt(fmax(0.0, sum2 / n - mean * mean)) : 0.0;
+  const double jitter = ((hi - mean) > (mean - lo)) ? (hi - mean) : (mean - lo);
+
+  printf("\nseq 300 BPM, 16 tracks: %u note-on, offset %.0f us, jitter rms %.0f us, "
+         "max %.0f us\n", (unsigned)n, mean, rms, jitter);
+  printf("  dispatched %u, late %u (max %u us), queue peak %u, drops %u\n",
+         (unsigned)st.dispatched, (unsigned)st.late, (unsigned)st.late_max_us,
+         (unsigned)st.queue_peak, (unsigned)st.queue_drops);
+
+  for (uint8_t t = 0U; t < BRICK_NUM_TRACKS; t++) {
+    const uint32_t want = SIM_SEQ_STEPS * (((t == 12U) || (t == 13U)) ? SIM_SEQ_RATCHETS : 1U);
+    if ((ons[t] < want) || (offs[t] != ons[t])) {
+      printf("  FAIL track %u: %u note-on (want %u), %u note-off\n",
+             t, (unsigned)ons[t], (unsigned)want, (unsigned)offs[t]);
+      failures++;
+    }
+  }
+  if ((sim_cart_plocks != sim_cart_notes) || (sim_cart_notes < 4U * SIM_SEQ_STEPS)) {
+    printf("  FAIL cartridge sink: %u p-locks, %u notes\n",
+           (unsigned)sim_cart_plocks, (unsigned)sim_cart_notes);
+    failures++;
+  }
+  if ((st.queue_drops != 0U) || (midi_sim_dropped() != 0U)) {
+    printf("  FAIL events dropped\n");
+    failures++;
+  }
+  if (jitter > SIM_SEQ_MAX_JITTER_US) {
+    printf("  FAIL jitter above %.0f us\n", SIM_SEQ_MAX_JITTER_US);
+    failures++;
+  }
+  return failures;
+}
+
+/*
+ * Relance en cours de lecture : aucun NOTE ON de l’ancienne génération ne
+ * doit sortir entre l’appel et le START de la nouvelle (les NOTE OFF, eux,
+ * partent aussitôt). Réutilise le pattern du test de gigue.
+ */
+static int seq_restart_test(void) {
+  const double step_us = 60e6 * 10.0 / (SIM_SEQ_BPM_X10 * 4.0);
+  uint32_t stale = 0U, starts = 0U, offs_before = 0U;
+  double restart_us, start_us = 0.0;
+
+  midi_sim_reset();
+  seq_engine_start();
+  chThdSleepMicroseconds((sysinterval_t)((SEQ_LOOKAHEAD_STEPS + 2.5) * step_us));
+  restart_us = midi_sim_now_us();
+  seq_engine_start();
+  chThdSleepMicroseconds((sysinterval_t)((SEQ_LOOKAHEAD_STEPS + 1.5) * step_us));
+  seq_engine_stop();
+  chThdSleepMilliseconds(20);
+
+  const midi_sim_msg_t *log = midi_sim_log();
+  for (size_t i = 0U; i < midi_sim_count(); i++) {
+    const midi_sim_msg_t *m = &log[i];
+    if (m->status == 0xFAU) {
+      starts++;
+      if (m->us >= restart_us) {
+        start_us = m->us;
+        break;
+      }
+    } else if (m->us >= restart_us) {
+      if ((m->status & 0xF0U) == 0x90U) {
+        stale++;
+      } else if ((m->status & 0xF0U) == 0x80U) {
+        offs_before++;
+      }
+    }
+  }
+
+  printf("seq restart: %u stale note-on, %u note-off flushed, new start +%.0f us\n",
+         (unsigned)stale, (unsigned)offs_before, start_us - restart_us);
+  if ((starts != 2U) || (stale != 0U)) {
+    printf("  FAIL restart while running\n");
+    return 1;
+  }
+  return 0;
+}
+
+/* ====================================================================== */
+/*                                PATTERNS                                */
+/* ====================================================================== */
+
+/*
+ * seq_pattern face à une table dense (bit 16 = posé, bits 0–15 = valeur) :
+ * éditions aléatoires, copier/coller de page (fusion), index step_start,
+ * forme BPT1 aller-retour et rejet des données abîmées ; puis seq_bank sur
+ * la SDRAM émulée : emplacements remplacés / effacés sans toucher aux voisins.
+ */
+static seq_pattern_t   pat_a, pat_b;
+static seq_page_clip_t pat_clip;
+static uint32_t pat_ref[BRICK_NUM_TRACKS][BRICK_STEPS_PER_TRACK][BRICK_MAX_PLOCKS_PER_STEP];
+static uint32_t pat_ser[2][SEQ_PATTERN_MAX_WORDS];
+
+static uint32_t pat_lcg = 0x5EED0015U;
+
+static uint32_t pat_rand(uint32_t n) {
+  return sim_rand(&pat_lcg, n);
+}
+
+/* Pool trié, index cohérent et contenu égal à la référence ; 0 = OK. */
+static uint32_t pat_check(const seq_pattern_t *p) {
+  uint32_t bad = 0U, count = 0U;
+
+  for (uint16_t i = 1U; i < p->plock_count; i++) {
+    bad += p->plocks[i].key <= p->plocks[i - 1U].key;
+  }
+  bad += p->step_start[0] != 0U;
+  bad += p->step_start[SEQ_TRACK_STEPS] != p->plock_count;
+  for (uint8_t t = 0U; t < BRICK_NUM_TRACKS; t++) {
+    for (uint8_t st = 0U; st < BRICK_STEPS_PER_TRACK; st++) {
+      uint32_t n = 0U;
+      for (uint8_t k = 0U; k < BRICK_MAX_PLOCKS_PER_STEP; k++) {
+        n += (pat_ref[t][st][k] >> 16) & 1U;
+      }
+      /* Le parcours begin..end doit donner exactement les p-locks du pas. */
+      const seq_plock_t *q = seq_plock_begin(p, t, st);
+      const seq_plock_t *e = seq_plock_end(p, t, st);
+      bad += (uint32_t)(e - q) != n;
+      for (; (q < e) && (bad == 0U); q++) {
+        const uint32_t r = pat_ref[t][st][SEQ_PLOCK_PARAM(q->key)];
+        bad += (q->key >> 6) != (uint16_t)(t * BRICK_STEPS_PER_TRACK + st);
+        bad += r != (0x10000U | q->value);
+      }
+      count += n;
+    }
+  }
+  bad += count != p->plock_count;
+  return bad;
+}
+
+/* Forme sérialisée identique des deux patterns. */
+static bool pat_same(const seq_pattern_t *a, const seq_pattern_t *b) {
+  const size_t na = seq_pattern_serialize(a, pat_ser[0], SEQ_PATTERN_MAX_WORDS);
+  const size_t nb = seq_pattern_serialize(b, pat_ser[1], SEQ_PATTERN_MAX_WORDS);
+  return (na != 0U) && (na == nb) && (memcmp(pat_ser[0], pat_ser[1], na * 4U) == 0);
+}
+
+/* Éditions aléatoires appliquées au pattern et à la référence. */
+static void pat_edit(seq_pattern_t *p, uint32_t ops) {
+  for (uint32_t n = 0U; n < ops; n++) {
+    const uint8_t t = (uint8_t)pat_rand(BRICK_NUM_TRACKS);
+    const uint8_t st = (uint8_t)pat_rand(BRICK_STEPS_PER_TRACK);
+    const uint8_t k = (uint8_t)pat_rand(8U);
+    const uint32_t op = pat_rand(10U);
+
+    if (op < 6U) {
+      const uint16_t v = (uint16_t)pat_rand(0x10000U);
+      if (seq_plock_set(p, t, st, k, v)) {
+        pat_ref[t][st][k] = 0x10000U | v;
+      }
+    } else if (op < 9U) {
+      (void)seq_plock_clear(p, t, st, k);
+      pat_ref[t][st][k] = 0U;
+    } else {
+      seq_plock_clear_step(p, t, st);
+      memset(pat_ref[t][st], 0, sizeof(pat_ref[t][st]));
+    }
+    seq_trig_set(p, t, st, (pat_rand(2U) != 0U));
+  }
+}
+
+static int pattern_test(void) {
+  uint32_t bad_edit = 0U, bad_paste = 0U, bad_ser = 0U, bad_bank = 0U;
+  size_t words_max = 0U;
+
+  /* Éditions : insertion / retrait au milieu du pool, index décalé. */
+  seq_pattern_init(&pat_a);
+  memset(pat_ref, 0, sizeof(pat_ref));
+  for (uint32_t round = 0U; round < 40U; round++) {
+    pat_edit(&pat_a, 50U);
+    bad_edit += pat_check(&pat_a);
+  }
+
+  /* Copier / coller : pages de bord et du milieu, source = destination. */
+  static const uint8_t pages[][2] = { {1U, 2U}, {0U, SEQ_PAGES - 1U},
+                                      {SEQ_PAGES - 1U, 0U}, {2U, 2U} };
+  for (uint8_t i = 0U; i < sizeof(pages) / sizeof(pages[0]); i++) {
+    const uint8_t from = pages[i][0], to = pages[i][1];
+    uint64_t trigs[BRICK_NUM_TRACKS];
+
+    seq_page_copy(&pat_a, from, &pat_clip);
+    for (uint8_t t = 0U; t < BRICK_NUM_TRACKS; t++) {
+      trigs[t] = pat_a.trigs[t];
+      for (uint8_t st = 0U; st < SEQ_STEPS_PER_PAGE; st++) {
+        memcpy(pat_ref[t][to * SEQ_STEPS_PER_PAGE + st],
+               pat_ref[t][from * SEQ_STEPS_PER_PAGE + st], sizeof(pat_ref[t][st]));
+      }
+      const uint64_t page = (uint64_t)((1UL << SEQ_STEPS_PER_PAGE) - 1U);
+      trigs[t] = (trigs[t] & ~(page << (to * SEQ_STEPS_PER_PAGE))) |
+                 (((trigs[t] >> (from * SEQ_STEPS_PER_PAGE)) & page) << (to * SEQ_STEPS_PER_PAGE));
+    }
+    bad_paste += !seq_page_paste(&pat_a, to, &pat_clip);
+    bad_paste += pat_check(&pat_a);
+    bad_paste += memcmp(trigs, pat_a.trigs, sizeof(trigs)) != 0;
+    pat_edit(&pat_a, 20U);
+  }
+
+  /* Pool plein, page 1 chargée : la coller sur la page 0 déborderait ;
+     le collage est refusé et le pattern reste intact. */
+  pat_b = pat_a;
+  for (uint16_t i = 0U; pat_b.plock_count < SEQ_PLOCK_POOL; i++) {
+    (void)seq_plock_set(&pat_b, (uint8_t)(i % BRICK_NUM_TRACKS),
+                        (uint8_t)(SEQ_STEPS_PER_PAGE + (i / BRICK_NUM_TRACKS) % SEQ_STEPS_PER_PAGE),
+                        (uint8_t)(i / (BRICK_NUM_TRACKS * SEQ_STEPS_PER_PAGE)), i);
+  }
+  seq_page_copy(&pat_b, 1U, &pat_clip);
+  uint16_t in_page0 = 0U;
+  for (uint8_t t = 0U; t < BRICK_NUM_TRACKS; t++) {
+    const uint16_t s0 = (uint16_t)(t * BRICK_STEPS_PER_TRACK);
+    in_page0 = (uint16_t)(in_page0 + pat_b.step_start[s0 + SEQ_STEPS_PER_PAGE] -
+                          pat_b.step_start[s0]);
+  }
+  bad_paste += pat_clip.plock_count <= in_page0;
+  pat_a = pat_b;
+  bad_paste += seq_page_paste(&pat_b, 0U, &pat_clip);
+  bad_paste += !pat_same(&pat_a, &pat_b);
+
+  /* BPT1 : aller-retour, puis en-tête, longueur et ordre des clés abîmés. */
+  const size_t words = seq_pattern_serialize(&pat_a, pat_ser[0], SEQ_PATTERN_MAX_WORDS);
+  words_max = words;
+  bad_ser += words != seq_pattern_serialized_words(pat_ser[0]);
+  bad_ser += seq_pattern_serialize(&pat_a, pat_ser[1], words - 1U) != 0U;
+  bad_ser += !seq_pattern_deserialize(&pat_b, pat_ser[0], words);
+  bad_ser += !pat_same(&pat_a, &pat_b);
+  seq_pattern_serialize(&pat_a, pat_ser[0], SEQ_PATTERN_MAX_WORDS);
+  bad_ser += seq_pattern_deserialize(&pat_b, pat_ser[0], words - 1U);
+  bad_ser += pat_b.plock_count != 0U;
+  pat_ser[0][words - 1U] = pat_ser[0][words - 2U];       /* clé répétée */
+  bad_ser += seq_pattern_deserialize(&pat_b, pat_ser[0], words);
+  pat_ser[0][0] ^= 1U;                                   /* magic */
+  bad_ser += seq_pattern_deserialize(&pat_b, pat_ser[0], words);
+
+  /* Banque : tailles différentes, remplacement par plus grand au milieu,
+     effacement, puis relecture de chaque emplacement. */
+  static seq_pattern_t slot_pat[4];
+  sdram_ext_init();
+  seq_bank_format();
+  for (uint8_t i = 0U; i < 4U; i++) {
+    seq_pattern_init(&slot_pat[i]);
+    for (uint16_t n = 0U; n < 40U * i * i; n++) {
+      (void)seq_plock_set(&slot_pat[i], (uint8_t)pat_rand(BRICK_NUM_TRACKS),
+                          (uint8_t)pat_rand(BRICK_STEPS_PER_TRACK),
+                          (uint8_t)pat_rand(BRICK_MAX_PLOCKS_PER_STEP), n);
+      seq_trig_set(&slot_pat[i], (uint8_t)pat_rand(BRICK_NUM_TRACKS),
+                   (uint8_t)pat_rand(BRICK_STEPS_PER_TRACK), true);
+    }
+    bad_bank += !seq_bank_store(i, &slot_pat[i]);
+  }
+  bad_bank += !seq_bank_store(1U, &pat_a);                 /* pool plein */
+  slot_pat[1] = pat_a;
+  seq_bank_erase(2U);
+  bad_bank += !seq_bank_store(SEQ_BANK_PATTERNS - 1U, &slot_pat[3]);
+  bad_bank += seq_bank_store(SEQ_BANK_PATTERNS, &slot_pat[3]);
+  for (uint8_t i = 0U; i < 4U; i++) {
+    const bool ok = seq_bank_load(i, &pat_b);
+    bad_bank += (i == 2U) ? (ok || seq_bank_used(i)) : (!ok || !pat_same(&pat_b, &slot_pat[i]));
+  }
+  bad_bank += !seq_bank_load(SEQ_BANK_PATTERNS - 1U, &pat_b) || !pat_same(&pat_b, &slot_pat[3]);
+  bad_bank += seq_bank_used(4U);
+
+  printf("\npatterns: edits %u, paste %u, BPT1 %u (%u words), bank %u mismatch\n",
+         (unsigned)bad_edit, (unsigned)bad_paste, (unsigned)bad_ser,
+         (unsigned)words_max, (unsigned)bad_bank);
+  const int fail = (bad_edit + bad_paste + bad_ser + bad_bank) != 0U;
+  if (fail) {
+    printf("  FAIL patterns\n");
+  }
+  return fail;
+}
+
+/* ====================================================================== */
+/*                                MIDI USB                                */
+/* ====================================================================== */
+
+/*
+ * Stress USB-MIDI : SIM_MIDI_THREADS threads de priorités différentes
+ * envoient chacun sur leur canal une suite numérotée de NOTE ON / NOTE OFF
+ * alternés (note = n & 0x7F, vélocité = 1 + (n >> 7)), par rafales de 1 à
+ * SIM_MIDI_BURST messages séparées de 1 à SIM_MIDI_IDLE ticks : l’EP est
+ * tantôt saturé, tantôt libre avec une trame partielle en attente du SOF
+ * (envoi immédiat). Les paquets capturés sur l’EP IN émulé doivent
+ * redonner, canal par canal, la suite exacte : paquet mal formé, doublon,
+ * inversion ou perte non comptée = échec.
+ */
+#define SIM_MIDI_THREADS   4U
+#define SIM_MIDI_MSGS      1500U
+#define SIM_MIDI_BURST     2U
+#define SIM_MIDI_IDLE      6U
+
+static THD_WORKING_AREA(waMidiStress[SIM_MIDI_THREADS], 1024);
+
+static THD_FUNCTION(thdMidiStress, arg) {
+  const uint8_t ch = (uint8_t)(uintptr_t)arg;
+  uint32_t lcg = 0x1234567U + ch;
+  uint32_t n = 0U;
+
+  while (n < SIM_MIDI_MSGS) {
+    lcg = lcg * 1664525U + 1013904223U;
+    const uint32_t burst = 1U + (lcg >> 28) % SIM_MIDI_BURST;
+
+    for (uint32_t i = 0U; (i < burst) && (n < SIM_MIDI_MSGS); i++, n++) {
+      const uint8_t note = (uint8_t)(n & 0x7FU);
+      const uint8_t vel = (uint8_t)(1U + (n >> 7));
+      if ((n & 1U) == 0U) {
+        midi_note_on(MIDI_DEST_USB, ch, note, vel);
+      } else {
+        midi_note_off(MIDI_DEST_USB, ch, note, vel);
+      }
+    }
+    chThdSleep((sysinterval_t)(1U + (lcg >> 20) % SIM_MIDI_IDLE));
+  }
+}
+
+static int midi_usb_stress_test(void) {
+  thread_t *thd[SIM_MIDI_THREADS];
+  uint32_t next[SIM_MIDI_THREADS] = {0};
+  uint32_t gaps = 0U, bad = 0U, order = 0U;
+
+  midi_stats_reset();
+  midi_sim_usb_connect(true);
+
+  for (uint8_t t = 0U; t < SIM_MIDI_THREADS; t++) {
+    thd[t] = chThdCreateStatic(waMidiStress[t], sizeof(waMidiStress[t]),
+                               NORMALPRIO + 1 + (tprio_t)t, thdMidiStress,
+                               (void *)(uintptr_t)t);
+  }
+  for (uint8_t t = 0U; t < SIM_MIDI_THREADS; t++) {
+    (void)chThdWait(thd[t]);
+  }
+  chThdSleepMilliseconds(50);               /* dernière trame partielle */
+
+  const uint8_t (*pkt)[4] = midi_sim_usb_packets();
+  for (size_t i = 0U; i < midi_sim_usb_count(); i++) {
+    const uint8_t *p = pkt[i];
+    const uint8_t ch = p[1] & 0x0FU;
+    const uint8_t type = p[1] & 0xF0U;
+    const uint32_t n = ((uint32_t)(p[3] - 1U) << 7) | p[2];
+
+    /* CIN = type du message, câble 0, canal connu, parité = NOTE ON/OFF. */
+    if ((ch >= SIM_MIDI_THREADS) || (p[0] != (type >> 4)) || (p[3] == 0U) ||
+        (type != (((n & 1U) == 0U) ? 0x90U : 0x80U))) {
+      bad++;
+      continue;
+    }
+    if (n < next[ch]) {
+      order++;                              /* doublon ou inversion */
+      continue;
+    }
+    gaps += n - next[ch];
+    next[ch] = n + 1U;
+  }
+  for (uint8_t t = 0U; t < SIM_MIDI_THREADS; t++) {
+    gaps += SIM_MIDI_MSGS - next[t];
+  }
+
+  const uint32_t drops = midi_tx_stats.tx_mb_drops + midi_tx_stats.usb_not_ready_drops;
+  const int fail = (bad != 0U) || (order != 0U) || (gaps != drops) ||
+                   (midi_sim_usb_dropped() != 0U) || (midi_tx_stats.tx_sent_immediate == 0U);
+
+  printf("\nmidi usb stress %u threads x %u msgs: %u packets in %u transfers "
+         "(%u immediate), %u lost (%u counted), %u malformed, %u out of order, "
+         "queue peak %u%s\n",
+         (unsigned)SIM_MIDI_THREADS, (unsigned)SIM_MIDI_MSGS,
+         (unsigned)midi_sim_usb_count(), (unsigned)midi_sim_usb_transfers(),
+         (unsigned)midi_tx_stats.tx_sent_immediate, (unsigned)gaps, (unsigned)drops,
+         (unsigned)bad, (unsigned)order, (unsigned)midi_usb_queue_high_watermark(),
+         fail ? " FAIL" : "");
+
+  midi_sim_usb_connect(false);
+  return fail;
+}
+
+/* ====================================================================== */
+/*                                 AUDIO                                  */
+/* ====================================================================== */
+
+static int16_t sim_cart_in[BRICK_MAX_CARTRIDGES][BRICK_AUDIO_FRAME_SAMPLES * BRICK_CART_AUDIO_CHANNELS];
+static int32_t sim_audio_out[BRICK_AUDIO_FRAME_SAMPLES * 2U];
+
+static void audio_benchmark(void) {
+  const int16_t *in[BRICK_MAX_CARTRIDGES];
+  audio_cart_gains_t gains[BRICK_MAX_CARTRIDGES];
+  volatile int32_t sink = 0;
+
+  for (uint8_t c = 0U; c < BRICK_MAX_CARTRIDGES; c++) {
+    for (size_t i = 0U; i < sizeof(sim_cart_in[c]) / sizeof(int16_t); i++) {
+      sim_cart_in[c][i] = (int16_t)rand();
+    }
+    for (uint8_t k = 0U; k < BRICK_CART_AUDIO_CHANNELS; k++) {
+      int16_t gl, gr;
+      audio_pan_gains(AUDIO_Q15_ONE / 2, (int8_t)(k * 32 - 48), &gl, &gr);
+      audio_cart_gains_set(&gains[c], k, gl, gr);
+    }
+    in[c] = sim_cart_in[c];
+  }
+
+  const double t0 = host_us();
+#if defined(SIM_HAVE_TSC)
+  const uint64_t c0 = __rdtsc();
+#endif
+  for (unsigned n = 0U; n < SIM_AUDIO_BLOCKS; n++) {
+    audio_mix_block(in, gains, AUDIO_Q15_ONE, sim_audio_out, 2U,
+                    BRICK_AUDIO_FRAME_SAMPLES);
+    sink += sim_audio_out[n & 1U];
+  }
+#if defined(SIM_HAVE_TSC)
+  const double cycles = (double)(__rdtsc() - c0);
+#else
+  const double cycles = 0.0;
+#endif
+  const double frames = (double)SIM_AUDIO_BLOCKS * BRICK_AUDIO_FRAME_SAMPLES;
+  const double us = host_us() - t0;
+  (void)sink;
+
+  printf("\naudio mix %u carts x %u ch, %u-frame blocks (%s kernel):\n",
+         (unsigned)BRICK_MAX_CARTRIDGES, (unsigned)BRICK_CART_AUDIO_CHANNELS,
+         (unsigned)BRICK_AUDIO_FRAME_SAMPLES, AUDIO_MIX_USE_DSP ? "DSP" : "C");
+  printf("  %.1f host cycles/frame, %.1f ns/frame, %.2f %% of a %u Hz frame\n",
+         cycles / frames, us * 1e3 / frames,
+         100.0 * (us / frames) * BRICK_AUDIO_SAMPLE_RATE / 1e6,
+         (unsigned)BRICK_AUDIO_SAMPLE_RATE);
+}
+
+/* ====================================================================== */
+/*                                FILTRES                                 */
+/* ====================================================================== */
+
+static uint16_t sim_filter_in[256][SIM_FILTER_CH];
+
+/* Capteur bruité avec pointes isolées (1 % des échantillons). */
+static void filter_fill(void) {
+  for (unsigned n = 0U; n < 256U; n++) {
+    for (unsigned c = 0U; c < SIM_FILTER_CH; c++) {
+      uint32_t v = 30000U + c * 1000U + (uint32_t)(rand() % 512);
+      if (rand() % 100 == 0) {
+        v = (uint32_t)(rand() & 0xFFFF);
+      }
+      sim_filter_in[n][c] = (uint16_t)v;
+    }
+  }
+}
+
+static double filter_cycles(void) {
+#if defined(SIM_HAVE_TSC)
+  return (double)__rdtsc();
+#else
+  return host_us() * 1e3;
+#endif
+}
+
+static int filter_test(void) {
+  static struct brick_asc asc[SIM_FILTER_CH];
+  static brick_ma_t ma;
+  static brick_ema_t ema;
+  static brick_median_t med;
+  uint16_t out[SIM_FILTER_CH];
+  volatile uint32_t sink = 0U;
+  int fail = 0;
+
+  filter_fill();
+
+  /* Moyenne mobile : sorties et drapeau identiques à brick_asc_process(). */
+  for (uint8_t shift = 0U; shift <= BRICK_FILTER_MA_MAX_SHIFT; shift++) {
+    brick_asc_array_set_factors(asc, SIM_FILTER_CH, 0U, SIM_FILTER_CH, (uint8_t)(1U << shift));
+    brick_ma_init(&ma, SIM_FILTER_CH, shift);
+    for (unsigned n = 0U; n < 1000U; n++) {
+      const uint16_t *in = sim_filter_in[n & 255U];
+      const bool full = brick_ma_process(&ma, in, out);
+      for (unsigned c = 0U; c < SIM_FILTER_CH; c++) {
+        uint16_t ref;
+        const bool ref_full = brick_asc_process(&asc[c], in[c], &ref);
+        fail += ref != out[c] || ref_full != full;
+      }
+    }
+  }
+
+  /* EMA : ±1 d'une référence en double précision, même pas. */
+  brick_ema_init(&ema, SIM_FILTER_CH, 3U);
+  double y[SIM_FILTER_CH];
+  for (unsigned n = 0U; n < 1000U; n++) {
+    const uint16_t *in = sim_filter_in[n & 255U];
+    brick_ema_process(&ema, in, out);
+    for (unsigned c = 0U; c < SIM_FILTER_CH; c++) {
+      y[c] = (n == 0U) ? in[c] : y[c] + (in[c] - y[c]) / 8.0;
+      fail += fabs(out[c] - y[c]) > 1.0 + 1e-9;
+    }
+  }
+
+  /* Médiane de 5 : comparée au tri de la fenêtre, une fois pleine. */
+  brick_median_init(&med, SIM_FILTER_CH, 5U);
+  for (unsigned n = 0U; n < 1000U; n++) {
+    brick_median_process(&med, sim_filter_in[n & 255U], out);
+    for (unsigned c = 0U; n >= 4U && c < SIM_FILTER_CH; c++) {
+      uint16_t w[5];
+      for (unsigned k = 0U; k < 5U; k++) {
+        w[k] = sim_filter_in[(n - k) & 255U][c];
+      }
+      for (unsigned i = 1U; i < 5U; i++) {
+        for (unsigned j = i; j > 0U && w[j - 1U] > w[j]; j--) {
+          const uint16_t t = w[j]; w[j] = w[j - 1U]; w[j - 1U] = t;
+        }
+      }
+      fail += out[c] != w[2];
+    }
+  }
+
+  /* Cycles par scan de 16 canaux. */
+  double t0, c_asc, c_ma, c_ema, c_med;
+  brick_asc_array_set_factors(asc, SIM_FILTER_CH, 0U, SIM_FILTER_CH, 8U);
+  t0 = filter_cycles();
+  for (unsigned n = 0U; n < SIM_FILTER_SCANS; n++) {
+    const uint16_t *in = sim_filter_in[n & 255U];
+    for (unsigned c = 0U; c < SIM_FILTER_CH; c++) {
+      (void)brick_asc_process(&asc[c], in[c], &out[c]);
+    }
+    sink += out[n & 15U];
+  }
+  c_asc = (filter_cycles() - t0) / SIM_FILTER_SCANS;
+
+  brick_ma_init(&ma, SIM_FILTER_CH, 3U);
+  t0 = filter_cycles();
+  for (unsigned n = 0U; n < SIM_FILTER_SCANS; n++) {
+    (void)brick_ma_process(&ma, sim_filter_in[n & 255U], out);
+    sink += out[n & 15U];
+  }
+  c_ma = (filter_cycles() - t0) / SIM_FILTER_SCANS;
+
+  t0 = filter_cycles();
+  for (unsigned n = 0U; n < SIM_FILTER_SCANS; n++) {
+    brick_ema_process(&ema, sim_filter_in[n & 255U], out);
+    sink += out[n & 15U];
+  }
+  c_ema = (filter_cycles() - t0) / SIM_FILTER_SCANS;
+
+  t0 = filter_cycles();
+  for (unsigned n = 0U; n < SIM_FILTER_SCANS; n++) {
+    brick_median_process(&med, sim_filter_in[n & 255U], out);
+    sink += out[n & 15U];
+  }
+  c_med = (filter_cycles() - t0) / SIM_FILTER_SCANS;
+  (void)sink;
+
+  printf("\nfilters, %u-channel scan (host %s/scan): brick_asc x8 %.0f, "
+         "ma x8 %.0f (x%.1f), ema %.0f, median5 %.0f%s\n",
+         (unsigned)SIM_FILTER_CH, SIM_HAVE_TSC_NAME, c_asc, c_ma, c_asc / c_ma,
+         c_ema, c_med, fail ? " FAIL" : "");
+  return fail;
+}
+
+/* ====================================================================== */
+/*                               SCAN HALL                                */
+/* ====================================================================== */
+
+#define SIM_SCAN_ADC_CH   (BRICK_HALL_MUX_COUNT + 1U)   /* MUXA, MUXB, POT */
+#define SIM_SCAN_FRAMES   4U
+#define SIM_SCAN_FEEDS    200000U
+
+static uint8_t sim_scan_mux_log[1U + SIM_SCAN_FRAMES * BRICK_HALL_MUX_CHANNELS];
+static unsigned sim_scan_mux_n;
+static uint8_t sim_scan_pot_ch;
+
+static void scan_mux(uint8_t ch) {
+  if (sim_scan_mux_n < sizeof(sim_scan_mux_log)) {
+    sim_scan_mux_log[sim_scan_mux_n] = ch;
+  }
+  sim_scan_mux_n++;
+}
+
+static void scan_pot_mux(uint8_t ch) {
+  sim_scan_pot_ch = ch;
+}
+
+/* Niveau établi de la voie ADC c (0 MUXA, 1 MUXB, 2 POT) en position ch. */
+static uint16_t scan_level(unsigned frame, uint8_t ch, unsigned c) {
+  return (uint16_t)(20000U * c + 1000U * ch + 10U * frame + 100U);
+}
+
+/*
+ * Demi-buffer DMA simulé d'une position de mux : les séquences
+ * d'établissement portent une valeur aberrante (à ignorer), les suivantes
+ * le niveau établi ±1 par paires (moyenne exacte).
+ */
+static void scan_half(uint16_t *half, unsigned frame, uint8_t ch) {
+  const size_t settle = hall_scan_settle_seqs();
+
+  for (size_t i = 0U; i < settle + HALL_SCAN_AVG_SEQS; i++) {
+    const size_t j = i - settle;
+    for (unsigned c = 0U; c < SIM_SCAN_ADC_CH; c++) {
+      int32_t v = 0xFFFF;
+      if (i >= settle) {
+        const bool alone = ((j & 1U) == 0U) && (j + 1U == HALL_SCAN_AVG_SEQS);
+        v = (int32_t)scan_level(frame, ch, c) + (alone ? 0 : ((j & 1U) ? 1 : -1));
+      }
+      half[i * SIM_SCAN_ADC_CH + c] = (uint16_t)v;
+    }
+  }
+}
+
+static int hall_scan_test(void) {
+  uint16_t half[(8U + HALL_SCAN_AVG_SEQS) * SIM_SCAN_ADC_CH];
+  hall_scan_frame_t f;
+  uint32_t last = 0U;
+  int fail = 0;
+
+  if (hall_scan_settle_seqs() > 8U) {
+    printf("hall scan: settle %u seqs too long for the test buffer FAIL\n",
+           (unsigned)hall_scan_settle_seqs());
+    return 1;
+  }
+
+  sim_scan_mux_n = 0U;
+  sim_scan_pot_ch = 0xFFU;
+  hall_scan_set_pot_mux(scan_pot_mux);
+  hall_scan_init(scan_mux);
+  fail += sim_scan_mux_n != 1U || sim_scan_mux_log[0] != 0U || sim_scan_pot_ch != 0U;
+  fail += hall_scan_get_frame(&f, last);
+  fail += hall_scan_wait_frame(&f, TIME_IMMEDIATE) != MSG_TIMEOUT;
+
+  for (unsigned frame = 0U; frame < SIM_SCAN_FRAMES; frame++) {
+    for (uint8_t ch = 0U; ch < BRICK_HALL_MUX_CHANNELS; ch++) {
+      /* Trame publiée seulement après la 8e position. */
+      fail += hall_scan_get_frame(&f, last);
+      scan_half(half, frame, ch);
+      hall_scan_feed_i(half, hall_scan_settle_seqs() + HALL_SCAN_AVG_SEQS);
+      fail += sim_scan_pot_ch != (uint8_t)((ch + 1U) % BRICK_HALL_MUX_CHANNELS);
+    }
+
+    fail += hall_scan_wait_frame(&f, TIME_IMMEDIATE) != MSG_OK;
+    fail += hall_scan_wait_frame(&f, TIME_IMMEDIATE) != MSG_TIMEOUT;
+    fail += f.seq != frame + 1U || !hall_scan_get_frame(&f, last);
+    last = f.seq;
+    for (uint8_t ch = 0U; ch < BRICK_HALL_MUX_CHANNELS; ch++) {
+      fail += f.raw[ch] != scan_level(frame, ch, 0U);
+      fail += f.raw[ch + BRICK_HALL_MUX_CHANNELS] != scan_level(frame, ch, 1U);
+      fail += f.pot[ch] != scan_level(frame, ch, 2U);
+      fail += (ch > 0U) && (rtcnt_t)(f.stamp[ch] - f.stamp[ch - 1U]) > (rtcnt_t)INT32_MAX;
+    }
+    fail += (rtcnt_t)(f.t_end - f.t_start) > (rtcnt_t)INT32_MAX;
+  }
+
+  /* Mux avancé d'une position par demi-buffer, retour à 0 en fin de trame. */
+  fail += sim_scan_mux_n != 1U + SIM_SCAN_FRAMES * BRICK_HALL_MUX_CHANNELS;
+  for (unsigned i = 0U; i < sim_scan_mux_n && i < sizeof(sim_scan_mux_log); i++) {
+    fail += sim_scan_mux_log[i] != i % BRICK_HALL_MUX_CHANNELS;
+  }
+
+  /* Demi-buffer plus court que l'établissement : la dernière séquence sert. */
+  scan_half(half, 0U, 0U);
+  hall_scan_init(NULL);
+  for (uint8_t ch = 0U; ch < BRICK_HALL_MUX_CHANNELS; ch++) {
+    hall_scan_feed_i(&half[(hall_scan_settle_seqs() - 1U) * SIM_SCAN_ADC_CH], 1U);
+  }
+  fail += !hall_scan_get_frame(&f, 0U) || f.raw[0] != 0xFFFFU || f.seq != 1U;
+  hall_scan_set_pot_mux(NULL);
+
+  /* Coût du callback DMA (une position de mux). */
+  scan_half(half, 0U, 0U);
+  const double t0 = filter_cycles();
+  for (unsigned n = 0U; n < SIM_SCAN_FEEDS; n++) {
+    hall_scan_feed_i(half, hall_scan_settle_seqs() + HALL_SCAN_AVG_SEQS);
+  }
+  const double c_feed = (filter_cycles() - t0) / SIM_SCAN_FEEDS;
+
+  printf("\nhall scan %u+%u seqs/position: %u frames checked, feed %.0f %s%s\n",
+         (unsigned)hall_scan_settle_seqs(), (unsigned)HALL_SCAN_AVG_SEQS,
+         (unsigned)SIM_SCAN_FRAMES, c_feed, SIM_HAVE_TSC_NAME, fail ? " FAIL" : "");
+  return fail;
+}
+
+/* ====================================================================== */
+/*                              VÉLOCITÉ HALL                             */
+/* ====================================================================== */
+
+/*
+ * Frappes rejouées dans hall_velocity (réglage nominal de drv_hall : repos
+ * 36000, course 28000, seuils 37500 / 40046, OFF 38515) : pour chaque
+ * durée de frappe, SIM_VEL_STRIKES frappes identiques à une phase de scan
+ * près et un bruit ADC de ±64. Dispersion de la vélocité au NOTE ON face à
+ * l'ancienne dérivée sur deux scans à 16 ms.
+ */
+#define SIM_VEL_RTC_HZ     400000000U
+#define SIM_VEL_FRAME_US   667U          /* trame Hall ~1,5 kHz */
+#define SIM_VEL_OLD_US     16000U        /* ancien scan */
+#define SIM_VEL_STRIKES    32U
+#define SIM_VEL_REST       36000U
+#define SIM_VEL_TRAVEL     28000U
+#define SIM_VEL_LOW        37500U
+#define SIM_VEL_ON         40046U
+#define SIM_VEL_OFF        38515U
+
+/* Course normalisée (0..1024) d'une frappe type, 16 instants réguliers. */
+static const uint16_t sim_vel_profile[17] = {
+  0U, 8U, 30U, 70U, 130U, 210U, 310U, 420U, 540U,
+  660U, 770U, 860U, 930U, 975U, 1000U, 1016U, 1024U
+};
+
+/* Valeur du capteur à t µs d'une frappe de d µs (touche maintenue après). */
+static uint16_t vel_sample(uint32_t t, uint32_t d, bool noise) {
+  uint32_t pos = 1024U;
+
+  if (t < d) {
+    const uint32_t x = t * 16U;
+    const uint32_t i = x / d;
+    const uint32_t f = x % d;
+    pos = sim_vel_profile[i] + (sim_vel_profile[i + 1U] - sim_vel_profile[i]) * f / d;
+  }
+  return (uint16_t)(SIM_VEL_REST + pos * SIM_VEL_TRAVEL / 1024U +
+                    (noise ? (uint32_t)(rand() % 129) : 64U) - 64U);
+}
+
+/* Logique de porte de drv_hall, ré-armement compris. */
+typedef struct {
+  uint16_t v;
+  rtcnt_t  t;
+  bool     gate;
+} sim_vel_key_t;
+
+static bool vel_step(sim_vel_key_t *k, uint16_t v, rtcnt_t t, uint8_t *vel) {
+  bool on = false;
+
+  hall_velocity_track(0U, 0, k->v, k->t, v, t);
+  if (!k->gate && v >= SIM_VEL_ON) {
+    k->gate = true;
+    *vel = hall_velocity_get(0U);
+    on = true;
+  } else if (k->gate && v <= SIM_VEL_OFF) {
+    k->gate = false;
+    hall_velocity_rearm(0U);
+  }
+  k->v = v;
+  k->t = t;
+  return on;
+}
+
+/* Une frappe de d µs partant de from, échantillonnée toutes les SIM_VEL_FRAME_US. */
+static uint8_t vel_strike(sim_vel_key_t *k, rtcnt_t *now, uint32_t d, uint32_t phase_us,
+                          uint16_t from) {
+  const rtcnt_t per_us = SIM_VEL_RTC_HZ / 1000000U;
+  uint8_t vel = 0U;
+
+  for (uint32_t t = phase_us; t < d + 10U * SIM_VEL_FRAME_US; t += SIM_VEL_FRAME_US) {
+    const uint16_t v = vel_sample(t, d, true);
+    (void)vel_step(k, (v > from) ? v : from, *now + t * per_us, &vel);
+  }
+  *now += (d + 10U * SIM_VEL_FRAME_US) * per_us;
+  return vel;
+}
+
+/* Ancienne estimation : dérivée entre deux scans consécutifs, dt en ms. */
+static uint8_t vel_old(uint32_t d, uint32_t phase_us) {
+  uint16_t v0 = vel_sample(0U, d, true);
+
+  for (uint32_t t = phase_us; ; t += SIM_VEL_OLD_US) {
+    const uint16_t v1 = vel_sample(t, d, true);
+    if (v1 >= SIM_VEL_ON) {
+      const uint32_t speed = (uint32_t)(v1 - v0) * 1000U / SIM_VEL_OLD_US;
+      const uint32_t v = speed * 127U / HALL_DERIV_MAX_COUNTS_PER_MS;
+      return (uint8_t)((v > 127U) ? 127U : ((v < 1U) ? 1U : v));
+    }
+    v0 = v1;
+  }
+}
+
+static void vel_release(sim_vel_key_t *k, rtcnt_t *now, uint16_t to) {
+  const rtcnt_t per_us = SIM_VEL_RTC_HZ / 1000000U;
+  uint8_t vel;
+
+  for (unsigned i = 0U; i < 20U; i++) {
+    *now += SIM_VEL_FRAME_US * per_us;
+    (void)vel_step(k, to, *now, &vel);
+  }
+}
+
+static int hall_velocity_test(void) {
+  static const uint32_t dur_ms[] = { 30U, 60U, 120U, 240U };
+  sim_vel_key_t k = { SIM_VEL_REST, 0U, false };
+  rtcnt_t now = 0U;
+  unsigned prev_mean = 128U;
+  int fail = 0;
+
+  hall_velocity_init(SIM_VEL_RTC_HZ);
+  hall_velocity_set_thresholds(SIM_VEL_LOW, SIM_VEL_ON);
+
+  printf("\nhall velocity, %u strikes per duration (frame %u us, noise +-64):\n",
+         (unsigned)SIM_VEL_STRIKES, (unsigned)SIM_VEL_FRAME_US);
+  for (size_t n = 0U; n < sizeof(dur_ms) / sizeof(dur_ms[0]); n++) {
+    const uint32_t d = dur_ms[n] * 1000U;
+    unsigned lo = 127U, hi = 0U, sum = 0U, olo = 127U, ohi = 0U;
+
+    for (unsigned s = 0U; s < SIM_VEL_STRIKES; s++) {
+      const uint8_t v = vel_strike(&k, &now, d, (uint32_t)rand() % SIM_VEL_FRAME_US, 0U);
+      const uint8_t o = vel_old(d, (uint32_t)rand() % SIM_VEL_OLD_US);
+
+      vel_release(&k, &now, SIM_VEL_REST);
+      sum += v;
+      lo = (v < lo) ? v : lo;
+      hi = (v > hi) ? v : hi;
+      olo = (o < olo) ? o : olo;
+      ohi = (o > ohi) ? o : ohi;
+    }
+
+    const unsigned mean = sum / SIM_VEL_STRIKES;
+    printf("  %3u ms: velocity %3u (%3u..%3u, spread %2u) | 16 ms derivative %3u..%3u (spread %3u)\n",
+           (unsigned)dur_ms[n], mean, lo, hi, hi - lo, olo, ohi, ohi - olo);
+    fail += (hi - lo) > 12U || (hi - lo) > (ohi - olo) || mean >= prev_mean;
+    prev_mean = mean;
+  }
+
+  /* Relâchement partiel entre seuil bas et seuil OFF : la porte se ferme
+     sans repasser sous le seuil bas, la frappe suivante est remesurée. */
+  const uint16_t partial = (uint16_t)((SIM_VEL_LOW + SIM_VEL_OFF) / 2U);
+  const uint8_t fast = vel_strike(&k, &now, 30000U, 0U, 0U);
+  vel_release(&k, &now, partial);
+  fail += k.gate;
+  const uint8_t slow = vel_strike(&k, &now, 240000U, 0U, partial);
+  vel_release(&k, &now, SIM_VEL_REST);
+  fail += slow == 0U || slow >= fast;
+  printf("  partial release: %u then %u%s\n", fast, slow, fail ? " FAIL" : "");
+  return fail;
+}
+
+/* ====================================================================== */
+/*                              CALIBRATION                               */
+/* ====================================================================== */
+
+static struct brick_cal_model sim_cal_ref;
+
+static void cal_reset(struct brick_cal_model *cal) {
+  memset(cal, 0, sizeof(*cal));
+  (void)brick_cal_pot_init(&cal->potmeter, 16U, BRICK_NUM_HALL_SENSORS);
+}
+
+/* Redémarrage : RAM perdue, flash conservée. */
+static uint8_t cal_reboot(void) {
+  brick_cal_store_stop();
+  cal_reset(&brick_cal_state);
+  return brick_cal_store_start() ? brick_cal_store_load(&brick_cal_state) : 0U;
+}
+
+static int cal_store_test(void) {
+  struct brick_cal_model *cal = &brick_cal_state;
+  uint8_t curve[BRICK_CAL_CURVE_LEN];
+  brick_cal_store_stats_t cs;
+  drv_flash_stats_t fs;
+  int fail = 0;
+
+  /* Flash vierge : formatée au montage, rien à restaurer. */
+  cal_reset(cal);
+  fail += !brick_cal_store_start();
+  fail += brick_cal_store_load(cal) != 0U;
+
+  (void)brick_cal_pot_enable_range(&cal->potmeter, 0U, 8U);
+  for (uint8_t k = 0U; k < BRICK_NUM_HALL_SENSORS; k++) {
+    (void)brick_cal_key_offset_set(&cal->key, k, (int16_t)(k * 37 - 300));
+    cal->potmeter.min[k] = (uint16_t)(1000U + k);
+    cal->potmeter.max[k] = (uint16_t)(60000U - k);
+  }
+  for (unsigned i = 0U; i < BRICK_CAL_CURVE_LEN; i++) {
+    curve[i] = (uint8_t)(i * i / 127U);
+  }
+  (void)brick_cal_key_curve_set(&cal->key, 3U, curve);
+  (void)brick_cal_key_curve_set(&cal->key, 11U, curve);
+
+  /* Première sauvegarde complète, puis seulement ce qui change. */
+  fail += brick_cal_store_save(cal) != BRICK_NUM_HALL_SENSORS;
+  fail += brick_cal_store_save(cal) != 0;
+  (void)brick_cal_key_offset_set(&cal->key, 5U, 123);
+  fail += brick_cal_store_save(cal) != 1;
+  (void)brick_cal_key_curve_set(&cal->key, 11U, NULL);
+  fail += brick_cal_store_save(cal) != 1;
+  sim_cal_ref = *cal;
+
+  fail += cal_reboot() != BRICK_NUM_HALL_SENSORS;
+  fail += memcmp(&sim_cal_ref, cal, sizeof(*cal)) != 0;
+  fail += brick_cal_store_save(cal) != 0;
+
+  /* Usure : assez de sauvegardes pour forcer le compactage MFS. */
+  const double t0 = host_us();
+  for (unsigned i = 0U; i < 2000U; i++) {
+    (void)brick_cal_key_offset_set(&cal->key, (uint8_t)(i % 4U), (int16_t)i);
+    fail += brick_cal_store_save(cal) != 1;
+  }
+  const double save_us = (host_us() - t0) / 2000.0;
+  sim_cal_ref = *cal;
+  drv_flash_get_stats(&fs);                           /* depuis le montage */
+  fail += fs.erases == 0U || fs.errors != 0U;
+
+  const double t1 = host_us();
+  fail += cal_reboot() != BRICK_NUM_HALL_SENSORS;
+  const double load_us = host_us() - t1;
+  fail += memcmp(&sim_cal_ref, cal, sizeof(*cal)) != 0;
+
+  brick_cal_store_get_stats(&cs);
+
+  /* Règle ECC : un mot flash déjà écrit (en-tête de banque) est refusé,
+     comme une écriture hors unité. */
+  brick_cal_store_stop();
+  {
+    BaseFlash *f = drv_flash_init();
+    const uint8_t b[DRV_FLASH_UNIT] = {0};
+    fail += flashProgram(f, 0U, sizeof(b), b) != FLASH_ERROR_PROGRAM &&
+            flashProgram(f, DRV_FLASH_LOGICAL_SECTOR, sizeof(b), b) != FLASH_ERROR_PROGRAM;
+    fail += flashProgram(f, DRV_FLASH_LOGICAL_SECTOR - 4U, 4U, b) != FLASH_ERROR_PROGRAM;
+  }
+
+  printf("cal store %u keys: %u writes, %u skipped, %u flash words, %u erases, "
+         "save %.1f us, boot restore %.1f us%s\n",
+         (unsigned)BRICK_NUM_HALL_SENSORS, (unsigned)cs.writes, (unsigned)cs.skipped,
+         (unsigned)fs.programs, (unsigned)fs.erases, save_us, load_us,
+         fail ? " FAIL" : "");
+  return fail;
+}
+
+/*
+ * Suivi du repos (brick_cal_rest) : 16 touches décalées de leur nominal,
+ * repos qui dérive de +3000 (échauffement) pendant la session, appuis
+ * lents réguliers. Seuils suivis face à des seuils fixes (ancien réglage
+ * 40000 / 38500) : appuis manqués, NOTE ON fantômes, touches bloquées.
+ * La dérive s'arrête au 3/4 de la session : écart final du repos suivi.
+ */
+#define SIM_REST_FRAMES   200000U
+#define SIM_REST_DRIFT    150000U
+#define SIM_REST_PERIOD   20000U
+
+/* Position d'un appui lent (0..256) : descente, maintien, remontée. */
+static uint32_t rest_press(uint32_t t) {
+  const uint32_t p = t % SIM_REST_PERIOD;
+
+  if (p < 10000U) {
+    return 0U;
+  }
+  if (p < 14000U) {
+    return (p - 10000U) * 256U / 4000U;
+  }
+  if (p < 16000U) {
+    return 256U;
+  }
+  if (p < 18000U) {
+    return (18000U - p) * 256U / 2000U;
+  }
+  return 0U;
+}
+
+static int cal_rest_test(void) {
+  static struct brick_cal_rest rest;
+  bool gate[BRICK_NUM_HALL_SENSORS] = {false};
+  bool gate_fixed[BRICK_NUM_HALL_SENSORS] = {false};
+  unsigned ons = 0U, ghosts = 0U, ons_fixed = 0U, ghosts_fixed = 0U, stuck_fixed = 0U;
+  unsigned max_err = 0U;
+  int fail = 0;
+
+  fail += brick_cal_rest_init(&rest, 36000U, 64000U, 14U, 37U, 14U) != 0;
+  fail += brick_cal_rest_init(&rest, 36000U, 64000U, 14U, 14U, 14U) == 0;
+  (void)brick_cal_rest_init(&rest, 36000U, 64000U, 14U, 37U, 14U);
+
+  const double t0 = filter_cycles();
+  for (uint32_t t = 0U; t < SIM_REST_FRAMES; t++) {
+    const uint32_t drift = ((t < SIM_REST_DRIFT) ? t : SIM_REST_DRIFT) * 3000U / SIM_REST_DRIFT;
+    const uint32_t press = rest_press(t);
+
+    for (uint8_t k = 0U; k < BRICK_NUM_HALL_SENSORS; k++) {
+      const uint32_t idle = 34500U + k * 200U + drift;
+      const uint32_t full = 60000U + k * 200U;
+      const uint16_t v = (uint16_t)(idle + (full - idle) * press / 256U +
+                                    (uint32_t)(rand() % 256));
+
+      brick_cal_rest_next(&rest, k, v, gate[k]);
+      if (!gate[k] && v >= rest.on[k]) {
+        gate[k] = true;
+        ons++;
+        ghosts += press == 0U;
+      } else if (gate[k] && v <= rest.off[k]) {
+        gate[k] = false;
+      }
+
+      if (!gate_fixed[k] && v >= 40000U) {
+        gate_fixed[k] = true;
+        ons_fixed++;
+        ghosts_fixed += press == 0U;
+      } else if (gate_fixed[k] && v <= 38500U) {
+        gate_fixed[k] = false;
+      }
+
+      if (t == SIM_REST_FRAMES - 1U) {
+        uint16_t b;
+        (void)brick_cal_rest_get(&rest, k, &b, NULL, NULL);
+        const unsigned err = (unsigned)abs((int)b - (int)(idle + 128U));
+        max_err = (err > max_err) ? err : max_err;
+        stuck_fixed += gate_fixed[k];
+      }
+    }
+  }
+  const double c_rest = (filter_cycles() - t0) /
+                        ((double)SIM_REST_FRAMES * BRICK_NUM_HALL_SENSORS);
+
+  const unsigned presses = (SIM_REST_FRAMES / SIM_REST_PERIOD) * BRICK_NUM_HALL_SENSORS;
+  fail += ons != presses || ghosts != 0U || max_err > 150U;
+
+  printf("cal rest %u keys, +3000 drift: %u/%u presses, %u ghosts, baseline err %u; "
+         "fixed thresholds %u presses, %u ghosts, %u stuck; %.0f %s/sample (incl. noise)%s\n",
+         (unsigned)BRICK_NUM_HALL_SENSORS, ons, presses, ghosts, max_err, ons_fixed,
+         ghosts_fixed, stuck_fixed, c_rest, SIM_HAVE_TSC_NAME, fail ? " FAIL" : "");
+  return fail;
+}
+
+/* ====================================================================== */
+/*                                ENTRÉES                                 */
+/* ====================================================================== */
+
+#define SIM_INPUT_SCANS   20000U
+#define SIM_INPUT_SR_BITS (((BRICK_NUM_BUTTONS + 7U) / 8U) * 8U)
+
+/* Mot que sr_read() décale depuis la chaîne : lvl[i] = i-ième bit lu. */
+static uint32_t input_sr_word(const uint8_t *lvl) {
+  uint32_t v = 0U;
+  for (uint8_t i = 0U; i < SIM_INPUT_SR_BITS; i++) {
+    v = (v << 1) | (lvl[i] & 1U);
+  }
+  return v;
+}
+
+/*
+ * Anti-rebond face à un compteur par bouton (4 lectures différentes de
+ * suite pour basculer), sur des rebonds aléatoires ; quadrature sur des
+ * tours complets dans les deux sens ; ordre de la chaîne 74HC165.
+ */
+static int input_test(void) {
+  uint32_t state = 0U, cnt0 = 0xFFFFFFFFU, cnt1 = 0xFFFFFFFFU;
+  uint32_t ref = 0U, lcg = 0x2468ACEU, toggles = 0U;
+  uint8_t run[32] = {0};
+  uint32_t bad_deb = 0U;
+  int32_t fwd = 0, rev = 0, illegal = 0;
+  uint32_t bad_sr = 0U;
+
+  /* Chaque bouton change d'état voulu de temps en temps et rebondit
+     1 à 3 lectures après chaque changement. */
+  uint32_t want = 0U, bounce = 0U;
+  for (uint32_t n = 0U; n < SIM_INPUT_SCANS; n++) {
+    lcg = lcg * 1664525U + 1013904223U;
+    if ((lcg >> 24) < 8U) {
+      const uint32_t b = 1U << ((lcg >> 8) & 31U);
+      want ^= b;
+      bounce |= b;
+    }
+    lcg = lcg * 1664525U + 1013904223U;
+    const uint32_t noise = bounce & lcg;
+    if ((n & 3U) == 3U) {
+      bounce = 0U;
+    }
+    const uint32_t sample = want ^ noise;
+
+    const uint32_t changed = input_debounce(sample, &state, &cnt0, &cnt1);
+    uint32_t expect = 0U;
+    for (uint8_t b = 0U; b < 32U; b++) {
+      if ((((sample ^ ref) >> b) & 1U) == 0U) {
+        run[b] = 0U;
+      } else if (++run[b] == INPUT_BTN_STABLE_SCANS) {
+        run[b] = 0U;
+        expect |= 1U << b;
+      }
+    }
+    ref ^= expect;
+    toggles += (uint32_t)__builtin_popcount(changed);
+    bad_deb += (changed != expect) || (state != ref);
+  }
+
+  /* Gray A << 1 | B, A en avance : 00 → 10 → 11 → 01. */
+  static const uint8_t gray[4] = { 0U, 2U, 3U, 1U };
+  for (uint8_t i = 0U; i < 4U * 25U; i++) {
+    fwd += input_quad_step(gray[i & 3U], gray[(i + 1U) & 3U]);
+    rev += input_quad_step(gray[(i + 1U) & 3U], gray[i & 3U]);
+    illegal += input_quad_step(gray[i & 3U], gray[(i + 2U) & 3U]);
+    illegal += input_quad_step(gray[i & 3U], gray[i & 3U]);
+  }
+
+  /* Un seul bouton appuyé (niveau bas) à chaque position de lecture. */
+  for (uint8_t i = 0U; i < SIM_INPUT_SR_BITS; i++) {
+    uint8_t lvl[SIM_INPUT_SR_BITS];
+    memset(lvl, INPUT_BTN_ACTIVE_LOW ? 1 : 0, sizeof(lvl));
+    lvl[i] ^= 1U;
+    const uint32_t want_btn = (i < BRICK_NUM_BUTTONS) ?
+                              (1UL << (BRICK_NUM_BUTTONS - 1U - i)) : 0U;
+    bad_sr += input_sr_buttons(input_sr_word(lvl)) != want_btn;
+  }
+
+  printf("\ninput debounce %u scans, %u toggles, %u mismatch; quadrature "
+         "%+d/%+d (illegal %d); 74HC165 %u bits, %u mismatch\n",
+         (unsigned)SIM_INPUT_SCANS, (unsigned)toggles, (unsigned)bad_deb,
+         (int)fwd, (int)rev, (int)illegal, (unsigned)SIM_INPUT_SR_BITS,
+         (unsigned)bad_sr);
+  const int fail = (bad_deb != 0U) || (toggles == 0U) ||
+                   (fwd != 100) || (rev != -100) || (illegal != 0) || (bad_sr != 0U);
+  if (fail) {
+    printf("  FAIL input\n");
+  }
+  return fail;
+}
+
+/* ====================================================================== */
+/*                                 SDRAM                                  */
+/* ====================================================================== */
+
+static uint32_t sim_sdram_src[SIM_SDRAM_WORDS];
+static uint32_t sim_sdram_dst[SIM_SDRAM_WORDS];
+static unsigned sim_sdram_cb_count;
+
+static void sim_sdram_cb(void *arg, bool ok) {
+  (void)arg;
+  if (ok) {
+    sim_sdram_cb_count++;
+  }
+}
+
+/* Octet porté par 8 symboles 4 bits (1000 = 0, 1100 = 1), MSB en premier,
+   sur deux demi-mots SPI consécutifs (haut d'abord). */
+static int leds_decode(const uint16_t *h) {
+  const uint32_t sym = ((uint32_t)h[0] << 16) | h[1];
+  int v = 0;
+  for (int bit = 7; bit >= 0; bit--) {
+    const uint32_t nib = (sym >> (bit * 4)) & 0xFU;
+    if (nib != 0x8U && nib != 0xCU) {
+      return -1;
+    }
+    v = (v << 1) | (nib == 0xCU);
+  }
+  return v;
+}
+
+static int leds_test(void) {
+  static const uint8_t rgb[3][3] = { {255, 0, 0}, {0, 128, 0}, {17, 200, 255} };
+  drv_leds_addr_stats_t st;
+  int fail = 0;
+
+  drv_leds_addr_init();
+  drv_leds_addr_set_brightness(255U);
+  for (uint8_t i = 0U; i < 3U; i++) {
+    drv_leds_addr_set(i, rgb[i][0], rgb[i][1], rgb[i][2]);
+  }
+  fail += !drv_leds_addr_render();
+  fail += drv_leds_addr_render();          /* image inchangée : rien ne part */
+  drv_leds_addr_set(0U, 255U, 0U, 0U);     /* même couleur : toujours rien */
+  fail += drv_leds_addr_render();
+
+  const uint16_t *f = drv_leds_addr_sim_frame();
+  for (uint8_t i = 0U; i < DRV_LEDS_ADDR_COUNT; i++) {
+    const uint8_t r = i < 3U ? rgb[i][0] : 0U;
+    const uint8_t g = i < 3U ? rgb[i][1] : 0U;
+    const uint8_t b = i < 3U ? rgb[i][2] : 0U;
+    fail += leds_decode(&f[i * 6U + 0U]) != (g * g + 127) / 255;
+    fail += leds_decode(&f[i * 6U + 2U]) != (r * r + 127) / 255;
+    fail += leds_decode(&f[i * 6U + 4U]) != (b * b + 127) / 255;
+  }
+  for (uint32_t w = 0U; w < DRV_LEDS_ADDR_RESET_HALFWORDS; w++) {
+    fail += f[DRV_LEDS_ADDR_COUNT * 6U + w] != 0U;
+  }
+
+  drv_leds_addr_set_brightness(64U);
+  fail += !drv_leds_addr_render();
+  fail += leds_decode(&drv_leds_addr_sim_frame()[2]) != 64;
+  drv_leds_addr_get_stats(&st);
+  fail += st.frames != 2U;
+
+  printf("\nleds %u WS2812, %u-halfword frame: %s\n", (unsigned)DRV_LEDS_ADDR_COUNT,
+         (unsigned)(DRV_LEDS_ADDR_COUNT * 6U + DRV_LEDS_ADDR_RESET_HALFWORDS),
+         fail ? "FAIL" : "ok");
+  return fail;
+}
+
+static int sdram_alloc_test(void) {
+  static const sdram_slot_t *held[SDRAM_POOL_SAMPLE_COUNT];
+  sdram_pool_stats_t ps;
+  sdram_arena_stats_t as;
+  int fail = 0;
+
+  sdram_alloc_init();
+
+  /* Pool : épuisement, emplacements disjoints, réutilisation d’un libre. */
+  for (unsigned i = 0U; i < SDRAM_POOL_SAMPLE_COUNT; i++) {
+    held[i] = sdram_pool_alloc(SDRAM_POOL_SAMPLE, SDRAM_POOL_SAMPLE_WORDS / 2U);
+    fail += held[i] == NULL;
+  }
+  fail += sdram_pool_alloc(SDRAM_POOL_SAMPLE, 1U) != NULL;
+  fail += sdram_pool_alloc(SDRAM_POOL_KIT, SDRAM_POOL_KIT_WORDS + 1U) != NULL;
+  for (unsigned i = 1U; i < SDRAM_POOL_SAMPLE_COUNT && fail == 0; i++) {
+    const uint32_t d = held[i]->word > held[i - 1U]->word ? held[i]->word - held[i - 1U]->word
+                                                          : held[i - 1U]->word - held[i]->word;
+    fail += d < SDRAM_POOL_SAMPLE_WORDS || held[i]->word >= SDRAM_ARENA_BASE_WORD;
+  }
+  sdram_pool_free(held[7]);
+  const sdram_slot_t *again = sdram_pool_alloc(SDRAM_POOL_SAMPLE, 100U);
+  fail += again == NULL || again->word != held[7]->word;
+  sdram_pool_get_stats(SDRAM_POOL_SAMPLE, &ps);
+  fail += ps.used != SDRAM_POOL_SAMPLE_COUNT || ps.high_water != SDRAM_POOL_SAMPLE_COUNT ||
+          ps.failures != 1U || ps.frag_pct != 50U;
+  for (unsigned i = 0U; i < SDRAM_POOL_SAMPLE_COUNT; i++) {
+    sdram_pool_free(i == 7U ? again : held[i]);
+  }
+  sdram_pool_get_stats(SDRAM_POOL_SAMPLE, &ps);
+  fail += ps.used != 0U;
+
+  /* Données d’un emplacement : via l’API sdram_ext uniquement. */
+  const sdram_slot_t *pat = sdram_pool_alloc(SDRAM_POOL_PATTERN, 256U);
+  sdram_ext_write_block(pat->word, sim_sdram_src, 256U);
+  sdram_ext_read_block(pat->word, sim_sdram_dst, 256U);
+  fail += memcmp(sim_sdram_dst, sim_sdram_src, 256U * 4U) != 0;
+  sdram_pool_free(pat);
+
+  /* Arène : alignement, repère, remise à zéro, refus au-delà de la fin. */
+  const uint32_t a0 = sdram_arena_alloc(3U, 0U);
+  const sdram_arena_mark_t m = sdram_arena_mark();
+  const uint32_t a1 = sdram_arena_alloc(100U, 64U);
+  fail += a0 != SDRAM_ARENA_BASE_WORD || (a1 & 63U) != 0U || a1 < a0 + 3U;
+  sdram_arena_get_stats(&as);
+  fail += as.used_words != (a1 - SDRAM_ARENA_BASE_WORD) + 100U;
+  sdram_arena_release(m);
+  fail += sdram_arena_alloc(1U, 0U) != a0 + 3U;
+  fail += sdram_arena_alloc(as.size_words, 0U) != SDRAM_ALLOC_NONE;
+  sdram_arena_reset();
+  fail += sdram_arena_alloc(as.size_words, 0U) != SDRAM_ARENA_BASE_WORD;
+  sdram_arena_get_stats(&as);
+  fail += as.failures != 1U || as.used_words != as.size_words || as.frag_pct != 0U;
+  sdram_arena_reset();
+
+  printf("sdram pools %u+%u+%u slots, arena %u KB\n",
+         (unsigned)SDRAM_POOL_PATTERN_COUNT, (unsigned)SDRAM_POOL_KIT_COUNT,
+         (unsigned)SDRAM_POOL_SAMPLE_COUNT, (unsigned)(as.size_words / 256U));
+  return fail;
+}
+
+static int sdram_test(void) {
+  const uint32_t *raw = sdram_ext_sim_raw();
+  const uint32_t a = 12345U;                          /* index quelconque */
+  const uint32_t b = a + SIM_SDRAM_WORDS + 7U;
+  const uint32_t c = b + SIM_SDRAM_WORDS + 3U;
+  int fail = 0;
+
+  sdram_ext_init();
+  for (uint32_t i = 0U; i < SIM_SDRAM_WORDS; i++) {
+    sim_sdram_src[i] = ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+  }
+
+  /* Bloc → disposition FMC (demi-mots permutés), relue mot à mot. */
+  sdram_ext_write_block(a, sim_sdram_src, SIM_SDRAM_WORDS - 5U);
+  for (uint32_t i = 0U; i < SIM_SDRAM_WORDS - 5U; i++) {
+    const uint32_t v = sim_sdram_src[i];
+    if (raw[a + i] != ((v >> 16) | (v << 16)) || sdram_ext_read32(a + i) != v) {
+      fail++;
+      break;
+    }
+  }
+
+  /* Mot à mot → bloc, puis copie SDRAM → SDRAM. */
+  for (uint32_t i = 0U; i < SIM_SDRAM_WORDS; i++) {
+    sdram_ext_write32(b + i, sim_sdram_src[i]);
+  }
+  sdram_ext_read_block(b, sim_sdram_dst, SIM_SDRAM_WORDS);
+  fail += memcmp(sim_sdram_dst, sim_sdram_src, sizeof(sim_sdram_dst)) != 0;
+  sdram_ext_copy(c, b + 1U, SIM_SDRAM_WORDS - 1U);
+  for (uint32_t i = 0U; i < SIM_SDRAM_WORDS - 1U; i++) {
+    if (sdram_ext_read32(c + i) != sim_sdram_src[i + 1U]) {
+      fail++;
+      break;
+    }
+  }
+
+  /* Bornes : rien d’écrit au-delà de la fin. */
+  sdram_ext_write_block(SDRAM_EXT_WORDS - 2U, sim_sdram_src, 3U);
+  fail += raw[SDRAM_EXT_WORDS - 2U] != 0U;
+  fail += sdram_ext_copy_async(SDRAM_EXT_WORDS - 1U, 0U, 2U, sim_sdram_cb, NULL);
+
+  /* Asynchrones : même résultat, un rappel par transfert. */
+  sim_sdram_cb_count = 0U;
+  memset(sim_sdram_dst, 0, sizeof(sim_sdram_dst));
+  fail += !sdram_ext_write_block_async(c, sim_sdram_src, SIM_SDRAM_WORDS, sim_sdram_cb, NULL);
+  fail += !sdram_ext_copy_async(a, c, SIM_SDRAM_WORDS, sim_sdram_cb, NULL);
+  fail += !sdram_ext_read_block_async(a, sim_sdram_dst, SIM_SDRAM_WORDS, sim_sdram_cb, NULL);
+  fail += memcmp(sim_sdram_dst, sim_sdram_src, sizeof(sim_sdram_dst)) != 0;
+  fail += sim_sdram_cb_count != 3U || sdram_ext_busy();
+
+  /* Débit : bloc contre boucle write32 / read32. */
+  double t0 = host_us();
+  for (unsigned n = 0U; n < SIM_SDRAM_LOOPS; n++) {
+    for (uint32_t i = 0U; i < SIM_SDRAM_WORDS; i++) {
+      sdram_ext_write32(b + i, sim_sdram_src[i]);
+    }
+    for (uint32_t i = 0U; i < SIM_SDRAM_WORDS; i++) {
+      sim_sdram_dst[i] = sdram_ext_read32(b + i);
+    }
+  }
+  const double word_us = host_us() - t0;
+  t0 = host_us();
+  for (unsigned n = 0U; n < SIM_SDRAM_LOOPS; n++) {
+    sdram_ext_write_block(b, sim_sdram_src, SIM_SDRAM_WORDS);
+    sdram_ext_read_block(b, sim_sdram_dst, SIM_SDRAM_WORDS);
+  }
+  const double block_us = host_us() - t0;
+  const double mb = 2.0 * SIM_SDRAM_LOOPS * SIM_SDRAM_WORDS * 4.0 / 1e6;
+
+  printf("\nsdram %u-word blocks: word loop %.0f MB/s, block %.0f MB/s (x%.1f)\n",
+         (unsigned)SIM_SDRAM_WORDS, mb / (word_us * 1e-6), mb / (block_us * 1e-6),
+         word_us / block_us);
+
+  fail += sdram_alloc_test();
+  if (fail != 0) {
+    printf("  FAIL sdram: %d check(s)\n", fail);
+  }
+  return fail;
+}
+
+/* ====================================================================== */
+/*                              VÉRIFICATIONS                             */
+/* ====================================================================== */
+
+static bool same_file(const char *a, const char *b) {
+  FILE *fa = fopen(a, "rb");
+  FILE *fb = fopen(b, "rb");
+  bool same = (fa != NULL) && (fb != NULL);
+
+  while (same) {
+    const int ca = fgetc(fa);
+    const int cb = fgetc(fb);
+    if (ca != cb) {
+      same = false;
+    } else if (ca == EOF) {
+      break;
+    }
+  }
+  if (fa) fclose(fa);
+  if (fb) fclose(fb);
+  return same;
+}
+
+int main(int argc, char *argv[]) {
+  const char *out_dir = (argc > 1) ? argv[1] : ".";
+  const char *ref_dir = (argc > 2) ? argv[2] : NULL;
+  static uint8_t gddram[SSD130X_SIM_PAGES * SSD130X_SIM_COLUMNS];
+  static uint8_t old_fb[SSD130X_SIM_PAGES * SSD130X_SIM_COLUMNS];
+  char path[256], ref[256];
+  int failures = 0;
+
+  halInit();
+  chSysInit();
+
+  chBSemObjectInit(&flushed, true);
+  drv_display_init();
+  drv_display_set_flush_callback(on_flush);
+  (void)chBSemWaitTimeout(&flushed, TIME_MS2I(100));
+
+  printf("%-12s %10s %10s %8s %8s %6s %6s\n",
+         "screen", "render_us", "old_us", "cmd_B", "data_B", "cmd_T", "data_T");
+
+  for (size_t i = 0U; i < sizeof(scenes) / sizeof(scenes[0]); i++) {
+    const scene_t *s = &scenes[i];
+    ssd130x_sim_stats_t st;
+
+    /* Ancien chemin pixel à pixel, s'il existe : même coût mesuré, image
+       gardée pour la comparer au rendu courant. */
+    double old_us = 0.0;
+    if (s->draw_old != NULL) {
+      const double t1 = host_us();
+      for (unsigned n = 0U; n < SIM_RENDER_LOOPS; n++) {
+        s->draw_old();
+      }
+      old_us = (host_us() - t1) / SIM_RENDER_LOOPS;
+      memcpy(old_fb, drv_display_get_buffer(), sizeof(old_fb));
+    }
+
+    /* Coût de rendu seul : passes répétées dans le buffer arrière. */
+    const double t0 = host_us();
+    for (unsigned n = 0U; n < SIM_RENDER_LOOPS; n++) {
+      s->draw();
+    }
+    const double render_us = (host_us() - t0) / SIM_RENDER_LOOPS;
+
+    if ((s->draw_old != NULL) &&
+        (memcmp(old_fb, drv_display_get_buffer(), sizeof(old_fb)) != 0)) {
+      printf("  FAIL %s: differs from the per-pixel path\n", s->name);
+      failures++;
+    }
+
+    /* Trafic SPI de la publication de cet écran. */
+    chBSemReset(&flushed, true);
+    ssd130x_sim_stats_reset();
+    drv_display_update();
+    (void)chBSemWaitTimeout(&flushed, TIME_MS2I(100));
+    ssd130x_sim_get_stats(&st);
+
+    char old_col[16] = "-";
+    if (s->draw_old != NULL) {
+      snprintf(old_col, sizeof(old_col), "%.2f", old_us);
+    }
+    printf("%-12s %10.2f %10s %8u %8u %6u %6u\n", s->name, render_us, old_col,
+           (unsigned)st.cmd_bytes, (unsigned)st.data_bytes,
+           (unsigned)st.cmd_transfers, (unsigned)st.data_transfers);
+
+    /* Le buffer arrière repart de l’image publiée : elle doit être en GDDRAM. */
+    ssd130x_sim_get_gddram(gddram);
+    if (memcmp(gddram, drv_display_get_buffer(), sizeof(gddram)) != 0) {
+      printf("  FAIL %s: GDDRAM differs from the published frame\n", s->name);
+      failures++;
+    }
+
+    snprintf(path, sizeof(path), "%s/%s.pgm", out_dir, s->name);
+    if (ssd130x_sim_dump_pgm(path, 1U) != 0) {
+      printf("  FAIL %s: cannot write %s\n", s->name, path);
+      failures++;
+    }
+    if (ref_dir != NULL) {
+      snprintf(ref, sizeof(ref), "%s/%s.pgm", ref_dir, s->name);
+      if (!same_file(path, ref)) {
+        printf("  FAIL %s: differs from %s\n", s->name, ref);
+        failures++;
+      }
+    }
+    snprintf(path, sizeof(path), "%s/%s.png", out_dir, s->name);
+    (void)ssd130x_sim_dump_png(path, SIM_SCALE);
+  }
+
+  /* Image inchangée : aucun octet ne doit partir sur le bus. */
+  {
+    ssd130x_sim_stats_t st;
+    chBSemReset(&flushed, true);
+    ssd130x_sim_stats_reset();
+    drv_display_update();
+    chThdSleepMilliseconds(20);
+    ssd130x_sim_get_stats(&st);
+    if (st.data_bytes != 0U) {
+      printf("  FAIL idle frame sent %u data bytes\n", (unsigned)st.data_bytes);
+      failures++;
+    }
+  }
+
+  failures += primitives_test();
+
+  midi_init();
+  seq_engine_init();
+  failures += seq_jitter_test();
+  failures += seq_restart_test();
+  failures += pattern_test();
+  failures += midi_usb_stress_test();
+  audio_benchmark();
+  failures += filter_test();
+  failures += hall_scan_test();
+  failures += hall_velocity_test();
+  failures += cal_store_test();
+  failures += cal_rest_test();
+  failures += input_test();
+  failures += leds_test();
+  failures += sdram_test();
+
+  printf("%s\n", failures ? "FAILED" : "OK");
+  exit(failures ? 1 : 0);
+}
@@ -0,0 +1,166 @@
+/**
+ * @file midi_sim.c
+ * @brief Sorties DIN et USB émulées pour `midi.c` (simulateur).
+ *
+ * Les threads du simulateur partagent un seul thread hôte et ne sont
+ * préemptés qu’aux points de blocage : pas de verrou sur les journaux.
+ * Les rappels « ISR » de `midi.c` sont appelés depuis le thread hôte USB.
+ *
+ * @ingroup drivers
+ */
+
+#include "ch.h"
+#include "hal.h"
+#include "midi.h"
+#include "midi_din.h"
+#include "midi_rx.h"
+#include "midi_sim.h"
+#include <string.h>
+#include <time.h>
+
+#if MIDI_SIM_USB_FRAME_TICKS < 2U
+#error "MIDI_SIM_USB_FRAME_TICKS doit valoir au moins 2 (fin de transfert, puis SOF)"
+#endif
+
+volatile bool usb_midi_tx_ready = false;
+volatile uint32_t midi_usb_rx_drops = 0;
+
+/* ====================================================================== */
+/*                                   DIN                                  */
+/* ====================================================================== */
+
+static midi_sim_msg_t    sim_log[MIDI_SIM_LOG_LEN];
+static size_t            sim_count;
+static uint32_t          sim_dropped;
+static midi_din_stats_t  sim_din_stats;
+
+double midi_sim_now_us(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec * 1e6 + (double)ts.tv_nsec / 1e3;
+}
+
+void midi_sim_reset(void) {
+  sim_count = 0U;
+  sim_dropped = 0U;
+}
+
+size_t midi_sim_count(void) {
+  return sim_count;
+}
+
+const midi_sim_msg_t *midi_sim_log(void) {
+  return sim_log;
+}
+
+uint32_t midi_sim_dropped(void) {
+  return sim_dropped;
+}
+
+void midi_din_start(SerialDriver *sdp) {
+  (void)sdp;
+}
+
+bool midi_din_send(const uint8_t *msg, size_t len) {
+  if ((msg == NULL) || (len == 0U)) {
+    return false;
+  }
+  if (sim_count >= MIDI_SIM_LOG_LEN) {
+    sim_dropped++;
+    return false;
+  }
+  sim_log[sim_count++] = (midi_sim_msg_t){ midi_sim_now_us(), msg[0],
+                                           (len > 1U) ? msg[1] : 0U,
+                                           (len > 2U) ? msg[2] : 0U };
+  return true;
+}
+
+const midi_din_stats_t *midi_din_get_stats(void) {
+  return &sim_din_stats;
+}
+
+void midi_din_stats_reset(void) {
+  memset(&sim_din_stats, 0, sizeof(sim_din_stats));
+}
+
+void midi_rx_start(void) {
+}
+
+/* ====================================================================== */
+/*                                   USB                                  */
+/* ====================================================================== */
+
+static uint8_t  usb_log[MIDI_SIM_USB_LOG_LEN][4];
+static size_t   usb_count;
+static uint32_t usb_dropped;
+static uint32_t usb_transfers;
+static bool     usb_in_flight;
+static bool     usb_host_started;
+
+static THD_WORKING_AREA(waUsbHost, 1024);
+
+/* Trame de bus : fin du transfert en cours, puis SOF en fin de trame. */
+static THD_FUNCTION(thdUsbHost, arg) {
+  (void)arg;
+#if CH_CFG_USE_REGISTRY
+  chRegSetThreadName("USB_HOST_SIM");
+#endif
+
+  while (true) {
+    chThdSleep(1);
+    if (usb_midi_tx_ready && usb_in_flight) {
+      usb_in_flight = false;
+      midi_usb_tx_done_from_isr();
+    }
+    chThdSleep(MIDI_SIM_USB_FRAME_TICKS - 1U);
+    if (usb_midi_tx_ready) {
+      midi_usb_sof_from_isr();
+    }
+  }
+}
+
+void midi_sim_usb_transmit_i(const uint8_t *buf, size_t len) {
+  usb_in_flight = true;
+  usb_transfers++;
+  for (size_t i = 0U; i + 4U <= len; i += 4U) {
+    if (usb_count >= MIDI_SIM_USB_LOG_LEN) {
+      usb_dropped++;
+      continue;
+    }
+    memcpy(usb_log[usb_count++], &buf[i], 4U);
+  }
+}
+
+void midi_sim_usb_connect(bool on) {
+  chSysLock();
+  if (on) {
+    usb_count = 0U;
+    usb_dropped = 0U;
+    usb_transfers = 0U;
+  }
+  usb_in_flight = false;
+  usb_midi_tx_ready = on;
+  midi_usb_tx_reset_i();
+  chSysUnlock();
+
+  if (on && !usb_host_started) {
+    usb_host_started = true;
+    chThdCreateStatic(waUsbHost, sizeof(waUsbHost), HIGHPRIO, thdUsbHost, NULL);
+  }
+}
+
+size_t midi_sim_usb_count(void) {
+  return usb_count;
+}
+
+const uint8_t (*midi_sim_usb_packets(void))[4] {
+  return (const uint8_t (*)[4])usb_log;
+}
+
+uint32_t midi_sim_usb_transfers(void) {
+  return usb_transfers;
+}
+
+uint32_t midi_sim_usb_dropped(void) {
+  return usb_dropped;
+}
@@ -0,0 +1,88 @@
+/**
+ * @file midi_sim.h
+ * @brief Sorties MIDI émulées pour le build hôte de `midi.c`.
+ *
+ * `midi.c` est compilé tel quel avec `SIMULATOR` ; seuls ses liens matériels
+ * sont remplacés :
+ * - **DIN** : `midi_din_send()` horodate (horloge hôte, µs) et journalise
+ *   chaque message, pour mesurer la gigue du dispatch du séquenceur face aux
+ *   dates idéales ;
+ * - **USB** : l’EP IN capture chaque paquet de 4 octets dans l’ordre
+ *   d’émission. Un thread « hôte USB » rythme le bus par trames de
+ *   `MIDI_SIM_USB_FRAME_TICKS` ticks : fin du transfert en cours au premier
+ *   tick (`midi_usb_tx_done_from_isr()`), SOF au dernier
+ *   (`midi_usb_sof_from_isr()`). Entre les deux, l’EP est libre alors qu’une
+ *   trame partielle peut attendre le SOF, comme sur la cible.
+ * - **Réception** : `midi_rx` n’est pas émulé.
+ *
+ * @ingroup drivers
+ */
+
+#ifndef MIDI_SIM_H
+#define MIDI_SIM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/* Mêmes endpoints que usbcfg.h (non compilé sans HAL USB). */
+#define MIDI_EP_OUT   1U
+#define MIDI_EP_IN    2U
+#define MIDI_EP_SIZE  64U
+
+#ifndef MIDI_SIM_LOG_LEN
+#define MIDI_SIM_LOG_LEN   32768U
+#endif
+
+#ifndef MIDI_SIM_USB_LOG_LEN
+#define MIDI_SIM_USB_LOG_LEN   16384U
+#endif
+
+#ifndef MIDI_SIM_USB_FRAME_TICKS
+#define MIDI_SIM_USB_FRAME_TICKS   2U
+#endif
+
+/** @brief Vrai quand l’hôte USB émulé est connecté (cf. usbcfg.h). */
+extern volatile bool usb_midi_tx_ready;
+
+/**
+ * @struct midi_sim_msg_t
+ * @brief Message reçu par la sortie DIN émulée.
+ */
+typedef struct {
+  double  us;         /**< Horloge hôte à l’émission */
+  uint8_t status;     /**< Octet de status (canal inclus) */
+  uint8_t d1;
+  uint8_t d2;
+} midi_sim_msg_t;
+
+/** @brief Horloge hôte monotone (µs). */
+double midi_sim_now_us(void);
+
+/** @brief Vide le journal DIN. */
+void midi_sim_reset(void);
+
+/** @brief Messages DIN journalisés (les suivants sont comptés comme perdus). */
+size_t midi_sim_count(void);
+const midi_sim_msg_t *midi_sim_log(void);
+uint32_t midi_sim_dropped(void);
+
+/**
+ * @brief Connecte (démarre l’hôte USB au premier appel) ou déconnecte l’EP IN.
+ * @note  La connexion vide la capture ; la déconnexion vide l’anneau de
+ *        `midi.c` comme un reset USB.
+ */
+void midi_sim_usb_connect(bool on);
+
+/** @brief Paquets USB-MIDI capturés, dans l’ordre d’émission. */
+size_t midi_sim_usb_count(void);
+const uint8_t (*midi_sim_usb_packets(void))[4];
+
+/** @brief Transferts EP IN démarrés et paquets perdus faute de place. */
+uint32_t midi_sim_usb_transfers(void);
+uint32_t midi_sim_usb_dropped(void);
+
+/** @brief EP IN : appelé par `midi.c` à la place de `usbStartTransmitI()`. */
+void midi_sim_usb_transmit_i(const uint8_t *buf, size_t len);
+
+#endif /* MIDI_SIM_H */
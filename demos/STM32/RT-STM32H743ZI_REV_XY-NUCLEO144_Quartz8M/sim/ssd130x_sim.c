@@ -0,0 +1,364 @@
+/**
+ * @file ssd130x_sim.c
+ * @brief SSD130x émulé : parseur de commandes, GDDRAM et export d’images.
+ *
+ * Les écritures viennent du thread d’affichage, les lectures du programme
+ * de test : l’état est protégé par le verrou système.
+ *
+ * @ingroup drivers
+ */
+
+#include "ch.h"
+#include "ssd130x_sim.h"
+#include <stdio.h>
+#include <string.h>
+
+#define GDDRAM_SIZE   (SSD130X_SIM_PAGES * SSD130X_SIM_COLUMNS)
+
+/* ====================================================================== */
+/*                                 ÉTAT                                   */
+/* ====================================================================== */
+
+typedef enum {
+  ADDR_HORIZONTAL = 0,
+  ADDR_VERTICAL   = 1,
+  ADDR_PAGE       = 2
+} addr_mode_t;
+
+static uint8_t gddram[GDDRAM_SIZE];
+
+static addr_mode_t mode;
+static uint8_t col, col_start, col_end;
+static uint8_t page, page_start, page_end;
+static bool    inverse;
+static bool    display_on;
+
+/* Commande en cours de réception (arguments manquants). */
+static uint8_t cmd_buf[8];
+static uint8_t cmd_len;
+static uint8_t cmd_need;
+
+static ssd130x_sim_stats_t stats;
+
+/* ====================================================================== */
+/*                               COMMANDES                                */
+/* ====================================================================== */
+
+/* Nombre d’arguments attendus après l’octet de commande. */
+static uint8_t cmd_args(uint8_t c) {
+  switch (c) {
+    case 0x20: case 0x81: case 0x8D: case 0xA8: case 0xD3:
+    case 0xD5: case 0xD9: case 0xDA: case 0xDB: case 0xFD:
+      return 1U;
+    case 0x21: case 0x22: case 0xA3:
+      return 2U;
+    case 0x29: case 0x2A:
+      return 5U;
+    case 0x26: case 0x27:
+      return 6U;
+    default:
+      return 0U;
+  }
+}
+
+static void cmd_exec(const uint8_t *c) {
+  switch (c[0]) {
+    case 0x20:
+      mode = (addr_mode_t)((c[1] & 0x03U) == 3U ? ADDR_PAGE : (c[1] & 0x03U));
+      return;
+
+    case 0x21:  /* fenêtre colonnes : modes horizontal / vertical seulement */
+      if (mode != ADDR_PAGE) {
+        col_start = (uint8_t)(c[1] & 0x7FU);
+        col_end   = (uint8_t)(c[2] & 0x7FU);
+        col = col_start;
+      }
+      return;
+
+    case 0x22:
+      if (mode != ADDR_PAGE) {
+        page_start = (uint8_t)(c[1] & 0x07U);
+        page_end   = (uint8_t)(c[2] & 0x07U);
+        page = page_start;
+      }
+      return;
+
+    case 0xA6: inverse = false;    return;
+    case 0xA7: inverse = true;     return;
+    case 0xAE: display_on = false; return;
+    case 0xAF: display_on = true;  return;
+
+    default:
+      break;
+  }
+
+  /* Adressage page : page 0xB0–0xB7, colonne en deux quartets. */
+  if (mode == ADDR_PAGE) {
+    if ((c[0] & 0xF8U) == 0xB0U) {
+      page = (uint8_t)(c[0] & 0x07U);
+    } else if (c[0] <= 0x0FU) {
+      col = (uint8_t)((col & 0xF0U) | c[0]);
+      col_start = col;
+    } else if (c[0] <= 0x1FU) {
+      col = (uint8_t)(((c[0] & 0x07U) << 4) | (col & 0x0FU));
+      col_start = col;
+    }
+  }
+  /* Autres commandes (contraste, multiplex, remap…) : sans effet sur la RAM. */
+}
+
+static void cmd_byte(uint8_t b) {
+  if (cmd_len == 0U) {
+    cmd_need = cmd_args(b);
+  }
+  cmd_buf[cmd_len++] = b;
+
+  if (cmd_len > cmd_need) {
+    cmd_exec(cmd_buf);
+    cmd_len = 0U;
+  }
+}
+
+/* ====================================================================== */
+/*                                DONNÉES                                 */
+/* ====================================================================== */
+
+static void data_byte(uint8_t b) {
+  gddram[(size_t)page * SSD130X_SIM_COLUMNS + col] = b;
+
+  switch (mode) {
+    case ADDR_HORIZONTAL:
+      if (col++ >= col_end) {
+        col = col_start;
+        page = (page >= page_end) ? page_start : (uint8_t)(page + 1U);
+      }
+      break;
+
+    case ADDR_VERTICAL:
+      if (page++ >= page_end) {
+        page = page_start;
+        col = (col >= col_end) ? col_start : (uint8_t)(col + 1U);
+      }
+      break;
+
+    default:  /* page : la colonne reboucle, la page ne change pas */
+      if (col++ >= SSD130X_SIM_COLUMNS - 1U) {
+        col = col_start;
+      }
+      break;
+  }
+}
+
+/* ====================================================================== */
+/*                                  API                                   */
+/* ====================================================================== */
+
+void ssd130x_sim_reset(void) {
+  chSysLock();
+  memset(gddram, 0, sizeof(gddram));
+  mode = ADDR_PAGE;                 /* valeur au reset du SSD130x */
+  col = col_start = 0U;
+  col_end = SSD130X_SIM_COLUMNS - 1U;
+  page = page_start = 0U;
+  page_end = SSD130X_SIM_PAGES - 1U;
+  inverse = false;
+  display_on = false;
+  cmd_len = 0U;
+  cmd_need = 0U;
+  stats = (ssd130x_sim_stats_t){0};
+  chSysUnlock();
+}
+
+void ssd130x_sim_write(bool data, const uint8_t *buf, size_t len) {
+  chSysLock();
+  if (data) {
+    stats.data_transfers++;
+    stats.data_bytes += (uint32_t)len;
+    for (size_t i = 0U; i < len; i++) {
+      data_byte(buf[i]);
+    }
+  } else {
+    stats.cmd_transfers++;
+    stats.cmd_bytes += (uint32_t)len;
+    for (size_t i = 0U; i < len; i++) {
+      cmd_byte(buf[i]);
+    }
+  }
+  chSysUnlock();
+}
+
+void ssd130x_sim_get_gddram(uint8_t out[SSD130X_SIM_PAGES * SSD130X_SIM_COLUMNS]) {
+  chSysLock();
+  memcpy(out, gddram, GDDRAM_SIZE);
+  chSysUnlock();
+}
+
+void ssd130x_sim_get_stats(ssd130x_sim_stats_t *s) {
+  chSysLock();
+  *s = stats;
+  chSysUnlock();
+}
+
+void ssd130x_sim_stats_reset(void) {
+  chSysLock();
+  stats = (ssd130x_sim_stats_t){0};
+  chSysUnlock();
+}
+
+/* ====================================================================== */
+/*                                EXPORT                                  */
+/* ====================================================================== */
+
+/* Image visible en niveaux de gris (0 / 255), une ligne après l’autre. */
+static void render_gray(uint8_t img[SSD130X_SIM_HEIGHT][SSD130X_SIM_COLUMNS]) {
+  uint8_t ram[GDDRAM_SIZE];
+  bool inv, on;
+
+  chSysLock();
+  memcpy(ram, gddram, GDDRAM_SIZE);
+  inv = inverse;
+  on = display_on;
+  chSysUnlock();
+
+  for (unsigned y = 0U; y < SSD130X_SIM_HEIGHT; y++) {
+    for (unsigned x = 0U; x < SSD130X_SIM_COLUMNS; x++) {
+      bool px = ((ram[(y >> 3) * SSD130X_SIM_COLUMNS + x] >> (y & 7U)) & 1U) != 0U;
+      img[y][x] = (on && (px != inv)) ? 255U : 0U;
+    }
+  }
+}
+
+int ssd130x_sim_dump_pgm(const char *path, unsigned scale) {
+  static uint8_t img[SSD130X_SIM_HEIGHT][SSD130X_SIM_COLUMNS];
+  FILE *f = fopen(path, "wb");
+
+  if (f == NULL) {
+    return -1;
+  }
+  if (scale == 0U) {
+    scale = 1U;
+  }
+
+  render_gray(img);
+  fprintf(f, "P5\n%u %u\n255\n",
+          SSD130X_SIM_COLUMNS * scale, SSD130X_SIM_HEIGHT * scale);
+  for (unsigned y = 0U; y < SSD130X_SIM_HEIGHT * scale; y++) {
+    for (unsigned x = 0U; x < SSD130X_SIM_COLUMNS * scale; x++) {
+      fputc(img[y / scale][x / scale], f);
+    }
+  }
+  return (fclose(f) == 0) ? 0 : -1;
+}
+
+/* PNG minimal : niveaux de gris 8 bits, deflate en blocs non compressés. */
+
+static uint32_t png_crc_table[256];
+
+static uint32_t png_crc(uint32_t crc, const uint8_t *p, size_t n) {
+  if (png_crc_table[1] == 0U) {
+    for (uint32_t i = 0U; i < 256U; i++) {
+      uint32_t c = i;
+      for (int k = 0; k < 8; k++) {
+        c = (c & 1U) ? (0xEDB88320U ^ (c >> 1)) : (c >> 1);
+      }
+      png_crc_table[i] = c;
+    }
+  }
+  for (size_t i = 0U; i < n; i++) {
+    crc = png_crc_table[(crc ^ p[i]) & 0xFFU] ^ (crc >> 8);
+  }
+  return crc;
+}
+
+static void put_be32(uint8_t *p, uint32_t v) {
+  p[0] = (uint8_t)(v >> 24); p[1] = (uint8_t)(v >> 16);
+  p[2] = (uint8_t)(v >> 8);  p[3] = (uint8_t)v;
+}
+
+static void png_chunk(FILE *f, const char *type, const uint8_t *data, size_t len) {
+  uint8_t hdr[8];
+  uint8_t crc_be[4];
+
+  put_be32(hdr, (uint32_t)len);
+  memcpy(&hdr[4], type, 4);
+  uint32_t crc = png_crc(0xFFFFFFFFU, &hdr[4], 4);
+  crc = png_crc(crc, data, len) ^ 0xFFFFFFFFU;
+  put_be32(crc_be, crc);
+
+  fwrite(hdr, 1, sizeof(hdr), f);
+  fwrite(data, 1, len, f);
+  fwrite(crc_be, 1, sizeof(crc_be), f);
+}
+
+#define PNG_MAX_SCALE  8U
+#define PNG_MAX_RAW    ((SSD130X_SIM_COLUMNS * PNG_MAX_SCALE + 1U) * \
+                        SSD130X_SIM_HEIGHT * PNG_MAX_SCALE)
+
+int ssd130x_sim_dump_png(const char *path, unsigned scale) {
+  static uint8_t img[SSD130X_SIM_HEIGHT][SSD130X_SIM_COLUMNS];
+  static uint8_t raw[PNG_MAX_RAW];
+  static uint8_t zdata[2U + PNG_MAX_RAW + 5U * (PNG_MAX_RAW / 65535U + 1U) + 4U];
+
+  if (scale == 0U) {
+    scale = 1U;
+  }
+  if (scale > PNG_MAX_SCALE) {
+    scale = PNG_MAX_SCALE;
+  }
+
+  const uint32_t w = SSD130X_SIM_COLUMNS * scale;
+  const uint32_t h = SSD130X_SIM_HEIGHT * scale;
+  size_t rn = 0U;
+
+  render_gray(img);
+  for (uint32_t y = 0U; y < h; y++) {
+    raw[rn++] = 0U;  /* filtre None */
+    for (uint32_t x = 0U; x < w; x++) {
+      raw[rn++] = img[y / scale][x / scale];
+    }
+  }
+
+  /* zlib : en-tête, blocs "stored" de 65535 octets max, Adler-32. */
+  size_t zn = 0U;
+  uint32_t a = 1U, b = 0U;
+  zdata[zn++] = 0x78U;
+  zdata[zn++] = 0x01U;
+  for (size_t off = 0U; off < rn; ) {
+    const size_t n = (rn - off > 65535U) ? 65535U : rn - off;
+    zdata[zn++] = (off + n == rn) ? 1U : 0U;
+    zdata[zn++] = (uint8_t)n;
+    zdata[zn++] = (uint8_t)(n >> 8);
+    zdata[zn++] = (uint8_t)~n;
+    zdata[zn++] = (uint8_t)(~n >> 8);
+    memcpy(&zdata[zn], &raw[off], n);
+    for (size_t i = 0U; i < n; i++) {
+      a = (a + raw[off + i]) % 65521U;
+      b = (b + a) % 65521U;
+    }
+    zn += n;
+    off += n;
+  }
+  put_be32(&zdata[zn], (b << 16) | a);
+  zn += 4U;
+
+  FILE *f = fopen(path, "wb");
+  if (f == NULL) {
+    return -1;
+  }
+
+  static const uint8_t sig[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+  uint8_t ihdr[13];
+  put_be32(&ihdr[0], w);
+  put_be32(&ihdr[4], h);
+  ihdr[8]  = 8U;   /* profondeur */
+  ihdr[9]  = 0U;   /* niveaux de gris */
+  ihdr[10] = 0U;
+  ihdr[11] = 0U;
+  ihdr[12] = 0U;
+
+  fwrite(sig, 1, sizeof(sig), f);
+  png_chunk(f, "IHDR", ihdr, sizeof(ihdr));
+  png_chunk(f, "IDAT", zdata, zn);
+  png_chunk(f, "IEND", NULL, 0U);
+  return (fclose(f) == 0) ? 0 : -1;
+}
@@ -0,0 +1,65 @@
+/**
+ * @file ssd130x_sim.h
+ * @brief Contrôleur SSD130x émulé pour le build hôte de `drv_display`.
+ *
+ * Remplace le lien SPI quand `drv_display.c` est compilé avec `SIMULATOR`
+ * (RT-Posix-Simulator). Les octets reçus sont interprétés comme par le
+ * contrôleur réel :
+ * - commandes à arguments, y compris réparties sur plusieurs transferts ;
+ * - modes d’adressage 0x20 (horizontal, vertical, page) ;
+ * - pointeurs colonne/page, fenêtres 0x21 / 0x22, 0xB0–0xB7 et 0x00–0x1F ;
+ * - GDDRAM 128 × 8 pages, inversion (0xA6/0xA7) et display ON/OFF.
+ *
+ * Chaque transfert est compté (octets commande/données, appels) pour
+ * mesurer le coût SPI d’une image.
+ *
+ * @ingroup drivers
+ */
+
+#ifndef SSD130X_SIM_H
+#define SSD130X_SIM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define SSD130X_SIM_COLUMNS   128U
+#define SSD130X_SIM_PAGES     8U
+#define SSD130X_SIM_HEIGHT    (SSD130X_SIM_PAGES * 8U)
+
+/**
+ * @struct ssd130x_sim_stats_t
+ * @brief Trafic SPI reçu par le contrôleur émulé.
+ */
+typedef struct {
+  uint32_t cmd_bytes;       /**< Octets reçus avec D/C = commande */
+  uint32_t data_bytes;      /**< Octets écrits en GDDRAM */
+  uint32_t cmd_transfers;   /**< Transferts (CS bas → haut) de commandes */
+  uint32_t data_transfers;  /**< Transferts de données */
+} ssd130x_sim_stats_t;
+
+/** @brief Reset matériel : GDDRAM à zéro, registres par défaut, stats à zéro. */
+void ssd130x_sim_reset(void);
+
+/**
+ * @brief Un transfert SPI complet.
+ * @param data true si D/C = données (écriture GDDRAM), false pour des commandes.
+ */
+void ssd130x_sim_write(bool data, const uint8_t *buf, size_t len);
+
+/** @brief Copie de la GDDRAM (page-major, 128 octets par page, bit0 = haut). */
+void ssd130x_sim_get_gddram(uint8_t out[SSD130X_SIM_PAGES * SSD130X_SIM_COLUMNS]);
+
+/** @brief Trafic cumulé depuis le dernier ssd130x_sim_stats_reset(). */
+void ssd130x_sim_get_stats(ssd130x_sim_stats_t *stats);
+void ssd130x_sim_stats_reset(void);
+
+/**
+ * @brief Écrit l’image visible (inversion et ON/OFF appliqués).
+ * @param scale Agrandissement entier (1 = 128 × 64).
+ * @return 0 si le fichier a été écrit, -1 sinon.
+ */
+int ssd130x_sim_dump_pgm(const char *path, unsigned scale);
+int ssd130x_sim_dump_png(const char *path, unsigned scale);
+
+#endif /* SSD130X_SIM_H */
@@ -13,15 +13,16 @@
  *
  * ## Notes d’implémentation :
  * - La police 5x7 est stockée directement sous forme de 5 colonnes par caractère.
- * - La police 4x6 est compressée (3 octets par glyphe) et est décompressée à la
- *   volée dans `font4x6_expanded` (lazy-init via `expand_font4x6()`).
+ * - La police 4x6 est compressée (3 octets par glyphe) ; ses colonnes sont
+ *   précompilées dans `font4x6_cols` (plus de décompression en RAM).
+ * - Chaque police expose aussi son atlas de colonnes (`atlas`/`stride`),
+ *   lu directement par le blitter de `drv_display`.
  */
 
 #include "font.h"
 #include "font5x7.h"
 #include "font4x6.h"
 #include "font5x8_elektron.h"
-#include <stdbool.h>
 
 /* =======================================================================
    Helpers GET_COL pour chaque police
@@ -41,49 +42,12 @@ static uint8_t get_col_5x7(char c, uint8_t col) {
 }
 
 /* -----------------------------------------------------------------------
-   4x6 : packée sur 3 octets par glyphe (cf. README police)
-   - Chaque byte encode 2 lignes de 4 colonnes.
-   - Ligne paire   → nibble haut (>>4)
-   - Ligne impaire → nibble bas (&0x0F)
-   - Dans un nibble : LSB = col0 (pixel gauche)
+   4x6 : la table source est packée sur 3 octets par glyphe (cf. README
+   police) ; ses colonnes sont précompilées dans `font4x6_cols`.
    ----------------------------------------------------------------------- */
 
-/** @internal Table décompressée : 95 glyphes (32..126), 4 colonnes chacune. */
-static uint8_t font4x6_expanded[95][4];
-static bool font4x6_ready = false;
-/* Colonne Elektron: on expose 5 colonnes "dessin" (0..4) ; la 6e est l'espace (gérée via spacing) */
-static uint8_t get_col_5x8_elektron(char c, uint8_t col) {
-    if ((uint8_t)c < FONT5X8_FIRST_CHAR || (uint8_t)c >= FONT5X8_LAST_CHAR) return 0;
-    if (col >= 5) return 0; /* width logique = 5 */
-    return font5x8_elektron[(uint8_t)c - FONT5X8_FIRST_CHAR][col];
-}
-
-/**
- * @brief Décompresse la table `font4x6` en RAM pour accès direct colonne/ligne.
- *
- * Appelée automatiquement au premier accès (`lazy init`).
- */
-static void expand_font4x6(void) {
-    for (int c = 32; c <= 126; c++) {
-        const uint8_t *g = font4x6[c];  // 3 octets = 6 lignes
-        for (uint8_t row = 0; row < 6; row++) {
-            uint8_t byte   = g[row >> 1]; // 0..2
-            uint8_t nibble = (row & 1)
-                ? (byte & 0x0F)   // ligne impaire
-                : (byte >> 4);    // ligne paire
-
-            for (uint8_t col = 0; col < 4; col++) {
-                uint8_t bit = (nibble >> col) & 1U;
-                if (bit)
-                    font4x6_expanded[c - 32][col] |= (1U << row);
-            }
-        }
-    }
-    font4x6_ready = true;
-}
-
 /**
- * @brief Retourne une colonne de la police 4x6 (décompressée à la volée).
+ * @brief Retourne une colonne de la police 4x6.
  *
  * @param c   Caractère ASCII (32..126)
  * @param col Index de colonne (0..3)
@@ -92,8 +56,14 @@ static void expand_font4x6(void) {
 static uint8_t get_col_4x6(char c, uint8_t col) {
     if (c < 32 || c > 126) return 0;
     if (col >= 4) return 0;
-    if (!font4x6_ready) expand_font4x6(); // lazy init
-    return font4x6_expanded[(uint8_t)c - 32][col];
+    return font4x6_cols[(uint8_t)c - 32][col];
+}
+
+/* Colonne Elektron: on expose 5 colonnes "dessin" (0..4) ; la 6e est l'espace (gérée via spacing) */
+static uint8_t get_col_5x8_elektron(char c, uint8_t col) {
+    if ((uint8_t)c < FONT5X8_FIRST_CHAR || (uint8_t)c >= FONT5X8_LAST_CHAR) return 0;
+    if (col >= 5) return 0; /* width logique = 5 */
+    return font5x8_elektron[(uint8_t)c - FONT5X8_FIRST_CHAR][col];
 }
 
 /* =======================================================================
@@ -108,6 +78,8 @@ const font_t FONT_5X7 = {
     .first    = 32,
     .last     = 126,
     .get_col  = get_col_5x7,
+    .atlas    = &font5x7[0][0],
+    .stride   = 5,
     .spacing  = 1
 };
 
@@ -119,6 +91,8 @@ const font_t FONT_4X6 = {
     .first    = 32,
     .last     = 126,
     .get_col  = get_col_4x6,
+    .atlas    = &font4x6_cols[0][0],
+    .stride   = 4,
     .spacing  = 0
 };
 
@@ -130,5 +104,7 @@ const font_t FONT_5X8_ELEKTRON = {
     .first   = FONT5X8_FIRST_CHAR,
     .last    = FONT5X8_LAST_CHAR,
     .spacing = 1,
-    .get_col = get_col_5x8_elektron
+    .get_col = get_col_5x8_elektron,
+    .atlas   = &font5x8_elektron[0][0],
+    .stride  = 6
 };
@@ -11,6 +11,11 @@
  * représentant une colonne de pixels d’un caractère donné.
  * Le moteur de rendu se charge ensuite de dessiner ces bits sur l’écran.
  *
+ * Les polices peuvent aussi exposer un **atlas** : leurs colonnes déjà au
+ * format page du SSD130x, que le blitter de `drv_display` décale et combine
+ * (OR) directement dans une ou deux pages du framebuffer, sans passer par
+ * `get_col()` ni par des écritures pixel par pixel.
+ *
  * ## Convention binaire
  * - `bit0` = pixel du haut
  * - `bit(height-1)` = pixel du bas
@@ -47,6 +52,14 @@ typedef struct font_s {
      * @return Octet contenant les bits de la colonne (bit0 = pixel haut).
      */
     uint8_t (*get_col)(char c, uint8_t col);
+    /**
+     * @brief Atlas de colonnes précompilées (optionnel, NULL sinon).
+     *
+     * Glyphes consécutifs à partir de `first`, `stride` octets par glyphe,
+     * un octet par colonne (bit0 = pixel haut), de `first` à `last` inclus.
+     */
+    const uint8_t *atlas;
+    uint8_t stride;     /**< Octets par glyphe dans `atlas` (>= width). */
 } font_t;
 
 /**
@@ -57,9 +70,10 @@ typedef struct font_s {
 extern const font_t FONT_5X7;
 
 /**
- * @brief Police compacte 4x6 (format packé, décompressée à la volée).
+ * @brief Police compacte 4x6.
  *
- * Basée sur `font4x6[][3]`, couvre les caractères ASCII 32 à 126.
+ * Basée sur `font4x6_cols[95][4]` (précompilée depuis `font4x6[][3]`),
+ * couvre les caractères ASCII 32 à 126.
  */
 extern const font_t FONT_4X6;
 extern const font_t FONT_5X8_ELEKTRON;
@@ -168,3 +168,107 @@ const uint8_t font4x6[][3] = {
     { 0x03, 0x60, 0x00 }, // U+007e (~)
     { 0x00, 0x00, 0x00 }  // U+007f
 };
+
+/**
+ * @brief Atlas 4x6 précompilé : 4 colonnes par glyphe, format page SSD130x.
+ *
+ * Généré hors ligne à partir de `font4x6` (ASCII 32 à 126) ; bit0 = pixel
+ * du haut. Remplace l’ancienne décompression paresseuse en RAM.
+ */
+const uint8_t font4x6_cols[95][4] = {
+    { 0x00, 0x00, 0x00, 0x00 }, // U+0020 (space)
+    { 0x00, 0x17, 0x00, 0x00 }, // U+0021 (!)
+    { 0x03, 0x00, 0x03, 0x00 }, // U+0022 (")
+    { 0x1F, 0x0A, 0x1F, 0x00 }, // U+0023 (#)
+    { 0x0A, 0x1F, 0x0D, 0x00 }, // U+0024 ($)
+    { 0x19, 0x04, 0x13, 0x00 }, // U+0025 (%)
+    { 0x0A, 0x17, 0x1D, 0x00 }, // U+0026 (&)
+    { 0x00, 0x03, 0x00, 0x00 }, // U+0027 (')
+    { 0x0E, 0x11, 0x00, 0x00 }, // U+0028 (()
+    { 0x00, 0x11, 0x0E, 0x00 }, // U+0029 ())
+    { 0x05, 0x02, 0x05, 0x00 }, // U+002a (*)
+    { 0x04, 0x0E, 0x04, 0x00 }, // U+002b (+)
+    { 0x20, 0x10, 0x00, 0x00 }, // U+002c (,)
+    { 0x04, 0x04, 0x04, 0x00 }, // U+002d (-)
+    { 0x10, 0x00, 0x00, 0x00 }, // U+002e (.)
+    { 0x18, 0x04, 0x03, 0x00 }, // U+002f (/)
+    { 0x1F, 0x11, 0x1F, 0x00 }, // U+0030 (0)
+    { 0x11, 0x1F, 0x10, 0x00 }, // U+0031 (1)
+    { 0x1D, 0x15, 0x17, 0x00 }, // U+0032 (2)
+    { 0x15, 0x15, 0x1F, 0x00 }, // U+0033 (3)
+    { 0x07, 0x04, 0x1F, 0x00 }, // U+0034 (4)
+    { 0x17, 0x15, 0x1D, 0x00 }, // U+0035 (5)
+    { 0x1F, 0x15, 0x1D, 0x00 }, // U+0036 (6)
+    { 0x01, 0x01, 0x1F, 0x00 }, // U+0037 (7)
+    { 0x1F, 0x15, 0x1F, 0x00 }, // U+0038 (8)
+    { 0x17, 0x15, 0x1F, 0x00 }, // U+0039 (9)
+    { 0x00, 0x14, 0x00, 0x00 }, // U+003a (:)
+    { 0x20, 0x14, 0x00, 0x00 }, // U+003b (;)
+    { 0x04, 0x0A, 0x11, 0x00 }, // U+003c (<)
+    { 0x0A, 0x0A, 0x0A, 0x00 }, // U+003d (=)
+    { 0x11, 0x0A, 0x04, 0x00 }, // U+003e (>)
+    { 0x01, 0x15, 0x07, 0x00 }, // U+003f (?)
+    { 0x0E, 0x11, 0x16, 0x00 }, // U+0040 (@)
+    { 0x1E, 0x05, 0x1E, 0x00 }, // U+0041 (A)
+    { 0x1F, 0x15, 0x0A, 0x00 }, // U+0042 (B)
+    { 0x0E, 0x11, 0x11, 0x00 }, // U+0043 (C)
+    { 0x1F, 0x11, 0x0E, 0x00 }, // U+0044 (D)
+    { 0x1F, 0x15, 0x11, 0x00 }, // U+0045 (E)
+    { 0x1F, 0x05, 0x01, 0x00 }, // U+0046 (F)
+    { 0x0E, 0x11, 0x1D, 0x00 }, // U+0047 (G)
+    { 0x1F, 0x04, 0x1F, 0x00 }, // U+0048 (H)
+    { 0x11, 0x1F, 0x11, 0x00 }, // U+0049 (I)
+    { 0x08, 0x10, 0x0F, 0x00 }, // U+004a (J)
+    { 0x1F, 0x04, 0x1B, 0x00 }, // U+004b (K)
+    { 0x1F, 0x10, 0x10, 0x00 }, // U+004c (L)
+    { 0x1F, 0x06, 0x1F, 0x00 }, // U+004d (M)
+    { 0x1F, 0x01, 0x1F, 0x00 }, // U+004e (N)
+    { 0x0E, 0x11, 0x0E, 0x00 }, // U+004f (O)
+    { 0x1F, 0x05, 0x07, 0x00 }, // U+0050 (P)
+    { 0x0E, 0x19, 0x17, 0x00 }, // U+0051 (Q)
+    { 0x1F, 0x05, 0x1A, 0x00 }, // U+0052 (R)
+    { 0x16, 0x15, 0x0D, 0x00 }, // U+0053 (S)
+    { 0x01, 0x1F, 0x01, 0x00 }, // U+0054 (T)
+    { 0x1F, 0x10, 0x1F, 0x00 }, // U+0055 (U)
+    { 0x07, 0x18, 0x07, 0x00 }, // U+0056 (V)
+    { 0x1F, 0x0C, 0x1F, 0x00 }, // U+0057 (W)
+    { 0x1B, 0x04, 0x1B, 0x00 }, // U+0058 (X)
+    { 0x03, 0x1C, 0x03, 0x00 }, // U+0059 (Y)
+    { 0x19, 0x15, 0x13, 0x00 }, // U+005a (Z)
+    { 0x00, 0x1F, 0x11, 0x00 }, // U+005b ([)
+    { 0x03, 0x04, 0x18, 0x00 }, // U+005c (\)
+    { 0x11, 0x1F, 0x00, 0x00 }, // U+005d (])
+    { 0x02, 0x01, 0x02, 0x00 }, // U+005e (^)
+    { 0x10, 0x10, 0x10, 0x00 }, // U+005f (_)
+    { 0x01, 0x02, 0x00, 0x00 }, // U+0060 (`)
+    { 0x0C, 0x12, 0x1E, 0x00 }, // U+0061 (a)
+    { 0x1F, 0x12, 0x0C, 0x00 }, // U+0062 (b)
+    { 0x0C, 0x12, 0x12, 0x00 }, // U+0063 (c)
+    { 0x0C, 0x12, 0x1F, 0x00 }, // U+0064 (d)
+    { 0x0C, 0x1A, 0x14, 0x00 }, // U+0065 (e)
+    { 0x04, 0x1E, 0x05, 0x00 }, // U+0066 (f)
+    { 0x04, 0x2A, 0x1C, 0x00 }, // U+0067 (g)
+    { 0x1F, 0x04, 0x18, 0x00 }, // U+0068 (h)
+    { 0x00, 0x1A, 0x00, 0x00 }, // U+0069 (i)
+    { 0x20, 0x1A, 0x00, 0x00 }, // U+006a (j)
+    { 0x1F, 0x04, 0x1A, 0x00 }, // U+006b (k)
+    { 0x00, 0x0F, 0x10, 0x00 }, // U+006c (l)
+    { 0x1E, 0x04, 0x1E, 0x00 }, // U+006d (m)
+    { 0x1E, 0x02, 0x1C, 0x00 }, // U+006e (n)
+    { 0x0C, 0x12, 0x0C, 0x00 }, // U+006f (o)
+    { 0x3E, 0x12, 0x0C, 0x00 }, // U+0070 (p)
+    { 0x0C, 0x12, 0x3E, 0x00 }, // U+0071 (q)
+    { 0x1C, 0x02, 0x04, 0x00 }, // U+0072 (r)
+    { 0x14, 0x12, 0x0A, 0x00 }, // U+0073 (s)
+    { 0x02, 0x0F, 0x12, 0x00 }, // U+0074 (t)
+    { 0x0E, 0x10, 0x1E, 0x00 }, // U+0075 (u)
+    { 0x06, 0x18, 0x06, 0x00 }, // U+0076 (v)
+    { 0x1E, 0x08, 0x1E, 0x00 }, // U+0077 (w)
+    { 0x12, 0x0C, 0x12, 0x00 }, // U+0078 (x)
+    { 0x06, 0x28, 0x1E, 0x00 }, // U+0079 (y)
+    { 0x1A, 0x12, 0x16, 0x00 }, // U+007a (z)
+    { 0x04, 0x1B, 0x11, 0x00 }, // U+007b ({)
+    { 0x00, 0x1F, 0x00, 0x00 }, // U+007c (|)
+    { 0x11, 0x1B, 0x04, 0x00 }, // U+007d (})
+    { 0x02, 0x06, 0x04, 0x00 }  // U+007e (~)
+};
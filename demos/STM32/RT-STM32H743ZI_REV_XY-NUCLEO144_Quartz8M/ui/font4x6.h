@@ -28,6 +28,9 @@
 /** @brief Table des glyphes 4x6, 3 octets par caractère. */
 extern const uint8_t font4x6[][3];
 
+/** @brief Atlas précompilé : 4 colonnes par glyphe (ASCII 32 à 126, bit0 = haut). */
+extern const uint8_t font4x6_cols[95][4];
+
 /** @brief Largeur en pixels de chaque caractère (4). */
 extern const uint8_t font4x6_width;
 
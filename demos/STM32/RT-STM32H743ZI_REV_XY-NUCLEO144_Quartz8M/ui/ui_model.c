@@ -1,11 +1,43 @@
+#include <stdbool.h>
+
 #include "ui_model.h"
 
-static volatile uint16_t ui_hall_mask;
+static volatile int32_t  ui_values[UI_FIELD_COUNT];
+static volatile uint32_t ui_versions[UI_FIELD_COUNT];
+
+/* UI_FIELD_NONE n’a pas de valeur : son emplacement reste à zéro. */
+static inline bool field_valid(ui_field_t field) {
+    return ((unsigned)field < UI_FIELD_COUNT) && (field != UI_FIELD_NONE);
+}
+
+void ui_model_set(ui_field_t field, int32_t value) {
+    if (!field_valid(field))
+        return;
+    if (__atomic_load_n(&ui_values[field], __ATOMIC_RELAXED) == value)
+        return;
+
+    /* Valeur puis version : un lecteur qui voit la nouvelle version lit
+       au moins cette valeur. */
+    __atomic_store_n(&ui_values[field], value, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&ui_versions[field], 1U, __ATOMIC_RELEASE);
+}
+
+int32_t ui_model_get(ui_field_t field) {
+    if (!field_valid(field))
+        return 0;
+    return __atomic_load_n(&ui_values[field], __ATOMIC_RELAXED);
+}
+
+uint32_t ui_model_version(ui_field_t field) {
+    if (!field_valid(field))
+        return 0U;
+    return __atomic_load_n(&ui_versions[field], __ATOMIC_ACQUIRE);
+}
 
 void ui_model_set_hall_mask(uint16_t mask) {
-    __atomic_store_n(&ui_hall_mask, mask, __ATOMIC_RELAXED);
+    ui_model_set(UI_FIELD_HALL_MASK, (int32_t)mask);
 }
 
 uint16_t ui_model_get_hall_mask(void) {
-    return __atomic_load_n(&ui_hall_mask, __ATOMIC_RELAXED);
+    return (uint16_t)ui_model_get(UI_FIELD_HALL_MASK);
 }
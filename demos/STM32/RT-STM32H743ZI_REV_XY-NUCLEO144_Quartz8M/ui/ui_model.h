@@ -1,8 +1,41 @@
+/**
+ * @file ui_model.h
+ * @brief Modèle de l’UI : champs scalaires versionnés.
+ *
+ * @ingroup ui
+ *
+ * Chaque champ porte un compteur de version incrémenté **uniquement** quand
+ * sa valeur change. Les widgets (`ui_widget.h`) retiennent la dernière
+ * version dessinée et ne sont redessinés que si elle a bougé.
+ *
+ * Un seul écrivain par champ ; lecture depuis n’importe quel thread.
+ */
+
 #ifndef UI_MODEL_H
 #define UI_MODEL_H
 
 #include <stdint.h>
 
+/**
+ * @brief Champs du modèle.
+ * @details NONE vaut 0 : un widget initialisé sans `.field` n’est lié à rien.
+ */
+typedef enum {
+    UI_FIELD_NONE = 0,        /**< Aucun champ (widget statique) */
+    UI_FIELD_HALL_MASK,       /**< Touches enfoncées (bit n = touche n) */
+    UI_FIELD_HALL_RAW,        /**< Mesure brute du capteur suivi */
+    UI_FIELD_HALL_MIDI,       /**< Valeur MIDI du capteur suivi */
+    UI_FIELD_HALL_GATE,       /**< Note du capteur suivi active (0/1) */
+    UI_FIELD_HALL_VELOCITY,   /**< Dernière vélocité du capteur suivi */
+    UI_FIELD_HALL_PRESSURE,   /**< Pression du capteur suivi */
+    UI_FIELD_COUNT
+} ui_field_t;
+
+/** @brief Écrit un champ ; la version n’avance que si la valeur change. */
+void ui_model_set(ui_field_t field, int32_t value);
+int32_t ui_model_get(ui_field_t field);
+uint32_t ui_model_version(ui_field_t field);
+
 void ui_model_set_hall_mask(uint16_t mask);
 uint16_t ui_model_get_hall_mask(void);
 
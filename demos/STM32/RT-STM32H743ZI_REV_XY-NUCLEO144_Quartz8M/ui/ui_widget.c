@@ -0,0 +1,144 @@
+/**
+ * @file ui_widget.c
+ * @brief Rendu incrémental de l’arbre de widgets.
+ *
+ * @ingroup ui
+ */
+
+#include "ui_widget.h"
+#include "drv_display.h"
+#include <stdio.h>
+
+/* =======================================================================
+   Arbre
+   ======================================================================= */
+
+void ui_widget_add(ui_widget_t *parent, ui_widget_t *w) {
+    ui_widget_t **link = &parent->child;
+
+    while (*link)
+        link = &(*link)->next;
+    w->next = NULL;
+    *link = w;
+    w->valid = false;
+}
+
+void ui_widget_invalidate(ui_widget_t *w) {
+    w->valid = false;
+    for (ui_widget_t *c = w->child; c; c = c->next)
+        ui_widget_invalidate(c);
+}
+
+/* =======================================================================
+   Dessin par type
+   ======================================================================= */
+
+static void draw_text(const ui_widget_t *w, int y, const char *txt) {
+    if (w->font)
+        drv_display_draw_text_with_font(w->font, (uint8_t)w->x, (uint8_t)y, txt);
+    else
+        drv_display_draw_text((uint8_t)w->x, (uint8_t)y, txt);
+}
+
+static const char *item_label(const ui_widget_t *w, int32_t v) {
+    return (v >= 0 && v < w->count) ? w->items[v] : "";
+}
+
+static void draw_value(const ui_widget_t *w, int32_t v) {
+    char buf[32];
+
+    if (w->items)
+        snprintf(buf, sizeof(buf), w->text ? w->text : "%s", item_label(w, v));
+    else
+        snprintf(buf, sizeof(buf), w->text ? w->text : "%ld", (long)v);
+    draw_text(w, w->y, buf);
+}
+
+static void draw_meter(const ui_widget_t *w, int32_t v) {
+    drv_display_draw_rect(w->x, w->y, w->w, w->h);
+    if (w->max <= 0 || w->w <= 2)
+        return;
+
+    if (v < 0)
+        v = 0;
+    if (v > w->max)
+        v = w->max;
+    const int fill = (int)(((int32_t)(w->w - 2) * v) / w->max);
+    drv_display_fill_rect(w->x + 1, w->y + 1, fill, w->h - 2);
+}
+
+static void draw_steps(const ui_widget_t *w, int32_t v) {
+    if (w->max <= 0)
+        return;
+
+    const int cell = w->w / w->max;
+    if (cell < 2)
+        return;
+
+    for (int i = 0; i < w->max && i < 32; i++) {
+        const int cx = w->x + i * cell;
+        if ((uint32_t)v & (1UL << i))
+            drv_display_fill_rect(cx, w->y, cell - 1, w->h);
+        else
+            drv_display_draw_rect(cx, w->y, cell - 1, w->h);
+    }
+}
+
+static void draw_menu(const ui_widget_t *w, int32_t sel) {
+    const font_t *f = w->font ? w->font : drv_display_get_font();
+    const int line = (f ? f->height : 7) + 1;
+    const int visible = w->h / line;
+    if (visible <= 0 || !w->items)
+        return;
+
+    /* Fenêtre glissante : l’entrée sélectionnée reste visible. */
+    int first = 0;
+    if (sel >= visible)
+        first = sel - visible + 1;
+
+    for (int i = 0; i < visible && first + i < w->count; i++) {
+        const int y = w->y + i * line;
+        draw_text(w, y, w->items[first + i]);
+        if (first + i == sel)
+            drv_display_invert_rect(w->x, y, w->w, line);
+    }
+}
+
+/* =======================================================================
+   Rendu
+   ======================================================================= */
+
+static bool render_widget(ui_widget_t *w) {
+    bool drawn = false;
+
+    if (w->type != UI_WIDGET_GROUP) {
+        const bool bound = (w->field != UI_FIELD_NONE);
+        const uint32_t version = bound ? ui_model_version((ui_field_t)w->field) : 0U;
+
+        if (!w->valid || version != w->version) {
+            const int32_t v = bound ? ui_model_get((ui_field_t)w->field) : 0;
+
+            drv_display_clear_rect(w->x, w->y, w->w, w->h);
+            switch (w->type) {
+            case UI_WIDGET_LABEL: draw_text(w, w->y, w->text ? w->text : ""); break;
+            case UI_WIDGET_VALUE: draw_value(w, v); break;
+            case UI_WIDGET_METER: draw_meter(w, v); break;
+            case UI_WIDGET_STEPS: draw_steps(w, v); break;
+            case UI_WIDGET_MENU:  draw_menu(w, v);  break;
+            default: break;
+            }
+            w->version = version;
+            w->valid = true;
+            drawn = true;
+        }
+    }
+
+    for (ui_widget_t *c = w->child; c; c = c->next)
+        drawn |= render_widget(c);
+
+    return drawn;
+}
+
+bool ui_tree_render(ui_widget_t *root) {
+    return root ? render_widget(root) : false;
+}
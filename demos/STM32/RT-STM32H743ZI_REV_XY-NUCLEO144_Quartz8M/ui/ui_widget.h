@@ -0,0 +1,82 @@
+/**
+ * @file ui_widget.h
+ * @brief UI en mode retenu : arbre de widgets liés aux champs de `ui_model`.
+ *
+ * @ingroup ui
+ *
+ * Chaque widget retient la version du champ qu’il a dessinée en dernier.
+ * `ui_tree_render()` parcourt l’arbre et ne redessine que les widgets dont
+ * le champ a changé (ou invalidés) : leur rectangle est effacé puis redessiné,
+ * ce qui l’ajoute à la région modifiée de `drv_display`. Le coût par tick
+ * suit donc le nombre de changements, pas la taille de l’écran.
+ *
+ * Les widgets sont des objets statiques de l’application (aucune allocation) :
+ * ```c
+ * static ui_widget_t raw = {
+ *     .type = UI_WIDGET_VALUE, .x = 0, .y = 12, .w = 128, .h = 8,
+ *     .field = UI_FIELD_HALL_RAW, .text = "RAW = %4ld"
+ * };
+ * ui_widget_add(&root, &raw);
+ * ```
+ */
+
+#ifndef BRICK_UI_WIDGET_H
+#define BRICK_UI_WIDGET_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "font.h"
+#include "ui_model.h"
+
+/** @brief Types de widgets. */
+typedef enum {
+    UI_WIDGET_GROUP = 0,  /**< Conteneur : ne dessine que ses enfants */
+    UI_WIDGET_LABEL,      /**< Texte fixe `text` */
+    UI_WIDGET_VALUE,      /**< `text` = format printf de la valeur (%ld),
+                               ou de `items[valeur]` (%s) si `items` est fourni */
+    UI_WIDGET_METER,      /**< Barre horizontale, valeur sur [0, `max`] */
+    UI_WIDGET_STEPS,      /**< Grille de `max` pas, bit n de la valeur = pas n */
+    UI_WIDGET_MENU        /**< Liste `items`, la valeur est l’entrée sélectionnée */
+} ui_widget_type_t;
+
+typedef struct ui_widget_s ui_widget_t;
+
+/**
+ * @brief Widget retenu.
+ *
+ * Les champs de configuration sont fixés par l’application ; les champs
+ * d’état sont gérés par `ui_tree_render()`.
+ */
+struct ui_widget_s {
+    ui_widget_type_t type;
+    int16_t x, y;              /**< Coin haut-gauche (pixels) */
+    uint8_t w, h;              /**< Rectangle effacé avant chaque rendu */
+    int8_t field;              /**< Champ lié (`ui_field_t`) ; @ref UI_FIELD_NONE (0) par défaut */
+    const font_t *font;        /**< Police, NULL = police courante */
+    const char *text;          /**< LABEL : texte ; VALUE : format */
+    int32_t max;               /**< METER : pleine échelle ; STEPS : nombre de pas */
+    const char *const *items;  /**< MENU / VALUE : libellés indexés par la valeur */
+    uint8_t count;             /**< Nombre d’entrées de `items` */
+
+    ui_widget_t *child;        /**< Premier enfant */
+    ui_widget_t *next;         /**< Frère suivant */
+
+    /* État retenu */
+    uint32_t version;          /**< Version du champ au dernier rendu */
+    bool valid;                /**< false : à redessiner au prochain rendu */
+};
+
+/** @brief Ajoute @p w en dernier enfant de @p parent. */
+void ui_widget_add(ui_widget_t *parent, ui_widget_t *w);
+
+/** @brief Force le rendu de @p w (et de ses enfants) au prochain passage. */
+void ui_widget_invalidate(ui_widget_t *w);
+
+/**
+ * @brief Redessine les widgets dont le champ a changé.
+ * @return true si au moins un widget a été redessiné
+ *         (l’appelant publie alors l’image par `drv_display_update()`).
+ */
+bool ui_tree_render(ui_widget_t *root);
+
+#endif /* BRICK_UI_WIDGET_H */
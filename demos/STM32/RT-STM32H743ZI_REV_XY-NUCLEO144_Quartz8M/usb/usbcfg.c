@@ -11,7 +11,7 @@
  * Il s’intègre au driver `USBDriver` de ChibiOS et assure :
  * - L’initialisation des endpoints lors de la configuration USB.
  * - Le réarmement de la réception OUT.
- * - La signalisation au thread MIDI lors de la fin d’envoi IN.
+ * - La notification du module MIDI en fin d’envoi IN et à chaque SOF.
  *
  * @details
  * **Résumé matériel :**
@@ -21,8 +21,8 @@
  *
  * Contraintes temps réel :
  * - Callbacks **courts** : pas d’appels bloquants en ISR.
- * - Toute transmission se fait via `usbStartTransmitI()` depuis un thread,
- *   déclenchée par un sémaphore signalé dans l’ISR (EP IN).
+ * - En ISR, seul l’enchaînement d’une trame déjà prête de l’anneau TX MIDI
+ *   (`usbStartTransmitI()`, O(1), sans copie) est autorisé.
  *
  * @ingroup drivers
  * @see midi.c  pour la logique de transmission/réception MIDI applicative.
@@ -31,7 +31,7 @@
 #include "hal.h"
 #include "usbcfg.h"
 #include "midi.h"
-#include "ch.h"         /* chBSemSignalI */
+#include "ch.h"
 #include <stdint.h>
 #include <stddef.h>
 
@@ -172,10 +172,10 @@ static USBInEndpointState   ep2_in_state;   /**< État runtime EP2 IN  */
 static USBOutEndpointState  ep1_out_state;  /**< État runtime EP1 OUT */
 
 /**
- * @brief Buffer de réception USB (paquets multiples de 4 octets).
- * @note Aligné sur 32 octets pour compatibilité D-Cache Cortex-M7.
+ * @brief Buffer de réception USB armé sur EP1 (paquets multiples de 4 octets).
+ * @note Fourni par le pool de `midi_rx.c` (alignés 32 octets, non cacheables).
  */
-static uint8_t rx_pkt[MIDI_EP_SIZE] __attribute__((aligned(32)));
+static uint8_t *rx_pkt;
 static volatile uint32_t usb_midi_rx_invalid_size = 0U;
 
 /**
@@ -187,16 +187,17 @@ static void ep1_out_cb(USBDriver *usbp, usbep_t ep) {
   (void)ep;
   const size_t rx_size = ep1_out_state.rxsize;
 
-  if ((rx_size == 0U) || (rx_size > sizeof rx_pkt)) {
+  if ((rx_size == 0U) || (rx_size > MIDI_EP_SIZE)) {
     usb_midi_rx_invalid_size++;
     midi_rx_stats.usb_rx_drops++;
-    usbStartReceiveI(usbp, MIDI_EP_OUT, rx_pkt, sizeof rx_pkt);
+    usbStartReceiveI(usbp, MIDI_EP_OUT, rx_pkt, MIDI_EP_SIZE);
     return;
   }
 
   usb_dcache_invalidate(rx_pkt, rx_size);
-  midi_usb_rx_submit_from_isr(rx_pkt, rx_size);
-  usbStartReceiveI(usbp, MIDI_EP_OUT, rx_pkt, sizeof rx_pkt);
+  /* Le buffer rempli part tel quel vers le parseur ; un autre est réarmé. */
+  rx_pkt = midi_usb_rx_submit_from_isr(rx_pkt, rx_size);
+  usbStartReceiveI(usbp, MIDI_EP_OUT, rx_pkt, MIDI_EP_SIZE);
 }
 
 /**
@@ -205,14 +206,12 @@ static void ep1_out_cb(USBDriver *usbp, usbep_t ep) {
  * @param ep   Numéro d’endpoint (ignoré).
  *
  * @details
- * Appelle `chBSemSignalI()` sur le sémaphore `tx_sem` défini dans `midi.c`
- * pour réveiller le thread d’émission.
+ * Délègue à `midi_usb_tx_done_from_isr()` qui enchaîne la trame suivante
+ * de l’anneau TX.
  */
-extern binary_semaphore_t tx_sem;   /* défini dans midi.c */
-extern binary_semaphore_t sof_sem;  /* défini dans midi.c */
 static void ep2_in_cb(USBDriver *usbp, usbep_t ep) {
   (void)usbp; (void)ep;
-  chBSemSignalI(&tx_sem);
+  midi_usb_tx_done_from_isr();
 }
 
 /* --- EP1 : OUT (bulk) --- */
@@ -279,10 +278,11 @@ static void usb_event(USBDriver *usbp, usbevent_t event) {
       osalSysLockFromISR();
       usbInitEndpointI(usbp, MIDI_EP_OUT, &ep1_out_cfg);
       usbInitEndpointI(usbp, MIDI_EP_IN,  &ep2_in_cfg);
-      usb_dcache_invalidate(rx_pkt, sizeof rx_pkt);
-      usbStartReceiveI(usbp, MIDI_EP_OUT, rx_pkt, sizeof rx_pkt);
+      rx_pkt = midi_usb_rx_arm_i();
+      usb_dcache_invalidate(rx_pkt, MIDI_EP_SIZE);
+      usbStartReceiveI(usbp, MIDI_EP_OUT, rx_pkt, MIDI_EP_SIZE);
+      midi_usb_tx_reset_i();
       usb_midi_tx_ready = true;
-      chBSemSignalI(&tx_sem);
       osalSysUnlockFromISR();
       break;
 
@@ -291,6 +291,7 @@ static void usb_event(USBDriver *usbp, usbevent_t event) {
     case USB_EVENT_SUSPEND:
       osalSysLockFromISR();
       usb_midi_tx_ready = false;
+      midi_usb_tx_reset_i();
       osalSysUnlockFromISR();
       break;
 
@@ -300,11 +301,11 @@ static void usb_event(USBDriver *usbp, usbevent_t event) {
 }
 
 /**
- * @brief Callback "Start Of Frame" (SOF). Inutilisé ici.
+ * @brief Callback "Start Of Frame" (SOF) : vide la trame MIDI partielle.
  */
 static void sof_handler(USBDriver *usbp) {
   (void)usbp;
-  chBSemSignalI(&sof_sem);
+  midi_usb_sof_from_isr();
 }
 
 /* ====================================================================== */